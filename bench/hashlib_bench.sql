@@ -0,0 +1,67 @@
+-- Throughput benchmark for the fast 64-bit hash functions.
+--
+-- Run with `make bench` (writes bench_output.txt) or directly:
+--   psql -X -f bench/hashlib_bench.sql
+--
+-- Every function hashes the same set of random text keys at several key
+-- lengths.  The reported time includes the executor overhead of scanning the
+-- key table, which is identical for all functions, so compare the rows of one
+-- key length against each other rather than reading them as absolute numbers.
+
+\set ON_ERROR_STOP on
+SET client_min_messages = warning;
+CREATE EXTENSION IF NOT EXISTS hashlib;
+
+-- Number of keys hashed per (function, key length) pair
+\if :{?bench_rows}
+\else
+\set bench_rows 200000
+\endif
+
+DROP TABLE IF EXISTS pg_temp.bench_keys;
+CREATE TEMP TABLE bench_keys AS
+SELECT len AS key_len,
+       substr(repeat(md5(g::text || ':' || len::text), (len + 31) / 32), 1, len) AS k
+FROM generate_series(1, :bench_rows) AS g,
+     unnest(ARRAY[8, 16, 32, 64, 256, 1024]) AS len;
+ANALYZE bench_keys;
+
+DROP TABLE IF EXISTS pg_temp.bench_results;
+CREATE TEMP TABLE bench_results (
+    fn text,
+    key_len integer,
+    ms numeric
+);
+
+DO $$
+DECLARE
+    fns text[] := ARRAY['rapidhash', 'komihash', 'aeshash64', 'wyhash', 'xxhash3_64',
+                        'xxhash64', 't1ha2', 'metrohash64', 'cityhash64'];
+    lens integer[];
+    fn text;
+    l integer;
+    t0 timestamptz;
+    dummy bigint;
+BEGIN
+    SELECT array_agg(DISTINCT key_len ORDER BY key_len) INTO lens FROM bench_keys;
+    FOREACH l IN ARRAY lens LOOP
+        FOREACH fn IN ARRAY fns LOOP
+            -- warm-up pass so every function starts with a hot cache
+            EXECUTE format('SELECT max(%I(k)) FROM bench_keys WHERE key_len = $1', fn)
+                INTO dummy USING l;
+            t0 := clock_timestamp();
+            EXECUTE format('SELECT max(%I(k)) FROM bench_keys WHERE key_len = $1', fn)
+                INTO dummy USING l;
+            INSERT INTO bench_results
+            VALUES (fn, l, round(extract(epoch FROM clock_timestamp() - t0)::numeric * 1000, 1));
+        END LOOP;
+    END LOOP;
+END
+$$;
+
+SELECT key_len,
+       fn,
+       ms,
+       round(ms / min(ms) OVER (PARTITION BY key_len), 2) AS relative
+FROM bench_results
+ORDER BY key_len, ms;
@@ -965,4 +965,2275 @@ LANGUAGE C IMMUTABLE STRICT;
 CREATE OR REPLACE FUNCTION xxhash3_128(integer, bigint)
 RETURNS text
 AS 'MODULE_PATHNAME', 'xxhash3_128_int_seed'
-LANGUAGE C IMMUTABLE STRICT;
\ No newline at end of file
+LANGUAGE C IMMUTABLE STRICT;
+
+-- rapidhash function for text (default seed)
+CREATE OR REPLACE FUNCTION rapidhash(text)
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'rapidhash_text'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- rapidhash function for text with custom seed
+CREATE OR REPLACE FUNCTION rapidhash(text, bigint)
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'rapidhash_text_seed'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- rapidhash function for bytea (default seed)
+CREATE OR REPLACE FUNCTION rapidhash(bytea)
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'rapidhash_bytea'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- rapidhash function for bytea with custom seed
+CREATE OR REPLACE FUNCTION rapidhash(bytea, bigint)
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'rapidhash_bytea_seed'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- rapidhash function for integer (default seed)
+CREATE OR REPLACE FUNCTION rapidhash(integer)
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'rapidhash_int4'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- rapidhash function for integer with custom seed
+CREATE OR REPLACE FUNCTION rapidhash(integer, bigint)
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'rapidhash_int4_seed'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- rapidhash function for bigint (default seed)
+CREATE OR REPLACE FUNCTION rapidhash(bigint)
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'rapidhash_int8'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- rapidhash function for bigint with custom seed
+CREATE OR REPLACE FUNCTION rapidhash(bigint, bigint)
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'rapidhash_int8_seed'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- komihash function for text (default seed = 0)
+CREATE OR REPLACE FUNCTION komihash(text)
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'komihash_text'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- komihash function for text with custom seed
+CREATE OR REPLACE FUNCTION komihash(text, bigint)
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'komihash_text_seed'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- komihash function for bytea (default seed = 0)
+CREATE OR REPLACE FUNCTION komihash(bytea)
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'komihash_bytea'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- komihash function for bytea with custom seed
+CREATE OR REPLACE FUNCTION komihash(bytea, bigint)
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'komihash_bytea_seed'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- komihash function for integer (default seed = 0)
+CREATE OR REPLACE FUNCTION komihash(integer)
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'komihash_int4'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- komihash function for integer with custom seed
+CREATE OR REPLACE FUNCTION komihash(integer, bigint)
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'komihash_int4_seed'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- komihash function for bigint (default seed = 0)
+CREATE OR REPLACE FUNCTION komihash(bigint)
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'komihash_int8'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- komihash function for bigint with custom seed
+CREATE OR REPLACE FUNCTION komihash(bigint, bigint)
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'komihash_int8_seed'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- aeshash64 function for text (default seed = 0)
+CREATE OR REPLACE FUNCTION aeshash64(text)
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'aeshash64_text'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- aeshash64 function for text with custom seed
+CREATE OR REPLACE FUNCTION aeshash64(text, bigint)
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'aeshash64_text_seed'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- aeshash64 function for bytea (default seed = 0)
+CREATE OR REPLACE FUNCTION aeshash64(bytea)
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'aeshash64_bytea'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- aeshash64 function for bytea with custom seed
+CREATE OR REPLACE FUNCTION aeshash64(bytea, bigint)
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'aeshash64_bytea_seed'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- aeshash64 function for integer (default seed = 0)
+CREATE OR REPLACE FUNCTION aeshash64(integer)
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'aeshash64_int4'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- aeshash64 function for integer with custom seed
+CREATE OR REPLACE FUNCTION aeshash64(integer, bigint)
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'aeshash64_int4_seed'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- aeshash64 function for bigint (default seed = 0)
+CREATE OR REPLACE FUNCTION aeshash64(bigint)
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'aeshash64_int8'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- aeshash64 function for bigint with custom seed
+CREATE OR REPLACE FUNCTION aeshash64(bigint, bigint)
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'aeshash64_int8_seed'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- aeshash128 function for text (default seed = 0)
+CREATE OR REPLACE FUNCTION aeshash128(text)
+RETURNS bigint[]
+AS 'MODULE_PATHNAME', 'aeshash128_text'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- aeshash128 function for text with custom seed
+CREATE OR REPLACE FUNCTION aeshash128(text, bigint)
+RETURNS bigint[]
+AS 'MODULE_PATHNAME', 'aeshash128_text_seed'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- aeshash128 function for bytea (default seed = 0)
+CREATE OR REPLACE FUNCTION aeshash128(bytea)
+RETURNS bigint[]
+AS 'MODULE_PATHNAME', 'aeshash128_bytea'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- aeshash128 function for bytea with custom seed
+CREATE OR REPLACE FUNCTION aeshash128(bytea, bigint)
+RETURNS bigint[]
+AS 'MODULE_PATHNAME', 'aeshash128_bytea_seed'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- aeshash128 function for integer (default seed = 0)
+CREATE OR REPLACE FUNCTION aeshash128(integer)
+RETURNS bigint[]
+AS 'MODULE_PATHNAME', 'aeshash128_int4'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- aeshash128 function for integer with custom seed
+CREATE OR REPLACE FUNCTION aeshash128(integer, bigint)
+RETURNS bigint[]
+AS 'MODULE_PATHNAME', 'aeshash128_int4_seed'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- aeshash128 function for bigint (default seed = 0)
+CREATE OR REPLACE FUNCTION aeshash128(bigint)
+RETURNS bigint[]
+AS 'MODULE_PATHNAME', 'aeshash128_int8'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- aeshash128 function for bigint with custom seed
+CREATE OR REPLACE FUNCTION aeshash128(bigint, bigint)
+RETURNS bigint[]
+AS 'MODULE_PATHNAME', 'aeshash128_int8_seed'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Name of the aeshash kernel selected for this CPU (aesni, armv8-crypto or portable)
+CREATE OR REPLACE FUNCTION aeshash_implementation()
+RETURNS text
+AS 'MODULE_PATHNAME', 'aeshash_implementation'
+LANGUAGE C STABLE STRICT;
+
+-- CRC-64/XZ function for text (default initial CRC = 0)
+CREATE OR REPLACE FUNCTION crc64(text)
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'crc64_text'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- CRC-64/XZ function for text continuing from a previous CRC
+CREATE OR REPLACE FUNCTION crc64(text, bigint)
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'crc64_text_seed'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- CRC-64/XZ function for bytea (default initial CRC = 0)
+CREATE OR REPLACE FUNCTION crc64(bytea)
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'crc64_bytea'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- CRC-64/XZ function for bytea continuing from a previous CRC
+CREATE OR REPLACE FUNCTION crc64(bytea, bigint)
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'crc64_bytea_seed'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- CRC-64/XZ function for integer (default initial CRC = 0)
+CREATE OR REPLACE FUNCTION crc64(integer)
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'crc64_int'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- CRC-64/XZ function for integer continuing from a previous CRC
+CREATE OR REPLACE FUNCTION crc64(integer, bigint)
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'crc64_int_seed'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- CRC-64/NVME function for text (default initial CRC = 0)
+CREATE OR REPLACE FUNCTION crc64_nvme(text)
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'crc64_nvme_text'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- CRC-64/NVME function for text continuing from a previous CRC
+CREATE OR REPLACE FUNCTION crc64_nvme(text, bigint)
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'crc64_nvme_text_seed'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- CRC-64/NVME function for bytea (default initial CRC = 0)
+CREATE OR REPLACE FUNCTION crc64_nvme(bytea)
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'crc64_nvme_bytea'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- CRC-64/NVME function for bytea continuing from a previous CRC
+CREATE OR REPLACE FUNCTION crc64_nvme(bytea, bigint)
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'crc64_nvme_bytea_seed'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- CRC-64/NVME function for integer (default initial CRC = 0)
+CREATE OR REPLACE FUNCTION crc64_nvme(integer)
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'crc64_nvme_int'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- CRC-64/NVME function for integer continuing from a previous CRC
+CREATE OR REPLACE FUNCTION crc64_nvme(integer, bigint)
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'crc64_nvme_int_seed'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- CRC-64/ECMA-182 function for text (default initial CRC = 0)
+CREATE OR REPLACE FUNCTION crc64_ecma(text)
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'crc64_ecma_text'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- CRC-64/ECMA-182 function for text continuing from a previous CRC
+CREATE OR REPLACE FUNCTION crc64_ecma(text, bigint)
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'crc64_ecma_text_seed'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- CRC-64/ECMA-182 function for bytea (default initial CRC = 0)
+CREATE OR REPLACE FUNCTION crc64_ecma(bytea)
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'crc64_ecma_bytea'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- CRC-64/ECMA-182 function for bytea continuing from a previous CRC
+CREATE OR REPLACE FUNCTION crc64_ecma(bytea, bigint)
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'crc64_ecma_bytea_seed'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- CRC-64/ECMA-182 function for integer (default initial CRC = 0)
+CREATE OR REPLACE FUNCTION crc64_ecma(integer)
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'crc64_ecma_int'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- CRC-64/ECMA-182 function for integer continuing from a previous CRC
+CREATE OR REPLACE FUNCTION crc64_ecma(integer, bigint)
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'crc64_ecma_int_seed'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Incremental hash state used by the *_init/_update/_final functions
+CREATE TYPE hashlib_state;
+
+CREATE OR REPLACE FUNCTION hashlib_state_in(cstring)
+RETURNS hashlib_state
+AS 'MODULE_PATHNAME', 'hashlib_state_in'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashlib_state_out(hashlib_state)
+RETURNS cstring
+AS 'MODULE_PATHNAME', 'hashlib_state_out'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashlib_state_recv(internal)
+RETURNS hashlib_state
+AS 'MODULE_PATHNAME', 'hashlib_state_recv'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashlib_state_send(hashlib_state)
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'hashlib_state_send'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE TYPE hashlib_state (
+    INPUT = hashlib_state_in,
+    OUTPUT = hashlib_state_out,
+    RECEIVE = hashlib_state_recv,
+    SEND = hashlib_state_send,
+    INTERNALLENGTH = VARIABLE,
+    ALIGNMENT = double,
+    STORAGE = main
+);
+
+-- Algorithm a hashlib_state belongs to (xxh3, spooky or highwayhash)
+CREATE OR REPLACE FUNCTION hashlib_state_algorithm(hashlib_state)
+RETURNS text
+AS 'MODULE_PATHNAME', 'hashlib_state_algorithm'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Number of bytes fed into a hashlib_state so far
+CREATE OR REPLACE FUNCTION hashlib_state_length(hashlib_state)
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'hashlib_state_length'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Streaming XXH3: new state (default seed = 0)
+CREATE OR REPLACE FUNCTION xxh3_init()
+RETURNS hashlib_state
+AS 'MODULE_PATHNAME', 'xxh3_init'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Streaming XXH3: new state with custom seed
+CREATE OR REPLACE FUNCTION xxh3_init(bigint)
+RETURNS hashlib_state
+AS 'MODULE_PATHNAME', 'xxh3_init_seed'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Streaming XXH3: add bytea data to a state
+CREATE OR REPLACE FUNCTION xxh3_update(hashlib_state, bytea)
+RETURNS hashlib_state
+AS 'MODULE_PATHNAME', 'xxh3_update'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Streaming XXH3: add text data to a state
+CREATE OR REPLACE FUNCTION xxh3_update(hashlib_state, text)
+RETURNS hashlib_state
+AS 'MODULE_PATHNAME', 'xxh3_update'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Streaming XXH3: 64-bit result, equal to xxhash3_64 of all data
+CREATE OR REPLACE FUNCTION xxh3_final(hashlib_state)
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'xxh3_final'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Streaming XXH3: 128-bit result, equal to xxhash3_128 of all data
+CREATE OR REPLACE FUNCTION xxh3_final128(hashlib_state)
+RETURNS text
+AS 'MODULE_PATHNAME', 'xxh3_final128'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Streaming SpookyHash: new state (default seed = 0)
+CREATE OR REPLACE FUNCTION spooky_init()
+RETURNS hashlib_state
+AS 'MODULE_PATHNAME', 'spooky_init'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Streaming SpookyHash: new state with custom seed (as spookyhash64)
+CREATE OR REPLACE FUNCTION spooky_init(bigint)
+RETURNS hashlib_state
+AS 'MODULE_PATHNAME', 'spooky_init_seed'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Streaming SpookyHash: new state with two seeds (as spookyhash128)
+CREATE OR REPLACE FUNCTION spooky_init(bigint, bigint)
+RETURNS hashlib_state
+AS 'MODULE_PATHNAME', 'spooky_init_seeds'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Streaming SpookyHash: add bytea data to a state
+CREATE OR REPLACE FUNCTION spooky_update(hashlib_state, bytea)
+RETURNS hashlib_state
+AS 'MODULE_PATHNAME', 'spooky_update'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Streaming SpookyHash: add text data to a state
+CREATE OR REPLACE FUNCTION spooky_update(hashlib_state, text)
+RETURNS hashlib_state
+AS 'MODULE_PATHNAME', 'spooky_update'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Streaming SpookyHash: 64-bit result, equal to spookyhash64 of all data
+CREATE OR REPLACE FUNCTION spooky_final(hashlib_state)
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'spooky_final'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Streaming SpookyHash: 128-bit result, equal to spookyhash128 of all data
+CREATE OR REPLACE FUNCTION spooky_final128(hashlib_state)
+RETURNS bigint[]
+AS 'MODULE_PATHNAME', 'spooky_final128'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Streaming HighwayHash: new state (default key)
+CREATE OR REPLACE FUNCTION highwayhash_init()
+RETURNS hashlib_state
+AS 'MODULE_PATHNAME', 'highwayhash_init'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Streaming HighwayHash: new state with custom key (4 bigint values)
+CREATE OR REPLACE FUNCTION highwayhash_init(bigint, bigint, bigint, bigint)
+RETURNS hashlib_state
+AS 'MODULE_PATHNAME', 'highwayhash_init_key'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Streaming HighwayHash: add bytea data to a state
+CREATE OR REPLACE FUNCTION highwayhash_update(hashlib_state, bytea)
+RETURNS hashlib_state
+AS 'MODULE_PATHNAME', 'highwayhash_update'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Streaming HighwayHash: add text data to a state
+CREATE OR REPLACE FUNCTION highwayhash_update(hashlib_state, text)
+RETURNS hashlib_state
+AS 'MODULE_PATHNAME', 'highwayhash_update'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Streaming HighwayHash: 64-bit result, equal to highwayhash64 of all data
+CREATE OR REPLACE FUNCTION highwayhash_final(hashlib_state)
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'highwayhash_final'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Streaming HighwayHash: 128-bit result, equal to highwayhash128 of all data
+CREATE OR REPLACE FUNCTION highwayhash_final128(hashlib_state)
+RETURNS bigint[]
+AS 'MODULE_PATHNAME', 'highwayhash_final128'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Streaming HighwayHash: 256-bit result, equal to highwayhash256 of all data
+CREATE OR REPLACE FUNCTION highwayhash_final256(hashlib_state)
+RETURNS bigint[]
+AS 'MODULE_PATHNAME', 'highwayhash_final256'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Large objects are read a few pages at a time, never materialized whole.
+-- The result equals hashing lo_get(oid) with the bytea variant.
+
+-- XXH3 64-bit hash of a large object (default seed = 0)
+CREATE OR REPLACE FUNCTION lo_xxhash3_64(oid)
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'lo_xxhash3_64'
+LANGUAGE C STABLE STRICT;
+
+-- XXH3 64-bit hash of a large object with custom seed
+CREATE OR REPLACE FUNCTION lo_xxhash3_64(oid, bigint)
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'lo_xxhash3_64_seed'
+LANGUAGE C STABLE STRICT;
+
+-- XXH3 128-bit hash of a large object (default seed = 0)
+CREATE OR REPLACE FUNCTION lo_xxhash3_128(oid)
+RETURNS text
+AS 'MODULE_PATHNAME', 'lo_xxhash3_128'
+LANGUAGE C STABLE STRICT;
+
+-- XXH3 128-bit hash of a large object with custom seed
+CREATE OR REPLACE FUNCTION lo_xxhash3_128(oid, bigint)
+RETURNS text
+AS 'MODULE_PATHNAME', 'lo_xxhash3_128_seed'
+LANGUAGE C STABLE STRICT;
+
+-- CRC32 of a large object (default seed = 0)
+CREATE OR REPLACE FUNCTION lo_crc32(oid)
+RETURNS integer
+AS 'MODULE_PATHNAME', 'lo_crc32'
+LANGUAGE C STABLE STRICT;
+
+-- CRC32 of a large object with custom seed
+CREATE OR REPLACE FUNCTION lo_crc32(oid, integer)
+RETURNS integer
+AS 'MODULE_PATHNAME', 'lo_crc32_seed'
+LANGUAGE C STABLE STRICT;
+
+-- Server-side files are read in 1 MB blocks, never materialized whole.
+-- The result equals the bytea function applied to pg_read_binary_file(path),
+-- widened to bigint.  Requires the privileges of pg_read_server_files.
+
+-- Hash of a whole file
+CREATE OR REPLACE FUNCTION hash_file(text, text)
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'hash_file'
+LANGUAGE C VOLATILE STRICT;
+
+-- Hash of one byte range of a file (offset, length)
+CREATE OR REPLACE FUNCTION hash_file(text, text, bigint, bigint)
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'hash_file_range'
+LANGUAGE C VOLATILE STRICT;
+
+-- Hashes of several byte ranges of a file (offsets, lengths)
+CREATE OR REPLACE FUNCTION hash_file(text, text, bigint[], bigint[])
+RETURNS bigint[]
+AS 'MODULE_PATHNAME', 'hash_file_ranges'
+LANGUAGE C VOLATILE STRICT;
+
+-- Tree-mode XXH3 128-bit hash: leaves of chunk_size bytes are hashed in
+-- parallel and combined in a fixed tree, so the result does not depend on
+-- the number of threads.  Not equal to xxhash3_128.
+
+-- Tree-mode XXH3 128-bit hash for text (default thread count)
+CREATE OR REPLACE FUNCTION xxh3_tree_128(text, integer)
+RETURNS text
+AS 'MODULE_PATHNAME', 'xxh3_tree_128'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Tree-mode XXH3 128-bit hash for text with thread count
+CREATE OR REPLACE FUNCTION xxh3_tree_128(text, integer, integer)
+RETURNS text
+AS 'MODULE_PATHNAME', 'xxh3_tree_128_threads'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Tree-mode XXH3 128-bit hash for bytea (default thread count)
+CREATE OR REPLACE FUNCTION xxh3_tree_128(bytea, integer)
+RETURNS text
+AS 'MODULE_PATHNAME', 'xxh3_tree_128'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Tree-mode XXH3 128-bit hash for bytea with thread count
+CREATE OR REPLACE FUNCTION xxh3_tree_128(bytea, integer, integer)
+RETURNS text
+AS 'MODULE_PATHNAME', 'xxh3_tree_128_threads'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Order-independent 128-bit fingerprint of a set of values.  Equal multisets
+-- give equal results whatever the row order; NULLs are ignored.
+
+-- Set fingerprint: transition function
+CREATE OR REPLACE FUNCTION xxh3_set_agg_transfn(internal, anyelement)
+RETURNS internal
+AS 'MODULE_PATHNAME', 'xxh3_set_agg_transfn'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- Set fingerprint: transition function for records
+CREATE OR REPLACE FUNCTION xxh3_set_agg_record_transfn(internal, record)
+RETURNS internal
+AS 'MODULE_PATHNAME', 'xxh3_set_agg_transfn'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- Set fingerprint: combine partial states from parallel workers
+CREATE OR REPLACE FUNCTION xxh3_set_agg_combine(internal, internal)
+RETURNS internal
+AS 'MODULE_PATHNAME', 'xxh3_set_agg_combine'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- Set fingerprint: serialize a partial state
+CREATE OR REPLACE FUNCTION xxh3_set_agg_serialize(internal)
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'xxh3_set_agg_serialize'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+-- Set fingerprint: deserialize a partial state
+CREATE OR REPLACE FUNCTION xxh3_set_agg_deserialize(bytea, internal)
+RETURNS internal
+AS 'MODULE_PATHNAME', 'xxh3_set_agg_deserialize'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+-- Set fingerprint: 128-bit result as hex text
+CREATE OR REPLACE FUNCTION xxh3_set_agg_final(internal)
+RETURNS text
+AS 'MODULE_PATHNAME', 'xxh3_set_agg_final'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- Set fingerprint of values of any type
+CREATE AGGREGATE xxh3_set_agg(anyelement) (
+    SFUNC = xxh3_set_agg_transfn,
+    STYPE = internal,
+    FINALFUNC = xxh3_set_agg_final,
+    COMBINEFUNC = xxh3_set_agg_combine,
+    SERIALFUNC = xxh3_set_agg_serialize,
+    DESERIALFUNC = xxh3_set_agg_deserialize,
+    PARALLEL = SAFE
+);
+
+-- Set fingerprint of rows
+CREATE AGGREGATE xxh3_set_agg_record(record) (
+    SFUNC = xxh3_set_agg_record_transfn,
+    STYPE = internal,
+    FINALFUNC = xxh3_set_agg_final,
+    COMBINEFUNC = xxh3_set_agg_combine,
+    SERIALFUNC = xxh3_set_agg_serialize,
+    DESERIALFUNC = xxh3_set_agg_deserialize,
+    PARALLEL = SAFE
+);
+
+-- Ordered streaming hash aggregates: each value is framed with its 8-byte
+-- little-endian length (all ones for NULL) and fed to the streaming kernel
+-- in aggregation order, so memory use does not grow with the row count.
+-- Use ORDER BY in the call for a reproducible result.
+
+-- Ordered XXH3: transition function
+CREATE OR REPLACE FUNCTION xxh3_agg_transfn(hashlib_state, bytea)
+RETURNS hashlib_state
+AS 'MODULE_PATHNAME', 'xxh3_agg_transfn'
+LANGUAGE C IMMUTABLE;
+
+-- Ordered XXH3: transition function for text
+CREATE OR REPLACE FUNCTION xxh3_agg_transfn(hashlib_state, text)
+RETURNS hashlib_state
+AS 'MODULE_PATHNAME', 'xxh3_agg_transfn'
+LANGUAGE C IMMUTABLE;
+
+-- Ordered XXH3: 64-bit result
+CREATE OR REPLACE FUNCTION xxh3_agg_final(hashlib_state)
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'xxh3_agg_final'
+LANGUAGE C IMMUTABLE;
+
+-- Ordered XXH3: 128-bit result
+CREATE OR REPLACE FUNCTION xxh3_agg_final128(hashlib_state)
+RETURNS text
+AS 'MODULE_PATHNAME', 'xxh3_agg_final128'
+LANGUAGE C IMMUTABLE;
+
+-- Ordered CRC32: transition function
+CREATE OR REPLACE FUNCTION crc32_agg_transfn(integer, bytea)
+RETURNS integer
+AS 'MODULE_PATHNAME', 'crc32_agg_transfn'
+LANGUAGE C IMMUTABLE;
+
+-- Ordered CRC32: transition function for text
+CREATE OR REPLACE FUNCTION crc32_agg_transfn(integer, text)
+RETURNS integer
+AS 'MODULE_PATHNAME', 'crc32_agg_transfn'
+LANGUAGE C IMMUTABLE;
+
+-- Ordered XXH3 64-bit hash of bytea values
+CREATE AGGREGATE xxh3_64_agg(bytea) (
+    SFUNC = xxh3_agg_transfn,
+    STYPE = hashlib_state,
+    FINALFUNC = xxh3_agg_final
+);
+
+-- Ordered XXH3 64-bit hash of text values
+CREATE AGGREGATE xxh3_64_agg(text) (
+    SFUNC = xxh3_agg_transfn,
+    STYPE = hashlib_state,
+    FINALFUNC = xxh3_agg_final
+);
+
+-- Ordered XXH3 128-bit hash of bytea values
+CREATE AGGREGATE xxh3_128_agg(bytea) (
+    SFUNC = xxh3_agg_transfn,
+    STYPE = hashlib_state,
+    FINALFUNC = xxh3_agg_final128
+);
+
+-- Ordered XXH3 128-bit hash of text values
+CREATE AGGREGATE xxh3_128_agg(text) (
+    SFUNC = xxh3_agg_transfn,
+    STYPE = hashlib_state,
+    FINALFUNC = xxh3_agg_final128
+);
+
+-- Ordered CRC32 of bytea values
+CREATE AGGREGATE crc32_agg(bytea) (
+    SFUNC = crc32_agg_transfn,
+    STYPE = integer,
+    INITCOND = '0'
+);
+
+-- Ordered CRC32 of text values
+CREATE AGGREGATE crc32_agg(text) (
+    SFUNC = crc32_agg_transfn,
+    STYPE = integer,
+    INITCOND = '0'
+);
+
+-- HyperLogLog distinct-count sketch over 64-bit hash values
+CREATE TYPE hll;
+
+CREATE OR REPLACE FUNCTION hll_in(cstring)
+RETURNS hll
+AS 'MODULE_PATHNAME', 'hll_in'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hll_out(hll)
+RETURNS cstring
+AS 'MODULE_PATHNAME', 'hll_out'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hll_recv(internal)
+RETURNS hll
+AS 'MODULE_PATHNAME', 'hll_recv'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hll_send(hll)
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'hll_send'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE TYPE hll (
+    INPUT = hll_in,
+    OUTPUT = hll_out,
+    RECEIVE = hll_recv,
+    SEND = hll_send,
+    INTERNALLENGTH = VARIABLE,
+    STORAGE = extended
+);
+
+-- hll from its stored layout as bytea (checked)
+CREATE OR REPLACE FUNCTION hll(bytea)
+RETURNS hll
+AS 'MODULE_PATHNAME', 'hll_from_bytea'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE CAST (bytea AS hll) WITH FUNCTION hll(bytea);
+CREATE CAST (hll AS bytea) WITHOUT FUNCTION;
+
+-- Empty hll sketch (default precision = 14)
+CREATE OR REPLACE FUNCTION hll_empty()
+RETURNS hll
+AS 'MODULE_PATHNAME', 'hll_empty'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Empty hll sketch with precision (4 to 18)
+CREATE OR REPLACE FUNCTION hll_empty(integer)
+RETURNS hll
+AS 'MODULE_PATHNAME', 'hll_empty'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Add one hash value to an hll sketch
+CREATE OR REPLACE FUNCTION hll_add(hll, bigint)
+RETURNS hll
+AS 'MODULE_PATHNAME', 'hll_add'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Union of two hll sketches, at the lower of their precisions
+CREATE OR REPLACE FUNCTION hll_union(hll, hll)
+RETURNS hll
+AS 'MODULE_PATHNAME', 'hll_union'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Estimated number of distinct hash values in an hll sketch
+CREATE OR REPLACE FUNCTION hll_cardinality(hll)
+RETURNS double precision
+AS 'MODULE_PATHNAME', 'hll_cardinality'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Precision of an hll sketch
+CREATE OR REPLACE FUNCTION hll_precision(hll)
+RETURNS integer
+AS 'MODULE_PATHNAME', 'hll_precision'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- hll aggregates: transition function for hash values
+CREATE OR REPLACE FUNCTION hll_add_agg_transfn(internal, bigint)
+RETURNS internal
+AS 'MODULE_PATHNAME', 'hll_add_agg_transfn'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- hll aggregates: transition function for hash values with precision
+CREATE OR REPLACE FUNCTION hll_add_agg_transfn(internal, bigint, integer)
+RETURNS internal
+AS 'MODULE_PATHNAME', 'hll_add_agg_transfn'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- approx_count_distinct: transition function for values of any type
+CREATE OR REPLACE FUNCTION approx_count_distinct_transfn(internal, anyelement)
+RETURNS internal
+AS 'MODULE_PATHNAME', 'approx_count_distinct_transfn'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- hll aggregates: transition function for sketches
+CREATE OR REPLACE FUNCTION hll_union_agg_transfn(internal, hll)
+RETURNS internal
+AS 'MODULE_PATHNAME', 'hll_union_agg_transfn'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- hll aggregates: combine partial states from parallel workers
+CREATE OR REPLACE FUNCTION hll_agg_combine(internal, internal)
+RETURNS internal
+AS 'MODULE_PATHNAME', 'hll_agg_combine'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- hll aggregates: serialize a partial state
+CREATE OR REPLACE FUNCTION hll_agg_serialize(internal)
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'hll_agg_serialize'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+-- hll aggregates: deserialize a partial state
+CREATE OR REPLACE FUNCTION hll_agg_deserialize(bytea, internal)
+RETURNS internal
+AS 'MODULE_PATHNAME', 'hll_agg_deserialize'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+-- hll aggregates: the sketch (NULL when there were no rows)
+CREATE OR REPLACE FUNCTION hll_agg_final(internal)
+RETURNS hll
+AS 'MODULE_PATHNAME', 'hll_agg_final'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- hll sketch of hash values (default precision = 14)
+CREATE AGGREGATE hll_add_agg(bigint) (
+    SFUNC = hll_add_agg_transfn,
+    STYPE = internal,
+    FINALFUNC = hll_agg_final,
+    COMBINEFUNC = hll_agg_combine,
+    SERIALFUNC = hll_agg_serialize,
+    DESERIALFUNC = hll_agg_deserialize,
+    PARALLEL = SAFE
+);
+
+-- hll sketch of hash values with precision
+CREATE AGGREGATE hll_add_agg(bigint, integer) (
+    SFUNC = hll_add_agg_transfn,
+    STYPE = internal,
+    FINALFUNC = hll_agg_final,
+    COMBINEFUNC = hll_agg_combine,
+    SERIALFUNC = hll_agg_serialize,
+    DESERIALFUNC = hll_agg_deserialize,
+    PARALLEL = SAFE
+);
+
+-- approx_count_distinct: the estimate (0 when there were no rows)
+CREATE OR REPLACE FUNCTION approx_count_distinct_final(internal)
+RETURNS double precision
+AS 'MODULE_PATHNAME', 'approx_count_distinct_final'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- Estimated number of distinct non-null values of any type, with an hll
+-- sketch of the default precision over their xxhash3_64
+CREATE AGGREGATE approx_count_distinct(anyelement) (
+    SFUNC = approx_count_distinct_transfn,
+    STYPE = internal,
+    FINALFUNC = approx_count_distinct_final,
+    COMBINEFUNC = hll_agg_combine,
+    SERIALFUNC = hll_agg_serialize,
+    DESERIALFUNC = hll_agg_deserialize,
+    PARALLEL = SAFE
+);
+
+-- Union of hll sketches, e.g. rolling daily sketches up to months
+CREATE AGGREGATE hll_union_agg(hll) (
+    SFUNC = hll_union_agg_transfn,
+    STYPE = internal,
+    FINALFUNC = hll_agg_final,
+    COMBINEFUNC = hll_agg_combine,
+    SERIALFUNC = hll_agg_serialize,
+    DESERIALFUNC = hll_agg_deserialize,
+    PARALLEL = SAFE
+);
+
+-- Theta (KMV) sketch: the k smallest 64-bit hash values of a set, for
+-- distinct counts of unions, intersections and differences
+CREATE TYPE theta_sketch;
+
+CREATE OR REPLACE FUNCTION theta_sketch_in(cstring)
+RETURNS theta_sketch
+AS 'MODULE_PATHNAME', 'theta_sketch_in'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION theta_sketch_out(theta_sketch)
+RETURNS cstring
+AS 'MODULE_PATHNAME', 'theta_sketch_out'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION theta_sketch_recv(internal)
+RETURNS theta_sketch
+AS 'MODULE_PATHNAME', 'theta_sketch_recv'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION theta_sketch_send(theta_sketch)
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'theta_sketch_send'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE TYPE theta_sketch (
+    INPUT = theta_sketch_in,
+    OUTPUT = theta_sketch_out,
+    RECEIVE = theta_sketch_recv,
+    SEND = theta_sketch_send,
+    INTERNALLENGTH = VARIABLE,
+    STORAGE = extended
+);
+
+-- theta_sketch from its stored layout as bytea (checked)
+CREATE OR REPLACE FUNCTION theta_sketch(bytea)
+RETURNS theta_sketch
+AS 'MODULE_PATHNAME', 'theta_sketch_from_bytea'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE CAST (bytea AS theta_sketch) WITH FUNCTION theta_sketch(bytea);
+CREATE CAST (theta_sketch AS bytea) WITHOUT FUNCTION;
+
+-- Union of two theta sketches
+CREATE OR REPLACE FUNCTION theta_union(theta_sketch, theta_sketch)
+RETURNS theta_sketch
+AS 'MODULE_PATHNAME', 'theta_union'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Intersection of two theta sketches
+CREATE OR REPLACE FUNCTION theta_intersect(theta_sketch, theta_sketch)
+RETURNS theta_sketch
+AS 'MODULE_PATHNAME', 'theta_intersect'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Values of the first theta sketch not in the second
+CREATE OR REPLACE FUNCTION theta_a_not_b(theta_sketch, theta_sketch)
+RETURNS theta_sketch
+AS 'MODULE_PATHNAME', 'theta_a_not_b'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Estimated number of distinct hash values in a theta sketch
+CREATE OR REPLACE FUNCTION theta_estimate(theta_sketch)
+RETURNS double precision
+AS 'MODULE_PATHNAME', 'theta_estimate'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Lower bound of the estimate (1, 2 or 3 standard deviations)
+CREATE OR REPLACE FUNCTION theta_lower_bound(theta_sketch, integer)
+RETURNS double precision
+AS 'MODULE_PATHNAME', 'theta_lower_bound'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Upper bound of the estimate (1, 2 or 3 standard deviations)
+CREATE OR REPLACE FUNCTION theta_upper_bound(theta_sketch, integer)
+RETURNS double precision
+AS 'MODULE_PATHNAME', 'theta_upper_bound'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Number of hash values kept in a theta sketch
+CREATE OR REPLACE FUNCTION theta_retained(theta_sketch)
+RETURNS integer
+AS 'MODULE_PATHNAME', 'theta_retained'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Theta aggregates: transition function for hash values
+CREATE OR REPLACE FUNCTION theta_sketch_agg_transfn(internal, bigint)
+RETURNS internal
+AS 'MODULE_PATHNAME', 'theta_sketch_agg_transfn'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- Theta aggregates: transition function for hash values with sketch size
+CREATE OR REPLACE FUNCTION theta_sketch_agg_transfn(internal, bigint, integer)
+RETURNS internal
+AS 'MODULE_PATHNAME', 'theta_sketch_agg_transfn'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- Theta aggregates: transition function for the union of sketches
+CREATE OR REPLACE FUNCTION theta_union_agg_transfn(internal, theta_sketch)
+RETURNS internal
+AS 'MODULE_PATHNAME', 'theta_union_agg_transfn'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- Theta aggregates: transition function for the intersection of sketches
+CREATE OR REPLACE FUNCTION theta_intersect_agg_transfn(internal, theta_sketch)
+RETURNS internal
+AS 'MODULE_PATHNAME', 'theta_intersect_agg_transfn'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- Theta aggregates: combine partial states (union)
+CREATE OR REPLACE FUNCTION theta_agg_combine(internal, internal)
+RETURNS internal
+AS 'MODULE_PATHNAME', 'theta_agg_combine'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- Theta aggregates: combine partial states (intersection)
+CREATE OR REPLACE FUNCTION theta_intersect_agg_combine(internal, internal)
+RETURNS internal
+AS 'MODULE_PATHNAME', 'theta_intersect_agg_combine'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- Theta aggregates: serialize a partial state
+CREATE OR REPLACE FUNCTION theta_agg_serialize(internal)
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'theta_agg_serialize'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+-- Theta aggregates: deserialize a partial state
+CREATE OR REPLACE FUNCTION theta_agg_deserialize(bytea, internal)
+RETURNS internal
+AS 'MODULE_PATHNAME', 'theta_agg_deserialize'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+-- Theta aggregates: the sketch (NULL when there were no rows)
+CREATE OR REPLACE FUNCTION theta_agg_final(internal)
+RETURNS theta_sketch
+AS 'MODULE_PATHNAME', 'theta_agg_final'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- Theta sketch of hash values (default k = 4096)
+CREATE AGGREGATE theta_sketch_agg(bigint) (
+    SFUNC = theta_sketch_agg_transfn,
+    STYPE = internal,
+    FINALFUNC = theta_agg_final,
+    COMBINEFUNC = theta_agg_combine,
+    SERIALFUNC = theta_agg_serialize,
+    DESERIALFUNC = theta_agg_deserialize,
+    PARALLEL = SAFE
+);
+
+-- Theta sketch of hash values with sketch size k
+CREATE AGGREGATE theta_sketch_agg(bigint, integer) (
+    SFUNC = theta_sketch_agg_transfn,
+    STYPE = internal,
+    FINALFUNC = theta_agg_final,
+    COMBINEFUNC = theta_agg_combine,
+    SERIALFUNC = theta_agg_serialize,
+    DESERIALFUNC = theta_agg_deserialize,
+    PARALLEL = SAFE
+);
+
+-- Union of theta sketches
+CREATE AGGREGATE theta_union_agg(theta_sketch) (
+    SFUNC = theta_union_agg_transfn,
+    STYPE = internal,
+    FINALFUNC = theta_agg_final,
+    COMBINEFUNC = theta_agg_combine,
+    SERIALFUNC = theta_agg_serialize,
+    DESERIALFUNC = theta_agg_deserialize,
+    PARALLEL = SAFE
+);
+
+-- Intersection of theta sketches
+CREATE AGGREGATE theta_intersect_agg(theta_sketch) (
+    SFUNC = theta_intersect_agg_transfn,
+    STYPE = internal,
+    FINALFUNC = theta_agg_final,
+    COMBINEFUNC = theta_intersect_agg_combine,
+    SERIALFUNC = theta_agg_serialize,
+    DESERIALFUNC = theta_agg_deserialize,
+    PARALLEL = SAFE
+);
+
+-- Count-min sketch: approximate frequencies of 64-bit hash values
+CREATE TYPE cms;
+
+CREATE OR REPLACE FUNCTION cms_in(cstring)
+RETURNS cms
+AS 'MODULE_PATHNAME', 'cms_in'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION cms_out(cms)
+RETURNS cstring
+AS 'MODULE_PATHNAME', 'cms_out'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION cms_recv(internal)
+RETURNS cms
+AS 'MODULE_PATHNAME', 'cms_recv'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION cms_send(cms)
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'cms_send'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE TYPE cms (
+    INPUT = cms_in,
+    OUTPUT = cms_out,
+    RECEIVE = cms_recv,
+    SEND = cms_send,
+    INTERNALLENGTH = VARIABLE,
+    STORAGE = extended
+);
+
+-- cms from its stored layout as bytea (checked)
+CREATE OR REPLACE FUNCTION cms(bytea)
+RETURNS cms
+AS 'MODULE_PATHNAME', 'cms_from_bytea'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE CAST (bytea AS cms) WITH FUNCTION cms(bytea);
+CREATE CAST (cms AS bytea) WITHOUT FUNCTION;
+
+-- Empty count-min sketch (default width = 2048, depth = 5)
+CREATE OR REPLACE FUNCTION cms_empty()
+RETURNS cms
+AS 'MODULE_PATHNAME', 'cms_empty'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Empty count-min sketch with width and depth
+CREATE OR REPLACE FUNCTION cms_empty(integer, integer)
+RETURNS cms
+AS 'MODULE_PATHNAME', 'cms_empty'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Add one occurrence of a hash value to a count-min sketch
+CREATE OR REPLACE FUNCTION cms_add(cms, bigint)
+RETURNS cms
+AS 'MODULE_PATHNAME', 'cms_add'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Add count occurrences of a hash value to a count-min sketch
+CREATE OR REPLACE FUNCTION cms_add(cms, bigint, bigint)
+RETURNS cms
+AS 'MODULE_PATHNAME', 'cms_add'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Sum of two count-min sketches of the same size
+CREATE OR REPLACE FUNCTION cms_merge(cms, cms)
+RETURNS cms
+AS 'MODULE_PATHNAME', 'cms_merge'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Estimated count of a hash value (never below the true count)
+CREATE OR REPLACE FUNCTION cms_estimate(cms, bigint)
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'cms_estimate'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Total count added to a count-min sketch
+CREATE OR REPLACE FUNCTION cms_total(cms)
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'cms_total'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Width of a count-min sketch
+CREATE OR REPLACE FUNCTION cms_width(cms)
+RETURNS integer
+AS 'MODULE_PATHNAME', 'cms_width'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Depth of a count-min sketch
+CREATE OR REPLACE FUNCTION cms_depth(cms)
+RETURNS integer
+AS 'MODULE_PATHNAME', 'cms_depth'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- cms aggregates: transition function for hash values
+CREATE OR REPLACE FUNCTION cms_add_agg_transfn(internal, bigint)
+RETURNS internal
+AS 'MODULE_PATHNAME', 'cms_add_agg_transfn'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- cms aggregates: transition function for hash values with width and depth
+CREATE OR REPLACE FUNCTION cms_add_agg_transfn(internal, bigint, integer, integer)
+RETURNS internal
+AS 'MODULE_PATHNAME', 'cms_add_agg_transfn'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- cms aggregates: transition function for sketches
+CREATE OR REPLACE FUNCTION cms_merge_agg_transfn(internal, cms)
+RETURNS internal
+AS 'MODULE_PATHNAME', 'cms_merge_agg_transfn'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- cms aggregates: combine partial states from parallel workers
+CREATE OR REPLACE FUNCTION cms_agg_combine(internal, internal)
+RETURNS internal
+AS 'MODULE_PATHNAME', 'cms_agg_combine'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- cms aggregates: serialize a partial state
+CREATE OR REPLACE FUNCTION cms_agg_serialize(internal)
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'cms_agg_serialize'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+-- cms aggregates: deserialize a partial state
+CREATE OR REPLACE FUNCTION cms_agg_deserialize(bytea, internal)
+RETURNS internal
+AS 'MODULE_PATHNAME', 'cms_agg_deserialize'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+-- cms aggregates: the sketch (NULL when there were no rows)
+CREATE OR REPLACE FUNCTION cms_agg_final(internal)
+RETURNS cms
+AS 'MODULE_PATHNAME', 'cms_agg_final'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- Count-min sketch of hash values (default width = 2048, depth = 5)
+CREATE AGGREGATE cms_add_agg(bigint) (
+    SFUNC = cms_add_agg_transfn,
+    STYPE = internal,
+    FINALFUNC = cms_agg_final,
+    COMBINEFUNC = cms_agg_combine,
+    SERIALFUNC = cms_agg_serialize,
+    DESERIALFUNC = cms_agg_deserialize,
+    PARALLEL = SAFE
+);
+
+-- Count-min sketch of hash values with width and depth
+CREATE AGGREGATE cms_add_agg(bigint, integer, integer) (
+    SFUNC = cms_add_agg_transfn,
+    STYPE = internal,
+    FINALFUNC = cms_agg_final,
+    COMBINEFUNC = cms_agg_combine,
+    SERIALFUNC = cms_agg_serialize,
+    DESERIALFUNC = cms_agg_deserialize,
+    PARALLEL = SAFE
+);
+
+-- Sum of count-min sketches, e.g. per-minute sketches into hours
+CREATE AGGREGATE cms_merge_agg(cms) (
+    SFUNC = cms_merge_agg_transfn,
+    STYPE = internal,
+    FINALFUNC = cms_agg_final,
+    COMBINEFUNC = cms_agg_combine,
+    SERIALFUNC = cms_agg_serialize,
+    DESERIALFUNC = cms_agg_deserialize,
+    PARALLEL = SAFE
+);
+
+-- Heavy hitters: Space-Saving summary of the most frequent values
+CREATE TYPE topk;
+
+CREATE OR REPLACE FUNCTION topk_in(cstring)
+RETURNS topk
+AS 'MODULE_PATHNAME', 'topk_in'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION topk_out(topk)
+RETURNS cstring
+AS 'MODULE_PATHNAME', 'topk_out'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION topk_recv(internal)
+RETURNS topk
+AS 'MODULE_PATHNAME', 'topk_recv'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION topk_send(topk)
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'topk_send'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE TYPE topk (
+    INPUT = topk_in,
+    OUTPUT = topk_out,
+    RECEIVE = topk_recv,
+    SEND = topk_send,
+    INTERNALLENGTH = VARIABLE,
+    STORAGE = extended
+);
+
+-- Items of a topk summary, largest count first
+CREATE OR REPLACE FUNCTION topk_items(topk, OUT value text, OUT count bigint, OUT error bigint)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME', 'topk_items'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- First n items of a topk summary, largest count first
+CREATE OR REPLACE FUNCTION topk_items(topk, integer, OUT value text, OUT count bigint, OUT error bigint)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME', 'topk_items'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Number of values summarized by a topk summary
+CREATE OR REPLACE FUNCTION topk_total(topk)
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'topk_total'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Merge of two topk summaries
+CREATE OR REPLACE FUNCTION topk_union(topk, topk)
+RETURNS topk
+AS 'MODULE_PATHNAME', 'topk_union'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- topk aggregates: transition function for values
+CREATE OR REPLACE FUNCTION topk_agg_transfn(internal, anyelement, integer)
+RETURNS internal
+AS 'MODULE_PATHNAME', 'topk_agg_transfn'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- topk aggregates: transition function for summaries
+CREATE OR REPLACE FUNCTION topk_union_agg_transfn(internal, topk)
+RETURNS internal
+AS 'MODULE_PATHNAME', 'topk_union_agg_transfn'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- topk aggregates: combine partial states from parallel workers
+CREATE OR REPLACE FUNCTION topk_agg_combine(internal, internal)
+RETURNS internal
+AS 'MODULE_PATHNAME', 'topk_agg_combine'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- topk aggregates: serialize a partial state
+CREATE OR REPLACE FUNCTION topk_agg_serialize(internal)
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'topk_agg_serialize'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+-- topk aggregates: deserialize a partial state
+CREATE OR REPLACE FUNCTION topk_agg_deserialize(bytea, internal)
+RETURNS internal
+AS 'MODULE_PATHNAME', 'topk_agg_deserialize'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+-- topk aggregates: the summary (NULL when there were no rows)
+CREATE OR REPLACE FUNCTION topk_agg_final(internal)
+RETURNS topk
+AS 'MODULE_PATHNAME', 'topk_agg_final'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- Space-Saving summary of values with k counters
+CREATE AGGREGATE topk_agg(anyelement, integer) (
+    SFUNC = topk_agg_transfn,
+    STYPE = internal,
+    FINALFUNC = topk_agg_final,
+    COMBINEFUNC = topk_agg_combine,
+    SERIALFUNC = topk_agg_serialize,
+    DESERIALFUNC = topk_agg_deserialize,
+    PARALLEL = SAFE
+);
+
+-- Merge of topk summaries
+CREATE AGGREGATE topk_union_agg(topk) (
+    SFUNC = topk_union_agg_transfn,
+    STYPE = internal,
+    FINALFUNC = topk_agg_final,
+    COMBINEFUNC = topk_agg_combine,
+    SERIALFUNC = topk_agg_serialize,
+    DESERIALFUNC = topk_agg_deserialize,
+    PARALLEL = SAFE
+);
+
+-- Split-block Bloom filter: approximate set membership of values of any type
+CREATE TYPE bloom;
+
+CREATE OR REPLACE FUNCTION bloom_in(cstring)
+RETURNS bloom
+AS 'MODULE_PATHNAME', 'bloom_in'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION bloom_out(bloom)
+RETURNS cstring
+AS 'MODULE_PATHNAME', 'bloom_out'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION bloom_recv(internal)
+RETURNS bloom
+AS 'MODULE_PATHNAME', 'bloom_recv'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION bloom_send(bloom)
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'bloom_send'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE TYPE bloom (
+    INPUT = bloom_in,
+    OUTPUT = bloom_out,
+    RECEIVE = bloom_recv,
+    SEND = bloom_send,
+    INTERNALLENGTH = VARIABLE,
+    STORAGE = extended
+);
+
+-- bloom from its stored layout as bytea (checked)
+CREATE OR REPLACE FUNCTION bloom(bytea)
+RETURNS bloom
+AS 'MODULE_PATHNAME', 'bloom_from_bytea'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE CAST (bytea AS bloom) WITH FUNCTION bloom(bytea);
+CREATE CAST (bloom AS bytea) WITHOUT FUNCTION;
+
+-- Whether a value may be in a bloom filter (never false for added values)
+CREATE OR REPLACE FUNCTION bloom_contains(bloom, anyelement)
+RETURNS boolean
+AS 'MODULE_PATHNAME', 'bloom_contains'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Whether any non-null element of an array may be in a bloom filter
+CREATE OR REPLACE FUNCTION bloom_contains_any(bloom, anyarray)
+RETURNS boolean
+AS 'MODULE_PATHNAME', 'bloom_contains_any'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Union of two bloom filters of the same size
+CREATE OR REPLACE FUNCTION bloom_union(bloom, bloom)
+RETURNS bloom
+AS 'MODULE_PATHNAME', 'bloom_union'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Number of 32-byte blocks of a bloom filter
+CREATE OR REPLACE FUNCTION bloom_blocks(bloom)
+RETURNS integer
+AS 'MODULE_PATHNAME', 'bloom_blocks'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- bloom aggregates: transition function for values
+CREATE OR REPLACE FUNCTION bloom_agg_transfn(internal, anyelement, bigint, double precision)
+RETURNS internal
+AS 'MODULE_PATHNAME', 'bloom_agg_transfn'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- bloom aggregates: combine partial states from parallel workers
+CREATE OR REPLACE FUNCTION bloom_agg_combine(internal, internal)
+RETURNS internal
+AS 'MODULE_PATHNAME', 'bloom_agg_combine'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- bloom aggregates: serialize a partial state
+CREATE OR REPLACE FUNCTION bloom_agg_serialize(internal)
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'bloom_agg_serialize'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+-- bloom aggregates: deserialize a partial state
+CREATE OR REPLACE FUNCTION bloom_agg_deserialize(bytea, internal)
+RETURNS internal
+AS 'MODULE_PATHNAME', 'bloom_agg_deserialize'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+-- bloom aggregates: the filter (NULL when there were no rows)
+CREATE OR REPLACE FUNCTION bloom_agg_final(internal)
+RETURNS bloom
+AS 'MODULE_PATHNAME', 'bloom_agg_final'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- Bloom filter of values sized for expected_n values at false positive rate fpp
+CREATE AGGREGATE bloom_agg(anyelement, bigint, double precision) (
+    SFUNC = bloom_agg_transfn,
+    STYPE = internal,
+    FINALFUNC = bloom_agg_final,
+    COMBINEFUNC = bloom_agg_combine,
+    SERIALFUNC = bloom_agg_serialize,
+    DESERIALFUNC = bloom_agg_deserialize,
+    PARALLEL = SAFE
+);
+
+-- Binary fuse filter: static approximate set membership of values of any type
+CREATE TYPE fuse_filter;
+
+CREATE OR REPLACE FUNCTION fuse_filter_in(cstring)
+RETURNS fuse_filter
+AS 'MODULE_PATHNAME', 'fuse_filter_in'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION fuse_filter_out(fuse_filter)
+RETURNS cstring
+AS 'MODULE_PATHNAME', 'fuse_filter_out'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION fuse_filter_recv(internal)
+RETURNS fuse_filter
+AS 'MODULE_PATHNAME', 'fuse_filter_recv'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION fuse_filter_send(fuse_filter)
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'fuse_filter_send'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE TYPE fuse_filter (
+    INPUT = fuse_filter_in,
+    OUTPUT = fuse_filter_out,
+    RECEIVE = fuse_filter_recv,
+    SEND = fuse_filter_send,
+    INTERNALLENGTH = VARIABLE,
+    STORAGE = extended
+);
+
+-- fuse_filter from its stored layout as bytea (checked)
+CREATE OR REPLACE FUNCTION fuse_filter(bytea)
+RETURNS fuse_filter
+AS 'MODULE_PATHNAME', 'fuse_filter_from_bytea'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE CAST (bytea AS fuse_filter) WITH FUNCTION fuse_filter(bytea);
+CREATE CAST (fuse_filter AS bytea) WITHOUT FUNCTION;
+
+-- Whether a value may be in a binary fuse filter (never false for added values)
+CREATE OR REPLACE FUNCTION fuse_contains(fuse_filter, anyelement)
+RETURNS boolean
+AS 'MODULE_PATHNAME', 'fuse_contains'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Whether any non-null element of an array may be in a binary fuse filter
+CREATE OR REPLACE FUNCTION fuse_contains_any(fuse_filter, anyarray)
+RETURNS boolean
+AS 'MODULE_PATHNAME', 'fuse_contains_any'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Number of distinct values in a binary fuse filter
+CREATE OR REPLACE FUNCTION fuse_count(fuse_filter)
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'fuse_count'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Fingerprint bits of a binary fuse filter (8 or 16)
+CREATE OR REPLACE FUNCTION fuse_bits(fuse_filter)
+RETURNS integer
+AS 'MODULE_PATHNAME', 'fuse_bits'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- fuse_filter aggregates: transition function for values
+CREATE OR REPLACE FUNCTION fuse_agg_transfn(internal, anyelement)
+RETURNS internal
+AS 'MODULE_PATHNAME', 'fuse_agg_transfn'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- fuse_filter aggregates: transition function for values with fingerprint bits
+CREATE OR REPLACE FUNCTION fuse_agg_transfn(internal, anyelement, integer)
+RETURNS internal
+AS 'MODULE_PATHNAME', 'fuse_agg_transfn'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- fuse_filter aggregates: combine partial states from parallel workers
+CREATE OR REPLACE FUNCTION fuse_agg_combine(internal, internal)
+RETURNS internal
+AS 'MODULE_PATHNAME', 'fuse_agg_combine'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- fuse_filter aggregates: serialize a partial state
+CREATE OR REPLACE FUNCTION fuse_agg_serialize(internal)
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'fuse_agg_serialize'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+-- fuse_filter aggregates: deserialize a partial state
+CREATE OR REPLACE FUNCTION fuse_agg_deserialize(bytea, internal)
+RETURNS internal
+AS 'MODULE_PATHNAME', 'fuse_agg_deserialize'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+-- fuse_filter aggregates: the filter (NULL when there were no rows)
+CREATE OR REPLACE FUNCTION fuse_agg_final(internal)
+RETURNS fuse_filter
+AS 'MODULE_PATHNAME', 'fuse_agg_final'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- Binary fuse filter of values with 8-bit fingerprints
+CREATE AGGREGATE fuse_agg(anyelement) (
+    SFUNC = fuse_agg_transfn,
+    STYPE = internal,
+    FINALFUNC = fuse_agg_final,
+    COMBINEFUNC = fuse_agg_combine,
+    SERIALFUNC = fuse_agg_serialize,
+    DESERIALFUNC = fuse_agg_deserialize,
+    PARALLEL = SAFE
+);
+
+-- Binary fuse filter of values with 8- or 16-bit fingerprints
+CREATE AGGREGATE fuse_agg(anyelement, integer) (
+    SFUNC = fuse_agg_transfn,
+    STYPE = internal,
+    FINALFUNC = fuse_agg_final,
+    COMBINEFUNC = fuse_agg_combine,
+    SERIALFUNC = fuse_agg_serialize,
+    DESERIALFUNC = fuse_agg_deserialize,
+    PARALLEL = SAFE
+);
+
+-- Exact set of integer or uuid values, probed in place
+CREATE TYPE hashset;
+
+CREATE OR REPLACE FUNCTION hashset_in(cstring)
+RETURNS hashset
+AS 'MODULE_PATHNAME', 'hashset_in'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashset_out(hashset)
+RETURNS cstring
+AS 'MODULE_PATHNAME', 'hashset_out'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashset_recv(internal)
+RETURNS hashset
+AS 'MODULE_PATHNAME', 'hashset_recv'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashset_send(hashset)
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'hashset_send'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE TYPE hashset (
+    INPUT = hashset_in,
+    OUTPUT = hashset_out,
+    RECEIVE = hashset_recv,
+    SEND = hashset_send,
+    INTERNALLENGTH = VARIABLE,
+    STORAGE = extended
+);
+
+-- hashset from its stored layout as bytea (checked)
+CREATE OR REPLACE FUNCTION hashset(bytea)
+RETURNS hashset
+AS 'MODULE_PATHNAME', 'hashset_from_bytea'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE CAST (bytea AS hashset) WITH FUNCTION hashset(bytea);
+CREATE CAST (hashset AS bytea) WITHOUT FUNCTION;
+
+-- hashset of the non-null elements of a bigint array
+CREATE OR REPLACE FUNCTION hashset(bigint[])
+RETURNS hashset
+AS 'MODULE_PATHNAME', 'hashset_from_array'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- hashset of the non-null elements of a integer array
+CREATE OR REPLACE FUNCTION hashset(integer[])
+RETURNS hashset
+AS 'MODULE_PATHNAME', 'hashset_from_array'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- hashset of the non-null elements of a uuid array
+CREATE OR REPLACE FUNCTION hashset(uuid[])
+RETURNS hashset
+AS 'MODULE_PATHNAME', 'hashset_from_array'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Whether a hashset holds a bigint value
+CREATE OR REPLACE FUNCTION hashset_contains(hashset, bigint)
+RETURNS boolean
+AS 'MODULE_PATHNAME', 'hashset_contains'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Whether a hashset holds a integer value
+CREATE OR REPLACE FUNCTION hashset_contains(hashset, integer)
+RETURNS boolean
+AS 'MODULE_PATHNAME', 'hashset_contains'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Whether a hashset holds a uuid value
+CREATE OR REPLACE FUNCTION hashset_contains(hashset, uuid)
+RETURNS boolean
+AS 'MODULE_PATHNAME', 'hashset_contains'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- hashset with a bigint value added
+CREATE OR REPLACE FUNCTION hashset_add(hashset, bigint)
+RETURNS hashset
+AS 'MODULE_PATHNAME', 'hashset_add'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- hashset with a integer value added
+CREATE OR REPLACE FUNCTION hashset_add(hashset, integer)
+RETURNS hashset
+AS 'MODULE_PATHNAME', 'hashset_add'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- hashset with a uuid value added
+CREATE OR REPLACE FUNCTION hashset_add(hashset, uuid)
+RETURNS hashset
+AS 'MODULE_PATHNAME', 'hashset_add'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Number of values in a hashset
+CREATE OR REPLACE FUNCTION hashset_count(hashset)
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'hashset_count'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- hashset aggregates: transition function for bigint values
+CREATE OR REPLACE FUNCTION hashset_agg_transfn(internal, bigint)
+RETURNS internal
+AS 'MODULE_PATHNAME', 'hashset_agg_transfn'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- hashset aggregates: transition function for integer values
+CREATE OR REPLACE FUNCTION hashset_agg_transfn(internal, integer)
+RETURNS internal
+AS 'MODULE_PATHNAME', 'hashset_agg_transfn'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- hashset aggregates: transition function for uuid values
+CREATE OR REPLACE FUNCTION hashset_agg_transfn(internal, uuid)
+RETURNS internal
+AS 'MODULE_PATHNAME', 'hashset_agg_transfn'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- hashset aggregates: combine partial states from parallel workers
+CREATE OR REPLACE FUNCTION hashset_agg_combine(internal, internal)
+RETURNS internal
+AS 'MODULE_PATHNAME', 'hashset_agg_combine'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- hashset aggregates: serialize a partial state
+CREATE OR REPLACE FUNCTION hashset_agg_serialize(internal)
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'hashset_agg_serialize'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+-- hashset aggregates: deserialize a partial state
+CREATE OR REPLACE FUNCTION hashset_agg_deserialize(bytea, internal)
+RETURNS internal
+AS 'MODULE_PATHNAME', 'hashset_agg_deserialize'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+-- hashset aggregates: the set (NULL when there were no rows)
+CREATE OR REPLACE FUNCTION hashset_agg_final(internal)
+RETURNS hashset
+AS 'MODULE_PATHNAME', 'hashset_agg_final'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- hashset of bigint values
+CREATE AGGREGATE hashset_agg(bigint) (
+    SFUNC = hashset_agg_transfn,
+    STYPE = internal,
+    FINALFUNC = hashset_agg_final,
+    COMBINEFUNC = hashset_agg_combine,
+    SERIALFUNC = hashset_agg_serialize,
+    DESERIALFUNC = hashset_agg_deserialize,
+    PARALLEL = SAFE
+);
+
+-- hashset of integer values
+CREATE AGGREGATE hashset_agg(integer) (
+    SFUNC = hashset_agg_transfn,
+    STYPE = internal,
+    FINALFUNC = hashset_agg_final,
+    COMBINEFUNC = hashset_agg_combine,
+    SERIALFUNC = hashset_agg_serialize,
+    DESERIALFUNC = hashset_agg_deserialize,
+    PARALLEL = SAFE
+);
+
+-- hashset of uuid values
+CREATE AGGREGATE hashset_agg(uuid) (
+    SFUNC = hashset_agg_transfn,
+    STYPE = internal,
+    FINALFUNC = hashset_agg_final,
+    COMBINEFUNC = hashset_agg_combine,
+    SERIALFUNC = hashset_agg_serialize,
+    DESERIALFUNC = hashset_agg_deserialize,
+    PARALLEL = SAFE
+);
+
+-- Minimal perfect hash function: dense indexes in [0, n) for a fixed set of values
+CREATE TYPE mphf;
+
+CREATE OR REPLACE FUNCTION mphf_in(cstring)
+RETURNS mphf
+AS 'MODULE_PATHNAME', 'mphf_in'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION mphf_out(mphf)
+RETURNS cstring
+AS 'MODULE_PATHNAME', 'mphf_out'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION mphf_recv(internal)
+RETURNS mphf
+AS 'MODULE_PATHNAME', 'mphf_recv'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION mphf_send(mphf)
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'mphf_send'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE TYPE mphf (
+    INPUT = mphf_in,
+    OUTPUT = mphf_out,
+    RECEIVE = mphf_recv,
+    SEND = mphf_send,
+    INTERNALLENGTH = VARIABLE,
+    STORAGE = extended
+);
+
+-- mphf from its stored layout as bytea (checked)
+CREATE OR REPLACE FUNCTION mphf(bytea)
+RETURNS mphf
+AS 'MODULE_PATHNAME', 'mphf_from_bytea'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE CAST (bytea AS mphf) WITH FUNCTION mphf(bytea);
+CREATE CAST (mphf AS bytea) WITHOUT FUNCTION;
+
+-- Index in [0, n) of a value in the set (some index or NULL for other values)
+CREATE OR REPLACE FUNCTION mphf_lookup(mphf, anyelement)
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'mphf_lookup'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Number of distinct values in a minimal perfect hash function
+CREATE OR REPLACE FUNCTION mphf_count(mphf)
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'mphf_count'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- mphf aggregates: transition function for values
+CREATE OR REPLACE FUNCTION mphf_agg_transfn(internal, anyelement)
+RETURNS internal
+AS 'MODULE_PATHNAME', 'mphf_agg_transfn'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- mphf aggregates: combine partial states from parallel workers
+CREATE OR REPLACE FUNCTION mphf_agg_combine(internal, internal)
+RETURNS internal
+AS 'MODULE_PATHNAME', 'mphf_agg_combine'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- mphf aggregates: serialize a partial state
+CREATE OR REPLACE FUNCTION mphf_agg_serialize(internal)
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'mphf_agg_serialize'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+-- mphf aggregates: deserialize a partial state
+CREATE OR REPLACE FUNCTION mphf_agg_deserialize(bytea, internal)
+RETURNS internal
+AS 'MODULE_PATHNAME', 'mphf_agg_deserialize'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+-- mphf aggregates: the function (NULL when there were no rows)
+CREATE OR REPLACE FUNCTION mphf_agg_final(internal)
+RETURNS mphf
+AS 'MODULE_PATHNAME', 'mphf_agg_final'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- Minimal perfect hash function of values
+CREATE AGGREGATE mphf_agg(anyelement) (
+    SFUNC = mphf_agg_transfn,
+    STYPE = internal,
+    FINALFUNC = mphf_agg_final,
+    COMBINEFUNC = mphf_agg_combine,
+    SERIALFUNC = mphf_agg_serialize,
+    DESERIALFUNC = mphf_agg_deserialize,
+    PARALLEL = SAFE
+);
+
+-- Jump consistent hash: bucket in [0, buckets) of a 64-bit key
+CREATE OR REPLACE FUNCTION jump_consistent_hash(bigint, integer)
+RETURNS integer
+AS 'MODULE_PATHNAME', 'jump_consistent_hash'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Jump consistent hash of the xxhash3_64 of text
+CREATE OR REPLACE FUNCTION jump_consistent_hash(text, integer)
+RETURNS integer
+AS 'MODULE_PATHNAME', 'jump_consistent_hash_text'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Jump consistent hash of the xxhash3_64 of bytea
+CREATE OR REPLACE FUNCTION jump_consistent_hash(bytea, integer)
+RETURNS integer
+AS 'MODULE_PATHNAME', 'jump_consistent_hash_text'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Rendezvous (highest random weight) hashing of a 64-bit key over named nodes
+CREATE OR REPLACE FUNCTION rendezvous_hash(bigint, text[])
+RETURNS text
+AS 'MODULE_PATHNAME', 'rendezvous_hash_int8'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Weighted rendezvous hashing of a 64-bit key over named nodes
+CREATE OR REPLACE FUNCTION rendezvous_hash(bigint, text[], double precision[])
+RETURNS text
+AS 'MODULE_PATHNAME', 'rendezvous_hash_int8'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Rendezvous (highest random weight) hashing of the xxhash3_64 of text over named nodes
+CREATE OR REPLACE FUNCTION rendezvous_hash(text, text[])
+RETURNS text
+AS 'MODULE_PATHNAME', 'rendezvous_hash_text'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Weighted rendezvous hashing of the xxhash3_64 of text over named nodes
+CREATE OR REPLACE FUNCTION rendezvous_hash(text, text[], double precision[])
+RETURNS text
+AS 'MODULE_PATHNAME', 'rendezvous_hash_text'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Rendezvous (highest random weight) hashing of the xxhash3_64 of bytea over named nodes
+CREATE OR REPLACE FUNCTION rendezvous_hash(bytea, text[])
+RETURNS text
+AS 'MODULE_PATHNAME', 'rendezvous_hash_text'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Weighted rendezvous hashing of the xxhash3_64 of bytea over named nodes
+CREATE OR REPLACE FUNCTION rendezvous_hash(bytea, text[], double precision[])
+RETURNS text
+AS 'MODULE_PATHNAME', 'rendezvous_hash_text'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Multi-probe consistent hashing of a 64-bit key over named nodes (21 probes)
+CREATE OR REPLACE FUNCTION multiprobe_hash(bigint, text[])
+RETURNS text
+AS 'MODULE_PATHNAME', 'multiprobe_hash_int8'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Multi-probe consistent hashing of a 64-bit key over named nodes with a number of probes
+CREATE OR REPLACE FUNCTION multiprobe_hash(bigint, text[], integer)
+RETURNS text
+AS 'MODULE_PATHNAME', 'multiprobe_hash_int8'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Multi-probe consistent hashing of the xxhash3_64 of text over named nodes (21 probes)
+CREATE OR REPLACE FUNCTION multiprobe_hash(text, text[])
+RETURNS text
+AS 'MODULE_PATHNAME', 'multiprobe_hash_text'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Multi-probe consistent hashing of the xxhash3_64 of text over named nodes with a number of probes
+CREATE OR REPLACE FUNCTION multiprobe_hash(text, text[], integer)
+RETURNS text
+AS 'MODULE_PATHNAME', 'multiprobe_hash_text'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Multi-probe consistent hashing of the xxhash3_64 of bytea over named nodes (21 probes)
+CREATE OR REPLACE FUNCTION multiprobe_hash(bytea, text[])
+RETURNS text
+AS 'MODULE_PATHNAME', 'multiprobe_hash_text'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Multi-probe consistent hashing of the xxhash3_64 of bytea over named nodes with a number of probes
+CREATE OR REPLACE FUNCTION multiprobe_hash(bytea, text[], integer)
+RETURNS text
+AS 'MODULE_PATHNAME', 'multiprobe_hash_text'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Consistent-hash routing table (Maglev) over named, weighted nodes
+CREATE TYPE hashring;
+
+CREATE OR REPLACE FUNCTION hashring_in(cstring)
+RETURNS hashring
+AS 'MODULE_PATHNAME', 'hashring_in'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashring_out(hashring)
+RETURNS cstring
+AS 'MODULE_PATHNAME', 'hashring_out'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashring_recv(internal)
+RETURNS hashring
+AS 'MODULE_PATHNAME', 'hashring_recv'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE OR REPLACE FUNCTION hashring_send(hashring)
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'hashring_send'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE TYPE hashring (
+    INPUT = hashring_in,
+    OUTPUT = hashring_out,
+    RECEIVE = hashring_recv,
+    SEND = hashring_send,
+    INTERNALLENGTH = VARIABLE,
+    STORAGE = extended
+);
+
+-- hashring from its stored layout as bytea (checked)
+CREATE OR REPLACE FUNCTION hashring(bytea)
+RETURNS hashring
+AS 'MODULE_PATHNAME', 'hashring_from_bytea'
+LANGUAGE C IMMUTABLE STRICT;
+
+CREATE CAST (bytea AS hashring) WITH FUNCTION hashring(bytea);
+CREATE CAST (hashring AS bytea) WITHOUT FUNCTION;
+
+-- hashring of nodes with equal weights
+CREATE OR REPLACE FUNCTION hashring(text[])
+RETURNS hashring
+AS 'MODULE_PATHNAME', 'hashring_from_arrays'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- hashring of weighted nodes
+CREATE OR REPLACE FUNCTION hashring(text[], double precision[])
+RETURNS hashring
+AS 'MODULE_PATHNAME', 'hashring_from_arrays'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Node of a 64-bit key in a hashring
+CREATE OR REPLACE FUNCTION ring_lookup(hashring, bigint)
+RETURNS text
+AS 'MODULE_PATHNAME', 'ring_lookup'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Node of the xxhash3_64 of text in a hashring
+CREATE OR REPLACE FUNCTION ring_lookup(hashring, text)
+RETURNS text
+AS 'MODULE_PATHNAME', 'ring_lookup'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Node of the xxhash3_64 of bytea in a hashring
+CREATE OR REPLACE FUNCTION ring_lookup(hashring, bytea)
+RETURNS text
+AS 'MODULE_PATHNAME', 'ring_lookup'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Nodes of a hashring by name, with their weights and shares of keys
+CREATE OR REPLACE FUNCTION ring_nodes(hashring, OUT node text, OUT weight double precision, OUT share double precision)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME', 'ring_nodes'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Shares of keys that move between nodes when a hashring is replaced by another
+CREATE OR REPLACE FUNCTION ring_diff(hashring, hashring, OUT old_node text, OUT new_node text, OUT share double precision)
+RETURNS SETOF record
+AS 'MODULE_PATHNAME', 'ring_diff'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- hashring aggregates: transition function for nodes
+CREATE OR REPLACE FUNCTION hashring_agg_transfn(internal, text)
+RETURNS internal
+AS 'MODULE_PATHNAME', 'hashring_agg_transfn'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- hashring aggregates: transition function for weighted nodes
+CREATE OR REPLACE FUNCTION hashring_agg_transfn(internal, text, double precision)
+RETURNS internal
+AS 'MODULE_PATHNAME', 'hashring_agg_transfn'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- hashring aggregates: combine partial states from parallel workers
+CREATE OR REPLACE FUNCTION hashring_agg_combine(internal, internal)
+RETURNS internal
+AS 'MODULE_PATHNAME', 'hashring_agg_combine'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- hashring aggregates: serialize a partial state
+CREATE OR REPLACE FUNCTION hashring_agg_serialize(internal)
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'hashring_agg_serialize'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+-- hashring aggregates: deserialize a partial state
+CREATE OR REPLACE FUNCTION hashring_agg_deserialize(bytea, internal)
+RETURNS internal
+AS 'MODULE_PATHNAME', 'hashring_agg_deserialize'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+-- hashring aggregates: the ring (NULL when there were no rows)
+CREATE OR REPLACE FUNCTION hashring_agg_final(internal)
+RETURNS hashring
+AS 'MODULE_PATHNAME', 'hashring_agg_final'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- hashring of nodes with equal weights
+CREATE AGGREGATE hashring_agg(text) (
+    SFUNC = hashring_agg_transfn,
+    STYPE = internal,
+    FINALFUNC = hashring_agg_final,
+    COMBINEFUNC = hashring_agg_combine,
+    SERIALFUNC = hashring_agg_serialize,
+    DESERIALFUNC = hashring_agg_deserialize,
+    PARALLEL = SAFE
+);
+
+-- hashring of weighted nodes
+CREATE AGGREGATE hashring_agg(text, double precision) (
+    SFUNC = hashring_agg_transfn,
+    STYPE = internal,
+    FINALFUNC = hashring_agg_final,
+    COMBINEFUNC = hashring_agg_combine,
+    SERIALFUNC = hashring_agg_serialize,
+    DESERIALFUNC = hashring_agg_deserialize,
+    PARALLEL = SAFE
+);
+
+-- Bucket in [0, n) of the xxhash3_64 of text, by multiply-high instead of modulo
+CREATE OR REPLACE FUNCTION hash_bucket(text, integer)
+RETURNS integer
+AS 'MODULE_PATHNAME', 'hash_bucket'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Bucket in [0, n) of the hash of text with a named algorithm
+CREATE OR REPLACE FUNCTION hash_bucket(text, integer, text)
+RETURNS integer
+AS 'MODULE_PATHNAME', 'hash_bucket'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Bucket in [0, n) of the xxhash3_64 of bytea
+CREATE OR REPLACE FUNCTION hash_bucket(bytea, integer)
+RETURNS integer
+AS 'MODULE_PATHNAME', 'hash_bucket'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Bucket in [0, n) of the hash of bytea with a named algorithm
+CREATE OR REPLACE FUNCTION hash_bucket(bytea, integer, text)
+RETURNS integer
+AS 'MODULE_PATHNAME', 'hash_bucket'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Bucket in [0, n) of the xxhash3_64 of a value of any other type
+CREATE OR REPLACE FUNCTION hash_bucket(anyelement, integer)
+RETURNS integer
+AS 'MODULE_PATHNAME', 'hash_bucket'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Bucket in [0, n) of the hash of a value of any other type with a named algorithm
+CREATE OR REPLACE FUNCTION hash_bucket(anyelement, integer, text)
+RETURNS integer
+AS 'MODULE_PATHNAME', 'hash_bucket'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Weighted bucket of the xxhash3_64 of text: an index into the weights
+CREATE OR REPLACE FUNCTION hash_bucket_weighted(text, double precision[])
+RETURNS integer
+AS 'MODULE_PATHNAME', 'hash_bucket_weighted'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Weighted bucket of the hash of text with a named algorithm
+CREATE OR REPLACE FUNCTION hash_bucket_weighted(text, double precision[], text)
+RETURNS integer
+AS 'MODULE_PATHNAME', 'hash_bucket_weighted'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Weighted bucket of the xxhash3_64 of bytea
+CREATE OR REPLACE FUNCTION hash_bucket_weighted(bytea, double precision[])
+RETURNS integer
+AS 'MODULE_PATHNAME', 'hash_bucket_weighted'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Weighted bucket of the hash of bytea with a named algorithm
+CREATE OR REPLACE FUNCTION hash_bucket_weighted(bytea, double precision[], text)
+RETURNS integer
+AS 'MODULE_PATHNAME', 'hash_bucket_weighted'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Weighted bucket of the xxhash3_64 of a value of any other type
+CREATE OR REPLACE FUNCTION hash_bucket_weighted(anyelement, double precision[])
+RETURNS integer
+AS 'MODULE_PATHNAME', 'hash_bucket_weighted'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Weighted bucket of the hash of a value of any other type with a named algorithm
+CREATE OR REPLACE FUNCTION hash_bucket_weighted(anyelement, double precision[], text)
+RETURNS integer
+AS 'MODULE_PATHNAME', 'hash_bucket_weighted'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- TABLESAMPLE hashlib_block(percent, seed): blocks sampled by the xxhash3_64 of (table, block, seed)
+CREATE OR REPLACE FUNCTION hashlib_block(internal)
+RETURNS tsm_handler
+AS 'MODULE_PATHNAME', 'hashlib_block'
+LANGUAGE C STRICT;
+
+-- TABLESAMPLE hashlib_row(percent, seed): rows sampled by the xxhash3_64 of (table, block, offset, seed)
+CREATE OR REPLACE FUNCTION hashlib_row(internal)
+RETURNS tsm_handler
+AS 'MODULE_PATHNAME', 'hashlib_row'
+LANGUAGE C STRICT;
+
+-- Planner support for hash_sample: its selectivity is the sample rate
+CREATE OR REPLACE FUNCTION hash_sample_support(internal)
+RETURNS internal
+AS 'MODULE_PATHNAME', 'hash_sample_support'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Whether text is in the sample of the given rate: its xxhash3_64 with the seed is below rate * 2^64
+CREATE OR REPLACE FUNCTION hash_sample(text, double precision, bigint)
+RETURNS boolean
+AS 'MODULE_PATHNAME', 'hash_sample'
+LANGUAGE C IMMUTABLE STRICT
+SUPPORT hash_sample_support;
+
+-- Whether bytea is in the sample of the given rate
+CREATE OR REPLACE FUNCTION hash_sample(bytea, double precision, bigint)
+RETURNS boolean
+AS 'MODULE_PATHNAME', 'hash_sample'
+LANGUAGE C IMMUTABLE STRICT
+SUPPORT hash_sample_support;
+
+-- Whether a value of any other type is in the sample of the given rate
+CREATE OR REPLACE FUNCTION hash_sample(anyelement, double precision, bigint)
+RETURNS boolean
+AS 'MODULE_PATHNAME', 'hash_sample'
+LANGUAGE C IMMUTABLE STRICT
+SUPPORT hash_sample_support;
+
+-- Experiment arm of text: the weighted bucket of its xxhash3_64 with the seed
+CREATE OR REPLACE FUNCTION ab_bucket(text, double precision[], bigint)
+RETURNS integer
+AS 'MODULE_PATHNAME', 'ab_bucket'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Experiment arm of bytea
+CREATE OR REPLACE FUNCTION ab_bucket(bytea, double precision[], bigint)
+RETURNS integer
+AS 'MODULE_PATHNAME', 'ab_bucket'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Experiment arm of a value of any other type
+CREATE OR REPLACE FUNCTION ab_bucket(anyelement, double precision[], bigint)
+RETURNS integer
+AS 'MODULE_PATHNAME', 'ab_bucket'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- bottom_k_sample: transition function
+CREATE OR REPLACE FUNCTION bottom_k_sample_transfn(internal, anyelement, integer, bigint)
+RETURNS internal
+AS 'MODULE_PATHNAME', 'bottom_k_sample_transfn'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- bottom_k_sample: combine partial states
+CREATE OR REPLACE FUNCTION bottom_k_sample_combine(internal, internal)
+RETURNS internal
+AS 'MODULE_PATHNAME', 'bottom_k_sample_combine'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- bottom_k_sample: serialize a partial state
+CREATE OR REPLACE FUNCTION bottom_k_sample_serialize(internal)
+RETURNS bytea
+AS 'MODULE_PATHNAME', 'bottom_k_sample_serialize'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+-- bottom_k_sample: deserialize a partial state
+CREATE OR REPLACE FUNCTION bottom_k_sample_deserialize(bytea, internal)
+RETURNS internal
+AS 'MODULE_PATHNAME', 'bottom_k_sample_deserialize'
+LANGUAGE C IMMUTABLE STRICT PARALLEL SAFE;
+
+-- bottom_k_sample: the sample in order of hash (NULL when there were no values)
+CREATE OR REPLACE FUNCTION bottom_k_sample_final(internal, anyelement, integer, bigint)
+RETURNS anyarray
+AS 'MODULE_PATHNAME', 'bottom_k_sample_final'
+LANGUAGE C IMMUTABLE PARALLEL SAFE;
+
+-- The k distinct values with the smallest xxhash3_64 with the seed, as hash_sample hashes them
+CREATE AGGREGATE bottom_k_sample(anyelement, integer, bigint) (
+    SFUNC = bottom_k_sample_transfn,
+    STYPE = internal,
+    FINALFUNC = bottom_k_sample_final,
+    FINALFUNC_EXTRA,
+    COMBINEFUNC = bottom_k_sample_combine,
+    SERIALFUNC = bottom_k_sample_serialize,
+    DESERIALFUNC = bottom_k_sample_deserialize,
+    PARALLEL = SAFE
+);
+
+-- Position of i in a pseudorandom permutation of [0, n) by a Feistel network on xxhash3_64
+CREATE OR REPLACE FUNCTION hash_permute(bigint, bigint, bigint)
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'hash_permute'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- Inverse of hash_permute: the i at position j
+CREATE OR REPLACE FUNCTION hash_permute_inverse(bigint, bigint, bigint)
+RETURNS bigint
+AS 'MODULE_PATHNAME', 'hash_permute_inverse'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- hash_permute(i, n, seed) for every i in [0, n)
+CREATE OR REPLACE FUNCTION hash_permute_series(bigint, bigint)
+RETURNS SETOF bigint
+AS 'MODULE_PATHNAME', 'hash_permute_series'
+LANGUAGE C IMMUTABLE STRICT;
+
+-- hash_permute(i, n, seed) for count values of i from start
+CREATE OR REPLACE FUNCTION hash_permute_series(bigint, bigint, bigint, bigint)
+RETURNS SETOF bigint
+AS 'MODULE_PATHNAME', 'hash_permute_series'
+LANGUAGE C IMMUTABLE STRICT;
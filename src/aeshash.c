@@ -0,0 +1,622 @@
+#include "postgres.h"
+#include "fmgr.h"
+#include "utils/builtins.h"
+#include "utils/array.h"
+#include "catalog/pg_type.h"
+#include "mb/pg_wchar.h"
+#include "access/htup_details.h"
+
+/* AES-round based hash (aeshash) implementation
+ * In the style of gxhash and aHash: every 16 bytes of input are absorbed over
+ * four independent 128-bit lanes with two AES encryption rounds (SubBytes,
+ * ShiftRows, MixColumns, then a round key XORed in): the first takes the input
+ * block as its round key and the second the lane's seeded initial value.
+ *
+ * A single round per block is not enough.  A difference in one byte of a block
+ * leaves the round as a one-byte difference, which the next block absorbed
+ * into the same lane sees after only SubBytes and MixColumns: a four-byte
+ * column difference that takes one of 255 values, whichever the seed.  Trying
+ * those 255 values in the next block finds a collision for every seed.  With
+ * the second round the difference covers the whole state before the next
+ * block is XORed in.
+ *
+ * The kernel is selected at runtime, the same way PostgreSQL picks its CRC-32C
+ * implementation: the first call resolves a function pointer to the AES-NI
+ * kernel (x86-64), the ARMv8 Crypto Extensions kernel (arm64 builds with the
+ * crypto extension enabled) or the portable kernel.  The portable kernel is a
+ * byte-wise software AES round and produces bit-identical output on every
+ * platform, including big-endian ones.
+ */
+
+#if (defined(__x86_64__) || defined(_M_AMD64)) && (defined(__GNUC__) || defined(__clang__))
+#define AESHASH_USE_X86 1
+#include <cpuid.h>
+#include <wmmintrin.h>
+#endif
+
+#if defined(__aarch64__) && (defined(__ARM_FEATURE_AES) || defined(__ARM_FEATURE_CRYPTO))
+#define AESHASH_USE_ARM 1
+#include <arm_neon.h>
+#endif
+
+/* Lane initialisation vectors (hexadecimal digits of pi) */
+static const uint64_t aeshash_iv[8] = {
+    0x243F6A8885A308D3ULL, 0x13198A2E03707344ULL,
+    0xA4093822299F31D0ULL, 0x082EFA98EC4E6C89ULL,
+    0x452821E638D01377ULL, 0xBE5466CF34E90C6CULL,
+    0xC0AC29B7C97C50DDULL, 0x3F84D5B5B5470917ULL
+};
+
+/* Finalisation round keys (hexadecimal digits of e) */
+static const uint64_t aeshash_fk[6] = {
+    0xB7E151628AED2A6AULL, 0xBF7158809CF4F3C7ULL,
+    0x62E7160F38B4DA56ULL, 0xA784D9045190CFEFULL,
+    0x324E7738926CFBE5ULL, 0xF4BF8D8D8C31D763ULL
+};
+
+/* 128-bit result structure */
+typedef struct {
+    uint64_t low;
+    uint64_t high;
+} aeshash128_t;
+
+typedef aeshash128_t (*aeshash_fn) (const uint8_t *p, size_t len, uint64_t seed);
+
+/* Portable kernel */
+
+/* AES S-box */
+static const uint8_t aes_sbox[256] = {
+    0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76,
+    0xca, 0x82, 0xc9, 0x7d, 0xfa, 0x59, 0x47, 0xf0, 0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0,
+    0xb7, 0xfd, 0x93, 0x26, 0x36, 0x3f, 0xf7, 0xcc, 0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15,
+    0x04, 0xc7, 0x23, 0xc3, 0x18, 0x96, 0x05, 0x9a, 0x07, 0x12, 0x80, 0xe2, 0xeb, 0x27, 0xb2, 0x75,
+    0x09, 0x83, 0x2c, 0x1a, 0x1b, 0x6e, 0x5a, 0xa0, 0x52, 0x3b, 0xd6, 0xb3, 0x29, 0xe3, 0x2f, 0x84,
+    0x53, 0xd1, 0x00, 0xed, 0x20, 0xfc, 0xb1, 0x5b, 0x6a, 0xcb, 0xbe, 0x39, 0x4a, 0x4c, 0x58, 0xcf,
+    0xd0, 0xef, 0xaa, 0xfb, 0x43, 0x4d, 0x33, 0x85, 0x45, 0xf9, 0x02, 0x7f, 0x50, 0x3c, 0x9f, 0xa8,
+    0x51, 0xa3, 0x40, 0x8f, 0x92, 0x9d, 0x38, 0xf5, 0xbc, 0xb6, 0xda, 0x21, 0x10, 0xff, 0xf3, 0xd2,
+    0xcd, 0x0c, 0x13, 0xec, 0x5f, 0x97, 0x44, 0x17, 0xc4, 0xa7, 0x7e, 0x3d, 0x64, 0x5d, 0x19, 0x73,
+    0x60, 0x81, 0x4f, 0xdc, 0x22, 0x2a, 0x90, 0x88, 0x46, 0xee, 0xb8, 0x14, 0xde, 0x5e, 0x0b, 0xdb,
+    0xe0, 0x32, 0x3a, 0x0a, 0x49, 0x06, 0x24, 0x5c, 0xc2, 0xd3, 0xac, 0x62, 0x91, 0x95, 0xe4, 0x79,
+    0xe7, 0xc8, 0x37, 0x6d, 0x8d, 0xd5, 0x4e, 0xa9, 0x6c, 0x56, 0xf4, 0xea, 0x65, 0x7a, 0xae, 0x08,
+    0xba, 0x78, 0x25, 0x2e, 0x1c, 0xa6, 0xb4, 0xc6, 0xe8, 0xdd, 0x74, 0x1f, 0x4b, 0xbd, 0x8b, 0x8a,
+    0x70, 0x3e, 0xb5, 0x66, 0x48, 0x03, 0xf6, 0x0e, 0x61, 0x35, 0x57, 0xb9, 0x86, 0xc1, 0x1d, 0x9e,
+    0xe1, 0xf8, 0x98, 0x11, 0x69, 0xd9, 0x8e, 0x94, 0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf,
+    0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68, 0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16
+};
+
+typedef struct {
+    uint8_t b[16];
+} aes_block;
+
+static inline uint8_t
+aes_xtime(uint8_t x)
+{
+    return (uint8_t)((x << 1) ^ ((x & 0x80) ? 0x1b : 0x00));
+}
+
+/* One AES encryption round, equivalent to _mm_aesenc_si128(s, k) */
+static inline void
+aes_round_soft(aes_block *s, const aes_block *k)
+{
+    uint8_t t[16];
+    int c;
+
+    /* SubBytes and ShiftRows: row r of column c comes from column c + r */
+    for (c = 0; c < 4; c++)
+    {
+        t[4 * c + 0] = aes_sbox[s->b[4 * c + 0]];
+        t[4 * c + 1] = aes_sbox[s->b[4 * ((c + 1) & 3) + 1]];
+        t[4 * c + 2] = aes_sbox[s->b[4 * ((c + 2) & 3) + 2]];
+        t[4 * c + 3] = aes_sbox[s->b[4 * ((c + 3) & 3) + 3]];
+    }
+
+    /* MixColumns and AddRoundKey */
+    for (c = 0; c < 4; c++)
+    {
+        uint8_t a0 = t[4 * c + 0], a1 = t[4 * c + 1], a2 = t[4 * c + 2], a3 = t[4 * c + 3];
+        uint8_t all = a0 ^ a1 ^ a2 ^ a3;
+
+        s->b[4 * c + 0] = a0 ^ all ^ aes_xtime(a0 ^ a1) ^ k->b[4 * c + 0];
+        s->b[4 * c + 1] = a1 ^ all ^ aes_xtime(a1 ^ a2) ^ k->b[4 * c + 1];
+        s->b[4 * c + 2] = a2 ^ all ^ aes_xtime(a2 ^ a3) ^ k->b[4 * c + 2];
+        s->b[4 * c + 3] = a3 ^ all ^ aes_xtime(a3 ^ a0) ^ k->b[4 * c + 3];
+    }
+}
+
+/* Absorb one input block into a lane: a round keyed by the block, then one
+ * keyed by the lane's seeded initial value */
+static inline void
+aes_absorb_soft(aes_block *s, const aes_block *blk, const aes_block *key)
+{
+    aes_round_soft(s, blk);
+    aes_round_soft(s, key);
+}
+
+/* Little-endian conversions so the portable kernel matches the SIMD lanes */
+static inline void
+aes_block_set64(aes_block *blk, uint64_t lo, uint64_t hi)
+{
+    int i;
+
+    for (i = 0; i < 8; i++)
+    {
+        blk->b[i] = (uint8_t)(lo >> (8 * i));
+        blk->b[8 + i] = (uint8_t)(hi >> (8 * i));
+    }
+}
+
+static inline uint64_t
+aes_block_get64(const aes_block *blk, int half)
+{
+    uint64_t v = 0;
+    int i;
+
+    for (i = 7; i >= 0; i--)
+        v = (v << 8) | blk->b[8 * half + i];
+    return v;
+}
+
+static inline void
+aes_block_xor(aes_block *dst, const aes_block *src)
+{
+    int i;
+
+    for (i = 0; i < 16; i++)
+        dst->b[i] ^= src->b[i];
+}
+
+static aeshash128_t
+aeshash_portable(const uint8_t *p, size_t len, uint64_t seed)
+{
+    const uint8_t *end = p + len;
+    size_t n = len;
+    aes_block s[4], key[4], seedv, blk, f;
+    aeshash128_t result;
+    int i;
+
+    aes_block_set64(&seedv, seed, (uint64_t)len);
+    for (i = 0; i < 4; i++)
+    {
+        aes_block_set64(&key[i], aeshash_iv[2 * i], aeshash_iv[2 * i + 1]);
+        aes_block_xor(&key[i], &seedv);
+        s[i] = key[i];
+    }
+
+    /* Bulk loop: 64 bytes per iteration, one lane per 16 bytes */
+    while (n >= 64)
+    {
+        for (i = 0; i < 4; i++)
+        {
+            memcpy(blk.b, p + 16 * i, 16);
+            aes_absorb_soft(&s[i], &blk, &key[i]);
+        }
+        p += 64;
+        n -= 64;
+    }
+
+    /* Remaining whole 16-byte chunks */
+    i = 0;
+    while (n > 16)
+    {
+        memcpy(blk.b, p, 16);
+        aes_absorb_soft(&s[i], &blk, &key[i]);
+        i++;
+        p += 16;
+        n -= 16;
+    }
+
+    /* Final 1-16 bytes: overlapping load, or zero padding for short input */
+    if (n > 0)
+    {
+        if (len >= 16)
+            memcpy(blk.b, end - 16, 16);
+        else
+        {
+            memset(blk.b, 0, 16);
+            memcpy(blk.b, p, n);
+        }
+        aes_absorb_soft(&s[3], &blk, &key[3]);
+    }
+
+    /* Fold the lanes together and finish with three keyed rounds */
+    aes_round_soft(&s[0], &s[1]);
+    aes_round_soft(&s[2], &s[3]);
+    aes_round_soft(&s[0], &s[2]);
+    for (i = 0; i < 3; i++)
+    {
+        aes_block_set64(&f, aeshash_fk[2 * i] ^ seed, aeshash_fk[2 * i + 1] ^ ~seed);
+        aes_round_soft(&s[0], &f);
+    }
+
+    result.low = aes_block_get64(&s[0], 0);
+    result.high = aes_block_get64(&s[0], 1);
+    return result;
+}
+
+#ifdef AESHASH_USE_X86
+/* AES-NI kernel */
+__attribute__((target("aes,sse2")))
+static inline __m128i
+aes_absorb_x86(__m128i s, __m128i blk, __m128i key)
+{
+    return _mm_aesenc_si128(_mm_aesenc_si128(s, blk), key);
+}
+
+__attribute__((target("aes,sse2")))
+static aeshash128_t
+aeshash_aesni(const uint8_t *p, size_t len, uint64_t seed)
+{
+    const uint8_t *end = p + len;
+    size_t n = len;
+    __m128i s[4], key[4], seedv, blk;
+    aeshash128_t result;
+    int i;
+
+    seedv = _mm_set_epi64x((long long)len, (long long)seed);
+    for (i = 0; i < 4; i++)
+    {
+        key[i] = _mm_xor_si128(_mm_set_epi64x((long long)aeshash_iv[2 * i + 1],
+                                              (long long)aeshash_iv[2 * i]), seedv);
+        s[i] = key[i];
+    }
+
+    while (n >= 64)
+    {
+        s[0] = aes_absorb_x86(s[0], _mm_loadu_si128((const __m128i *)(p)), key[0]);
+        s[1] = aes_absorb_x86(s[1], _mm_loadu_si128((const __m128i *)(p + 16)), key[1]);
+        s[2] = aes_absorb_x86(s[2], _mm_loadu_si128((const __m128i *)(p + 32)), key[2]);
+        s[3] = aes_absorb_x86(s[3], _mm_loadu_si128((const __m128i *)(p + 48)), key[3]);
+        p += 64;
+        n -= 64;
+    }
+
+    i = 0;
+    while (n > 16)
+    {
+        s[i] = aes_absorb_x86(s[i], _mm_loadu_si128((const __m128i *)p), key[i]);
+        i++;
+        p += 16;
+        n -= 16;
+    }
+
+    if (n > 0)
+    {
+        if (len >= 16)
+            blk = _mm_loadu_si128((const __m128i *)(end - 16));
+        else
+        {
+            uint8_t tmp[16];
+            memset(tmp, 0, 16);
+            memcpy(tmp, p, n);
+            blk = _mm_loadu_si128((const __m128i *)tmp);
+        }
+        s[3] = aes_absorb_x86(s[3], blk, key[3]);
+    }
+
+    s[0] = _mm_aesenc_si128(s[0], s[1]);
+    s[2] = _mm_aesenc_si128(s[2], s[3]);
+    s[0] = _mm_aesenc_si128(s[0], s[2]);
+    for (i = 0; i < 3; i++)
+        s[0] = _mm_aesenc_si128(s[0], _mm_set_epi64x((long long)(aeshash_fk[2 * i + 1] ^ ~seed),
+                                                     (long long)(aeshash_fk[2 * i] ^ seed)));
+
+    _mm_storeu_si128((__m128i *)&result, s[0]);
+    return result;
+}
+#endif
+
+#ifdef AESHASH_USE_ARM
+/* ARMv8 Crypto Extensions kernel: AESE with a zero key followed by AESMC is
+ * SubBytes/ShiftRows/MixColumns, so XORing the key afterwards gives AESENC. */
+static inline uint8x16_t
+aes_round_arm(uint8x16_t s, uint8x16_t k)
+{
+    return veorq_u8(vaesmcq_u8(vaeseq_u8(s, vdupq_n_u8(0))), k);
+}
+
+static inline uint8x16_t
+aes_absorb_arm(uint8x16_t s, uint8x16_t blk, uint8x16_t key)
+{
+    return aes_round_arm(aes_round_arm(s, blk), key);
+}
+
+static inline uint8x16_t
+aes_set64_arm(uint64_t lo, uint64_t hi)
+{
+    return vreinterpretq_u8_u64(vcombine_u64(vcreate_u64(lo), vcreate_u64(hi)));
+}
+
+static aeshash128_t
+aeshash_armv8(const uint8_t *p, size_t len, uint64_t seed)
+{
+    const uint8_t *end = p + len;
+    size_t n = len;
+    uint8x16_t s[4], key[4], seedv, blk;
+    aeshash128_t result;
+    int i;
+
+    seedv = aes_set64_arm(seed, (uint64_t)len);
+    for (i = 0; i < 4; i++)
+    {
+        key[i] = veorq_u8(aes_set64_arm(aeshash_iv[2 * i], aeshash_iv[2 * i + 1]), seedv);
+        s[i] = key[i];
+    }
+
+    while (n >= 64)
+    {
+        s[0] = aes_absorb_arm(s[0], vld1q_u8(p), key[0]);
+        s[1] = aes_absorb_arm(s[1], vld1q_u8(p + 16), key[1]);
+        s[2] = aes_absorb_arm(s[2], vld1q_u8(p + 32), key[2]);
+        s[3] = aes_absorb_arm(s[3], vld1q_u8(p + 48), key[3]);
+        p += 64;
+        n -= 64;
+    }
+
+    i = 0;
+    while (n > 16)
+    {
+        s[i] = aes_absorb_arm(s[i], vld1q_u8(p), key[i]);
+        i++;
+        p += 16;
+        n -= 16;
+    }
+
+    if (n > 0)
+    {
+        if (len >= 16)
+            blk = vld1q_u8(end - 16);
+        else
+        {
+            uint8_t tmp[16];
+            memset(tmp, 0, 16);
+            memcpy(tmp, p, n);
+            blk = vld1q_u8(tmp);
+        }
+        s[3] = aes_absorb_arm(s[3], blk, key[3]);
+    }
+
+    s[0] = aes_round_arm(s[0], s[1]);
+    s[2] = aes_round_arm(s[2], s[3]);
+    s[0] = aes_round_arm(s[0], s[2]);
+    for (i = 0; i < 3; i++)
+        s[0] = aes_round_arm(s[0], aes_set64_arm(aeshash_fk[2 * i] ^ seed,
+                                                 aeshash_fk[2 * i + 1] ^ ~seed));
+
+    result.low = vgetq_lane_u64(vreinterpretq_u64_u8(s[0]), 0);
+    result.high = vgetq_lane_u64(vreinterpretq_u64_u8(s[0]), 1);
+    return result;
+}
+#endif
+
+/* Runtime kernel selection */
+static aeshash128_t aeshash_choose(const uint8_t *p, size_t len, uint64_t seed);
+
+static aeshash_fn aeshash_impl = aeshash_choose;
+static const char *aeshash_impl_name = "portable";
+
+static void
+aeshash_select(void)
+{
+#ifdef AESHASH_USE_X86
+    unsigned int eax, ebx, ecx, edx;
+
+    if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & bit_AES))
+    {
+        aeshash_impl = aeshash_aesni;
+        aeshash_impl_name = "aesni";
+        return;
+    }
+#endif
+#ifdef AESHASH_USE_ARM
+    aeshash_impl = aeshash_armv8;
+    aeshash_impl_name = "armv8-crypto";
+    return;
+#endif
+    aeshash_impl = aeshash_portable;
+    aeshash_impl_name = "portable";
+}
+
+static aeshash128_t
+aeshash_choose(const uint8_t *p, size_t len, uint64_t seed)
+{
+    aeshash_select();
+    return aeshash_impl(p, len, seed);
+}
+
+static inline aeshash128_t
+aeshash(const void *data, size_t len, uint64_t seed)
+{
+    return aeshash_impl((const uint8_t *)data, len, seed);
+}
+
+/* PostgreSQL function wrappers */
+
+/* Build the bigint[2] result of the 128-bit variants */
+static ArrayType *
+aeshash128_array(aeshash128_t hash)
+{
+    Datum elems[2];
+
+    elems[0] = Int64GetDatum((int64_t)hash.low);
+    elems[1] = Int64GetDatum((int64_t)hash.high);
+
+    return construct_array(elems, 2, INT8OID, 8, true, 'd');
+}
+
+/* aeshash64(text) -> bigint */
+PG_FUNCTION_INFO_V1(aeshash64_text);
+Datum
+aeshash64_text(PG_FUNCTION_ARGS)
+{
+    text *input = PG_GETARG_TEXT_PP(0);
+    aeshash128_t hash = aeshash(VARDATA_ANY(input), VARSIZE_ANY_EXHDR(input), 0);
+    PG_RETURN_INT64((int64_t)hash.low);
+}
+
+/* aeshash64(text, bigint) -> bigint */
+PG_FUNCTION_INFO_V1(aeshash64_text_seed);
+Datum
+aeshash64_text_seed(PG_FUNCTION_ARGS)
+{
+    text *input = PG_GETARG_TEXT_PP(0);
+    uint64_t seed = (uint64_t)PG_GETARG_INT64(1);
+    aeshash128_t hash = aeshash(VARDATA_ANY(input), VARSIZE_ANY_EXHDR(input), seed);
+    PG_RETURN_INT64((int64_t)hash.low);
+}
+
+/* aeshash64(bytea) -> bigint */
+PG_FUNCTION_INFO_V1(aeshash64_bytea);
+Datum
+aeshash64_bytea(PG_FUNCTION_ARGS)
+{
+    bytea *input = PG_GETARG_BYTEA_PP(0);
+    aeshash128_t hash = aeshash(VARDATA_ANY(input), VARSIZE_ANY_EXHDR(input), 0);
+    PG_RETURN_INT64((int64_t)hash.low);
+}
+
+/* aeshash64(bytea, bigint) -> bigint */
+PG_FUNCTION_INFO_V1(aeshash64_bytea_seed);
+Datum
+aeshash64_bytea_seed(PG_FUNCTION_ARGS)
+{
+    bytea *input = PG_GETARG_BYTEA_PP(0);
+    uint64_t seed = (uint64_t)PG_GETARG_INT64(1);
+    aeshash128_t hash = aeshash(VARDATA_ANY(input), VARSIZE_ANY_EXHDR(input), seed);
+    PG_RETURN_INT64((int64_t)hash.low);
+}
+
+/* aeshash64(integer) -> bigint */
+PG_FUNCTION_INFO_V1(aeshash64_int4);
+Datum
+aeshash64_int4(PG_FUNCTION_ARGS)
+{
+    int32 val = PG_GETARG_INT32(0);
+    aeshash128_t hash = aeshash(&val, sizeof(int32), 0);
+    PG_RETURN_INT64((int64_t)hash.low);
+}
+
+/* aeshash64(integer, bigint) -> bigint */
+PG_FUNCTION_INFO_V1(aeshash64_int4_seed);
+Datum
+aeshash64_int4_seed(PG_FUNCTION_ARGS)
+{
+    int32 val = PG_GETARG_INT32(0);
+    uint64_t seed = (uint64_t)PG_GETARG_INT64(1);
+    aeshash128_t hash = aeshash(&val, sizeof(int32), seed);
+    PG_RETURN_INT64((int64_t)hash.low);
+}
+
+/* aeshash64(bigint) -> bigint */
+PG_FUNCTION_INFO_V1(aeshash64_int8);
+Datum
+aeshash64_int8(PG_FUNCTION_ARGS)
+{
+    int64 val = PG_GETARG_INT64(0);
+    aeshash128_t hash = aeshash(&val, sizeof(int64), 0);
+    PG_RETURN_INT64((int64_t)hash.low);
+}
+
+/* aeshash64(bigint, bigint) -> bigint */
+PG_FUNCTION_INFO_V1(aeshash64_int8_seed);
+Datum
+aeshash64_int8_seed(PG_FUNCTION_ARGS)
+{
+    int64 val = PG_GETARG_INT64(0);
+    uint64_t seed = (uint64_t)PG_GETARG_INT64(1);
+    aeshash128_t hash = aeshash(&val, sizeof(int64), seed);
+    PG_RETURN_INT64((int64_t)hash.low);
+}
+
+/* aeshash128(text) -> bigint[] */
+PG_FUNCTION_INFO_V1(aeshash128_text);
+Datum
+aeshash128_text(PG_FUNCTION_ARGS)
+{
+    text *input = PG_GETARG_TEXT_PP(0);
+    aeshash128_t hash = aeshash(VARDATA_ANY(input), VARSIZE_ANY_EXHDR(input), 0);
+    PG_RETURN_ARRAYTYPE_P(aeshash128_array(hash));
+}
+
+/* aeshash128(text, bigint) -> bigint[] */
+PG_FUNCTION_INFO_V1(aeshash128_text_seed);
+Datum
+aeshash128_text_seed(PG_FUNCTION_ARGS)
+{
+    text *input = PG_GETARG_TEXT_PP(0);
+    uint64_t seed = (uint64_t)PG_GETARG_INT64(1);
+    aeshash128_t hash = aeshash(VARDATA_ANY(input), VARSIZE_ANY_EXHDR(input), seed);
+    PG_RETURN_ARRAYTYPE_P(aeshash128_array(hash));
+}
+
+/* aeshash128(bytea) -> bigint[] */
+PG_FUNCTION_INFO_V1(aeshash128_bytea);
+Datum
+aeshash128_bytea(PG_FUNCTION_ARGS)
+{
+    bytea *input = PG_GETARG_BYTEA_PP(0);
+    aeshash128_t hash = aeshash(VARDATA_ANY(input), VARSIZE_ANY_EXHDR(input), 0);
+    PG_RETURN_ARRAYTYPE_P(aeshash128_array(hash));
+}
+
+/* aeshash128(bytea, bigint) -> bigint[] */
+PG_FUNCTION_INFO_V1(aeshash128_bytea_seed);
+Datum
+aeshash128_bytea_seed(PG_FUNCTION_ARGS)
+{
+    bytea *input = PG_GETARG_BYTEA_PP(0);
+    uint64_t seed = (uint64_t)PG_GETARG_INT64(1);
+    aeshash128_t hash = aeshash(VARDATA_ANY(input), VARSIZE_ANY_EXHDR(input), seed);
+    PG_RETURN_ARRAYTYPE_P(aeshash128_array(hash));
+}
+
+/* aeshash128(integer) -> bigint[] */
+PG_FUNCTION_INFO_V1(aeshash128_int4);
+Datum
+aeshash128_int4(PG_FUNCTION_ARGS)
+{
+    int32 val = PG_GETARG_INT32(0);
+    aeshash128_t hash = aeshash(&val, sizeof(int32), 0);
+    PG_RETURN_ARRAYTYPE_P(aeshash128_array(hash));
+}
+
+/* aeshash128(integer, bigint) -> bigint[] */
+PG_FUNCTION_INFO_V1(aeshash128_int4_seed);
+Datum
+aeshash128_int4_seed(PG_FUNCTION_ARGS)
+{
+    int32 val = PG_GETARG_INT32(0);
+    uint64_t seed = (uint64_t)PG_GETARG_INT64(1);
+    aeshash128_t hash = aeshash(&val, sizeof(int32), seed);
+    PG_RETURN_ARRAYTYPE_P(aeshash128_array(hash));
+}
+
+/* aeshash128(bigint) -> bigint[] */
+PG_FUNCTION_INFO_V1(aeshash128_int8);
+Datum
+aeshash128_int8(PG_FUNCTION_ARGS)
+{
+    int64 val = PG_GETARG_INT64(0);
+    aeshash128_t hash = aeshash(&val, sizeof(int64), 0);
+    PG_RETURN_ARRAYTYPE_P(aeshash128_array(hash));
+}
+
+/* aeshash128(bigint, bigint) -> bigint[] */
+PG_FUNCTION_INFO_V1(aeshash128_int8_seed);
+Datum
+aeshash128_int8_seed(PG_FUNCTION_ARGS)
+{
+    int64 val = PG_GETARG_INT64(0);
+    uint64_t seed = (uint64_t)PG_GETARG_INT64(1);
+    aeshash128_t hash = aeshash(&val, sizeof(int64), seed);
+    PG_RETURN_ARRAYTYPE_P(aeshash128_array(hash));
+}
+
+/* aeshash_implementation() -> text: name of the kernel selected for this CPU */
+PG_FUNCTION_INFO_V1(aeshash_implementation);
+Datum
+aeshash_implementation(PG_FUNCTION_ARGS)
+{
+    if (aeshash_impl == aeshash_choose)
+        aeshash_select();
+    PG_RETURN_TEXT_P(cstring_to_text(aeshash_impl_name));
+}
@@ -0,0 +1,595 @@
+#include "postgres.h"
+#include "fmgr.h"
+#include "utils/builtins.h"
+#include "utils/array.h"
+#include "libpq/pqformat.h"
+
+#include <math.h>
+
+#include "hashlib_datum.h"
+#include "hashlib_sketch.h"
+
+/*
+ * Split-block Bloom filter for approximate set membership.
+ *
+ * The filter is an array of 256-bit blocks, each eight 32-bit words.  A value
+ * is hashed once with xxhash3_64 over its canonical bytes (see
+ * hashlib_datum.h).  The top 32 bits choose the block and the low 32 bits set
+ * one bit in each of its eight words, the bit of word i being the top five
+ * bits of key * SALT[i].  This is the design of the Parquet and Impala filters:
+ * a probe touches one cache line, and the eight word tests are independent,
+ * so they map onto one AVX2 compare.
+ *
+ * A value is never reported absent once added; the chance that an absent
+ * value is reported present is the false positive probability (fpp) the
+ * filter was sized for, provided no more than expected_n values were added.
+ *
+ * Stored layout (integers little-endian):
+ *
+ *   byte 0       format version (1)
+ *   bytes 1-3    reserved (0)
+ *   bytes 4-7    number of blocks
+ *   then         blocks of eight 32-bit words
+ */
+
+#if (defined(__x86_64__) || defined(_M_AMD64)) && (defined(__GNUC__) || defined(__clang__))
+#define BLOOM_USE_AVX2 1
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define bloom_prefetch(p)   __builtin_prefetch(p)
+#else
+#define bloom_prefetch(p)   ((void) 0)
+#endif
+
+#define BLOOM_VERSION           1
+#define BLOOM_HEADER_SIZE       8
+#define BLOOM_BLOCK_WORDS       8
+#define BLOOM_BLOCK_SIZE        32
+#define BLOOM_MAX_BLOCKS        (1 << 24)
+
+/* How many blocks ahead of the probe to prefetch */
+#define BLOOM_PREFETCH_DISTANCE 8
+
+static const uint32 bloom_salt[BLOOM_BLOCK_WORDS] = {
+    0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+    0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U
+};
+
+typedef struct BloomState
+{
+    uint32      nblocks;
+    uint32     *words;          /* nblocks * 8 words */
+} BloomState;
+
+/*
+ * False positive probability of a filter holding on average lambda values per
+ * block: the block loads are Poisson distributed, and a block holding j values
+ * has each bit of a word set with probability 1 - (31/32)^j.  The uneven loads
+ * make this higher than the fpp of a classic Bloom filter of the same size.
+ */
+static float8
+bloom_fpp(float8 lambda)
+{
+    float8 fpp = 0.0;
+    int first = (int) Max(lambda - 12.0 * sqrt(lambda) - 32.0, 0.0);
+    int last = (int) (lambda + 12.0 * sqrt(lambda)) + 32;
+    int j;
+
+    /* the Poisson terms in log space, which do not underflow for large lambda */
+    for (j = first; j <= last; j++)
+        fpp += exp(j * log(lambda) - lambda - lgamma(j + 1.0)) *
+            pow(1.0 - pow(31.0 / 32.0, j), BLOOM_BLOCK_WORDS);
+    return fpp;
+}
+
+/* The fewest blocks whose fpp for expected_n values is at most fpp */
+static uint32
+bloom_size_blocks(int64 expected_n, float8 fpp)
+{
+    float8 bits;
+    uint32 lo;
+    uint32 hi;
+
+    if (expected_n < 1)
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("bloom filter expected_n must be positive")));
+    if (!(fpp > 0.0 && fpp < 1.0))
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("bloom filter fpp must be between 0 and 1 exclusive")));
+
+    /* a classic Bloom filter with 8 hash functions is a lower bound */
+    bits = -8.0 * (float8) expected_n / log(1.0 - pow(fpp, 1.0 / BLOOM_BLOCK_WORDS));
+    if (bits / (BLOOM_BLOCK_SIZE * 8) > BLOOM_MAX_BLOCKS ||
+        bloom_fpp((float8) expected_n / BLOOM_MAX_BLOCKS) > fpp)
+        ereport(ERROR,
+                (errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+                 errmsg("bloom filter for %lld values at fpp %g would exceed %d blocks",
+                        (long long) expected_n, fpp, BLOOM_MAX_BLOCKS)));
+
+    lo = (uint32) Max(floor(bits / (BLOOM_BLOCK_SIZE * 8)), 1.0);
+    hi = BLOOM_MAX_BLOCKS;
+    while (lo < hi)
+    {
+        uint32 mid = lo + (hi - lo) / 2;
+
+        if (bloom_fpp((float8) expected_n / mid) <= fpp)
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+    return lo;
+}
+
+static BloomState *
+bloom_state_create(MemoryContext context, uint32 nblocks)
+{
+    BloomState *state = (BloomState *) MemoryContextAlloc(context, sizeof(BloomState));
+
+    state->nblocks = nblocks;
+    state->words = (uint32 *) MemoryContextAllocZero(context,
+                                                     (Size) nblocks * BLOOM_BLOCK_SIZE);
+    return state;
+}
+
+static inline uint32
+bloom_block(uint64 hash, uint32 nblocks)
+{
+    return hashlib_reduce32((uint32) (hash >> 32), nblocks);
+}
+
+static void
+bloom_state_add(BloomState *state, uint64 hash)
+{
+    uint32 *block = state->words + (Size) bloom_block(hash, state->nblocks) * BLOOM_BLOCK_WORDS;
+    uint32 key = (uint32) hash;
+    int i;
+
+    for (i = 0; i < BLOOM_BLOCK_WORDS; i++)
+        block[i] |= (uint32) 1 << ((key * bloom_salt[i]) >> 27);
+}
+
+static void
+bloom_state_merge(BloomState *state, const BloomState *other)
+{
+    Size n = (Size) state->nblocks * BLOOM_BLOCK_WORDS;
+    Size i;
+
+    if (state->nblocks != other->nblocks)
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("cannot merge bloom filters of different sizes (%u and %u blocks)",
+                        state->nblocks, other->nblocks)));
+
+    for (i = 0; i < n; i++)
+        state->words[i] |= other->words[i];
+}
+
+static bytea *
+bloom_state_serialize(const BloomState *state)
+{
+    Size n = (Size) state->nblocks * BLOOM_BLOCK_WORDS;
+    Size size = BLOOM_HEADER_SIZE + 4 * n;
+    bytea *result = (bytea *) palloc(VARHDRSZ + size);
+    uint8 *data;
+    Size i;
+
+    SET_VARSIZE(result, VARHDRSZ + size);
+    data = (uint8 *) VARDATA(result);
+    data[0] = BLOOM_VERSION;
+    data[1] = data[2] = data[3] = 0;
+    hashlib_write_le32(data + 4, state->nblocks);
+    for (i = 0; i < n; i++)
+        hashlib_write_le32(data + BLOOM_HEADER_SIZE + 4 * i, state->words[i]);
+    return result;
+}
+
+static void
+bloom_invalid(void)
+{
+    ereport(ERROR,
+            (errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+             errmsg("invalid bloom filter")));
+}
+
+static void
+bloom_validate(const bytea *filter)
+{
+    const uint8 *data = (const uint8 *) VARDATA_ANY(filter);
+    Size size = VARSIZE_ANY_EXHDR(filter);
+    uint32 nblocks;
+
+    if (size < BLOOM_HEADER_SIZE || data[0] != BLOOM_VERSION ||
+        data[1] != 0 || data[2] != 0 || data[3] != 0)
+        bloom_invalid();
+
+    nblocks = hashlib_read_le32(data + 4);
+    if (nblocks < 1 || nblocks > BLOOM_MAX_BLOCKS ||
+        size != BLOOM_HEADER_SIZE + (Size) nblocks * BLOOM_BLOCK_SIZE)
+        bloom_invalid();
+}
+
+static BloomState *
+bloom_state_load(MemoryContext context, const bytea *filter)
+{
+    const uint8 *data = (const uint8 *) VARDATA_ANY(filter);
+    BloomState *state = bloom_state_create(context, hashlib_read_le32(data + 4));
+    Size n = (Size) state->nblocks * BLOOM_BLOCK_WORDS;
+    Size i;
+
+    for (i = 0; i < n; i++)
+        state->words[i] = hashlib_read_le32(data + BLOOM_HEADER_SIZE + 4 * i);
+    return state;
+}
+
+static BloomState *
+bloom_getarg_state(FunctionCallInfo fcinfo, int argno)
+{
+    bytea *filter = PG_GETARG_BYTEA_PP(argno);
+
+    bloom_validate(filter);
+    return bloom_state_load(CurrentMemoryContext, filter);
+}
+
+/* fn_extra of the probe functions */
+typedef struct BloomCache
+{
+    HashlibTypeIO *io;
+    HashlibDetoastCache filter;
+} BloomCache;
+
+static BloomCache *
+bloom_cache(FunctionCallInfo fcinfo)
+{
+    if (fcinfo->flinfo->fn_extra == NULL)
+        fcinfo->flinfo->fn_extra = MemoryContextAllocZero(fcinfo->flinfo->fn_mcxt, sizeof(BloomCache));
+    return (BloomCache *) fcinfo->flinfo->fn_extra;
+}
+
+/* Hash of a non-null value of the type described by io */
+static uint64
+bloom_hash_value(HashlibTypeIO *io, Datum value)
+{
+    bytea *bytes = hashlib_value_bytes(io, value);
+    uint64 hash = hashlib_xxh3_64(VARDATA(bytes), VARSIZE(bytes) - VARHDRSZ);
+
+    pfree(bytes);
+    return hash;
+}
+
+/*
+ * Probe kernels: the index of the first of n hashes that may be in the
+ * filter whose stored blocks start at blocks, or -1 if none is.
+ */
+typedef int (*bloom_probe_fn) (const uint8 *blocks, uint32 nblocks, const uint64 *hashes, int n);
+
+static int
+bloom_probe_scalar(const uint8 *blocks, uint32 nblocks, const uint64 *hashes, int n)
+{
+    int j;
+
+    for (j = 0; j < n; j++)
+    {
+        const uint8 *block = blocks + (Size) bloom_block(hashes[j], nblocks) * BLOOM_BLOCK_SIZE;
+        uint32 key = (uint32) hashes[j];
+        int i;
+
+        if (j + BLOOM_PREFETCH_DISTANCE < n)
+            bloom_prefetch(blocks + (Size) bloom_block(hashes[j + BLOOM_PREFETCH_DISTANCE], nblocks) * BLOOM_BLOCK_SIZE);
+
+        for (i = 0; i < BLOOM_BLOCK_WORDS; i++)
+        {
+            uint32 bit = (uint32) 1 << ((key * bloom_salt[i]) >> 27);
+
+            if ((hashlib_read_le32(block + 4 * i) & bit) == 0)
+                break;
+        }
+        if (i == BLOOM_BLOCK_WORDS)
+            return j;
+    }
+    return -1;
+}
+
+#ifdef BLOOM_USE_AVX2
+/* The eight word tests of a probe as one 256-bit multiply, shift and test */
+__attribute__((target("avx2")))
+static int
+bloom_probe_avx2(const uint8 *blocks, uint32 nblocks, const uint64 *hashes, int n)
+{
+    const __m256i salt = _mm256_loadu_si256((const __m256i *) bloom_salt);
+    const __m256i ones = _mm256_set1_epi32(1);
+    int j;
+
+    for (j = 0; j < n; j++)
+    {
+        const uint8 *block = blocks + (Size) bloom_block(hashes[j], nblocks) * BLOOM_BLOCK_SIZE;
+        __m256i bits;
+
+        if (j + BLOOM_PREFETCH_DISTANCE < n)
+            bloom_prefetch(blocks + (Size) bloom_block(hashes[j + BLOOM_PREFETCH_DISTANCE], nblocks) * BLOOM_BLOCK_SIZE);
+
+        bits = _mm256_mullo_epi32(_mm256_set1_epi32((int) (uint32) hashes[j]), salt);
+        bits = _mm256_sllv_epi32(ones, _mm256_srli_epi32(bits, 27));
+        /* x86 is little-endian, so the stored words load as they are */
+        if (_mm256_testc_si256(_mm256_loadu_si256((const __m256i *) block), bits))
+            return j;
+    }
+    return -1;
+}
+#endif
+
+/* Runtime kernel selection */
+static int bloom_probe_choose(const uint8 *blocks, uint32 nblocks, const uint64 *hashes, int n);
+
+static bloom_probe_fn bloom_probe_impl = bloom_probe_choose;
+
+#ifdef BLOOM_USE_AVX2
+/* AVX2 in the CPU and 256-bit register state enabled by the OS */
+static bool
+bloom_have_avx2(void)
+{
+    unsigned int eax, ebx, ecx, edx;
+    uint32 xcr0_lo;
+    uint32 xcr0_hi;
+
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) ||
+        (ecx & (bit_OSXSAVE | bit_AVX)) != (bit_OSXSAVE | bit_AVX))
+        return false;
+    __asm__ __volatile__("xgetbv" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+    if ((xcr0_lo & 0x6) != 0x6)
+        return false;
+    return __get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) && (ebx & bit_AVX2);
+}
+#endif
+
+static int
+bloom_probe_choose(const uint8 *blocks, uint32 nblocks, const uint64 *hashes, int n)
+{
+#ifdef BLOOM_USE_AVX2
+    if (bloom_have_avx2())
+        bloom_probe_impl = bloom_probe_avx2;
+    else
+        bloom_probe_impl = bloom_probe_scalar;
+#else
+    bloom_probe_impl = bloom_probe_scalar;
+#endif
+    return bloom_probe_impl(blocks, nblocks, hashes, n);
+}
+
+/* bloom_in(cstring) -> bloom */
+PG_FUNCTION_INFO_V1(bloom_in);
+
+Datum
+bloom_in(PG_FUNCTION_ARGS)
+{
+    bytea *filter = (bytea *) hashlib_sketch_from_hex(PG_GETARG_CSTRING(0), "bloom");
+
+    bloom_validate(filter);
+    PG_RETURN_BYTEA_P(filter);
+}
+
+/* bloom_out(bloom) -> cstring */
+PG_FUNCTION_INFO_V1(bloom_out);
+
+Datum
+bloom_out(PG_FUNCTION_ARGS)
+{
+    PG_RETURN_CSTRING(hashlib_sketch_to_hex((struct varlena *) PG_GETARG_BYTEA_PP(0)));
+}
+
+/* bloom_recv(internal) -> bloom */
+PG_FUNCTION_INFO_V1(bloom_recv);
+
+Datum
+bloom_recv(PG_FUNCTION_ARGS)
+{
+    bytea *filter = (bytea *) hashlib_sketch_recv((StringInfo) PG_GETARG_POINTER(0));
+
+    bloom_validate(filter);
+    PG_RETURN_BYTEA_P(filter);
+}
+
+/* bloom_send(bloom) -> bytea */
+PG_FUNCTION_INFO_V1(bloom_send);
+
+Datum
+bloom_send(PG_FUNCTION_ARGS)
+{
+    bytea *filter = PG_GETARG_BYTEA_PP(0);
+    StringInfoData buf;
+
+    pq_begintypsend(&buf);
+    pq_sendbytes(&buf, VARDATA_ANY(filter), VARSIZE_ANY_EXHDR(filter));
+    PG_RETURN_BYTEA_P(pq_endtypsend(&buf));
+}
+
+/* bloom(bytea) -> bloom: checks the stored layout, for the bytea cast */
+PG_FUNCTION_INFO_V1(bloom_from_bytea);
+
+Datum
+bloom_from_bytea(PG_FUNCTION_ARGS)
+{
+    bytea *filter = PG_GETARG_BYTEA_P_COPY(0);
+
+    bloom_validate(filter);
+    PG_RETURN_BYTEA_P(filter);
+}
+
+/* bloom_contains(bloom, anyelement) -> boolean */
+PG_FUNCTION_INFO_V1(bloom_contains);
+
+Datum
+bloom_contains(PG_FUNCTION_ARGS)
+{
+    BloomCache *cache = bloom_cache(fcinfo);
+    const uint8 *data;
+    uint64 hash;
+
+    /* probe the stored blocks in place rather than loading the filter */
+    data = (const uint8 *) VARDATA_ANY(hashlib_sketch_getarg_cached(fcinfo, 0, &cache->filter,
+                                                                    bloom_validate));
+    hash = bloom_hash_value(hashlib_type_io(fcinfo->flinfo, hashlib_arg_type(fcinfo, 1), &cache->io),
+                            PG_GETARG_DATUM(1));
+    PG_RETURN_BOOL(bloom_probe_impl(data + BLOOM_HEADER_SIZE, hashlib_read_le32(data + 4),
+                                    &hash, 1) >= 0);
+}
+
+/*
+ * bloom_contains_any(bloom, anyarray) -> boolean
+ *
+ * Whether any non-null element may be in the filter.  All elements are
+ * hashed first and then probed in one pass, prefetching the blocks of later
+ * elements while the current one is tested.
+ */
+PG_FUNCTION_INFO_V1(bloom_contains_any);
+
+Datum
+bloom_contains_any(PG_FUNCTION_ARGS)
+{
+    ArrayType *array = PG_GETARG_ARRAYTYPE_P(1);
+    BloomCache *cache = bloom_cache(fcinfo);
+    HashlibTypeIO *io;
+    const uint8 *data;
+    Datum *elems;
+    bool *nulls;
+    uint64 *hashes;
+    int nelems;
+    int n = 0;
+    int i;
+
+    data = (const uint8 *) VARDATA_ANY(hashlib_sketch_getarg_cached(fcinfo, 0, &cache->filter,
+                                                                    bloom_validate));
+    io = hashlib_type_io(fcinfo->flinfo, ARR_ELEMTYPE(array), &cache->io);
+
+    deconstruct_array(array, io->typid, io->typlen, io->typbyval, io->typalign,
+                      &elems, &nulls, &nelems);
+    if (nelems == 0)
+        PG_RETURN_BOOL(false);
+
+    hashes = (uint64 *) palloc(sizeof(uint64) * nelems);
+    for (i = 0; i < nelems; i++)
+    {
+        if (!nulls[i])
+            hashes[n++] = bloom_hash_value(io, elems[i]);
+    }
+
+    PG_RETURN_BOOL(bloom_probe_impl(data + BLOOM_HEADER_SIZE, hashlib_read_le32(data + 4),
+                                    hashes, n) >= 0);
+}
+
+/* bloom_union(bloom, bloom) -> bloom: values in either filter */
+PG_FUNCTION_INFO_V1(bloom_union);
+
+Datum
+bloom_union(PG_FUNCTION_ARGS)
+{
+    BloomState *state = bloom_getarg_state(fcinfo, 0);
+
+    bloom_state_merge(state, bloom_getarg_state(fcinfo, 1));
+    PG_RETURN_BYTEA_P(bloom_state_serialize(state));
+}
+
+/* bloom_blocks(bloom) -> integer: number of 32-byte blocks */
+PG_FUNCTION_INFO_V1(bloom_blocks);
+
+Datum
+bloom_blocks(PG_FUNCTION_ARGS)
+{
+    bytea *filter = PG_GETARG_BYTEA_PP(0);
+
+    bloom_validate(filter);
+    PG_RETURN_INT32((int32) hashlib_read_le32((const uint8 *) VARDATA_ANY(filter) + 4));
+}
+
+/* bloom_agg_transfn(internal, anyelement, bigint, double precision) -> internal */
+PG_FUNCTION_INFO_V1(bloom_agg_transfn);
+
+Datum
+bloom_agg_transfn(PG_FUNCTION_ARGS)
+{
+    MemoryContext aggcontext;
+    BloomState *state;
+
+    if (!AggCheckCallContext(fcinfo, &aggcontext))
+        elog(ERROR, "bloom_agg_transfn called in non-aggregate context");
+
+    if (PG_ARGISNULL(0))
+    {
+        if (PG_ARGISNULL(2) || PG_ARGISNULL(3))
+            ereport(ERROR,
+                    (errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED),
+                     errmsg("bloom filter expected_n and fpp must not be null")));
+        state = bloom_state_create(aggcontext,
+                                   bloom_size_blocks(PG_GETARG_INT64(2), PG_GETARG_FLOAT8(3)));
+    }
+    else
+        state = (BloomState *) PG_GETARG_POINTER(0);
+
+    if (!PG_ARGISNULL(1))
+        bloom_state_add(state, bloom_hash_value(hashlib_arg_type_io(fcinfo, 1), PG_GETARG_DATUM(1)));
+
+    PG_RETURN_POINTER(state);
+}
+
+/* bloom_agg_combine(internal, internal) -> internal */
+PG_FUNCTION_INFO_V1(bloom_agg_combine);
+
+Datum
+bloom_agg_combine(PG_FUNCTION_ARGS)
+{
+    MemoryContext aggcontext;
+    BloomState *state;
+    BloomState *other;
+
+    if (!AggCheckCallContext(fcinfo, &aggcontext))
+        elog(ERROR, "bloom_agg_combine called in non-aggregate context");
+
+    if (PG_ARGISNULL(1))
+        PG_RETURN_POINTER(PG_ARGISNULL(0) ? NULL : PG_GETARG_POINTER(0));
+
+    other = (BloomState *) PG_GETARG_POINTER(1);
+    if (PG_ARGISNULL(0))
+        state = bloom_state_create(aggcontext, other->nblocks);
+    else
+        state = (BloomState *) PG_GETARG_POINTER(0);
+    bloom_state_merge(state, other);
+
+    PG_RETURN_POINTER(state);
+}
+
+/* bloom_agg_serialize(internal) -> bytea: the stored form */
+PG_FUNCTION_INFO_V1(bloom_agg_serialize);
+
+Datum
+bloom_agg_serialize(PG_FUNCTION_ARGS)
+{
+    PG_RETURN_BYTEA_P(bloom_state_serialize((BloomState *) PG_GETARG_POINTER(0)));
+}
+
+/* bloom_agg_deserialize(bytea, internal) -> internal */
+PG_FUNCTION_INFO_V1(bloom_agg_deserialize);
+
+Datum
+bloom_agg_deserialize(PG_FUNCTION_ARGS)
+{
+    if (!AggCheckCallContext(fcinfo, NULL))
+        elog(ERROR, "bloom_agg_deserialize called in non-aggregate context");
+
+    PG_RETURN_POINTER(bloom_getarg_state(fcinfo, 0));
+}
+
+/* bloom_agg_final(internal) -> bloom; NULL when there were no rows */
+PG_FUNCTION_INFO_V1(bloom_agg_final);
+
+Datum
+bloom_agg_final(PG_FUNCTION_ARGS)
+{
+    if (PG_ARGISNULL(0))
+        PG_RETURN_NULL();
+
+    PG_RETURN_BYTEA_P(bloom_state_serialize((BloomState *) PG_GETARG_POINTER(0)));
+}
@@ -0,0 +1,378 @@
+#include "postgres.h"
+#include "fmgr.h"
+#include "catalog/pg_type.h"
+#include "utils/array.h"
+#include "utils/datum.h"
+#include "utils/lsyscache.h"
+#include "utils/memutils.h"
+
+#include "hashlib_bucket.h"
+#include "hashlib_sketch.h"
+
+/*
+ * bottom_k_sample(value, k, seed): the k distinct values with the smallest
+ * xxhash3_64 with the seed, hashed as hash_sample hashes its key.
+ *
+ * The hash depends only on the value and the seed, so the samples of two
+ * tables with the same seed are coordinated: a key that is in the sample of
+ * both tables' keys is in each table's sample, and joins of samples keep
+ * their matches.  Values are kept as for the theta sketch, with their hash:
+ * values whose hash is below theta are appended to a buffer of up to 2k
+ * entries, which is sorted, deduplicated by hash and cut back to k when
+ * full, theta becoming the (k+1)-th smallest hash.  Values that are cut are
+ * freed, so a group holds at most 2k values.
+ *
+ * The partial states of a parallel aggregate are serialized with
+ * datumSerialize, which is only meant for other backends of the same
+ * server.
+ */
+
+#define BOTTOMK_MAX_K           (1 << 20)
+
+typedef struct BottomKEntry
+{
+    uint64      hash;
+    Datum       value;
+} BottomKEntry;
+
+typedef struct BottomKState
+{
+    Oid         typid;
+    int16       typlen;
+    bool        typbyval;
+    char        typalign;
+    int         k;
+    uint64      seed;
+    uint64      theta;          /* hashes at or above it are not kept */
+    BottomKEntry *entries;      /* sorted up to nsorted */
+    int         nentries;
+    int         nsorted;
+    int         capacity;
+    HashlibTypeIO *io;          /* for hashing values of other types */
+} BottomKState;
+
+static BottomKState *
+bottomk_state_create(MemoryContext context, Oid typid, int k, uint64 seed, int capacity)
+{
+    BottomKState *state = (BottomKState *) MemoryContextAllocZero(context, sizeof(BottomKState));
+
+    state->typid = typid;
+    get_typlenbyvalalign(typid, &state->typlen, &state->typbyval, &state->typalign);
+    state->k = k;
+    state->seed = seed;
+    state->theta = PG_UINT64_MAX;
+    state->capacity = Max(capacity, 1);
+    state->entries = (BottomKEntry *) MemoryContextAlloc(context, sizeof(BottomKEntry) * state->capacity);
+    return state;
+}
+
+static int
+bottomk_entry_cmp(const void *a, const void *b)
+{
+    uint64 x = ((const BottomKEntry *) a)->hash;
+    uint64 y = ((const BottomKEntry *) b)->hash;
+
+    return x < y ? -1 : x > y ? 1 : 0;
+}
+
+static void
+bottomk_entry_free(BottomKState *state, BottomKEntry *entry)
+{
+    if (!state->typbyval)
+        pfree(DatumGetPointer(entry->value));
+}
+
+/* Sort and deduplicate the entries, keep the k smallest and lower theta */
+static void
+bottomk_state_compact(BottomKState *state)
+{
+    int n = 0;
+    int i;
+
+    if (state->nsorted == state->nentries)
+        return;
+
+    qsort(state->entries, state->nentries, sizeof(BottomKEntry), bottomk_entry_cmp);
+    for (i = 0; i < state->nentries; i++)
+    {
+        if (state->entries[i].hash >= state->theta ||
+            (n > 0 && state->entries[n - 1].hash == state->entries[i].hash))
+            bottomk_entry_free(state, &state->entries[i]);
+        else
+            state->entries[n++] = state->entries[i];
+    }
+
+    if (n > state->k)
+    {
+        state->theta = state->entries[state->k].hash;
+        for (i = state->k; i < n; i++)
+            bottomk_entry_free(state, &state->entries[i]);
+        n = state->k;
+    }
+    state->nentries = n;
+    state->nsorted = n;
+}
+
+/* Whether an entry with this hash would be kept */
+static bool
+bottomk_state_wants(BottomKState *state, uint64 hash)
+{
+    if (hash >= state->theta)
+        return false;
+
+    if (state->nentries == state->capacity)
+    {
+        bottomk_state_compact(state);
+        /* a buffer that is mostly retained entries grows, up to twice k */
+        if (state->nentries > state->capacity / 2)
+        {
+            state->capacity = Min(state->capacity * 2, 2 * state->k);
+            state->entries = (BottomKEntry *) repalloc(state->entries,
+                                                       sizeof(BottomKEntry) * state->capacity);
+        }
+        if (hash >= state->theta)
+            return false;
+    }
+    return true;
+}
+
+/* Add value, which is already in the state's memory context */
+static void
+bottomk_state_add(BottomKState *state, uint64 hash, Datum value)
+{
+    state->entries[state->nentries].hash = hash;
+    state->entries[state->nentries].value = value;
+    state->nentries++;
+}
+
+/* Merge other into state, taking over other's values */
+static void
+bottomk_state_union(BottomKState *state, BottomKState *other)
+{
+    MemoryContext old = MemoryContextSwitchTo(GetMemoryChunkContext(state->entries));
+    int i;
+
+    bottomk_state_compact(other);
+    state->theta = Min(state->theta, other->theta);
+    for (i = 0; i < other->nentries; i++)
+    {
+        if (bottomk_state_wants(state, other->entries[i].hash))
+            bottomk_state_add(state, other->entries[i].hash,
+                              datumCopy(other->entries[i].value, state->typbyval, state->typlen));
+    }
+    /* apply the new theta to the entries that were already there */
+    state->nsorted = 0;
+    bottomk_state_compact(state);
+    MemoryContextSwitchTo(old);
+}
+
+static void
+bottomk_check_args(int32 k, BottomKState *state)
+{
+    if (k < 1 || k > BOTTOMK_MAX_K)
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("sample size must be between 1 and %d", BOTTOMK_MAX_K)));
+    if (state != NULL && k != state->k)
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("sample size must be the same for all rows of a group")));
+}
+
+/* bottom_k_sample_transfn(internal, anyelement, integer, bigint) -> internal */
+PG_FUNCTION_INFO_V1(bottom_k_sample_transfn);
+
+Datum
+bottom_k_sample_transfn(PG_FUNCTION_ARGS)
+{
+    MemoryContext aggcontext;
+    BottomKState *state = PG_ARGISNULL(0) ? NULL : (BottomKState *) PG_GETARG_POINTER(0);
+    Datum value;
+    uint64 hash;
+
+    if (!AggCheckCallContext(fcinfo, &aggcontext))
+        elog(ERROR, "bottom_k_sample_transfn called in non-aggregate context");
+
+    if (PG_ARGISNULL(2) || PG_ARGISNULL(3))
+        ereport(ERROR,
+                (errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED),
+                 errmsg("sample size and seed must not be null")));
+    bottomk_check_args(PG_GETARG_INT32(2), state);
+
+    if (state == NULL)
+    {
+        int32 k = PG_GETARG_INT32(2);
+
+        /* start small; the buffer grows towards 2k as values arrive */
+        state = bottomk_state_create(aggcontext, hashlib_arg_type(fcinfo, 1), k,
+                                     (uint64) PG_GETARG_INT64(3), Min(k, 64));
+    }
+    else if ((uint64) PG_GETARG_INT64(3) != state->seed)
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("seed must be the same for all rows of a group")));
+
+    if (PG_ARGISNULL(1))
+        PG_RETURN_POINTER(state);
+
+    hash = hashlib_bucket_value_hash_seed(fcinfo->flinfo, state->typid, &state->io,
+                                          PG_GETARG_DATUM(1), state->seed);
+    if (!bottomk_state_wants(state, hash))
+        PG_RETURN_POINTER(state);
+
+    /* copy the value into the aggregate context, detoasted as array_agg does */
+    value = PG_GETARG_DATUM(1);
+    if (!state->typbyval)
+    {
+        MemoryContext old = MemoryContextSwitchTo(aggcontext);
+
+        if (state->typlen == -1)
+            value = PointerGetDatum(PG_DETOAST_DATUM_COPY(value));
+        else
+            value = datumCopy(value, false, state->typlen);
+        MemoryContextSwitchTo(old);
+    }
+    bottomk_state_add(state, hash, value);
+
+    PG_RETURN_POINTER(state);
+}
+
+/* bottom_k_sample_combine(internal, internal) -> internal */
+PG_FUNCTION_INFO_V1(bottom_k_sample_combine);
+
+Datum
+bottom_k_sample_combine(PG_FUNCTION_ARGS)
+{
+    MemoryContext aggcontext;
+    BottomKState *state;
+    BottomKState *other;
+
+    if (!AggCheckCallContext(fcinfo, &aggcontext))
+        elog(ERROR, "bottom_k_sample_combine called in non-aggregate context");
+
+    if (PG_ARGISNULL(1))
+        PG_RETURN_POINTER(PG_ARGISNULL(0) ? NULL : PG_GETARG_POINTER(0));
+    other = (BottomKState *) PG_GETARG_POINTER(1);
+
+    if (PG_ARGISNULL(0))
+    {
+        bottomk_state_compact(other);
+        state = bottomk_state_create(aggcontext, other->typid, other->k, other->seed,
+                                     Max(other->nentries, 64));
+    }
+    else
+        state = (BottomKState *) PG_GETARG_POINTER(0);
+
+    bottomk_state_union(state, other);
+    PG_RETURN_POINTER(state);
+}
+
+/*
+ * bottom_k_sample_serialize(internal) -> bytea:
+ *
+ *   bytes 0-3    element type OID
+ *   bytes 4-7    k
+ *   bytes 8-15   seed
+ *   bytes 16-23  theta
+ *   bytes 24-27  number of entries n
+ *   then         n entries: hash (8 bytes) and the value by datumSerialize
+ */
+PG_FUNCTION_INFO_V1(bottom_k_sample_serialize);
+
+Datum
+bottom_k_sample_serialize(PG_FUNCTION_ARGS)
+{
+    BottomKState *state = (BottomKState *) PG_GETARG_POINTER(0);
+    bytea *result;
+    char *ptr;
+    Size size = 28;
+    int i;
+
+    bottomk_state_compact(state);
+    for (i = 0; i < state->nentries; i++)
+        size += 8 + datumEstimateSpace(state->entries[i].value, false,
+                                       state->typbyval, state->typlen);
+
+    result = (bytea *) palloc(VARHDRSZ + size);
+    SET_VARSIZE(result, VARHDRSZ + size);
+    ptr = VARDATA(result);
+    hashlib_write_le32((uint8 *) ptr, state->typid);
+    hashlib_write_le32((uint8 *) ptr + 4, (uint32) state->k);
+    hashlib_write_le64((uint8 *) ptr + 8, state->seed);
+    hashlib_write_le64((uint8 *) ptr + 16, state->theta);
+    hashlib_write_le32((uint8 *) ptr + 24, (uint32) state->nentries);
+    ptr += 28;
+    for (i = 0; i < state->nentries; i++)
+    {
+        hashlib_write_le64((uint8 *) ptr, state->entries[i].hash);
+        ptr += 8;
+        datumSerialize(state->entries[i].value, false, state->typbyval, state->typlen, &ptr);
+    }
+
+    PG_RETURN_BYTEA_P(result);
+}
+
+/* bottom_k_sample_deserialize(bytea, internal) -> internal */
+PG_FUNCTION_INFO_V1(bottom_k_sample_deserialize);
+
+Datum
+bottom_k_sample_deserialize(PG_FUNCTION_ARGS)
+{
+    bytea *data = PG_GETARG_BYTEA_PP(0);
+    const char *ptr = VARDATA_ANY(data);
+    BottomKState *state;
+    int n;
+    int i;
+
+    if (!AggCheckCallContext(fcinfo, NULL))
+        elog(ERROR, "bottom_k_sample_deserialize called in non-aggregate context");
+
+    n = (int) hashlib_read_le32((const uint8 *) ptr + 24);
+    state = bottomk_state_create(CurrentMemoryContext, hashlib_read_le32((const uint8 *) ptr),
+                                 (int) hashlib_read_le32((const uint8 *) ptr + 4),
+                                 hashlib_read_le64((const uint8 *) ptr + 8), Max(n, 64));
+    state->theta = hashlib_read_le64((const uint8 *) ptr + 16);
+    ptr += 28;
+    for (i = 0; i < n; i++)
+    {
+        uint64 hash = hashlib_read_le64((const uint8 *) ptr);
+        bool isnull;
+
+        ptr += 8;
+        state->entries[i].hash = hash;
+        state->entries[i].value = datumRestore((char **) &ptr, &isnull);
+    }
+    state->nentries = n;
+    state->nsorted = n;
+
+    PG_RETURN_POINTER(state);
+}
+
+/*
+ * bottom_k_sample_final(internal, anyelement, integer, bigint) -> anyarray:
+ * the sample in order of hash; NULL when there were no values
+ */
+PG_FUNCTION_INFO_V1(bottom_k_sample_final);
+
+Datum
+bottom_k_sample_final(PG_FUNCTION_ARGS)
+{
+    BottomKState *state;
+    Datum *values;
+    int i;
+
+    if (PG_ARGISNULL(0))
+        PG_RETURN_NULL();
+
+    state = (BottomKState *) PG_GETARG_POINTER(0);
+    bottomk_state_compact(state);
+    if (state->nentries == 0)
+        PG_RETURN_NULL();
+
+    values = (Datum *) palloc(sizeof(Datum) * state->nentries);
+    for (i = 0; i < state->nentries; i++)
+        values[i] = state->entries[i].value;
+
+    PG_RETURN_ARRAYTYPE_P(construct_array(values, state->nentries, state->typid,
+                                          state->typlen, state->typbyval, state->typalign));
+}
@@ -4,6 +4,8 @@
 #include "mb/pg_wchar.h"
 #include "access/htup_details.h"
 
+#include "hashlib_bucket.h"
+
 /* CityHash64 constants */
 static const uint64_t k0 = 0xc3a5c85c97cb3127ULL;
 static const uint64_t k1 = 0xb492b66fbe98f273ULL;
@@ -211,6 +213,17 @@ cityhash64(const char *s, size_t len)
     return cityhash64_with_seed(s, len, 81);
 }
 
+/* hash_bucket support: CityHash64 without a seed */
+static uint64
+cityhash64_bucket_hash(const void *data, size_t len)
+{
+    return cityhash64((const char *)data, len);
+}
+
+const HashlibBucketHasher cityhash64_bucket_hasher = {
+    "cityhash64", cityhash64_bucket_hash
+};
+
 /* CityHash64 for text input with default seed */
 PG_FUNCTION_INFO_V1(cityhash64_text);
 
@@ -0,0 +1,498 @@
+#include "postgres.h"
+#include "fmgr.h"
+#include "utils/builtins.h"
+#include "mb/pg_wchar.h"
+#include "access/htup_details.h"
+#include "libpq/pqformat.h"
+
+#include "hashlib_sketch.h"
+
+/*
+ * Count-min sketch: approximate frequencies of keys in a stream.
+ *
+ * The sketch is depth rows of width counters.  Adding a key increments one
+ * counter in each row and its estimated count is the smallest of those
+ * counters, which never underestimates and overestimates by at most
+ * e / width of the total count with probability 1 - e^-depth.
+ *
+ * Keys arrive as 64-bit hash values.  The counter of row i is chosen from
+ * g_i = h1 + i * h2 (Kirsch-Mitzenmacher double hashing), where h1 and h2
+ * are two mixes of the key, so one hash pass gives all depth positions.
+ * The top 32 bits of g_i are reduced to [0, width) by multiplication.
+ *
+ * Stored layout (integers little-endian):
+ *
+ *   byte 0       format version (1)
+ *   byte 1       depth
+ *   bytes 2-3    reserved (0)
+ *   bytes 4-7    width
+ *   bytes 8-15   total count added
+ *   then         depth * width 32-bit counters, row by row
+ *
+ * Counters saturate at 2^32 - 1.
+ */
+
+#define CMS_VERSION             1
+#define CMS_HEADER_SIZE         16
+
+#define CMS_MIN_WIDTH           16
+#define CMS_MAX_WIDTH           (1 << 22)
+#define CMS_MAX_DEPTH           16
+#define CMS_DEFAULT_WIDTH       2048
+#define CMS_DEFAULT_DEPTH       5
+
+typedef struct CmsState
+{
+    int         width;
+    int         depth;
+    int64       total;
+    uint32     *counters;       /* depth rows of width counters */
+} CmsState;
+
+static void
+cms_check_size(int32 width, int32 depth)
+{
+    if (width < CMS_MIN_WIDTH || width > CMS_MAX_WIDTH)
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("count-min sketch width must be between %d and %d",
+                        CMS_MIN_WIDTH, CMS_MAX_WIDTH)));
+    if (depth < 1 || depth > CMS_MAX_DEPTH)
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("count-min sketch depth must be between 1 and %d",
+                        CMS_MAX_DEPTH)));
+}
+
+static void
+cms_check_count(int64 count)
+{
+    if (count < 0)
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("count-min sketch count cannot be negative")));
+}
+
+static CmsState *
+cms_state_create(MemoryContext context, int width, int depth)
+{
+    CmsState *state = (CmsState *) MemoryContextAlloc(context, sizeof(CmsState));
+
+    state->width = width;
+    state->depth = depth;
+    state->total = 0;
+    state->counters = (uint32 *) MemoryContextAllocZero(context,
+                                                        sizeof(uint32) * (Size) width * depth);
+    return state;
+}
+
+static inline uint32
+cms_saturating_add(uint32 counter, uint64 count)
+{
+    return count >= PG_UINT32_MAX - counter ? PG_UINT32_MAX : counter + (uint32) count;
+}
+
+/* Counter of row for the double-hashing value g */
+static inline Size
+cms_index(uint64 g, int row, uint32 width)
+{
+    return (Size) row * width + hashlib_reduce32((uint32) (g >> 32), width);
+}
+
+static void
+cms_state_add(CmsState *state, uint64 key, int64 count)
+{
+    uint64 h1 = hashlib_mix64(key);
+    uint64 h2 = hashlib_mix64(h1) | 1;
+    uint64 g = h1;
+    int i;
+
+    for (i = 0; i < state->depth; i++)
+    {
+        uint32 *counter = &state->counters[cms_index(g, i, (uint32) state->width)];
+
+        *counter = cms_saturating_add(*counter, (uint64) count);
+        g += h2;
+    }
+
+    if (count > PG_INT64_MAX - state->total)
+        state->total = PG_INT64_MAX;
+    else
+        state->total += count;
+}
+
+static void
+cms_state_merge(CmsState *state, const CmsState *other)
+{
+    Size n = (Size) state->width * state->depth;
+    Size i;
+
+    if (state->width != other->width || state->depth != other->depth)
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("cannot merge count-min sketches of different sizes (%dx%d and %dx%d)",
+                        state->width, state->depth, other->width, other->depth)));
+
+    for (i = 0; i < n; i++)
+        state->counters[i] = cms_saturating_add(state->counters[i], other->counters[i]);
+
+    if (other->total > PG_INT64_MAX - state->total)
+        state->total = PG_INT64_MAX;
+    else
+        state->total += other->total;
+}
+
+static bytea *
+cms_state_serialize(const CmsState *state)
+{
+    Size n = (Size) state->width * state->depth;
+    Size size = CMS_HEADER_SIZE + 4 * n;
+    bytea *result = (bytea *) palloc(VARHDRSZ + size);
+    uint8 *data;
+    Size i;
+
+    SET_VARSIZE(result, VARHDRSZ + size);
+    data = (uint8 *) VARDATA(result);
+    data[0] = CMS_VERSION;
+    data[1] = (uint8) state->depth;
+    data[2] = data[3] = 0;
+    hashlib_write_le32(data + 4, (uint32) state->width);
+    hashlib_write_le64(data + 8, (uint64) state->total);
+    for (i = 0; i < n; i++)
+        hashlib_write_le32(data + CMS_HEADER_SIZE + 4 * i, state->counters[i]);
+    return result;
+}
+
+static void
+cms_invalid(void)
+{
+    ereport(ERROR,
+            (errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+             errmsg("invalid count-min sketch")));
+}
+
+static void
+cms_validate(const bytea *sketch)
+{
+    const uint8 *data = (const uint8 *) VARDATA_ANY(sketch);
+    Size size = VARSIZE_ANY_EXHDR(sketch);
+    uint32 width;
+
+    if (size < CMS_HEADER_SIZE || data[0] != CMS_VERSION || data[2] != 0 || data[3] != 0)
+        cms_invalid();
+
+    width = hashlib_read_le32(data + 4);
+    if (width < CMS_MIN_WIDTH || width > CMS_MAX_WIDTH ||
+        data[1] < 1 || data[1] > CMS_MAX_DEPTH ||
+        (int64) hashlib_read_le64(data + 8) < 0 ||
+        size != CMS_HEADER_SIZE + (Size) 4 * width * data[1])
+        cms_invalid();
+}
+
+static CmsState *
+cms_state_load(MemoryContext context, const bytea *sketch)
+{
+    const uint8 *data = (const uint8 *) VARDATA_ANY(sketch);
+    CmsState *state = cms_state_create(context, (int) hashlib_read_le32(data + 4), data[1]);
+    Size n = (Size) state->width * state->depth;
+    Size i;
+
+    state->total = (int64) hashlib_read_le64(data + 8);
+    for (i = 0; i < n; i++)
+        state->counters[i] = hashlib_read_le32(data + CMS_HEADER_SIZE + 4 * i);
+    return state;
+}
+
+static CmsState *
+cms_getarg_state(FunctionCallInfo fcinfo, int argno)
+{
+    bytea *sketch = PG_GETARG_BYTEA_PP(argno);
+
+    cms_validate(sketch);
+    return cms_state_load(CurrentMemoryContext, sketch);
+}
+
+/* cms_in(cstring) -> cms */
+PG_FUNCTION_INFO_V1(cms_in);
+
+Datum
+cms_in(PG_FUNCTION_ARGS)
+{
+    bytea *sketch = (bytea *) hashlib_sketch_from_hex(PG_GETARG_CSTRING(0), "cms");
+
+    cms_validate(sketch);
+    PG_RETURN_BYTEA_P(sketch);
+}
+
+/* cms_out(cms) -> cstring */
+PG_FUNCTION_INFO_V1(cms_out);
+
+Datum
+cms_out(PG_FUNCTION_ARGS)
+{
+    PG_RETURN_CSTRING(hashlib_sketch_to_hex((struct varlena *) PG_GETARG_BYTEA_PP(0)));
+}
+
+/* cms_recv(internal) -> cms */
+PG_FUNCTION_INFO_V1(cms_recv);
+
+Datum
+cms_recv(PG_FUNCTION_ARGS)
+{
+    bytea *sketch = (bytea *) hashlib_sketch_recv((StringInfo) PG_GETARG_POINTER(0));
+
+    cms_validate(sketch);
+    PG_RETURN_BYTEA_P(sketch);
+}
+
+/* cms_send(cms) -> bytea */
+PG_FUNCTION_INFO_V1(cms_send);
+
+Datum
+cms_send(PG_FUNCTION_ARGS)
+{
+    bytea *sketch = PG_GETARG_BYTEA_PP(0);
+    StringInfoData buf;
+
+    pq_begintypsend(&buf);
+    pq_sendbytes(&buf, VARDATA_ANY(sketch), VARSIZE_ANY_EXHDR(sketch));
+    PG_RETURN_BYTEA_P(pq_endtypsend(&buf));
+}
+
+/* cms(bytea) -> cms: checks the stored layout, for the bytea cast */
+PG_FUNCTION_INFO_V1(cms_from_bytea);
+
+Datum
+cms_from_bytea(PG_FUNCTION_ARGS)
+{
+    bytea *sketch = PG_GETARG_BYTEA_P_COPY(0);
+
+    cms_validate(sketch);
+    PG_RETURN_BYTEA_P(sketch);
+}
+
+/* cms_empty([width, depth]) -> cms */
+PG_FUNCTION_INFO_V1(cms_empty);
+
+Datum
+cms_empty(PG_FUNCTION_ARGS)
+{
+    int32 width = PG_NARGS() > 0 ? PG_GETARG_INT32(0) : CMS_DEFAULT_WIDTH;
+    int32 depth = PG_NARGS() > 1 ? PG_GETARG_INT32(1) : CMS_DEFAULT_DEPTH;
+
+    cms_check_size(width, depth);
+    PG_RETURN_BYTEA_P(cms_state_serialize(cms_state_create(CurrentMemoryContext, width, depth)));
+}
+
+/* cms_add(cms, bigint [, count bigint]) -> cms */
+PG_FUNCTION_INFO_V1(cms_add);
+
+Datum
+cms_add(PG_FUNCTION_ARGS)
+{
+    CmsState *state = cms_getarg_state(fcinfo, 0);
+    int64 count = PG_NARGS() > 2 ? PG_GETARG_INT64(2) : 1;
+
+    cms_check_count(count);
+    cms_state_add(state, (uint64) PG_GETARG_INT64(1), count);
+    PG_RETURN_BYTEA_P(cms_state_serialize(state));
+}
+
+/* cms_merge(cms, cms) -> cms */
+PG_FUNCTION_INFO_V1(cms_merge);
+
+Datum
+cms_merge(PG_FUNCTION_ARGS)
+{
+    CmsState *state = cms_getarg_state(fcinfo, 0);
+
+    cms_state_merge(state, cms_getarg_state(fcinfo, 1));
+    PG_RETURN_BYTEA_P(cms_state_serialize(state));
+}
+
+/* cms_estimate(cms, bigint) -> bigint */
+PG_FUNCTION_INFO_V1(cms_estimate);
+
+Datum
+cms_estimate(PG_FUNCTION_ARGS)
+{
+    bytea *sketch = PG_GETARG_BYTEA_PP(0);
+    const uint8 *data;
+    uint32 width;
+    uint64 h1;
+    uint64 h2;
+    uint64 g;
+    uint32 estimate = PG_UINT32_MAX;
+    int i;
+
+    /* read the counters in place rather than loading the whole sketch */
+    cms_validate(sketch);
+    data = (const uint8 *) VARDATA_ANY(sketch);
+    width = hashlib_read_le32(data + 4);
+    h1 = hashlib_mix64((uint64) PG_GETARG_INT64(1));
+    h2 = hashlib_mix64(h1) | 1;
+    g = h1;
+    for (i = 0; i < data[1]; i++)
+    {
+        estimate = Min(estimate, hashlib_read_le32(data + CMS_HEADER_SIZE + 4 * cms_index(g, i, width)));
+        g += h2;
+    }
+    PG_RETURN_INT64((int64) estimate);
+}
+
+/* cms_total(cms) -> bigint: total count added */
+PG_FUNCTION_INFO_V1(cms_total);
+
+Datum
+cms_total(PG_FUNCTION_ARGS)
+{
+    bytea *sketch = PG_GETARG_BYTEA_PP(0);
+
+    cms_validate(sketch);
+    PG_RETURN_INT64((int64) hashlib_read_le64((const uint8 *) VARDATA_ANY(sketch) + 8));
+}
+
+/* cms_width(cms) -> integer */
+PG_FUNCTION_INFO_V1(cms_width);
+
+Datum
+cms_width(PG_FUNCTION_ARGS)
+{
+    bytea *sketch = PG_GETARG_BYTEA_PP(0);
+
+    cms_validate(sketch);
+    PG_RETURN_INT32((int32) hashlib_read_le32((const uint8 *) VARDATA_ANY(sketch) + 4));
+}
+
+/* cms_depth(cms) -> integer */
+PG_FUNCTION_INFO_V1(cms_depth);
+
+Datum
+cms_depth(PG_FUNCTION_ARGS)
+{
+    bytea *sketch = PG_GETARG_BYTEA_PP(0);
+
+    cms_validate(sketch);
+    PG_RETURN_INT32((int32) ((const uint8 *) VARDATA_ANY(sketch))[1]);
+}
+
+/* cms_add_agg_transfn(internal, bigint [, width, depth]) -> internal */
+PG_FUNCTION_INFO_V1(cms_add_agg_transfn);
+
+Datum
+cms_add_agg_transfn(PG_FUNCTION_ARGS)
+{
+    MemoryContext aggcontext;
+    CmsState *state;
+
+    if (!AggCheckCallContext(fcinfo, &aggcontext))
+        elog(ERROR, "cms_add_agg_transfn called in non-aggregate context");
+
+    if (PG_ARGISNULL(0))
+    {
+        int32 width = CMS_DEFAULT_WIDTH;
+        int32 depth = CMS_DEFAULT_DEPTH;
+
+        if (PG_NARGS() > 3)
+        {
+            if (PG_ARGISNULL(2) || PG_ARGISNULL(3))
+                ereport(ERROR,
+                        (errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED),
+                         errmsg("count-min sketch width and depth must not be null")));
+            width = PG_GETARG_INT32(2);
+            depth = PG_GETARG_INT32(3);
+        }
+        cms_check_size(width, depth);
+        state = cms_state_create(aggcontext, width, depth);
+    }
+    else
+        state = (CmsState *) PG_GETARG_POINTER(0);
+
+    if (!PG_ARGISNULL(1))
+        cms_state_add(state, (uint64) PG_GETARG_INT64(1), 1);
+
+    PG_RETURN_POINTER(state);
+}
+
+/* cms_merge_agg_transfn(internal, cms) -> internal */
+PG_FUNCTION_INFO_V1(cms_merge_agg_transfn);
+
+Datum
+cms_merge_agg_transfn(PG_FUNCTION_ARGS)
+{
+    MemoryContext aggcontext;
+    bytea *sketch;
+
+    if (!AggCheckCallContext(fcinfo, &aggcontext))
+        elog(ERROR, "cms_merge_agg_transfn called in non-aggregate context");
+
+    if (PG_ARGISNULL(1))
+        PG_RETURN_POINTER(PG_ARGISNULL(0) ? NULL : PG_GETARG_POINTER(0));
+
+    sketch = PG_GETARG_BYTEA_PP(1);
+    cms_validate(sketch);
+    if (PG_ARGISNULL(0))
+        PG_RETURN_POINTER(cms_state_load(aggcontext, sketch));
+
+    cms_state_merge((CmsState *) PG_GETARG_POINTER(0), cms_state_load(CurrentMemoryContext, sketch));
+    PG_RETURN_POINTER(PG_GETARG_POINTER(0));
+}
+
+/* cms_agg_combine(internal, internal) -> internal */
+PG_FUNCTION_INFO_V1(cms_agg_combine);
+
+Datum
+cms_agg_combine(PG_FUNCTION_ARGS)
+{
+    MemoryContext aggcontext;
+    CmsState *state;
+    CmsState *other;
+
+    if (!AggCheckCallContext(fcinfo, &aggcontext))
+        elog(ERROR, "cms_agg_combine called in non-aggregate context");
+
+    if (PG_ARGISNULL(1))
+        PG_RETURN_POINTER(PG_ARGISNULL(0) ? NULL : PG_GETARG_POINTER(0));
+
+    other = (CmsState *) PG_GETARG_POINTER(1);
+    if (PG_ARGISNULL(0))
+        state = cms_state_create(aggcontext, other->width, other->depth);
+    else
+        state = (CmsState *) PG_GETARG_POINTER(0);
+    cms_state_merge(state, other);
+
+    PG_RETURN_POINTER(state);
+}
+
+/* cms_agg_serialize(internal) -> bytea: the stored form */
+PG_FUNCTION_INFO_V1(cms_agg_serialize);
+
+Datum
+cms_agg_serialize(PG_FUNCTION_ARGS)
+{
+    PG_RETURN_BYTEA_P(cms_state_serialize((CmsState *) PG_GETARG_POINTER(0)));
+}
+
+/* cms_agg_deserialize(bytea, internal) -> internal */
+PG_FUNCTION_INFO_V1(cms_agg_deserialize);
+
+Datum
+cms_agg_deserialize(PG_FUNCTION_ARGS)
+{
+    if (!AggCheckCallContext(fcinfo, NULL))
+        elog(ERROR, "cms_agg_deserialize called in non-aggregate context");
+
+    PG_RETURN_POINTER(cms_getarg_state(fcinfo, 0));
+}
+
+/* cms_agg_final(internal) -> cms; NULL when there were no rows */
+PG_FUNCTION_INFO_V1(cms_agg_final);
+
+Datum
+cms_agg_final(PG_FUNCTION_ARGS)
+{
+    if (PG_ARGISNULL(0))
+        PG_RETURN_NULL();
+
+    PG_RETURN_BYTEA_P(cms_state_serialize((CmsState *) PG_GETARG_POINTER(0)));
+}
@@ -0,0 +1,384 @@
+#include "postgres.h"
+#include "fmgr.h"
+#include "utils/builtins.h"
+#include "utils/array.h"
+#include "utils/datum.h"
+#include "utils/memutils.h"
+#include "catalog/pg_type.h"
+
+#include <math.h>
+
+#include "hashlib_sketch.h"
+
+/*
+ * Consistent hashing: map keys to buckets or nodes so that when the number
+ * of buckets or the set of nodes changes, only the keys that have to move do
+ * (about 1/N of them), unlike hash % N, which moves almost all of them.
+ *
+ * jump_consistent_hash is Lamping and Veach, "A Fast, Minimal Memory,
+ * Consistent Hash Algorithm" (2014), with the reference 64-bit LCG, so it
+ * gives the same buckets as other implementations for the same key.  It maps
+ * to buckets numbered 0 to N - 1 and only supports adding or removing the
+ * last bucket.
+ *
+ * rendezvous_hash (highest random weight) maps to named nodes: each node
+ * scores the key with fmix64(key ^ node), where node is the xxhash3_64 of its
+ * name, and the highest score wins.  With weights the score is
+ * -weight / ln(u) for u the score scaled to (0, 1), which gives each node a
+ * share of keys proportional to its weight (Schindelhauer and Schomaker,
+ * "Weighted Distributed Hash Tables", 2005).  Removing a node moves only its
+ * keys.  A lookup costs one hash per node.
+ *
+ * multiprobe_hash (Appleton and O'Reilly, "Multi-probe consistent hashing",
+ * 2015) places each node once on a 64-bit ring at the xxhash3_64 of its name
+ * and hashes the key k times, with fmix64(key + i * 0x9E3779B97F4A7C15); the
+ * node that follows any probe most closely wins.  21 probes give a peak to
+ * mean load of about 1.1 over 100 nodes without virtual nodes, and a lookup
+ * costs k binary searches.
+ *
+ * The text and bytea forms hash the key with xxhash3_64 first.  The node
+ * array and its hashes are cached in fn_extra, so a constant node list is
+ * hashed once per query.
+ */
+
+#define CONSISTENT_DEFAULT_PROBES   21
+#define CONSISTENT_MAX_PROBES       1024
+#define CONSISTENT_PROBE_INCREMENT  UINT64CONST(0x9E3779B97F4A7C15)
+
+/* A node list and what is derived from it, cached in fn_extra */
+typedef struct ConsistentNodes
+{
+    MemoryContext mcxt;
+    /* copies of the node and weight arrays, to recognise them */
+    ArrayType  *nodes_image;
+    ArrayType  *weights_image;
+    int         n;
+    Datum      *names;          /* text, pointing into nodes_image */
+    uint64     *hashes;         /* xxhash3_64 of each name */
+    double     *weights;        /* NULL without weights */
+    /* multiprobe_hash only: node indexes sorted by hash */
+    int        *ring;
+} ConsistentNodes;
+
+static int32
+consistent_jump(uint64 key, int32 buckets)
+{
+    int64 b = -1;
+    int64 j = 0;
+
+    if (buckets <= 0)
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("number of buckets must be positive")));
+
+    while (j < buckets)
+    {
+        b = j;
+        key = key * UINT64CONST(2862933555777941757) + 1;
+        j = (int64) ((double) (b + 1) * ((double) (INT64CONST(1) << 31) / (double) ((key >> 33) + 1)));
+    }
+    return (int32) b;
+}
+
+static uint64
+consistent_text_key(text *key)
+{
+    return hashlib_xxh3_64(VARDATA_ANY(key), VARSIZE_ANY_EXHDR(key));
+}
+
+static bool
+consistent_same_array(ArrayType *image, ArrayType *array)
+{
+    if (image == NULL || array == NULL)
+        return image == array;
+    return VARSIZE(image) == VARSIZE(array) && memcmp(image, array, VARSIZE(array)) == 0;
+}
+
+static int
+consistent_ring_cmp(const void *a, const void *b, void *arg)
+{
+    const uint64 *hashes = (const uint64 *) arg;
+    uint64 x = hashes[*(const int *) a];
+    uint64 y = hashes[*(const int *) b];
+
+    if (x != y)
+        return x < y ? -1 : 1;
+    return *(const int *) a - *(const int *) b;
+}
+
+/*
+ * The node list of the call, from the cache when the node and weight arrays
+ * are the same as last time.  weights may be NULL.
+ */
+static ConsistentNodes *
+consistent_nodes(FunctionCallInfo fcinfo, ArrayType *nodes, ArrayType *weights)
+{
+    ConsistentNodes *cache = (ConsistentNodes *) fcinfo->flinfo->fn_extra;
+    MemoryContext oldcontext;
+    ArrayType *image;
+    bool *nulls;
+    int i;
+
+    if (cache != NULL &&
+        consistent_same_array(cache->nodes_image, nodes) &&
+        consistent_same_array(cache->weights_image, weights))
+        return cache;
+
+    if (ARR_NDIM(nodes) > 1)
+        ereport(ERROR,
+                (errcode(ERRCODE_ARRAY_SUBSCRIPT_ERROR),
+                 errmsg("node array must be one-dimensional")));
+
+    if (cache == NULL)
+    {
+        cache = (ConsistentNodes *) MemoryContextAllocZero(fcinfo->flinfo->fn_mcxt,
+                                                           sizeof(ConsistentNodes));
+        cache->mcxt = AllocSetContextCreate(fcinfo->flinfo->fn_mcxt,
+                                            "hashlib consistent hash nodes",
+                                            ALLOCSET_SMALL_SIZES);
+        fcinfo->flinfo->fn_extra = cache;
+    }
+    else
+    {
+        MemoryContextReset(cache->mcxt);
+        cache->nodes_image = NULL;
+        cache->weights_image = NULL;
+    }
+    oldcontext = MemoryContextSwitchTo(cache->mcxt);
+
+    /* the cached names point into the copy of the array */
+    image = (ArrayType *) palloc(VARSIZE(nodes));
+    memcpy(image, nodes, VARSIZE(nodes));
+    deconstruct_array(image, TEXTOID, -1, false, 'i', &cache->names, &nulls, &cache->n);
+    if (cache->n == 0)
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("node array must not be empty")));
+
+    cache->hashes = (uint64 *) palloc(sizeof(uint64) * cache->n);
+    for (i = 0; i < cache->n; i++)
+    {
+        if (nulls[i])
+            ereport(ERROR,
+                    (errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED),
+                     errmsg("node names must not be null")));
+        cache->hashes[i] = consistent_text_key(DatumGetTextPP(cache->names[i]));
+    }
+
+    cache->weights = NULL;
+    if (weights != NULL)
+    {
+        Datum *values;
+        int nweights;
+        bool positive = false;
+
+        if (ARR_NDIM(weights) > 1)
+            ereport(ERROR,
+                    (errcode(ERRCODE_ARRAY_SUBSCRIPT_ERROR),
+                     errmsg("weight array must be one-dimensional")));
+        deconstruct_array(weights, FLOAT8OID, sizeof(float8), FLOAT8PASSBYVAL, 'd',
+                          &values, &nulls, &nweights);
+        if (nweights != cache->n)
+            ereport(ERROR,
+                    (errcode(ERRCODE_ARRAY_SUBSCRIPT_ERROR),
+                     errmsg("node and weight arrays must have the same length")));
+
+        cache->weights = (double *) palloc(sizeof(double) * cache->n);
+        for (i = 0; i < cache->n; i++)
+        {
+            if (nulls[i] || isnan(DatumGetFloat8(values[i])) || isinf(DatumGetFloat8(values[i])) ||
+                DatumGetFloat8(values[i]) < 0)
+                ereport(ERROR,
+                        (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                         errmsg("node weights must be finite and not negative")));
+            cache->weights[i] = DatumGetFloat8(values[i]);
+            positive |= cache->weights[i] > 0;
+        }
+        if (!positive)
+            ereport(ERROR,
+                    (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                     errmsg("at least one node weight must be positive")));
+    }
+
+    /* only a node list that passed the checks is recognised next time */
+    cache->ring = NULL;
+    cache->nodes_image = image;
+    if (weights != NULL)
+    {
+        cache->weights_image = (ArrayType *) palloc(VARSIZE(weights));
+        memcpy(cache->weights_image, weights, VARSIZE(weights));
+    }
+    MemoryContextSwitchTo(oldcontext);
+    return cache;
+}
+
+/* Index of the node that key maps to by highest random weight */
+static int
+consistent_rendezvous(ConsistentNodes *nodes, uint64 key)
+{
+    int best = 0;
+    int i;
+
+    if (nodes->weights == NULL)
+    {
+        uint64 best_score = 0;
+
+        for (i = 0; i < nodes->n; i++)
+        {
+            uint64 score = hashlib_mix64(key ^ nodes->hashes[i]);
+
+            if (i == 0 || score > best_score)
+            {
+                best = i;
+                best_score = score;
+            }
+        }
+    }
+    else
+    {
+        double best_score = -1;
+
+        for (i = 0; i < nodes->n; i++)
+        {
+            /* the top 53 bits of the score, scaled into (0, 1) */
+            double u = ((double) (hashlib_mix64(key ^ nodes->hashes[i]) >> 11) + 0.5) *
+                (1.0 / 9007199254740992.0);
+            double score = nodes->weights[i] > 0 ? -nodes->weights[i] / log(u) : 0;
+
+            if (score > best_score)
+            {
+                best = i;
+                best_score = score;
+            }
+        }
+    }
+    return best;
+}
+
+/* Index of the node that key maps to by multi-probe consistent hashing */
+static int
+consistent_multiprobe(ConsistentNodes *nodes, uint64 key, int32 probes)
+{
+    int best = 0;
+    uint64 best_distance = PG_UINT64_MAX;
+    int32 p;
+
+    if (probes < 1 || probes > CONSISTENT_MAX_PROBES)
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("number of probes must be between 1 and %d", CONSISTENT_MAX_PROBES)));
+
+    if (nodes->ring == NULL)
+    {
+        int i;
+
+        nodes->ring = (int *) MemoryContextAlloc(nodes->mcxt, sizeof(int) * nodes->n);
+        for (i = 0; i < nodes->n; i++)
+            nodes->ring[i] = i;
+        qsort_arg(nodes->ring, nodes->n, sizeof(int), consistent_ring_cmp, nodes->hashes);
+    }
+
+    for (p = 0; p < probes; p++)
+    {
+        uint64 probe = hashlib_mix64(key + (uint64) p * CONSISTENT_PROBE_INCREMENT);
+        int lo = 0;
+        int hi = nodes->n;
+        int node;
+        uint64 distance;
+
+        /* the first node at or after the probe, wrapping around the ring */
+        while (lo < hi)
+        {
+            int mid = lo + (hi - lo) / 2;
+
+            if (nodes->hashes[nodes->ring[mid]] < probe)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        node = nodes->ring[lo == nodes->n ? 0 : lo];
+        distance = nodes->hashes[node] - probe;
+        if (distance < best_distance || (distance == best_distance && node < best))
+        {
+            best = node;
+            best_distance = distance;
+        }
+    }
+    return best;
+}
+
+/* jump_consistent_hash(bigint, integer) -> integer */
+PG_FUNCTION_INFO_V1(jump_consistent_hash);
+
+Datum
+jump_consistent_hash(PG_FUNCTION_ARGS)
+{
+    PG_RETURN_INT32(consistent_jump((uint64) PG_GETARG_INT64(0), PG_GETARG_INT32(1)));
+}
+
+/* jump_consistent_hash(text | bytea, integer) -> integer */
+PG_FUNCTION_INFO_V1(jump_consistent_hash_text);
+
+Datum
+jump_consistent_hash_text(PG_FUNCTION_ARGS)
+{
+    PG_RETURN_INT32(consistent_jump(consistent_text_key(PG_GETARG_TEXT_PP(0)), PG_GETARG_INT32(1)));
+}
+
+/* Node name rendezvous_hash gives key, over the nodes and weights in args 1 and 2 */
+static Datum
+consistent_rendezvous_name(FunctionCallInfo fcinfo, uint64 key)
+{
+    ConsistentNodes *nodes;
+
+    nodes = consistent_nodes(fcinfo, PG_GETARG_ARRAYTYPE_P(1),
+                             PG_NARGS() > 2 ? PG_GETARG_ARRAYTYPE_P(2) : NULL);
+    return datumCopy(nodes->names[consistent_rendezvous(nodes, key)], false, -1);
+}
+
+/* Node name multiprobe_hash gives key, over the nodes and probes in args 1 and 2 */
+static Datum
+consistent_multiprobe_name(FunctionCallInfo fcinfo, uint64 key)
+{
+    ConsistentNodes *nodes;
+    int32 probes = PG_NARGS() > 2 ? PG_GETARG_INT32(2) : CONSISTENT_DEFAULT_PROBES;
+
+    nodes = consistent_nodes(fcinfo, PG_GETARG_ARRAYTYPE_P(1), NULL);
+    return datumCopy(nodes->names[consistent_multiprobe(nodes, key, probes)], false, -1);
+}
+
+/* rendezvous_hash(bigint, text[] [, double precision[]]) -> text */
+PG_FUNCTION_INFO_V1(rendezvous_hash_int8);
+
+Datum
+rendezvous_hash_int8(PG_FUNCTION_ARGS)
+{
+    PG_RETURN_DATUM(consistent_rendezvous_name(fcinfo, (uint64) PG_GETARG_INT64(0)));
+}
+
+/* rendezvous_hash(text | bytea, text[] [, double precision[]]) -> text */
+PG_FUNCTION_INFO_V1(rendezvous_hash_text);
+
+Datum
+rendezvous_hash_text(PG_FUNCTION_ARGS)
+{
+    PG_RETURN_DATUM(consistent_rendezvous_name(fcinfo, consistent_text_key(PG_GETARG_TEXT_PP(0))));
+}
+
+/* multiprobe_hash(bigint, text[] [, probes integer]) -> text */
+PG_FUNCTION_INFO_V1(multiprobe_hash_int8);
+
+Datum
+multiprobe_hash_int8(PG_FUNCTION_ARGS)
+{
+    PG_RETURN_DATUM(consistent_multiprobe_name(fcinfo, (uint64) PG_GETARG_INT64(0)));
+}
+
+/* multiprobe_hash(text | bytea, text[] [, probes integer]) -> text */
+PG_FUNCTION_INFO_V1(multiprobe_hash_text);
+
+Datum
+multiprobe_hash_text(PG_FUNCTION_ARGS)
+{
+    PG_RETURN_DATUM(consistent_multiprobe_name(fcinfo, consistent_text_key(PG_GETARG_TEXT_PP(0))));
+}
@@ -4,6 +4,10 @@
 #include "mb/pg_wchar.h"
 #include "access/htup_details.h"
 
+#include "hashlib_file.h"
+#include "hashlib_lo.h"
+#include "hashlib_toast.h"
+
 /* CRC32 lookup table */
 static const uint32_t crc32_table[256] = {
     0x00000000, 0x77073096, 0xee0e612c, 0x990951ba, 0x076dc419, 0x706af48f,
@@ -66,16 +70,53 @@ crc32(const void *data, size_t len, uint32_t initial_crc)
     return crc ^ 0xFFFFFFFF;
 }
 
+static void
+crc32_stream_update(void *arg, const uint8 *data, size_t len)
+{
+    uint32_t *crc = (uint32_t *)arg;
+    *crc = crc32(data, len, *crc);
+}
+
+/* hash_file support: crc32 with the default initial CRC */
+static void *
+crc32_file_start(void)
+{
+    return palloc0(sizeof(uint32_t));
+}
+
+static int64
+crc32_file_finish(void *state)
+{
+    return (int64)(int32_t)*(uint32_t *)state;
+}
+
+const HashlibFileHasher crc32_file_hasher = {
+    "crc32", crc32_file_start, crc32_stream_update, crc32_file_finish
+};
+
+/* CRC32 of a text or bytea datum, streaming large out-of-line values */
+static uint32_t
+crc32_datum(Datum value, uint32_t initial_crc)
+{
+    bytea *input;
+    uint32_t crc = initial_crc;
+
+    if (hashlib_datum_streamable(value)) {
+        hashlib_stream_datum(value, crc32_stream_update, &crc);
+        return crc;
+    }
+
+    input = DatumGetByteaPP(value);
+    return crc32(VARDATA_ANY(input), VARSIZE_ANY_EXHDR(input), initial_crc);
+}
+
 /* CRC32 for text input with default initial CRC (0) */
 PG_FUNCTION_INFO_V1(crc32_text);
 
 Datum
 crc32_text(PG_FUNCTION_ARGS)
 {
-    text *input = PG_GETARG_TEXT_PP(0);
-    char *data = VARDATA_ANY(input);
-    int len = VARSIZE_ANY_EXHDR(input);
-    uint32_t hash = crc32(data, len, 0);
+    uint32_t hash = crc32_datum(PG_GETARG_DATUM(0), 0);
     PG_RETURN_INT32((int32_t)hash);
 }
 
@@ -85,11 +126,8 @@ PG_FUNCTION_INFO_V1(crc32_text_seed);
 Datum
 crc32_text_seed(PG_FUNCTION_ARGS)
 {
-    text *input = PG_GETARG_TEXT_PP(0);
     int32_t seed = PG_GETARG_INT32(1);
-    char *data = VARDATA_ANY(input);
-    int len = VARSIZE_ANY_EXHDR(input);
-    uint32_t hash = crc32(data, len, (uint32_t)seed);
+    uint32_t hash = crc32_datum(PG_GETARG_DATUM(0), (uint32_t)seed);
     PG_RETURN_INT32((int32_t)hash);
 }
 
@@ -99,10 +137,7 @@ PG_FUNCTION_INFO_V1(crc32_bytea);
 Datum
 crc32_bytea(PG_FUNCTION_ARGS)
 {
-    bytea *input = PG_GETARG_BYTEA_PP(0);
-    char *data = VARDATA_ANY(input);
-    int len = VARSIZE_ANY_EXHDR(input);
-    uint32_t hash = crc32(data, len, 0);
+    uint32_t hash = crc32_datum(PG_GETARG_DATUM(0), 0);
     PG_RETURN_INT32((int32_t)hash);
 }
 
@@ -112,11 +147,8 @@ PG_FUNCTION_INFO_V1(crc32_bytea_seed);
 Datum
 crc32_bytea_seed(PG_FUNCTION_ARGS)
 {
-    bytea *input = PG_GETARG_BYTEA_PP(0);
     int32_t seed = PG_GETARG_INT32(1);
-    char *data = VARDATA_ANY(input);
-    int len = VARSIZE_ANY_EXHDR(input);
-    uint32_t hash = crc32(data, len, (uint32_t)seed);
+    uint32_t hash = crc32_datum(PG_GETARG_DATUM(0), (uint32_t)seed);
     PG_RETURN_INT32((int32_t)hash);
 }
 
@@ -141,4 +173,43 @@ crc32_int_seed(PG_FUNCTION_ARGS)
     int32_t seed = PG_GETARG_INT32(1);
     uint32_t hash = crc32(&input, sizeof(int32_t), (uint32_t)seed);
     PG_RETURN_INT32((int32_t)hash);
-}
\ No newline at end of file
+}
+
+/* CRC32 of the contents of a large object, read a few pages at a time */
+PG_FUNCTION_INFO_V1(lo_crc32);
+
+Datum
+lo_crc32(PG_FUNCTION_ARGS)
+{
+    uint32_t crc = 0;
+
+    hashlib_stream_large_object(PG_GETARG_OID(0), crc32_stream_update, &crc);
+    PG_RETURN_INT32((int32_t)crc);
+}
+
+/* CRC32 of a large object with custom initial CRC */
+PG_FUNCTION_INFO_V1(lo_crc32_seed);
+
+Datum
+lo_crc32_seed(PG_FUNCTION_ARGS)
+{
+    uint32_t crc = (uint32_t)PG_GETARG_INT32(1);
+
+    hashlib_stream_large_object(PG_GETARG_OID(0), crc32_stream_update, &crc);
+    PG_RETURN_INT32((int32_t)crc);
+}
+
+/*
+ * crc32_agg_transfn(integer, bytea/text) -> integer, for the ordered
+ * aggregate: the CRC is chained over each value framed with its length
+ */
+PG_FUNCTION_INFO_V1(crc32_agg_transfn);
+
+Datum
+crc32_agg_transfn(PG_FUNCTION_ARGS)
+{
+    uint32_t crc = (uint32_t)PG_GETARG_INT32(0);
+
+    hashlib_stream_framed_datum(PG_GETARG_DATUM(1), PG_ARGISNULL(1), crc32_stream_update, &crc);
+    PG_RETURN_INT32((int32_t)crc);
+}
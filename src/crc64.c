@@ -0,0 +1,621 @@
+#include "postgres.h"
+#include "fmgr.h"
+#include "utils/builtins.h"
+#include "mb/pg_wchar.h"
+#include "access/htup_details.h"
+
+#include "hashlib_file.h"
+#include "hashlib_toast.h"
+
+/* CRC-64 implementation
+ * Three catalogued CRC-64 variants are provided:
+ *
+ *   CRC-64/XZ     poly 0x42F0E1EBA9EA3693, reflected, init/xorout ~0
+ *                 (xz, Go's crc64.ECMA table, "CRC-64/GO-ECMA")
+ *   CRC-64/NVME   poly 0xAD93D23594C93659, reflected, init/xorout ~0
+ *                 (NVMe end-to-end data protection, AWS S3 checksums)
+ *   CRC-64/ECMA-182  poly 0x42F0E1EBA9EA3693, not reflected, init/xorout 0
+ *
+ * Every variant has a slicing-by-8 table kernel.  The reflected variants also
+ * have carry-less multiply folding kernels (PCLMULQDQ on x86-64, PMULL on arm64
+ * builds with the crypto extension) that fold four 128-bit accumulators over
+ * 64-byte blocks.  The folding kernel is selected at runtime on first use, as
+ * in aeshash.c, and always produces the same result as the table kernel.
+ */
+
+#if (defined(__x86_64__) || defined(_M_AMD64)) && (defined(__GNUC__) || defined(__clang__))
+#define CRC64_USE_PCLMUL 1
+#include <cpuid.h>
+#include <wmmintrin.h>
+#endif
+
+#if defined(__aarch64__) && (defined(__ARM_FEATURE_AES) || defined(__ARM_FEATURE_CRYPTO))
+#define CRC64_USE_PMULL 1
+#include <arm_neon.h>
+#endif
+
+/* Inputs shorter than this are not worth setting up the folding kernel for */
+#define CRC64_FOLD_MIN_LEN 128
+
+typedef struct crc64_variant
+{
+    uint64_t    poly;           /* polynomial in normal (MSB-first) form */
+    bool        reflected;      /* reflected input and output */
+    uint64_t    xorout;         /* initial value and final XOR */
+
+    /*
+     * Bit-reflected x^n mod P for n = 191, 127 (fold by 128 bits) and
+     * n = 575, 511 (fold by 512 bits).  Only used by reflected variants.
+     */
+    uint64_t    k[4];
+
+    bool        table_ready;
+    uint64_t    table[8][256];
+} crc64_variant;
+
+static crc64_variant crc64_xz = {
+    0x42F0E1EBA9EA3693ULL, true, ~0ULL,
+    {0xE05DD497CA393AE4ULL, 0xDABE95AFC7875F40ULL, 0x6AE3EFBB9DD441F3ULL, 0x081F6054A7842DF4ULL},
+    false, {{0}}
+};
+
+static crc64_variant crc64_nvme = {
+    0xAD93D23594C93659ULL, true, ~0ULL,
+    {0xEADC41FD2BA3D420ULL, 0x21E9761E252621ACULL, 0x0C32CDB31E18A84AULL, 0x62242240ACE5045AULL},
+    false, {{0}}
+};
+
+static crc64_variant crc64_ecma = {
+    0x42F0E1EBA9EA3693ULL, false, 0ULL,
+    {0, 0, 0, 0},
+    false, {{0}}
+};
+
+/* Byte reading functions */
+static inline uint64_t
+crc64_read64le(const uint8_t *p)
+{
+    return (uint64_t)p[0] | ((uint64_t)p[1] << 8) | ((uint64_t)p[2] << 16) | ((uint64_t)p[3] << 24) |
+           ((uint64_t)p[4] << 32) | ((uint64_t)p[5] << 40) | ((uint64_t)p[6] << 48) | ((uint64_t)p[7] << 56);
+}
+
+static inline uint64_t
+crc64_read64be(const uint8_t *p)
+{
+    return ((uint64_t)p[0] << 56) | ((uint64_t)p[1] << 48) | ((uint64_t)p[2] << 40) | ((uint64_t)p[3] << 32) |
+           ((uint64_t)p[4] << 24) | ((uint64_t)p[5] << 16) | ((uint64_t)p[6] << 8) | (uint64_t)p[7];
+}
+
+static uint64_t
+crc64_reflect(uint64_t v)
+{
+    uint64_t r = 0;
+    int i;
+
+    for (i = 0; i < 64; i++)
+    {
+        r = (r << 1) | (v & 1);
+        v >>= 1;
+    }
+    return r;
+}
+
+/* Build the slicing-by-8 tables on first use */
+static void
+crc64_init_table(crc64_variant *v)
+{
+    int i, j, n;
+
+    if (v->table_ready)
+        return;
+
+    if (v->reflected)
+    {
+        uint64_t rpoly = crc64_reflect(v->poly);
+
+        for (i = 0; i < 256; i++)
+        {
+            uint64_t crc = (uint64_t)i;
+            for (j = 0; j < 8; j++)
+                crc = (crc & 1) ? (crc >> 1) ^ rpoly : crc >> 1;
+            v->table[0][i] = crc;
+        }
+        for (n = 1; n < 8; n++)
+            for (i = 0; i < 256; i++)
+                v->table[n][i] = (v->table[n - 1][i] >> 8) ^ v->table[0][v->table[n - 1][i] & 0xFF];
+    }
+    else
+    {
+        for (i = 0; i < 256; i++)
+        {
+            uint64_t crc = (uint64_t)i << 56;
+            for (j = 0; j < 8; j++)
+                crc = (crc >> 63) ? (crc << 1) ^ v->poly : crc << 1;
+            v->table[0][i] = crc;
+        }
+        for (n = 1; n < 8; n++)
+            for (i = 0; i < 256; i++)
+                v->table[n][i] = (v->table[n - 1][i] << 8) ^ v->table[0][v->table[n - 1][i] >> 56];
+    }
+
+    v->table_ready = true;
+}
+
+/* Slicing-by-8 kernel for reflected variants; crc is the raw register */
+static uint64_t
+crc64_table_reflected(const crc64_variant *v, uint64_t crc, const uint8_t *p, size_t len)
+{
+    while (len >= 8)
+    {
+        uint64_t x = crc ^ crc64_read64le(p);
+        crc = v->table[7][x & 0xFF] ^ v->table[6][(x >> 8) & 0xFF] ^
+              v->table[5][(x >> 16) & 0xFF] ^ v->table[4][(x >> 24) & 0xFF] ^
+              v->table[3][(x >> 32) & 0xFF] ^ v->table[2][(x >> 40) & 0xFF] ^
+              v->table[1][(x >> 48) & 0xFF] ^ v->table[0][x >> 56];
+        p += 8;
+        len -= 8;
+    }
+    while (len--)
+        crc = v->table[0][(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+    return crc;
+}
+
+/* Slicing-by-8 kernel for non-reflected variants; crc is the raw register */
+static uint64_t
+crc64_table_normal(const crc64_variant *v, uint64_t crc, const uint8_t *p, size_t len)
+{
+    while (len >= 8)
+    {
+        uint64_t x = crc ^ crc64_read64be(p);
+        crc = v->table[7][x >> 56] ^ v->table[6][(x >> 48) & 0xFF] ^
+              v->table[5][(x >> 40) & 0xFF] ^ v->table[4][(x >> 32) & 0xFF] ^
+              v->table[3][(x >> 24) & 0xFF] ^ v->table[2][(x >> 16) & 0xFF] ^
+              v->table[1][(x >> 8) & 0xFF] ^ v->table[0][x & 0xFF];
+        p += 8;
+        len -= 8;
+    }
+    while (len--)
+        crc = v->table[0][(crc >> 56) ^ *p++] ^ (crc << 8);
+    return crc;
+}
+
+/*
+ * Carry-less multiply folding for reflected variants.
+ *
+ * A 16-byte little-endian load of reflected input holds the bit-reversed
+ * chunk polynomial, with the earlier 64 bits in the low lane.  Moving a chunk
+ * forward by n bits multiplies it by x^n; doing that separately for each lane
+ * with the constants x^(n+63) and x^(n-1) (the extra -1 absorbs the one-bit
+ * shift of a reflected carry-less product) gives a 128-bit value that is XORed
+ * into the chunk n bits later.  What is left after the last fold is a 16-byte
+ * message with a zero CRC register, which the table kernel finishes.
+ */
+#ifdef CRC64_USE_PCLMUL
+__attribute__((target("pclmul,sse2")))
+static uint64_t
+crc64_fold_pclmul(const crc64_variant *v, uint64_t crc, const uint8_t *p, size_t len)
+{
+    const __m128i k128 = _mm_set_epi64x((long long)v->k[1], (long long)v->k[0]);
+    const __m128i k512 = _mm_set_epi64x((long long)v->k[3], (long long)v->k[2]);
+    __m128i x0, x1, x2, x3;
+    uint8_t rest[16];
+
+    x0 = _mm_xor_si128(_mm_loadu_si128((const __m128i *)p), _mm_set_epi64x(0, (long long)crc));
+    x1 = _mm_loadu_si128((const __m128i *)(p + 16));
+    x2 = _mm_loadu_si128((const __m128i *)(p + 32));
+    x3 = _mm_loadu_si128((const __m128i *)(p + 48));
+    p += 64;
+    len -= 64;
+
+    while (len >= 64)
+    {
+        x0 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x0, k512, 0x00),
+                                         _mm_clmulepi64_si128(x0, k512, 0x11)),
+                           _mm_loadu_si128((const __m128i *)p));
+        x1 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x1, k512, 0x00),
+                                         _mm_clmulepi64_si128(x1, k512, 0x11)),
+                           _mm_loadu_si128((const __m128i *)(p + 16)));
+        x2 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x2, k512, 0x00),
+                                         _mm_clmulepi64_si128(x2, k512, 0x11)),
+                           _mm_loadu_si128((const __m128i *)(p + 32)));
+        x3 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x3, k512, 0x00),
+                                         _mm_clmulepi64_si128(x3, k512, 0x11)),
+                           _mm_loadu_si128((const __m128i *)(p + 48)));
+        p += 64;
+        len -= 64;
+    }
+
+    /* Fold the four accumulators into one */
+    x1 = _mm_xor_si128(x1, _mm_xor_si128(_mm_clmulepi64_si128(x0, k128, 0x00),
+                                         _mm_clmulepi64_si128(x0, k128, 0x11)));
+    x2 = _mm_xor_si128(x2, _mm_xor_si128(_mm_clmulepi64_si128(x1, k128, 0x00),
+                                         _mm_clmulepi64_si128(x1, k128, 0x11)));
+    x3 = _mm_xor_si128(x3, _mm_xor_si128(_mm_clmulepi64_si128(x2, k128, 0x00),
+                                         _mm_clmulepi64_si128(x2, k128, 0x11)));
+
+    /* Remaining whole 16-byte chunks */
+    while (len >= 16)
+    {
+        x3 = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(x3, k128, 0x00),
+                                         _mm_clmulepi64_si128(x3, k128, 0x11)),
+                           _mm_loadu_si128((const __m128i *)p));
+        p += 16;
+        len -= 16;
+    }
+
+    _mm_storeu_si128((__m128i *)rest, x3);
+    crc = crc64_table_reflected(v, 0, rest, 16);
+    return crc64_table_reflected(v, crc, p, len);
+}
+#endif
+
+#ifdef CRC64_USE_PMULL
+static inline uint64x2_t
+crc64_fold_pmull_step(uint64x2_t x, uint64_t klo, uint64_t khi)
+{
+    uint64x2_t lo = vreinterpretq_u64_p128(vmull_p64((poly64_t)vgetq_lane_u64(x, 0), (poly64_t)klo));
+    uint64x2_t hi = vreinterpretq_u64_p128(vmull_p64((poly64_t)vgetq_lane_u64(x, 1), (poly64_t)khi));
+    return veorq_u64(lo, hi);
+}
+
+static uint64_t
+crc64_fold_pmull(const crc64_variant *v, uint64_t crc, const uint8_t *p, size_t len)
+{
+    uint64x2_t x0, x1, x2, x3;
+    uint8_t rest[16];
+
+    x0 = veorq_u64(vreinterpretq_u64_u8(vld1q_u8(p)), vcombine_u64(vcreate_u64(crc), vcreate_u64(0)));
+    x1 = vreinterpretq_u64_u8(vld1q_u8(p + 16));
+    x2 = vreinterpretq_u64_u8(vld1q_u8(p + 32));
+    x3 = vreinterpretq_u64_u8(vld1q_u8(p + 48));
+    p += 64;
+    len -= 64;
+
+    while (len >= 64)
+    {
+        x0 = veorq_u64(crc64_fold_pmull_step(x0, v->k[2], v->k[3]), vreinterpretq_u64_u8(vld1q_u8(p)));
+        x1 = veorq_u64(crc64_fold_pmull_step(x1, v->k[2], v->k[3]), vreinterpretq_u64_u8(vld1q_u8(p + 16)));
+        x2 = veorq_u64(crc64_fold_pmull_step(x2, v->k[2], v->k[3]), vreinterpretq_u64_u8(vld1q_u8(p + 32)));
+        x3 = veorq_u64(crc64_fold_pmull_step(x3, v->k[2], v->k[3]), vreinterpretq_u64_u8(vld1q_u8(p + 48)));
+        p += 64;
+        len -= 64;
+    }
+
+    x1 = veorq_u64(x1, crc64_fold_pmull_step(x0, v->k[0], v->k[1]));
+    x2 = veorq_u64(x2, crc64_fold_pmull_step(x1, v->k[0], v->k[1]));
+    x3 = veorq_u64(x3, crc64_fold_pmull_step(x2, v->k[0], v->k[1]));
+
+    while (len >= 16)
+    {
+        x3 = veorq_u64(crc64_fold_pmull_step(x3, v->k[0], v->k[1]), vreinterpretq_u64_u8(vld1q_u8(p)));
+        p += 16;
+        len -= 16;
+    }
+
+    vst1q_u8(rest, vreinterpretq_u8_u64(x3));
+    crc = crc64_table_reflected(v, 0, rest, 16);
+    return crc64_table_reflected(v, crc, p, len);
+}
+#endif
+
+/* Runtime kernel selection for the reflected variants */
+typedef uint64_t (*crc64_fn) (const crc64_variant *v, uint64_t crc, const uint8_t *p, size_t len);
+
+static uint64_t crc64_choose(const crc64_variant *v, uint64_t crc, const uint8_t *p, size_t len);
+
+static crc64_fn crc64_reflected_impl = crc64_choose;
+
+static uint64_t
+crc64_choose(const crc64_variant *v, uint64_t crc, const uint8_t *p, size_t len)
+{
+#ifdef CRC64_USE_PCLMUL
+    unsigned int eax, ebx, ecx, edx;
+
+    if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & bit_PCLMUL))
+        crc64_reflected_impl = crc64_fold_pclmul;
+    else
+        crc64_reflected_impl = crc64_table_reflected;
+#elif defined(CRC64_USE_PMULL)
+    crc64_reflected_impl = crc64_fold_pmull;
+#else
+    crc64_reflected_impl = crc64_table_reflected;
+#endif
+    return crc64_reflected_impl(v, crc, p, len);
+}
+
+/*
+ * Compute a CRC-64.  initial_crc is a previous result to continue from, so
+ * crc64(b, crc64(a)) == crc64(a || b); pass 0 to start a new checksum.
+ */
+static uint64_t
+crc64(crc64_variant *v, const void *data, size_t len, uint64_t initial_crc)
+{
+    const uint8_t *p = (const uint8_t *)data;
+    uint64_t crc = initial_crc ^ v->xorout;
+
+    crc64_init_table(v);
+
+    if (!v->reflected)
+        crc = crc64_table_normal(v, crc, p, len);
+    else if (len >= CRC64_FOLD_MIN_LEN)
+        crc = crc64_reflected_impl(v, crc, p, len);
+    else
+        crc = crc64_table_reflected(v, crc, p, len);
+
+    return crc ^ v->xorout;
+}
+
+typedef struct crc64_stream
+{
+    crc64_variant *variant;
+    uint64_t    crc;
+} crc64_stream;
+
+static void
+crc64_stream_update(void *arg, const uint8 *data, size_t len)
+{
+    crc64_stream *stream = (crc64_stream *) arg;
+
+    stream->crc = crc64(stream->variant, data, len, stream->crc);
+}
+
+/* hash_file support: each variant with the default initial CRC */
+static void *
+crc64_file_start(crc64_variant *v)
+{
+    crc64_stream *stream = (crc64_stream *) palloc(sizeof(crc64_stream));
+
+    stream->variant = v;
+    stream->crc = 0;
+    return stream;
+}
+
+static void *
+crc64_xz_file_start(void)
+{
+    return crc64_file_start(&crc64_xz);
+}
+
+static void *
+crc64_nvme_file_start(void)
+{
+    return crc64_file_start(&crc64_nvme);
+}
+
+static void *
+crc64_ecma_file_start(void)
+{
+    return crc64_file_start(&crc64_ecma);
+}
+
+static int64
+crc64_file_finish(void *state)
+{
+    return (int64) ((crc64_stream *) state)->crc;
+}
+
+const HashlibFileHasher crc64_file_hasher = {
+    "crc64", crc64_xz_file_start, crc64_stream_update, crc64_file_finish
+};
+
+const HashlibFileHasher crc64_nvme_file_hasher = {
+    "crc64_nvme", crc64_nvme_file_start, crc64_stream_update, crc64_file_finish
+};
+
+const HashlibFileHasher crc64_ecma_file_hasher = {
+    "crc64_ecma", crc64_ecma_file_start, crc64_stream_update, crc64_file_finish
+};
+
+/* CRC-64 of a text or bytea datum, streaming large out-of-line values */
+static uint64_t
+crc64_datum(crc64_variant *v, Datum value, uint64_t initial_crc)
+{
+    bytea *input;
+    crc64_stream stream;
+
+    if (hashlib_datum_streamable(value))
+    {
+        stream.variant = v;
+        stream.crc = initial_crc;
+        hashlib_stream_datum(value, crc64_stream_update, &stream);
+        return stream.crc;
+    }
+
+    input = DatumGetByteaPP(value);
+    return crc64(v, VARDATA_ANY(input), VARSIZE_ANY_EXHDR(input), initial_crc);
+}
+
+/* CRC-64/XZ for text input with default initial CRC (0) */
+PG_FUNCTION_INFO_V1(crc64_text);
+
+Datum
+crc64_text(PG_FUNCTION_ARGS)
+{
+    uint64_t hash = crc64_datum(&crc64_xz, PG_GETARG_DATUM(0), 0);
+    PG_RETURN_INT64((int64_t)hash);
+}
+
+/* CRC-64/XZ for text input with custom initial CRC */
+PG_FUNCTION_INFO_V1(crc64_text_seed);
+
+Datum
+crc64_text_seed(PG_FUNCTION_ARGS)
+{
+    int64_t seed = PG_GETARG_INT64(1);
+    uint64_t hash = crc64_datum(&crc64_xz, PG_GETARG_DATUM(0), (uint64_t)seed);
+    PG_RETURN_INT64((int64_t)hash);
+}
+
+/* CRC-64/XZ for bytea input with default initial CRC (0) */
+PG_FUNCTION_INFO_V1(crc64_bytea);
+
+Datum
+crc64_bytea(PG_FUNCTION_ARGS)
+{
+    uint64_t hash = crc64_datum(&crc64_xz, PG_GETARG_DATUM(0), 0);
+    PG_RETURN_INT64((int64_t)hash);
+}
+
+/* CRC-64/XZ for bytea input with custom initial CRC */
+PG_FUNCTION_INFO_V1(crc64_bytea_seed);
+
+Datum
+crc64_bytea_seed(PG_FUNCTION_ARGS)
+{
+    int64_t seed = PG_GETARG_INT64(1);
+    uint64_t hash = crc64_datum(&crc64_xz, PG_GETARG_DATUM(0), (uint64_t)seed);
+    PG_RETURN_INT64((int64_t)hash);
+}
+
+/* CRC-64/XZ for integer input */
+PG_FUNCTION_INFO_V1(crc64_int);
+
+Datum
+crc64_int(PG_FUNCTION_ARGS)
+{
+    int32_t input = PG_GETARG_INT32(0);
+    uint64_t hash = crc64(&crc64_xz, &input, sizeof(int32_t), 0);
+    PG_RETURN_INT64((int64_t)hash);
+}
+
+/* CRC-64/XZ for integer input with custom initial CRC */
+PG_FUNCTION_INFO_V1(crc64_int_seed);
+
+Datum
+crc64_int_seed(PG_FUNCTION_ARGS)
+{
+    int32_t input = PG_GETARG_INT32(0);
+    int64_t seed = PG_GETARG_INT64(1);
+    uint64_t hash = crc64(&crc64_xz, &input, sizeof(int32_t), (uint64_t)seed);
+    PG_RETURN_INT64((int64_t)hash);
+}
+
+/* CRC-64/NVME for text input with default initial CRC (0) */
+PG_FUNCTION_INFO_V1(crc64_nvme_text);
+
+Datum
+crc64_nvme_text(PG_FUNCTION_ARGS)
+{
+    uint64_t hash = crc64_datum(&crc64_nvme, PG_GETARG_DATUM(0), 0);
+    PG_RETURN_INT64((int64_t)hash);
+}
+
+/* CRC-64/NVME for text input with custom initial CRC */
+PG_FUNCTION_INFO_V1(crc64_nvme_text_seed);
+
+Datum
+crc64_nvme_text_seed(PG_FUNCTION_ARGS)
+{
+    int64_t seed = PG_GETARG_INT64(1);
+    uint64_t hash = crc64_datum(&crc64_nvme, PG_GETARG_DATUM(0), (uint64_t)seed);
+    PG_RETURN_INT64((int64_t)hash);
+}
+
+/* CRC-64/NVME for bytea input with default initial CRC (0) */
+PG_FUNCTION_INFO_V1(crc64_nvme_bytea);
+
+Datum
+crc64_nvme_bytea(PG_FUNCTION_ARGS)
+{
+    uint64_t hash = crc64_datum(&crc64_nvme, PG_GETARG_DATUM(0), 0);
+    PG_RETURN_INT64((int64_t)hash);
+}
+
+/* CRC-64/NVME for bytea input with custom initial CRC */
+PG_FUNCTION_INFO_V1(crc64_nvme_bytea_seed);
+
+Datum
+crc64_nvme_bytea_seed(PG_FUNCTION_ARGS)
+{
+    int64_t seed = PG_GETARG_INT64(1);
+    uint64_t hash = crc64_datum(&crc64_nvme, PG_GETARG_DATUM(0), (uint64_t)seed);
+    PG_RETURN_INT64((int64_t)hash);
+}
+
+/* CRC-64/NVME for integer input */
+PG_FUNCTION_INFO_V1(crc64_nvme_int);
+
+Datum
+crc64_nvme_int(PG_FUNCTION_ARGS)
+{
+    int32_t input = PG_GETARG_INT32(0);
+    uint64_t hash = crc64(&crc64_nvme, &input, sizeof(int32_t), 0);
+    PG_RETURN_INT64((int64_t)hash);
+}
+
+/* CRC-64/NVME for integer input with custom initial CRC */
+PG_FUNCTION_INFO_V1(crc64_nvme_int_seed);
+
+Datum
+crc64_nvme_int_seed(PG_FUNCTION_ARGS)
+{
+    int32_t input = PG_GETARG_INT32(0);
+    int64_t seed = PG_GETARG_INT64(1);
+    uint64_t hash = crc64(&crc64_nvme, &input, sizeof(int32_t), (uint64_t)seed);
+    PG_RETURN_INT64((int64_t)hash);
+}
+
+/* CRC-64/ECMA-182 for text input with default initial CRC (0) */
+PG_FUNCTION_INFO_V1(crc64_ecma_text);
+
+Datum
+crc64_ecma_text(PG_FUNCTION_ARGS)
+{
+    uint64_t hash = crc64_datum(&crc64_ecma, PG_GETARG_DATUM(0), 0);
+    PG_RETURN_INT64((int64_t)hash);
+}
+
+/* CRC-64/ECMA-182 for text input with custom initial CRC */
+PG_FUNCTION_INFO_V1(crc64_ecma_text_seed);
+
+Datum
+crc64_ecma_text_seed(PG_FUNCTION_ARGS)
+{
+    int64_t seed = PG_GETARG_INT64(1);
+    uint64_t hash = crc64_datum(&crc64_ecma, PG_GETARG_DATUM(0), (uint64_t)seed);
+    PG_RETURN_INT64((int64_t)hash);
+}
+
+/* CRC-64/ECMA-182 for bytea input with default initial CRC (0) */
+PG_FUNCTION_INFO_V1(crc64_ecma_bytea);
+
+Datum
+crc64_ecma_bytea(PG_FUNCTION_ARGS)
+{
+    uint64_t hash = crc64_datum(&crc64_ecma, PG_GETARG_DATUM(0), 0);
+    PG_RETURN_INT64((int64_t)hash);
+}
+
+/* CRC-64/ECMA-182 for bytea input with custom initial CRC */
+PG_FUNCTION_INFO_V1(crc64_ecma_bytea_seed);
+
+Datum
+crc64_ecma_bytea_seed(PG_FUNCTION_ARGS)
+{
+    int64_t seed = PG_GETARG_INT64(1);
+    uint64_t hash = crc64_datum(&crc64_ecma, PG_GETARG_DATUM(0), (uint64_t)seed);
+    PG_RETURN_INT64((int64_t)hash);
+}
+
+/* CRC-64/ECMA-182 for integer input */
+PG_FUNCTION_INFO_V1(crc64_ecma_int);
+
+Datum
+crc64_ecma_int(PG_FUNCTION_ARGS)
+{
+    int32_t input = PG_GETARG_INT32(0);
+    uint64_t hash = crc64(&crc64_ecma, &input, sizeof(int32_t), 0);
+    PG_RETURN_INT64((int64_t)hash);
+}
+
+/* CRC-64/ECMA-182 for integer input with custom initial CRC */
+PG_FUNCTION_INFO_V1(crc64_ecma_int_seed);
+
+Datum
+crc64_ecma_int_seed(PG_FUNCTION_ARGS)
+{
+    int32_t input = PG_GETARG_INT32(0);
+    int64_t seed = PG_GETARG_INT64(1);
+    uint64_t hash = crc64(&crc64_ecma, &input, sizeof(int32_t), (uint64_t)seed);
+    PG_RETURN_INT64((int64_t)hash);
+}
@@ -4,6 +4,8 @@
 #include "mb/pg_wchar.h"
 #include "access/htup_details.h"
 
+#include "hashlib_bucket.h"
+
 /* FarmHash constants */
 #define FARMHASH_K0 0xc3a5c85c97cb3127ULL
 #define FARMHASH_K1 0xb492b66fbe98f273ULL
@@ -292,6 +294,17 @@ farmhash64_with_seeds(const char *s, size_t len, uint64_t seed0, uint64_t seed1)
     return farmhash_hash_len_16(farmhash64_impl(s, len) - seed0, seed1, FARMHASH_K1);
 }
 
+/* hash_bucket support: FarmHash64 without a seed */
+static uint64
+farmhash64_bucket_hash(const void *data, size_t len)
+{
+    return farmhash64_impl((const char *)data, len);
+}
+
+const HashlibBucketHasher farmhash64_bucket_hasher = {
+    "farmhash64", farmhash64_bucket_hash
+};
+
 /* PostgreSQL function wrappers for FarmHash32 */
 
 /* FarmHash32 for text input with default seed */
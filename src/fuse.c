@@ -0,0 +1,792 @@
+#include "postgres.h"
+#include "fmgr.h"
+#include "utils/builtins.h"
+#include "utils/array.h"
+#include "utils/memutils.h"
+#include "libpq/pqformat.h"
+
+#include <math.h>
+
+#include "hashlib_datum.h"
+#include "hashlib_sketch.h"
+
+/*
+ * Binary fuse filter: a static, approximate membership set (Graf and Lemire,
+ * "Binary Fuse Filters: Fast and Smaller Than Xor Filters", 2022).
+ *
+ * The filter is an array of 8- or 16-bit fingerprints split into segments.
+ * A key maps to three slots in three consecutive segments, and the filter is
+ * built so that the xor of those slots equals the key's fingerprint.  A probe
+ * is three reads and a compare, with a false positive rate of 2^-bits.  The
+ * array holds about 1.13 slots per key for large sets, against about 1.44
+ * times log2(1/fpp) bits per key for an optimal Bloom filter.
+ *
+ * Values are hashed once with xxhash3_64 over their canonical bytes (see
+ * hashlib_datum.h) and the filter hash of a key is fmix64(key + seed).
+ * Building fails with small probability for a given seed, in which case it is
+ * retried with the next seed from a fixed splitmix64 sequence, so the same
+ * set always gives the same filter.  The aggregate collects the 64-bit keys,
+ * sorts them to remove duplicates and builds the filter in the final step.
+ *
+ * Stored layout (integers little-endian):
+ *
+ *   byte 0       format version (1)
+ *   byte 1       fingerprint bits (8 or 16)
+ *   bytes 2-3    reserved (0)
+ *   bytes 4-7    segment length (a power of two)
+ *   bytes 8-11   segment count
+ *   bytes 12-15  number of distinct keys
+ *   bytes 16-23  seed
+ *   then         (segment count + 2) * segment length fingerprints
+ */
+
+#if defined(__GNUC__) || defined(__clang__)
+#define fuse_prefetch(p)    __builtin_prefetch(p)
+#else
+#define fuse_prefetch(p)    ((void) 0)
+#endif
+
+#define FUSE_VERSION            1
+#define FUSE_HEADER_SIZE        24
+#define FUSE_ARITY              3
+#define FUSE_MAX_SEGMENT_LENGTH 262144
+#define FUSE_MAX_KEYS           100000000
+#define FUSE_MAX_ITERATIONS     100
+#define FUSE_DEFAULT_BITS       8
+
+/* How many keys ahead of the probe to prefetch */
+#define FUSE_PREFETCH_DISTANCE  8
+
+typedef struct FuseState
+{
+    int         bits;
+    int64       nkeys;
+    int64       capacity;
+    uint64     *keys;           /* xxhash3_64 of the values; duplicates are
+                                 * removed when the buffer fills */
+} FuseState;
+
+/* Shape of a filter, derived from its number of keys */
+typedef struct FuseShape
+{
+    uint32      segment_length;
+    uint32      segment_count;
+} FuseShape;
+
+static void
+fuse_check_bits(int32 bits)
+{
+    if (bits != 8 && bits != 16)
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("binary fuse filter fingerprint bits must be 8 or 16")));
+}
+
+static FuseState *
+fuse_state_create(MemoryContext context, int bits)
+{
+    FuseState *state = (FuseState *) MemoryContextAlloc(context, sizeof(FuseState));
+
+    state->bits = bits;
+    state->nkeys = 0;
+    state->capacity = 1024;
+    state->keys = (uint64 *) MemoryContextAlloc(context, sizeof(uint64) * state->capacity);
+    return state;
+}
+
+static int
+fuse_key_cmp(const void *a, const void *b)
+{
+    uint64 x = *(const uint64 *) a;
+    uint64 y = *(const uint64 *) b;
+
+    return x < y ? -1 : x > y ? 1 : 0;
+}
+
+static void
+fuse_state_dedupe(FuseState *state)
+{
+    int64 n = 0;
+    int64 i;
+
+    qsort(state->keys, state->nkeys, sizeof(uint64), fuse_key_cmp);
+    for (i = 0; i < state->nkeys; i++)
+    {
+        if (n == 0 || state->keys[n - 1] != state->keys[i])
+            state->keys[n++] = state->keys[i];
+    }
+    state->nkeys = n;
+}
+
+/*
+ * Make room for n more keys.  A full buffer is first sorted and deduplicated,
+ * so that the limit applies to distinct keys; it only grows when that leaves
+ * it more than half full, which keeps the sorting amortized.
+ */
+static void
+fuse_state_reserve(FuseState *state, int64 n)
+{
+    if (state->nkeys + n <= state->capacity)
+        return;
+    fuse_state_dedupe(state);
+    if (state->nkeys + n <= state->capacity / 2)
+        return;
+    if (state->nkeys + n > FUSE_MAX_KEYS)
+        ereport(ERROR,
+                (errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+                 errmsg("binary fuse filter cannot hold more than %d keys", FUSE_MAX_KEYS)));
+    state->capacity = Min(Max(state->capacity * 2, state->nkeys + n), FUSE_MAX_KEYS);
+    state->keys = (uint64 *) repalloc_huge(state->keys, sizeof(uint64) * state->capacity);
+}
+
+static void
+fuse_state_add(FuseState *state, uint64 key)
+{
+    fuse_state_reserve(state, 1);
+    state->keys[state->nkeys++] = key;
+}
+
+static void
+fuse_state_merge(FuseState *state, const FuseState *other)
+{
+    int64 i;
+
+    if (state->bits != other->bits)
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("cannot merge binary fuse filter states of %d and %d bits",
+                        state->bits, other->bits)));
+
+    /* key by key, so that keys the states share are dropped as the buffer fills */
+    for (i = 0; i < other->nkeys; i++)
+        fuse_state_add(state, other->keys[i]);
+}
+
+static FuseShape
+fuse_shape(uint32 size)
+{
+    FuseShape shape;
+    uint32 capacity;
+    int64 segments;
+
+    if (size == 0)
+        shape.segment_length = 4;
+    else
+        shape.segment_length = (uint32) 1 << (int) floor(log((double) size) / log(3.33) + 2.25);
+    shape.segment_length = Min(shape.segment_length, FUSE_MAX_SEGMENT_LENGTH);
+
+    if (size <= 1)
+        capacity = 0;
+    else
+        capacity = (uint32) round((double) size *
+                                  Max(1.125, 0.875 + 0.25 * log(1000000.0) / log((double) size)));
+    segments = ((int64) capacity + shape.segment_length - 1) / shape.segment_length - (FUSE_ARITY - 1);
+    shape.segment_count = (uint32) Max(segments, 1);
+    return shape;
+}
+
+static inline Size
+fuse_array_length(FuseShape shape)
+{
+    return (Size) (shape.segment_count + FUSE_ARITY - 1) * shape.segment_length;
+}
+
+/* Slot index of hash in segment offset 0, 1 or 2 */
+static inline uint32
+fuse_slot(int index, uint64 hash, FuseShape shape)
+{
+    uint32 h = hashlib_reduce64(hash, shape.segment_count * shape.segment_length);
+    uint64 hh = hash & ((UINT64CONST(1) << 36) - 1);
+
+    h += index * shape.segment_length;
+    return h ^ (uint32) ((hh >> (36 - 18 * index)) & (shape.segment_length - 1));
+}
+
+static inline uint32
+fuse_fingerprint(uint64 hash)
+{
+    return (uint32) (hash ^ (hash >> 32));
+}
+
+/* splitmix64, the sequence of seeds tried */
+static uint64
+fuse_next_seed(uint64 *counter)
+{
+    uint64 z = (*counter += UINT64CONST(0x9E3779B97F4A7C15));
+
+    z = (z ^ (z >> 30)) * UINT64CONST(0xBF58476D1CE4E5B9);
+    z = (z ^ (z >> 27)) * UINT64CONST(0x94D049BB133111EB);
+    return z ^ (z >> 31);
+}
+
+static inline uint32
+fuse_mod3(uint8 x)
+{
+    return x > 2 ? x - 3 : x;
+}
+
+/*
+ * Build the filter of size distinct keys: peel the 3-hypergraph of keys and
+ * slots, then assign fingerprints in reverse peeling order.  Returns NULL if
+ * no seed worked.
+ *
+ * The peeling only looks at the per-slot counts and xors, so the result
+ * depends on the set of keys, not on their order.
+ */
+static bytea *
+fuse_build(const uint64 *keys, uint32 size, int bits)
+{
+    uint64 counter = UINT64CONST(0x726b2b9d438b9d4d);
+    FuseShape shape = fuse_shape(size);
+    Size length = fuse_array_length(shape);
+    Size nbytes = length * (bits / 8);
+    uint64 *order = (uint64 *) palloc_extended(sizeof(uint64) * ((Size) size + 1), MCXT_ALLOC_HUGE);
+    uint8 *found = (uint8 *) palloc_extended(Max(size, 1), MCXT_ALLOC_HUGE);
+    uint32 *alone = (uint32 *) palloc_extended(sizeof(uint32) * length, MCXT_ALLOC_HUGE);
+    uint8 *t2count = (uint8 *) palloc_extended(length, MCXT_ALLOC_HUGE);
+    uint64 *t2hash = (uint64 *) palloc_extended(sizeof(uint64) * length, MCXT_ALLOC_HUGE);
+    uint32 *start;
+    int block_bits = 1;
+    uint32 nblocks;
+    bytea *result = NULL;
+    uint64 seed = 0;
+    uint32 stacksize = 0;
+    int loop;
+    Size i;
+
+    while (((uint32) 1 << block_bits) < shape.segment_count)
+        block_bits++;
+    nblocks = (uint32) 1 << block_bits;
+    start = (uint32 *) palloc(sizeof(uint32) * nblocks);
+
+    for (loop = 0; loop < FUSE_MAX_ITERATIONS && result == NULL; loop++)
+    {
+        uint32 nalone = 0;
+        bool error = false;
+
+        seed = fuse_next_seed(&counter);
+        memset(order, 0, sizeof(uint64) * ((Size) size + 1));
+        memset(t2count, 0, length);
+        memset(t2hash, 0, sizeof(uint64) * length);
+
+        /* order the hashes by segment so that the slot updates are local */
+        order[size] = 1;
+        for (i = 0; i < nblocks; i++)
+            start[i] = (uint32) (((uint64) i * size) >> block_bits);
+        for (i = 0; i < size; i++)
+        {
+            uint64 hash = hashlib_mix64(keys[i] + seed);
+            uint32 segment = (uint32) (hash >> (64 - block_bits));
+
+            while (order[start[segment]] != 0)
+                segment = (segment + 1) & (nblocks - 1);
+            order[start[segment]] = hash;
+            start[segment]++;
+        }
+
+        /* count and xor the keys of each slot */
+        for (i = 0; i < size; i++)
+        {
+            uint64 hash = order[i];
+            uint32 h0 = fuse_slot(0, hash, shape);
+            uint32 h1 = fuse_slot(1, hash, shape);
+            uint32 h2 = fuse_slot(2, hash, shape);
+
+            t2count[h0] += 4;
+            t2hash[h0] ^= hash;
+            t2count[h1] += 4;
+            t2count[h1] ^= 1;
+            t2hash[h1] ^= hash;
+            t2count[h2] += 4;
+            t2count[h2] ^= 2;
+            t2hash[h2] ^= hash;
+
+            /* a wrapped counter: too many keys share a slot */
+            if (t2count[h0] < 4 || t2count[h1] < 4 || t2count[h2] < 4)
+                error = true;
+        }
+        if (error)
+            continue;
+
+        /* peel slots holding one key */
+        for (i = 0; i < length; i++)
+        {
+            alone[nalone] = (uint32) i;
+            nalone += (t2count[i] >> 2) == 1 ? 1 : 0;
+        }
+        stacksize = 0;
+        while (nalone > 0)
+        {
+            uint32 index = alone[--nalone];
+            uint32 h012[5];
+            uint64 hash;
+            uint8 which;
+            uint32 other;
+
+            if ((t2count[index] >> 2) != 1)
+                continue;
+            hash = t2hash[index];
+            h012[0] = fuse_slot(0, hash, shape);
+            h012[1] = fuse_slot(1, hash, shape);
+            h012[2] = fuse_slot(2, hash, shape);
+            h012[3] = h012[0];
+            h012[4] = h012[1];
+            which = t2count[index] & 3;
+            found[stacksize] = which;
+            order[stacksize] = hash;
+            stacksize++;
+
+            other = h012[which + 1];
+            alone[nalone] = other;
+            nalone += (t2count[other] >> 2) == 2 ? 1 : 0;
+            t2count[other] -= 4;
+            t2count[other] ^= fuse_mod3(which + 1);
+            t2hash[other] ^= hash;
+
+            other = h012[which + 2];
+            alone[nalone] = other;
+            nalone += (t2count[other] >> 2) == 2 ? 1 : 0;
+            t2count[other] -= 4;
+            t2count[other] ^= fuse_mod3(which + 2);
+            t2hash[other] ^= hash;
+        }
+        if (stacksize == size)
+            result = (bytea *) palloc_extended(VARHDRSZ + FUSE_HEADER_SIZE + nbytes,
+                                               MCXT_ALLOC_HUGE | MCXT_ALLOC_ZERO);
+    }
+
+    if (result != NULL)
+    {
+        uint8 *data = (uint8 *) VARDATA(result);
+        uint8 *fp = data + FUSE_HEADER_SIZE;
+
+        SET_VARSIZE(result, VARHDRSZ + FUSE_HEADER_SIZE + nbytes);
+        data[0] = FUSE_VERSION;
+        data[1] = (uint8) bits;
+        hashlib_write_le32(data + 4, shape.segment_length);
+        hashlib_write_le32(data + 8, shape.segment_count);
+        hashlib_write_le32(data + 12, stacksize);
+        hashlib_write_le64(data + 16, seed);
+
+        /* each key's slot is the xor of its fingerprint and its other two slots */
+        for (i = stacksize; i-- > 0;)
+        {
+            uint64 hash = order[i];
+            uint32 h012[5];
+
+            h012[0] = fuse_slot(0, hash, shape);
+            h012[1] = fuse_slot(1, hash, shape);
+            h012[2] = fuse_slot(2, hash, shape);
+            h012[3] = h012[0];
+            h012[4] = h012[1];
+            if (bits == 8)
+                fp[h012[found[i]]] = (uint8) fuse_fingerprint(hash) ^
+                    fp[h012[found[i] + 1]] ^ fp[h012[found[i] + 2]];
+            else
+                hashlib_write_le16(fp + 2 * h012[found[i]],
+                                   (uint16) fuse_fingerprint(hash) ^
+                                   hashlib_read_le16(fp + 2 * h012[found[i] + 1]) ^
+                                   hashlib_read_le16(fp + 2 * h012[found[i] + 2]));
+        }
+    }
+
+    pfree(order);
+    pfree(found);
+    pfree(alone);
+    pfree(t2count);
+    pfree(t2hash);
+    pfree(start);
+    return result;
+}
+
+static bytea *
+fuse_state_build(FuseState *state)
+{
+    bytea *result;
+
+    /* removing repeated keys leaves the state describing the same set */
+    fuse_state_dedupe(state);
+    result = fuse_build(state->keys, (uint32) state->nkeys, state->bits);
+    if (result == NULL)
+        ereport(ERROR,
+                (errcode(ERRCODE_INTERNAL_ERROR),
+                 errmsg("could not build binary fuse filter of " INT64_FORMAT " keys", state->nkeys)));
+    return result;
+}
+
+static void
+fuse_invalid(void)
+{
+    ereport(ERROR,
+            (errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+             errmsg("invalid binary fuse filter")));
+}
+
+static void
+fuse_validate(const bytea *filter)
+{
+    const uint8 *data = (const uint8 *) VARDATA_ANY(filter);
+    Size size = VARSIZE_ANY_EXHDR(filter);
+    FuseShape shape;
+
+    if (size < FUSE_HEADER_SIZE || data[0] != FUSE_VERSION ||
+        (data[1] != 8 && data[1] != 16) || data[2] != 0 || data[3] != 0)
+        fuse_invalid();
+
+    shape.segment_length = hashlib_read_le32(data + 4);
+    shape.segment_count = hashlib_read_le32(data + 8);
+    if (shape.segment_length == 0 || shape.segment_length > FUSE_MAX_SEGMENT_LENGTH ||
+        (shape.segment_length & (shape.segment_length - 1)) != 0 ||
+        shape.segment_count == 0 || shape.segment_count > PG_UINT32_MAX / shape.segment_length - 2 ||
+        hashlib_read_le32(data + 12) > FUSE_MAX_KEYS ||
+        size != FUSE_HEADER_SIZE + fuse_array_length(shape) * (data[1] / 8))
+        fuse_invalid();
+}
+
+/* Whether the key with xxhash3_64 value key may be in the filter */
+static inline bool
+fuse_probe(const uint8 *data, uint64 key)
+{
+    FuseShape shape;
+    uint64 hash = hashlib_mix64(key + hashlib_read_le64(data + 16));
+    const uint8 *fp = data + FUSE_HEADER_SIZE;
+    uint32 h0;
+    uint32 h1;
+    uint32 h2;
+
+    shape.segment_length = hashlib_read_le32(data + 4);
+    shape.segment_count = hashlib_read_le32(data + 8);
+    h0 = fuse_slot(0, hash, shape);
+    h1 = fuse_slot(1, hash, shape);
+    h2 = fuse_slot(2, hash, shape);
+    if (data[1] == 8)
+        return (uint8) fuse_fingerprint(hash) == (fp[h0] ^ fp[h1] ^ fp[h2]);
+    return (uint16) fuse_fingerprint(hash) ==
+        (hashlib_read_le16(fp + 2 * h0) ^ hashlib_read_le16(fp + 2 * h1) ^ hashlib_read_le16(fp + 2 * h2));
+}
+
+/* Start fetching the slots of key, to be probed shortly */
+static inline void
+fuse_prefetch_key(const uint8 *data, uint64 key)
+{
+    FuseShape shape;
+    uint64 hash = hashlib_mix64(key + hashlib_read_le64(data + 16));
+    const uint8 *fp = data + FUSE_HEADER_SIZE;
+    int width = data[1] / 8;
+
+    shape.segment_length = hashlib_read_le32(data + 4);
+    shape.segment_count = hashlib_read_le32(data + 8);
+    fuse_prefetch(fp + (Size) width * fuse_slot(0, hash, shape));
+    fuse_prefetch(fp + (Size) width * fuse_slot(1, hash, shape));
+    fuse_prefetch(fp + (Size) width * fuse_slot(2, hash, shape));
+}
+
+/* Hash of a non-null value of the type described by io */
+static uint64
+fuse_hash_value(HashlibTypeIO *io, Datum value)
+{
+    bytea *bytes = hashlib_value_bytes(io, value);
+    uint64 hash = hashlib_xxh3_64(VARDATA(bytes), VARSIZE(bytes) - VARHDRSZ);
+
+    pfree(bytes);
+    return hash;
+}
+
+/* fn_extra of the probe functions */
+typedef struct FuseCache
+{
+    HashlibTypeIO *io;
+    HashlibDetoastCache filter;
+} FuseCache;
+
+static FuseCache *
+fuse_cache(FunctionCallInfo fcinfo)
+{
+    if (fcinfo->flinfo->fn_extra == NULL)
+        fcinfo->flinfo->fn_extra = MemoryContextAllocZero(fcinfo->flinfo->fn_mcxt, sizeof(FuseCache));
+    return (FuseCache *) fcinfo->flinfo->fn_extra;
+}
+
+/* fuse_filter_in(cstring) -> fuse_filter */
+PG_FUNCTION_INFO_V1(fuse_filter_in);
+
+Datum
+fuse_filter_in(PG_FUNCTION_ARGS)
+{
+    bytea *filter = (bytea *) hashlib_sketch_from_hex(PG_GETARG_CSTRING(0), "fuse_filter");
+
+    fuse_validate(filter);
+    PG_RETURN_BYTEA_P(filter);
+}
+
+/* fuse_filter_out(fuse_filter) -> cstring */
+PG_FUNCTION_INFO_V1(fuse_filter_out);
+
+Datum
+fuse_filter_out(PG_FUNCTION_ARGS)
+{
+    PG_RETURN_CSTRING(hashlib_sketch_to_hex((struct varlena *) PG_GETARG_BYTEA_PP(0)));
+}
+
+/* fuse_filter_recv(internal) -> fuse_filter */
+PG_FUNCTION_INFO_V1(fuse_filter_recv);
+
+Datum
+fuse_filter_recv(PG_FUNCTION_ARGS)
+{
+    bytea *filter = (bytea *) hashlib_sketch_recv((StringInfo) PG_GETARG_POINTER(0));
+
+    fuse_validate(filter);
+    PG_RETURN_BYTEA_P(filter);
+}
+
+/* fuse_filter_send(fuse_filter) -> bytea */
+PG_FUNCTION_INFO_V1(fuse_filter_send);
+
+Datum
+fuse_filter_send(PG_FUNCTION_ARGS)
+{
+    bytea *filter = PG_GETARG_BYTEA_PP(0);
+    StringInfoData buf;
+
+    pq_begintypsend(&buf);
+    pq_sendbytes(&buf, VARDATA_ANY(filter), VARSIZE_ANY_EXHDR(filter));
+    PG_RETURN_BYTEA_P(pq_endtypsend(&buf));
+}
+
+/* fuse_filter(bytea) -> fuse_filter: checks the stored layout, for the bytea cast */
+PG_FUNCTION_INFO_V1(fuse_filter_from_bytea);
+
+Datum
+fuse_filter_from_bytea(PG_FUNCTION_ARGS)
+{
+    bytea *filter = PG_GETARG_BYTEA_P_COPY(0);
+
+    fuse_validate(filter);
+    PG_RETURN_BYTEA_P(filter);
+}
+
+/* fuse_contains(fuse_filter, anyelement) -> boolean */
+PG_FUNCTION_INFO_V1(fuse_contains);
+
+Datum
+fuse_contains(PG_FUNCTION_ARGS)
+{
+    FuseCache *cache = fuse_cache(fcinfo);
+    const uint8 *data;
+    HashlibTypeIO *io;
+
+    data = (const uint8 *) VARDATA_ANY(hashlib_sketch_getarg_cached(fcinfo, 0, &cache->filter,
+                                                                    fuse_validate));
+    io = hashlib_type_io(fcinfo->flinfo, hashlib_arg_type(fcinfo, 1), &cache->io);
+    PG_RETURN_BOOL(fuse_probe(data, fuse_hash_value(io, PG_GETARG_DATUM(1))));
+}
+
+/*
+ * fuse_contains_any(fuse_filter, anyarray) -> boolean
+ *
+ * Whether any non-null element may be in the filter.  All elements are
+ * hashed first and then probed in one pass, prefetching the slots of later
+ * elements while the current one is tested.
+ */
+PG_FUNCTION_INFO_V1(fuse_contains_any);
+
+Datum
+fuse_contains_any(PG_FUNCTION_ARGS)
+{
+    ArrayType *array = PG_GETARG_ARRAYTYPE_P(1);
+    FuseCache *cache = fuse_cache(fcinfo);
+    HashlibTypeIO *io;
+    const uint8 *data;
+    Datum *elems;
+    bool *nulls;
+    uint64 *keys;
+    int nelems;
+    int n = 0;
+    int i;
+
+    data = (const uint8 *) VARDATA_ANY(hashlib_sketch_getarg_cached(fcinfo, 0, &cache->filter,
+                                                                    fuse_validate));
+    io = hashlib_type_io(fcinfo->flinfo, ARR_ELEMTYPE(array), &cache->io);
+
+    deconstruct_array(array, io->typid, io->typlen, io->typbyval, io->typalign,
+                      &elems, &nulls, &nelems);
+    if (nelems == 0)
+        PG_RETURN_BOOL(false);
+
+    keys = (uint64 *) palloc(sizeof(uint64) * nelems);
+    for (i = 0; i < nelems; i++)
+    {
+        if (!nulls[i])
+            keys[n++] = fuse_hash_value(io, elems[i]);
+    }
+
+    for (i = 0; i < Min(n, FUSE_PREFETCH_DISTANCE); i++)
+        fuse_prefetch_key(data, keys[i]);
+    for (i = 0; i < n; i++)
+    {
+        if (i + FUSE_PREFETCH_DISTANCE < n)
+            fuse_prefetch_key(data, keys[i + FUSE_PREFETCH_DISTANCE]);
+        if (fuse_probe(data, keys[i]))
+            PG_RETURN_BOOL(true);
+    }
+    PG_RETURN_BOOL(false);
+}
+
+/* fuse_count(fuse_filter) -> bigint: number of distinct keys */
+PG_FUNCTION_INFO_V1(fuse_count);
+
+Datum
+fuse_count(PG_FUNCTION_ARGS)
+{
+    bytea *filter = PG_GETARG_BYTEA_PP(0);
+
+    fuse_validate(filter);
+    PG_RETURN_INT64((int64) hashlib_read_le32((const uint8 *) VARDATA_ANY(filter) + 12));
+}
+
+/* fuse_bits(fuse_filter) -> integer: fingerprint bits */
+PG_FUNCTION_INFO_V1(fuse_bits);
+
+Datum
+fuse_bits(PG_FUNCTION_ARGS)
+{
+    bytea *filter = PG_GETARG_BYTEA_PP(0);
+
+    fuse_validate(filter);
+    PG_RETURN_INT32((int32) ((const uint8 *) VARDATA_ANY(filter))[1]);
+}
+
+/* fuse_agg_transfn(internal, anyelement [, bits integer]) -> internal */
+PG_FUNCTION_INFO_V1(fuse_agg_transfn);
+
+Datum
+fuse_agg_transfn(PG_FUNCTION_ARGS)
+{
+    MemoryContext aggcontext;
+    FuseState *state;
+
+    if (!AggCheckCallContext(fcinfo, &aggcontext))
+        elog(ERROR, "fuse_agg_transfn called in non-aggregate context");
+
+    if (PG_ARGISNULL(0))
+    {
+        int32 bits = FUSE_DEFAULT_BITS;
+
+        if (PG_NARGS() > 2)
+        {
+            if (PG_ARGISNULL(2))
+                ereport(ERROR,
+                        (errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED),
+                         errmsg("binary fuse filter fingerprint bits must not be null")));
+            bits = PG_GETARG_INT32(2);
+        }
+        fuse_check_bits(bits);
+        state = fuse_state_create(aggcontext, bits);
+    }
+    else
+        state = (FuseState *) PG_GETARG_POINTER(0);
+
+    if (!PG_ARGISNULL(1))
+        fuse_state_add(state, fuse_hash_value(hashlib_arg_type_io(fcinfo, 1), PG_GETARG_DATUM(1)));
+
+    PG_RETURN_POINTER(state);
+}
+
+/* fuse_agg_combine(internal, internal) -> internal */
+PG_FUNCTION_INFO_V1(fuse_agg_combine);
+
+Datum
+fuse_agg_combine(PG_FUNCTION_ARGS)
+{
+    MemoryContext aggcontext;
+    FuseState *state;
+    FuseState *other;
+
+    if (!AggCheckCallContext(fcinfo, &aggcontext))
+        elog(ERROR, "fuse_agg_combine called in non-aggregate context");
+
+    if (PG_ARGISNULL(1))
+        PG_RETURN_POINTER(PG_ARGISNULL(0) ? NULL : PG_GETARG_POINTER(0));
+
+    other = (FuseState *) PG_GETARG_POINTER(1);
+    if (PG_ARGISNULL(0))
+        state = fuse_state_create(aggcontext, other->bits);
+    else
+        state = (FuseState *) PG_GETARG_POINTER(0);
+    fuse_state_merge(state, other);
+
+    PG_RETURN_POINTER(state);
+}
+
+/*
+ * fuse_agg_serialize(internal) -> bytea
+ *
+ * A partial state is the fingerprint bits followed by the distinct collected
+ * keys as little-endian 64-bit integers.
+ */
+PG_FUNCTION_INFO_V1(fuse_agg_serialize);
+
+Datum
+fuse_agg_serialize(PG_FUNCTION_ARGS)
+{
+    FuseState *state = (FuseState *) PG_GETARG_POINTER(0);
+    Size size;
+    bytea *result;
+    uint8 *data;
+    int64 i;
+
+    /* removing repeated keys leaves the state describing the same set */
+    fuse_state_dedupe(state);
+    size = 1 + sizeof(uint64) * state->nkeys;
+    result = (bytea *) palloc_extended(VARHDRSZ + size, MCXT_ALLOC_HUGE);
+    SET_VARSIZE(result, VARHDRSZ + size);
+    data = (uint8 *) VARDATA(result);
+    data[0] = (uint8) state->bits;
+    for (i = 0; i < state->nkeys; i++)
+        hashlib_write_le64(data + 1 + 8 * i, state->keys[i]);
+    PG_RETURN_BYTEA_P(result);
+}
+
+/* fuse_agg_deserialize(bytea, internal) -> internal */
+PG_FUNCTION_INFO_V1(fuse_agg_deserialize);
+
+Datum
+fuse_agg_deserialize(PG_FUNCTION_ARGS)
+{
+    bytea *partial;
+    const uint8 *data;
+    Size size;
+    FuseState *state;
+    int64 n;
+    int64 i;
+
+    if (!AggCheckCallContext(fcinfo, NULL))
+        elog(ERROR, "fuse_agg_deserialize called in non-aggregate context");
+
+    partial = PG_GETARG_BYTEA_PP(0);
+    data = (const uint8 *) VARDATA_ANY(partial);
+    size = VARSIZE_ANY_EXHDR(partial);
+    if (size < 1 || (size - 1) % 8 != 0 || (data[0] != 8 && data[0] != 16))
+        elog(ERROR, "invalid binary fuse filter partial state");
+
+    n = (int64) (size - 1) / 8;
+    state = fuse_state_create(CurrentMemoryContext, data[0]);
+    fuse_state_reserve(state, n);
+    for (i = 0; i < n; i++)
+        state->keys[i] = hashlib_read_le64(data + 1 + 8 * i);
+    state->nkeys = n;
+    PG_RETURN_POINTER(state);
+}
+
+/* fuse_agg_final(internal) -> fuse_filter; NULL when there were no rows */
+PG_FUNCTION_INFO_V1(fuse_agg_final);
+
+Datum
+fuse_agg_final(PG_FUNCTION_ARGS)
+{
+    if (PG_ARGISNULL(0))
+        PG_RETURN_NULL();
+
+    PG_RETURN_BYTEA_P(fuse_state_build((FuseState *) PG_GETARG_POINTER(0)));
+}
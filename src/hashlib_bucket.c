@@ -0,0 +1,435 @@
+#include "postgres.h"
+#include "fmgr.h"
+#include "catalog/pg_type.h"
+#include "nodes/supportnodes.h"
+#include "optimizer/optimizer.h"
+#include "utils/array.h"
+#include "utils/builtins.h"
+#include "utils/memutils.h"
+
+#include <math.h>
+
+#include "hashlib_bucket.h"
+#include "hashlib_datum.h"
+#include "hashlib_sketch.h"
+
+/*
+ * hash_bucket and hash_bucket_weighted: the bucket of a key for partitioning
+ * and routing, in place of abs(hash(key)) % n.
+ *
+ * The key is hashed as the SQL function of the chosen algorithm hashes it
+ * (text and bytea by their bytes, integer and bigint by their in-memory
+ * bytes).  Other text-like types (varchar, bpchar, name, json, citext and
+ * domains over them) hash as the same text does, bpchar without its trailing
+ * spaces as hashbpchar does, and other types by their binary send form, as
+ * the hash aggregates do.  The 64-bit hash h goes to
+ * bucket (h * n) >> 64, which needs no division, is unbiased for any n and
+ * has no abs() to overflow.  Weighted buckets split the 64-bit range in
+ * proportion to the weights.
+ *
+ * The algorithm is looked up by name once and kept in fn_extra with the
+ * bucket bounds, so a routing query pays for neither per row.
+ *
+ * hash_sample and ab_bucket hash the key the same way with xxhash3_64 and a
+ * seed, so that a sample or an experiment's arms are independent of the
+ * buckets and of other seeds.  A key is sampled when its hash is below
+ * rate * 2^64, and the arm is the weighted bucket of the hash.
+ */
+
+static const HashlibBucketHasher *const hashlib_bucket_hashers[] = {
+    &xxhash3_64_bucket_hasher,
+    &xxhash64_bucket_hasher,
+    &wyhash_bucket_hasher,
+    &rapidhash_bucket_hasher,
+    &komihash_bucket_hasher,
+    &cityhash64_bucket_hasher,
+    &farmhash64_bucket_hasher,
+    &metrohash64_bucket_hasher
+};
+
+/* fn_extra of hash_bucket, hash_bucket_weighted, ab_bucket and hash_sample */
+typedef struct HashlibBucketCache
+{
+    Oid         typid;          /* type of the key */
+    HashlibTypeIO *io;          /* I/O lookup of other key types */
+    const HashlibBucketHasher *hasher;
+    /* hash_bucket_weighted only */
+    MemoryContext mcxt;         /* holds the weights image and bounds */
+    ArrayType  *weights_image;
+    uint64     *bounds;         /* bucket i holds hashes below bounds[i] */
+    int         last;           /* the last bucket with a positive weight */
+    /* hash_sample only */
+    bool        has_rate;
+    float8      rate;
+    uint64      threshold;      /* keys with hashes below it are sampled */
+} HashlibBucketCache;
+
+static HashlibBucketCache *
+hashlib_bucket_cache(FunctionCallInfo fcinfo)
+{
+    HashlibBucketCache *cache = (HashlibBucketCache *) fcinfo->flinfo->fn_extra;
+
+    if (cache == NULL)
+    {
+        cache = (HashlibBucketCache *) MemoryContextAllocZero(fcinfo->flinfo->fn_mcxt,
+                                                              sizeof(HashlibBucketCache));
+        cache->typid = hashlib_arg_type(fcinfo, 0);
+        fcinfo->flinfo->fn_extra = cache;
+    }
+    return cache;
+}
+
+/* The hasher named by argument argno, or xxhash3_64 if there is none */
+static const HashlibBucketHasher *
+hashlib_bucket_hasher(FunctionCallInfo fcinfo, HashlibBucketCache *cache, int argno)
+{
+    text *algorithm;
+    char *name;
+    int len;
+    int i;
+
+    if (PG_NARGS() <= argno)
+        return &xxhash3_64_bucket_hasher;
+
+    algorithm = PG_GETARG_TEXT_PP(argno);
+    len = VARSIZE_ANY_EXHDR(algorithm);
+    if (cache->hasher != NULL && strlen(cache->hasher->name) == (size_t) len &&
+        memcmp(cache->hasher->name, VARDATA_ANY(algorithm), len) == 0)
+        return cache->hasher;
+
+    name = text_to_cstring(algorithm);
+    for (i = 0; i < lengthof(hashlib_bucket_hashers); i++)
+    {
+        if (strcmp(name, hashlib_bucket_hashers[i]->name) == 0)
+        {
+            cache->hasher = hashlib_bucket_hashers[i];
+            pfree(name);
+            return cache->hasher;
+        }
+    }
+
+    ereport(ERROR,
+            (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+             errmsg("unrecognized hash_bucket algorithm \"%s\"", name),
+             errhint("Valid algorithms are xxhash3_64, xxhash64, wyhash, rapidhash, komihash, cityhash64, farmhash64 and metrohash64.")));
+    return NULL;                /* keep compiler quiet */
+}
+
+/* The bytes of a key that are hashed */
+typedef struct HashlibBucketKey
+{
+    const void *data;
+    size_t      len;
+    bytea      *bytes;          /* canonical bytes to free, or NULL */
+    union
+    {
+        int32       i4;
+        int64       i8;
+    }           value;          /* integer keys */
+} HashlibBucketKey;
+
+/* Set key to the bytes of value, a non-null value of type typid */
+static void
+hashlib_bucket_key(FmgrInfo *flinfo, Oid typid, HashlibTypeIO **io, Datum value,
+                   HashlibBucketKey *key)
+{
+    key->bytes = NULL;
+    switch (typid)
+    {
+        case TEXTOID:
+        case BYTEAOID:
+            {
+                bytea *bytes = DatumGetByteaPP(value);
+
+                key->data = VARDATA_ANY(bytes);
+                key->len = VARSIZE_ANY_EXHDR(bytes);
+                break;
+            }
+        case INT4OID:
+            key->value.i4 = DatumGetInt32(value);
+            key->data = &key->value.i4;
+            key->len = sizeof(int32);
+            break;
+        case INT8OID:
+            key->value.i8 = DatumGetInt64(value);
+            key->data = &key->value.i8;
+            key->len = sizeof(int64);
+            break;
+        default:
+            {
+                HashlibTypeIO *type_io = hashlib_type_io(flinfo, typid, io);
+
+                if (type_io->kind == HASHLIB_BYTES_STRING)
+                {
+                    /* varchar, bpchar, json, citext, ... hash as text does */
+                    text *string = DatumGetTextPP(value);
+
+                    key->data = VARDATA_ANY(string);
+                    key->len = VARSIZE_ANY_EXHDR(string);
+                    /* without the pad spaces, which bpchar equality ignores */
+                    if (type_io->basetype == BPCHAROID)
+                        key->len = bpchartruelen(VARDATA_ANY(string), key->len);
+                    break;
+                }
+                key->bytes = hashlib_value_bytes(type_io, value);
+                key->data = VARDATA(key->bytes);
+                key->len = VARSIZE(key->bytes) - VARHDRSZ;
+                break;
+            }
+    }
+}
+
+/* 64-bit hash of the key in argument 0 */
+static uint64
+hashlib_bucket_key_hash(FunctionCallInfo fcinfo, HashlibBucketCache *cache,
+                        const HashlibBucketHasher *hasher)
+{
+    HashlibBucketKey key;
+    uint64 hash;
+
+    hashlib_bucket_key(fcinfo->flinfo, cache->typid, &cache->io, PG_GETARG_DATUM(0), &key);
+    hash = hasher->hash(key.data, key.len);
+    if (key.bytes != NULL)
+        pfree(key.bytes);
+    return hash;
+}
+
+/*
+ * xxhash3_64 with a seed of value, a non-null value of type typid, hashed as
+ * hash_sample hashes its key; io caches the type's I/O lookup
+ */
+uint64
+hashlib_bucket_value_hash_seed(FmgrInfo *flinfo, Oid typid, HashlibTypeIO **io, Datum value,
+                               uint64 seed)
+{
+    HashlibBucketKey key;
+    uint64 hash;
+
+    hashlib_bucket_key(flinfo, typid, io, value, &key);
+    hash = hashlib_xxh3_64_seed(key.data, key.len, seed);
+    if (key.bytes != NULL)
+        pfree(key.bytes);
+    return hash;
+}
+
+/* xxhash3_64 of the key in argument 0 with a seed */
+static uint64
+hashlib_bucket_key_hash_seed(FunctionCallInfo fcinfo, HashlibBucketCache *cache, uint64 seed)
+{
+    return hashlib_bucket_value_hash_seed(fcinfo->flinfo, cache->typid, &cache->io,
+                                          PG_GETARG_DATUM(0), seed);
+}
+
+/* hash_bucket(key, n [, algorithm]) -> integer: bucket in [0, n) */
+PG_FUNCTION_INFO_V1(hash_bucket);
+
+Datum
+hash_bucket(PG_FUNCTION_ARGS)
+{
+    HashlibBucketCache *cache = hashlib_bucket_cache(fcinfo);
+    int32 buckets = PG_GETARG_INT32(1);
+    const HashlibBucketHasher *hasher = hashlib_bucket_hasher(fcinfo, cache, 2);
+
+    if (buckets <= 0)
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("number of buckets must be positive")));
+
+    PG_RETURN_INT32((int32) hashlib_reduce64(hashlib_bucket_key_hash(fcinfo, cache, hasher),
+                                             (uint32) buckets));
+}
+
+/*
+ * Set the bounds of the cache for the weights, unless they are the ones of
+ * the last call
+ */
+static void
+hashlib_bucket_set_weights(FunctionCallInfo fcinfo, HashlibBucketCache *cache, ArrayType *weights)
+{
+    MemoryContext oldcontext;
+    Datum *values;
+    bool *nulls;
+    int n;
+    double total = 0;
+    double sum = 0;
+    int i;
+
+    if (cache->weights_image != NULL && VARSIZE(cache->weights_image) == VARSIZE(weights) &&
+        memcmp(cache->weights_image, weights, VARSIZE(weights)) == 0)
+        return;
+
+    if (ARR_NDIM(weights) > 1)
+        ereport(ERROR,
+                (errcode(ERRCODE_ARRAY_SUBSCRIPT_ERROR),
+                 errmsg("weight array must be one-dimensional")));
+
+    if (cache->mcxt == NULL)
+        cache->mcxt = AllocSetContextCreate(fcinfo->flinfo->fn_mcxt,
+                                            "hashlib bucket weights",
+                                            ALLOCSET_SMALL_SIZES);
+    else
+    {
+        MemoryContextReset(cache->mcxt);
+        cache->weights_image = NULL;
+    }
+    oldcontext = MemoryContextSwitchTo(cache->mcxt);
+
+    deconstruct_array(weights, FLOAT8OID, sizeof(float8), FLOAT8PASSBYVAL, 'd',
+                      &values, &nulls, &n);
+    if (n == 0)
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("weight array must not be empty")));
+
+    cache->last = -1;
+    for (i = 0; i < n; i++)
+    {
+        if (nulls[i] || isnan(DatumGetFloat8(values[i])) || isinf(DatumGetFloat8(values[i])) ||
+            DatumGetFloat8(values[i]) < 0)
+            ereport(ERROR,
+                    (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                     errmsg("bucket weights must be finite and not negative")));
+        total += DatumGetFloat8(values[i]);
+        if (DatumGetFloat8(values[i]) > 0)
+            cache->last = i;
+    }
+    if (cache->last < 0)
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("at least one bucket weight must be positive")));
+    if (isinf(total))
+        ereport(ERROR,
+                (errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+                 errmsg("sum of bucket weights is out of range")));
+
+    /* the last positive bucket takes the rest of the range, so it has no bound */
+    cache->bounds = (uint64 *) palloc(sizeof(uint64) * Max(cache->last, 1));
+    for (i = 0; i < cache->last; i++)
+    {
+        double bound;
+
+        sum += DatumGetFloat8(values[i]);
+        bound = sum / total * 18446744073709551616.0;
+        cache->bounds[i] = bound >= 18446744073709551615.0 ? PG_UINT64_MAX : (uint64) bound;
+    }
+
+    /* the image is set last, so that an error above leaves no cache */
+    cache->weights_image = (ArrayType *) palloc(VARSIZE(weights));
+    memcpy(cache->weights_image, weights, VARSIZE(weights));
+    MemoryContextSwitchTo(oldcontext);
+}
+
+/* The weighted bucket of a hash: the first bucket whose bound is above it */
+static int32
+hashlib_bucket_weighted_index(HashlibBucketCache *cache, uint64 hash)
+{
+    int lo = 0;
+    int hi = cache->last;
+
+    while (lo < hi)
+    {
+        int mid = lo + (hi - lo) / 2;
+
+        if (hash < cache->bounds[mid])
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+    return lo;
+}
+
+/*
+ * hash_bucket_weighted(key, weights [, algorithm]) -> integer: bucket in
+ * [0, n) for n weights, each taking a share of keys proportional to its weight
+ */
+PG_FUNCTION_INFO_V1(hash_bucket_weighted);
+
+Datum
+hash_bucket_weighted(PG_FUNCTION_ARGS)
+{
+    HashlibBucketCache *cache = hashlib_bucket_cache(fcinfo);
+    const HashlibBucketHasher *hasher = hashlib_bucket_hasher(fcinfo, cache, 2);
+
+    hashlib_bucket_set_weights(fcinfo, cache, PG_GETARG_ARRAYTYPE_P(1));
+    PG_RETURN_INT32(hashlib_bucket_weighted_index(cache, hashlib_bucket_key_hash(fcinfo, cache, hasher)));
+}
+
+/*
+ * ab_bucket(key, weights, seed) -> integer: experiment arm in [0, n) for n
+ * weights, by the xxhash3_64 of the key with the seed
+ */
+PG_FUNCTION_INFO_V1(ab_bucket);
+
+Datum
+ab_bucket(PG_FUNCTION_ARGS)
+{
+    HashlibBucketCache *cache = hashlib_bucket_cache(fcinfo);
+
+    hashlib_bucket_set_weights(fcinfo, cache, PG_GETARG_ARRAYTYPE_P(1));
+    PG_RETURN_INT32(hashlib_bucket_weighted_index(cache,
+                                                  hashlib_bucket_key_hash_seed(fcinfo, cache,
+                                                                               (uint64) PG_GETARG_INT64(2))));
+}
+
+/*
+ * hash_sample(key, rate, seed) -> boolean: whether the key is in the sample
+ * of the given rate, that is whether the xxhash3_64 of the key with the seed
+ * is below rate * 2^64
+ */
+PG_FUNCTION_INFO_V1(hash_sample);
+
+Datum
+hash_sample(PG_FUNCTION_ARGS)
+{
+    HashlibBucketCache *cache = hashlib_bucket_cache(fcinfo);
+    float8 rate = PG_GETARG_FLOAT8(1);
+
+    if (!cache->has_rate || cache->rate != rate)
+    {
+        if (isnan(rate) || rate < 0 || rate > 1)
+            ereport(ERROR,
+                    (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                     errmsg("sample rate must be between 0 and 1")));
+        cache->rate = rate;
+        cache->threshold = rate * 18446744073709551616.0 >= 18446744073709551615.0 ?
+            PG_UINT64_MAX : (uint64) (rate * 18446744073709551616.0);
+        cache->has_rate = true;
+    }
+
+    /* a rate of 1 keeps every key, including the one with the largest hash */
+    if (rate >= 1)
+        PG_RETURN_BOOL(true);
+    PG_RETURN_BOOL(hashlib_bucket_key_hash_seed(fcinfo, cache, (uint64) PG_GETARG_INT64(2)) <
+                   cache->threshold);
+}
+
+/*
+ * hash_sample_support(internal) -> internal: the selectivity of
+ * hash_sample(key, rate, seed) is rate when rate is known at plan time
+ */
+PG_FUNCTION_INFO_V1(hash_sample_support);
+
+Datum
+hash_sample_support(PG_FUNCTION_ARGS)
+{
+    Node *rawreq = (Node *) PG_GETARG_POINTER(0);
+
+    if (IsA(rawreq, SupportRequestSelectivity))
+    {
+        SupportRequestSelectivity *req = (SupportRequestSelectivity *) rawreq;
+        Node *rate = estimate_expression_value(req->root, (Node *) lsecond(req->args));
+
+        if (IsA(rate, Const) && !((Const *) rate)->constisnull)
+        {
+            float8 selectivity = DatumGetFloat8(((Const *) rate)->constvalue);
+
+            if (selectivity >= 0 && selectivity <= 1)
+            {
+                req->selectivity = selectivity;
+                PG_RETURN_POINTER(req);
+            }
+        }
+    }
+
+    PG_RETURN_POINTER(NULL);
+}
@@ -0,0 +1,36 @@
+#ifndef HASHLIB_BUCKET_H
+#define HASHLIB_BUCKET_H
+
+#include "postgres.h"
+#include "fmgr.h"
+
+#include "hashlib_datum.h"
+
+/*
+ * Hashing for hash_bucket and hash_bucket_weighted.
+ *
+ * Each algorithm that hash_bucket accepts provides a HashlibBucketHasher
+ * next to its kernel: hash returns the 64-bit hash of the bytes with the
+ * default seed, as the matching SQL function does.
+ */
+
+typedef struct HashlibBucketHasher
+{
+    const char *name;           /* algorithm name accepted by hash_bucket */
+    uint64      (*hash) (const void *data, size_t len);
+} HashlibBucketHasher;
+
+extern const HashlibBucketHasher xxhash3_64_bucket_hasher;
+extern const HashlibBucketHasher xxhash64_bucket_hasher;
+extern const HashlibBucketHasher wyhash_bucket_hasher;
+extern const HashlibBucketHasher rapidhash_bucket_hasher;
+extern const HashlibBucketHasher komihash_bucket_hasher;
+extern const HashlibBucketHasher cityhash64_bucket_hasher;
+extern const HashlibBucketHasher farmhash64_bucket_hasher;
+extern const HashlibBucketHasher metrohash64_bucket_hasher;
+
+/* The hash of hash_sample and ab_bucket, for other keyed samples */
+extern uint64 hashlib_bucket_value_hash_seed(FmgrInfo *flinfo, Oid typid, HashlibTypeIO **io,
+                                             Datum value, uint64 seed);
+
+#endif                          /* HASHLIB_BUCKET_H */
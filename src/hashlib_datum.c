@@ -0,0 +1,345 @@
+#include "postgres.h"
+#include "fmgr.h"
+#include "utils/builtins.h"
+#include "mb/pg_wchar.h"
+#include "access/htup_details.h"
+#include "catalog/pg_type.h"
+#include "lib/stringinfo.h"
+#include "utils/array.h"
+#include "utils/arrayaccess.h"
+#include "utils/jsonb.h"
+#include "utils/lsyscache.h"
+#include "utils/typcache.h"
+
+#include "hashlib_datum.h"
+
+#define HASHLIB_NULL_FRAME  0xFFFFFFFF
+
+static void
+hashlib_type_io_init(HashlibTypeIO *io, Oid typid, int32 typmod, MemoryContext mcxt)
+{
+    Oid basetype = getBaseType(typid);
+    int16 typlen;
+    bool typbyval;
+    char typalign;
+    char typdelim;
+    Oid typioparam;
+    char category;
+    bool preferred;
+    bool isvarlena;
+    Oid func;
+
+    memset(io, 0, sizeof(HashlibTypeIO));
+    io->typid = typid;
+    io->basetype = basetype;
+    io->typmod = typmod;
+    io->mcxt = mcxt;
+    get_typlenbyvalalign(typid, &io->typlen, &io->typbyval, &io->typalign);
+    get_type_category_preferred(basetype, &category, &preferred);
+
+    /* composite types are resolved per value, see hashlib_record_bytes */
+    if (type_is_rowtype(typid))
+        io->kind = HASHLIB_BYTES_COMPOSITE;
+    else if (basetype == NAMEOID)
+        io->kind = HASHLIB_BYTES_NAME;
+    else if ((category == TYPCATEGORY_STRING && io->typlen == -1) ||
+             basetype == JSONOID || basetype == XMLOID)
+        io->kind = HASHLIB_BYTES_STRING;
+    else if (basetype == JSONBOID)
+        io->kind = HASHLIB_BYTES_JSONB;
+    else if (type_is_enum(basetype))
+        io->kind = HASHLIB_BYTES_ENUM;
+    else if (OidIsValid(get_element_type(basetype)) && io->typlen == -1)
+        io->kind = HASHLIB_BYTES_ARRAY;
+    else
+        io->kind = HASHLIB_BYTES_SEND;
+
+    switch (io->kind)
+    {
+        case HASHLIB_BYTES_ENUM:
+            /* the label, which enum_out returns whatever the settings */
+            getTypeOutputInfo(basetype, &func, &isvarlena);
+            fmgr_info_cxt(func, &io->proc, mcxt);
+            break;
+        case HASHLIB_BYTES_SEND:
+            /* the output function would depend on DateStyle and the like */
+            get_type_io_data(basetype, IOFunc_send, &typlen, &typbyval, &typalign,
+                             &typdelim, &typioparam, &func);
+            if (!OidIsValid(func))
+                ereport(ERROR,
+                        (errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+                         errmsg("cannot hash values of type %s", format_type_be(typid)),
+                         errdetail("The type has no binary send function.")));
+            fmgr_info_cxt(func, &io->proc, mcxt);
+            break;
+        default:
+            break;
+    }
+}
+
+/*
+ * I/O information for values of typid, cached in *cache for the lifetime of
+ * flinfo (usually cache is &flinfo->fn_extra)
+ */
+HashlibTypeIO *
+hashlib_type_io(FmgrInfo *flinfo, Oid typid, HashlibTypeIO **cache)
+{
+    HashlibTypeIO *io = *cache;
+
+    if (io == NULL || io->typid != typid)
+    {
+        io = (HashlibTypeIO *) MemoryContextAlloc(flinfo->fn_mcxt, sizeof(HashlibTypeIO));
+        hashlib_type_io_init(io, typid, -1, flinfo->fn_mcxt);
+        *cache = io;
+    }
+    return io;
+}
+
+/* Type of argument argno of the calling function */
+Oid
+hashlib_arg_type(FunctionCallInfo fcinfo, int argno)
+{
+    Oid typid = get_fn_expr_argtype(fcinfo->flinfo, argno);
+
+    if (!OidIsValid(typid))
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("could not determine input data type")));
+    return typid;
+}
+
+/* I/O information for argument argno of the calling function, cached in fn_extra */
+HashlibTypeIO *
+hashlib_arg_type_io(FunctionCallInfo fcinfo, int argno)
+{
+    return hashlib_type_io(fcinfo->flinfo, hashlib_arg_type(fcinfo, argno),
+                           (HashlibTypeIO **) &fcinfo->flinfo->fn_extra);
+}
+
+static void
+hashlib_append_le32(StringInfo buf, uint32 v)
+{
+    char b[4];
+
+    b[0] = (char) v;
+    b[1] = (char) (v >> 8);
+    b[2] = (char) (v >> 16);
+    b[3] = (char) (v >> 24);
+    appendBinaryStringInfo(buf, b, 4);
+}
+
+static void
+hashlib_append_be32(StringInfo buf, uint32 v)
+{
+    char b[4];
+
+    b[0] = (char) (v >> 24);
+    b[1] = (char) (v >> 16);
+    b[2] = (char) (v >> 8);
+    b[3] = (char) v;
+    appendBinaryStringInfo(buf, b, 4);
+}
+
+/* Column-framed bytes of a composite value */
+static bytea *
+hashlib_record_bytes(HashlibTypeIO *io, Datum value)
+{
+    HeapTupleHeader rec = DatumGetHeapTupleHeader(value);
+    Oid tuptype = HeapTupleHeaderGetTypeId(rec);
+    int32 tuptypmod = HeapTupleHeaderGetTypMod(rec);
+    HeapTupleData tuple;
+    StringInfoData buf;
+    Datum *values;
+    bool *nulls;
+    int i;
+
+    if (io->tupdesc == NULL || io->tupdesc->tdtypeid != tuptype ||
+        io->tupdesc->tdtypmod != tuptypmod)
+    {
+        MemoryContext old = MemoryContextSwitchTo(io->mcxt);
+        TupleDesc tupdesc = lookup_rowtype_tupdesc_copy(tuptype, tuptypmod);
+
+        io->columns = (HashlibTypeIO *) palloc(sizeof(HashlibTypeIO) * Max(tupdesc->natts, 1));
+        for (i = 0; i < tupdesc->natts; i++)
+        {
+            Form_pg_attribute att = TupleDescAttr(tupdesc, i);
+
+            if (!att->attisdropped)
+                hashlib_type_io_init(&io->columns[i], att->atttypid, att->atttypmod, io->mcxt);
+        }
+        io->tupdesc = tupdesc;
+        MemoryContextSwitchTo(old);
+    }
+
+    tuple.t_len = HeapTupleHeaderGetDatumLength(rec);
+    ItemPointerSetInvalid(&tuple.t_self);
+    tuple.t_tableOid = InvalidOid;
+    tuple.t_data = rec;
+
+    values = (Datum *) palloc(sizeof(Datum) * Max(io->tupdesc->natts, 1));
+    nulls = (bool *) palloc(sizeof(bool) * Max(io->tupdesc->natts, 1));
+    heap_deform_tuple(&tuple, io->tupdesc, values, nulls);
+
+    initStringInfo(&buf);
+    appendStringInfoSpaces(&buf, VARHDRSZ);
+    for (i = 0; i < io->tupdesc->natts; i++)
+    {
+        bytea *column;
+
+        if (TupleDescAttr(io->tupdesc, i)->attisdropped)
+            continue;
+        if (nulls[i])
+        {
+            hashlib_append_le32(&buf, HASHLIB_NULL_FRAME);
+            continue;
+        }
+        column = hashlib_value_bytes(&io->columns[i], values[i]);
+        hashlib_append_le32(&buf, (uint32) VARSIZE(column) - VARHDRSZ);
+        appendBinaryStringInfo(&buf, VARDATA(column), VARSIZE(column) - VARHDRSZ);
+        pfree(column);
+    }
+
+    pfree(values);
+    pfree(nulls);
+    SET_VARSIZE(buf.data, buf.len);
+    return (bytea *) buf.data;
+}
+
+/*
+ * array_send framing of an array without the element type OID, which differs
+ * between databases for user-defined types: the dimensions and bounds, then
+ * each element's canonical bytes with a length frame
+ */
+static bytea *
+hashlib_array_bytes(HashlibTypeIO *io, Datum value)
+{
+    ArrayType *array = DatumGetArrayTypeP(value);
+    Oid elemtype = ARR_ELEMTYPE(array);
+    int ndim = ARR_NDIM(array);
+    StringInfoData buf;
+    array_iter iter;
+    int nitems;
+    int i;
+
+    if (io->element == NULL || io->element->typid != elemtype)
+    {
+        HashlibTypeIO *element = (HashlibTypeIO *) MemoryContextAlloc(io->mcxt, sizeof(HashlibTypeIO));
+
+        hashlib_type_io_init(element, elemtype, -1, io->mcxt);
+        io->element = element;
+    }
+
+    initStringInfo(&buf);
+    appendStringInfoSpaces(&buf, VARHDRSZ);
+    hashlib_append_be32(&buf, (uint32) ndim);
+    hashlib_append_be32(&buf, ARR_HASNULL(array) ? 1 : 0);
+    for (i = 0; i < ndim; i++)
+    {
+        hashlib_append_be32(&buf, (uint32) ARR_DIMS(array)[i]);
+        hashlib_append_be32(&buf, (uint32) ARR_LBOUND(array)[i]);
+    }
+
+    nitems = ArrayGetNItems(ndim, ARR_DIMS(array));
+    array_iter_setup(&iter, (AnyArrayType *) array);
+    for (i = 0; i < nitems; i++)
+    {
+        bool isnull;
+        Datum element = array_iter_next(&iter, &isnull, i, io->element->typlen,
+                                        io->element->typbyval, io->element->typalign);
+        bytea *bytes;
+
+        if (isnull)
+        {
+            hashlib_append_be32(&buf, HASHLIB_NULL_FRAME);
+            continue;
+        }
+        bytes = hashlib_value_bytes(io->element, element);
+        hashlib_append_be32(&buf, (uint32) VARSIZE(bytes) - VARHDRSZ);
+        appendBinaryStringInfo(&buf, VARDATA(bytes), VARSIZE(bytes) - VARHDRSZ);
+        pfree(bytes);
+    }
+
+    SET_VARSIZE(buf.data, buf.len);
+    return (bytea *) buf.data;
+}
+
+/* A copy of len bytes as a bytea */
+static bytea *
+hashlib_bytes_copy(const char *data, int len)
+{
+    bytea *result = (bytea *) palloc(VARHDRSZ + len);
+
+    SET_VARSIZE(result, VARHDRSZ + len);
+    memcpy(VARDATA(result), data, len);
+    return result;
+}
+
+/* Canonical bytes of value, a non-null value of the type described by io */
+bytea *
+hashlib_value_bytes(HashlibTypeIO *io, Datum value)
+{
+    bytea *result;
+    char *str;
+    int64 v;
+    int len;
+    int i;
+
+    switch (io->kind)
+    {
+        case HASHLIB_BYTES_COMPOSITE:
+            return hashlib_record_bytes(io, value);
+        case HASHLIB_BYTES_ARRAY:
+            return hashlib_array_bytes(io, value);
+        case HASHLIB_BYTES_STRING:
+            {
+                text *t = DatumGetTextPP(value);
+
+                return hashlib_bytes_copy(VARDATA_ANY(t), VARSIZE_ANY_EXHDR(t));
+            }
+        case HASHLIB_BYTES_NAME:
+            str = NameStr(*DatumGetName(value));
+            return hashlib_bytes_copy(str, strlen(str));
+        case HASHLIB_BYTES_JSONB:
+            {
+                Jsonb *jb = DatumGetJsonbP(value);
+                StringInfoData buf;
+
+                /* jsonb_send: format version 1, then the text */
+                initStringInfo(&buf);
+                appendStringInfoSpaces(&buf, VARHDRSZ);
+                appendStringInfoChar(&buf, 1);
+                str = JsonbToCString(NULL, &jb->root, VARSIZE(jb));
+                appendStringInfoString(&buf, str);
+                pfree(str);
+                SET_VARSIZE(buf.data, buf.len);
+                return (bytea *) buf.data;
+            }
+        case HASHLIB_BYTES_ENUM:
+            str = OutputFunctionCall(&io->proc, value);
+            result = hashlib_bytes_copy(str, strlen(str));
+            pfree(str);
+            return result;
+        case HASHLIB_BYTES_SEND:
+            break;
+    }
+
+    switch (io->typid)
+    {
+        /* the send form of the integer types, without a StringInfo per value */
+        case INT2OID:
+        case INT4OID:
+        case INT8OID:
+            len = io->typid == INT2OID ? 2 : io->typid == INT4OID ? 4 : 8;
+            v = io->typid == INT2OID ? DatumGetInt16(value) :
+                io->typid == INT4OID ? DatumGetInt32(value) : DatumGetInt64(value);
+            result = (bytea *) palloc(VARHDRSZ + len);
+            SET_VARSIZE(result, VARHDRSZ + len);
+            for (i = 0; i < len; i++)
+                ((uint8 *) VARDATA(result))[i] = (uint8) (v >> (8 * (len - 1 - i)));
+            return result;
+        default:
+            break;
+    }
+
+    return SendFunctionCall(&io->proc, value);
+}
@@ -0,0 +1,62 @@
+#ifndef HASHLIB_DATUM_H
+#define HASHLIB_DATUM_H
+
+#include "postgres.h"
+#include "fmgr.h"
+#include "access/tupdesc.h"
+
+/*
+ * Canonical bytes of values of any type, for the hash aggregates.
+ *
+ * A value is represented by its binary send form, which unlike the text form
+ * does not depend on settings such as DateStyle or TimeZone.  Send functions
+ * of text-like types convert to the client encoding, so those are taken
+ * as they are stored instead: string types (text, varchar, bpchar, name and
+ * other types of the string category), json and xml by their bytes, jsonb as
+ * its send form in the server encoding, and enums by their label.  These
+ * are the bytes the send function returns when the client encoding is the
+ * server encoding.  Arrays are framed as by array_send but without the
+ * element type OID, with each element in its canonical bytes.  A composite
+ * value is represented column by column, each column framed as a 4-byte
+ * little-endian length (0xFFFFFFFF for NULL) followed by its bytes.  Type
+ * OIDs, which differ between databases for user-defined types, are thus never
+ * part of the bytes.  Types without a send function are rejected.
+ *
+ * The I/O lookup is cached in fn_extra of the calling function.
+ */
+
+typedef enum HashlibBytesKind
+{
+    HASHLIB_BYTES_SEND,         /* the send function */
+    HASHLIB_BYTES_STRING,       /* the varlena payload */
+    HASHLIB_BYTES_NAME,         /* the name up to its terminator */
+    HASHLIB_BYTES_JSONB,        /* version byte and text in the server encoding */
+    HASHLIB_BYTES_ENUM,         /* the label */
+    HASHLIB_BYTES_ARRAY,        /* array_send framing, less the OID, of canonical elements */
+    HASHLIB_BYTES_COMPOSITE     /* column-framed canonical columns */
+} HashlibBytesKind;
+
+typedef struct HashlibTypeIO
+{
+    Oid         typid;
+    Oid         basetype;       /* typid with domains resolved */
+    int32       typmod;
+    MemoryContext mcxt;         /* where the lookups are cached */
+    int16       typlen;
+    bool        typbyval;
+    char        typalign;
+    HashlibBytesKind kind;
+    FmgrInfo    proc;           /* send or, for enums, output function */
+    /* composite types only, looked up on first use */
+    TupleDesc   tupdesc;
+    struct HashlibTypeIO *columns;
+    /* array types only, looked up on first use */
+    struct HashlibTypeIO *element;
+} HashlibTypeIO;
+
+extern Oid hashlib_arg_type(FunctionCallInfo fcinfo, int argno);
+extern HashlibTypeIO *hashlib_type_io(FmgrInfo *flinfo, Oid typid, HashlibTypeIO **cache);
+extern HashlibTypeIO *hashlib_arg_type_io(FunctionCallInfo fcinfo, int argno);
+extern bytea *hashlib_value_bytes(HashlibTypeIO *io, Datum value);
+
+#endif                          /* HASHLIB_DATUM_H */
@@ -0,0 +1,286 @@
+#include "postgres.h"
+#include "fmgr.h"
+#include "utils/builtins.h"
+#include "mb/pg_wchar.h"
+#include "access/htup_details.h"
+#include "utils/array.h"
+#include "catalog/pg_type.h"
+#include "catalog/pg_authid.h"
+#include "miscadmin.h"
+#include "port/pg_crc32c.h"
+#include "storage/fd.h"
+#include "utils/acl.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "hashlib_file.h"
+
+/*
+ * hash_file: hash a server-side file, or ranges of it, without reading it
+ * into a bytea first.
+ *
+ * The file is read with pread() into one block-sized buffer, with block
+ * boundaries aligned to file offsets that are multiples of the block size,
+ * and each block is handed to the streaming kernel of the chosen algorithm.
+ * The kernel sees exactly the bytes pg_read_binary_file would return, so the
+ * result equals the bytea function applied to that.  Read-ahead is requested
+ * with posix_fadvise(POSIX_FADV_SEQUENTIAL) where available.
+ */
+
+/* Bytes read per call */
+#define HASHLIB_FILE_BLOCK  (1024 * 1024)
+
+#if PG_VERSION_NUM < 140000
+#define ROLE_PG_READ_SERVER_FILES DEFAULT_ROLE_READ_SERVER_FILES
+#endif
+
+/* hash_file support: CRC-32C (Castagnoli) using the server's implementation */
+static void *
+crc32c_file_start(void)
+{
+    pg_crc32c *crc = (pg_crc32c *) palloc(sizeof(pg_crc32c));
+
+    INIT_CRC32C(*crc);
+    return crc;
+}
+
+static void
+crc32c_file_update(void *arg, const uint8 *data, size_t len)
+{
+    pg_crc32c *crc = (pg_crc32c *) arg;
+
+    COMP_CRC32C(*crc, data, len);
+}
+
+static int64
+crc32c_file_finish(void *state)
+{
+    pg_crc32c crc = *(pg_crc32c *) state;
+
+    FIN_CRC32C(crc);
+    return (int64) (int32) crc;
+}
+
+static const HashlibFileHasher crc32c_file_hasher = {
+    "crc32c", crc32c_file_start, crc32c_file_update, crc32c_file_finish
+};
+
+static const HashlibFileHasher *const hashlib_file_hashers[] = {
+    &xxhash3_64_file_hasher,
+    &crc32_file_hasher,
+    &crc32c_file_hasher,
+    &crc64_file_hasher,
+    &crc64_nvme_file_hasher,
+    &crc64_ecma_file_hasher
+};
+
+static const HashlibFileHasher *
+hashlib_file_hasher(text *algorithm)
+{
+    char *name = text_to_cstring(algorithm);
+    int i;
+
+    for (i = 0; i < lengthof(hashlib_file_hashers); i++)
+    {
+        if (strcmp(name, hashlib_file_hashers[i]->name) == 0)
+            return hashlib_file_hashers[i];
+    }
+
+    ereport(ERROR,
+            (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+             errmsg("unrecognized hash_file algorithm \"%s\"", name),
+             errhint("Valid algorithms are xxhash3_64, crc32, crc32c, crc64, crc64_nvme and crc64_ecma.")));
+    return NULL;                /* keep compiler quiet */
+}
+
+/*
+ * Open path for reading.  Reading arbitrary server files is reserved to
+ * roles with the privileges of pg_read_server_files, as for COPY FROM a file.
+ * Relative paths are relative to the data directory.
+ */
+static int
+hashlib_file_open(text *path, char **filename)
+{
+    int fd;
+
+    if (!has_privs_of_role(GetUserId(), ROLE_PG_READ_SERVER_FILES))
+        ereport(ERROR,
+                (errcode(ERRCODE_INSUFFICIENT_PRIVILEGE),
+                 errmsg("permission denied to hash files"),
+                 errdetail("Only roles with privileges of the \"%s\" role may hash files on the server.",
+                           "pg_read_server_files")));
+
+    *filename = text_to_cstring(path);
+    canonicalize_path(*filename);
+
+    fd = OpenTransientFile(*filename, O_RDONLY | PG_BINARY);
+    if (fd < 0)
+        ereport(ERROR,
+                (errcode_for_file_access(),
+                 errmsg("could not open file \"%s\" for reading: %m", *filename)));
+    return fd;
+}
+
+static void
+hashlib_file_check_range(int64 offset, int64 length)
+{
+    if (offset < 0)
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("requested offset cannot be negative")));
+    if (length < 0)
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("requested length cannot be negative")));
+}
+
+/*
+ * Hash length bytes of the open file starting at offset, or everything up to
+ * the end of the file if length is -1.  A range running past the end of the
+ * file is cut short, as pg_read_binary_file does.
+ */
+static int64
+hashlib_file_hash_range(int fd, const char *filename, const HashlibFileHasher *hasher,
+                        char *buf, int64 offset, int64 length)
+{
+    void *state = hasher->start();
+    int64 hash;
+
+#ifdef USE_POSIX_FADVISE
+    (void) posix_fadvise(fd, (off_t) offset, length < 0 ? 0 : (off_t) length,
+                         POSIX_FADV_SEQUENTIAL);
+#endif
+
+    while (length != 0)
+    {
+        /* read up to the next block boundary so later reads are aligned */
+        size_t want = HASHLIB_FILE_BLOCK - (size_t) (offset % HASHLIB_FILE_BLOCK);
+        ssize_t nread;
+
+        if (length > 0 && (int64) want > length)
+            want = (size_t) length;
+
+        nread = pread(fd, buf, want, (off_t) offset);
+        if (nread < 0)
+            ereport(ERROR,
+                    (errcode_for_file_access(),
+                     errmsg("could not read file \"%s\": %m", filename)));
+        if (nread == 0)
+            break;
+
+        hasher->update(state, (const uint8 *) buf, (size_t) nread);
+        offset += nread;
+        if (length > 0)
+            length -= nread;
+        CHECK_FOR_INTERRUPTS();
+    }
+
+    hash = hasher->finish(state);
+    pfree(state);
+    return hash;
+}
+
+/* hash_file(path, algorithm) -> bigint: hash of the whole file */
+PG_FUNCTION_INFO_V1(hash_file);
+
+Datum
+hash_file(PG_FUNCTION_ARGS)
+{
+    const HashlibFileHasher *hasher = hashlib_file_hasher(PG_GETARG_TEXT_PP(1));
+    char *filename;
+    int fd = hashlib_file_open(PG_GETARG_TEXT_PP(0), &filename);
+    char *buf = palloc(HASHLIB_FILE_BLOCK);
+    int64 hash = hashlib_file_hash_range(fd, filename, hasher, buf, 0, -1);
+
+    CloseTransientFile(fd);
+    pfree(buf);
+    PG_RETURN_INT64(hash);
+}
+
+/* hash_file(path, algorithm, offset, length) -> bigint: hash of one range */
+PG_FUNCTION_INFO_V1(hash_file_range);
+
+Datum
+hash_file_range(PG_FUNCTION_ARGS)
+{
+    const HashlibFileHasher *hasher = hashlib_file_hasher(PG_GETARG_TEXT_PP(1));
+    int64 offset = PG_GETARG_INT64(2);
+    int64 length = PG_GETARG_INT64(3);
+    char *filename;
+    int fd;
+    char *buf;
+    int64 hash;
+
+    hashlib_file_check_range(offset, length);
+    fd = hashlib_file_open(PG_GETARG_TEXT_PP(0), &filename);
+    buf = palloc(HASHLIB_FILE_BLOCK);
+    hash = hashlib_file_hash_range(fd, filename, hasher, buf, offset, length);
+
+    CloseTransientFile(fd);
+    pfree(buf);
+    PG_RETURN_INT64(hash);
+}
+
+/*
+ * hash_file(path, algorithm, offsets bigint[], lengths bigint[]) -> bigint[]:
+ * one hash per (offset, length) pair, reading the file through one descriptor
+ */
+PG_FUNCTION_INFO_V1(hash_file_ranges);
+
+Datum
+hash_file_ranges(PG_FUNCTION_ARGS)
+{
+    const HashlibFileHasher *hasher = hashlib_file_hasher(PG_GETARG_TEXT_PP(1));
+    ArrayType *offsets_array = PG_GETARG_ARRAYTYPE_P(2);
+    ArrayType *lengths_array = PG_GETARG_ARRAYTYPE_P(3);
+    Datum *offsets;
+    Datum *lengths;
+    bool *offset_nulls;
+    bool *length_nulls;
+    int noffsets;
+    int nlengths;
+    Datum *hashes;
+    char *filename;
+    int fd;
+    char *buf;
+    int i;
+
+    if (ARR_NDIM(offsets_array) > 1 || ARR_NDIM(lengths_array) > 1)
+        ereport(ERROR,
+                (errcode(ERRCODE_ARRAY_SUBSCRIPT_ERROR),
+                 errmsg("offsets and lengths must be one-dimensional arrays")));
+
+    deconstruct_array(offsets_array, INT8OID, 8, FLOAT8PASSBYVAL, 'd',
+                      &offsets, &offset_nulls, &noffsets);
+    deconstruct_array(lengths_array, INT8OID, 8, FLOAT8PASSBYVAL, 'd',
+                      &lengths, &length_nulls, &nlengths);
+
+    if (noffsets != nlengths)
+        ereport(ERROR,
+                (errcode(ERRCODE_ARRAY_SUBSCRIPT_ERROR),
+                 errmsg("offsets and lengths must have the same number of elements")));
+
+    for (i = 0; i < noffsets; i++)
+    {
+        if (offset_nulls[i] || length_nulls[i])
+            ereport(ERROR,
+                    (errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED),
+                     errmsg("offsets and lengths must not contain nulls")));
+        hashlib_file_check_range(DatumGetInt64(offsets[i]), DatumGetInt64(lengths[i]));
+    }
+
+    fd = hashlib_file_open(PG_GETARG_TEXT_PP(0), &filename);
+    buf = palloc(HASHLIB_FILE_BLOCK);
+    hashes = (Datum *) palloc(sizeof(Datum) * Max(noffsets, 1));
+
+    for (i = 0; i < noffsets; i++)
+        hashes[i] = Int64GetDatum(hashlib_file_hash_range(fd, filename, hasher, buf,
+                                                          DatumGetInt64(offsets[i]),
+                                                          DatumGetInt64(lengths[i])));
+
+    CloseTransientFile(fd);
+    pfree(buf);
+
+    PG_RETURN_ARRAYTYPE_P(construct_array(hashes, noffsets, INT8OID, 8, FLOAT8PASSBYVAL, 'd'));
+}
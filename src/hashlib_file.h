@@ -0,0 +1,32 @@
+#ifndef HASHLIB_FILE_H
+#define HASHLIB_FILE_H
+
+#include "postgres.h"
+#include "fmgr.h"
+
+#include "hashlib_toast.h"
+
+/*
+ * Hashing of server-side files (hash_file).
+ *
+ * Each algorithm that hash_file accepts provides a HashlibFileHasher next to
+ * its kernel: start allocates a fresh state, update is fed the file one block
+ * at a time and finish returns the result as the matching SQL function
+ * would, widened to bigint.
+ */
+
+typedef struct HashlibFileHasher
+{
+    const char *name;           /* algorithm name accepted by hash_file */
+    void       *(*start) (void);
+    hashlib_stream_fn update;
+    int64       (*finish) (void *state);
+} HashlibFileHasher;
+
+extern const HashlibFileHasher xxhash3_64_file_hasher;
+extern const HashlibFileHasher crc32_file_hasher;
+extern const HashlibFileHasher crc64_file_hasher;
+extern const HashlibFileHasher crc64_nvme_file_hasher;
+extern const HashlibFileHasher crc64_ecma_file_hasher;
+
+#endif                          /* HASHLIB_FILE_H */
@@ -0,0 +1,38 @@
+#include "postgres.h"
+#include "fmgr.h"
+#include "utils/guc.h"
+
+#include "hashlib_guc.h"
+
+/*
+ * Definition of the extension's settings.  A new setting gets its variable
+ * and DefineCustom*Variable call here and an extern in hashlib_guc.h; the
+ * code that uses it only reads the variable.
+ */
+
+int hashlib_tree_max_threads = 2;
+
+#if PG_VERSION_NUM < 150000
+/* declared by fmgr.h from PostgreSQL 15 */
+void _PG_init(void);
+#endif
+
+/* Define the settings when the library is loaded */
+void
+_PG_init(void)
+{
+    DefineCustomIntVariable("hashlib.tree_max_threads",
+                            "Maximum number of threads one xxh3_tree_128 call may use.",
+                            "Counts the backend's own thread; larger thread counts are reduced to it.",
+                            &hashlib_tree_max_threads,
+                            2, 1, HASHLIB_TREE_MAX_THREADS,
+                            PGC_SUSET,
+                            0,
+                            NULL, NULL, NULL);
+
+#if PG_VERSION_NUM >= 150000
+    MarkGUCPrefixReserved("hashlib");
+#else
+    EmitWarningsOnPlaceholders("hashlib");
+#endif
+}
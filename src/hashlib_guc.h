@@ -0,0 +1,16 @@
+#ifndef HASHLIB_GUC_H
+#define HASHLIB_GUC_H
+
+#include "postgres.h"
+
+/*
+ * Settings of the extension, all under the hashlib. prefix.  They are defined
+ * in _PG_init (hashlib_guc.c) when the library is loaded; each is read by the
+ * code it configures through the variable below.
+ */
+
+/* hashlib.tree_max_threads: the most threads one xxh3_tree_128 call may use */
+#define HASHLIB_TREE_MAX_THREADS    64
+extern int  hashlib_tree_max_threads;
+
+#endif                          /* HASHLIB_GUC_H */
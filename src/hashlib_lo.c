@@ -0,0 +1,40 @@
+#include "postgres.h"
+#include "fmgr.h"
+#include "miscadmin.h"
+#include "libpq/be-fsstubs.h"
+#include "libpq/libpq-fs.h"
+#include "storage/large_object.h"
+#include "utils/fmgrprotos.h"
+
+#include "hashlib_lo.h"
+
+/* Bytes read per call: a whole number of pg_largeobject pages (256 kB) */
+#define HASHLIB_LO_READ     (LOBLKSIZE * 128)
+
+/*
+ * Feed the contents of large object loid to fn one read buffer at a time.
+ *
+ * The object is opened like lo_open(loid, INV_READ) does, so the usual
+ * SELECT privilege check applies and the descriptor is released at the end
+ * of the (sub)transaction if an error interrupts the loop.
+ */
+void
+hashlib_stream_large_object(Oid loid, hashlib_stream_fn fn, void *arg)
+{
+    char *buf = palloc(HASHLIB_LO_READ);
+    int32 fd;
+    int n;
+
+    fd = DatumGetInt32(DirectFunctionCall2(be_lo_open,
+                                           ObjectIdGetDatum(loid),
+                                           Int32GetDatum(INV_READ)));
+
+    while ((n = lo_read(fd, buf, HASHLIB_LO_READ)) > 0)
+    {
+        fn(arg, (const uint8 *) buf, (size_t) n);
+        CHECK_FOR_INTERRUPTS();
+    }
+
+    DirectFunctionCall1(be_lo_close, Int32GetDatum(fd));
+    pfree(buf);
+}
@@ -0,0 +1,19 @@
+#ifndef HASHLIB_LO_H
+#define HASHLIB_LO_H
+
+#include "postgres.h"
+#include "fmgr.h"
+
+#include "hashlib_toast.h"
+
+/*
+ * Hashing of large objects without materializing them as a bytea.
+ *
+ * The object is read through the server-side large object descriptors a
+ * fixed number of pg_largeobject pages at a time and fed to a streaming
+ * kernel, so memory use does not depend on the size of the object.
+ */
+
+extern void hashlib_stream_large_object(Oid loid, hashlib_stream_fn fn, void *arg);
+
+#endif                          /* HASHLIB_LO_H */
@@ -0,0 +1,122 @@
+#include "postgres.h"
+#include "fmgr.h"
+#include "utils/builtins.h"
+#include "mb/pg_wchar.h"
+#include "access/htup_details.h"
+#include "libpq/pqformat.h"
+#if PG_VERSION_NUM >= 130000
+#include "access/detoast.h"
+#else
+#include "access/tuptoaster.h"
+#endif
+
+#include "hashlib_sketch.h"
+
+/* Text form of a sketch: \x followed by its contents in hex */
+char *
+hashlib_sketch_to_hex(const struct varlena *sketch)
+{
+    static const char hexdigits[] = "0123456789abcdef";
+    const uint8 *data = (const uint8 *) VARDATA_ANY(sketch);
+    size_t len = VARSIZE_ANY_EXHDR(sketch);
+    char *out = palloc(2 * len + 3);
+    size_t i;
+
+    out[0] = '\\';
+    out[1] = 'x';
+    for (i = 0; i < len; i++)
+    {
+        out[2 + 2 * i] = hexdigits[data[i] >> 4];
+        out[3 + 2 * i] = hexdigits[data[i] & 0xF];
+    }
+    out[2 + 2 * len] = '\0';
+    return out;
+}
+
+static int
+hashlib_sketch_hex_value(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+/* Parse the text form; the caller validates the contents */
+struct varlena *
+hashlib_sketch_from_hex(const char *str, const char *typname)
+{
+    size_t hexlen = strlen(str);
+    struct varlena *result;
+    uint8 *data;
+    size_t i;
+
+    if (hexlen < 2 || str[0] != '\\' || str[1] != 'x' || hexlen % 2 != 0)
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_TEXT_REPRESENTATION),
+                 errmsg("invalid input syntax for type %s: \"%s\"", typname, str)));
+
+    result = (struct varlena *) palloc(VARHDRSZ + (hexlen - 2) / 2);
+    SET_VARSIZE(result, VARHDRSZ + (hexlen - 2) / 2);
+    data = (uint8 *) VARDATA(result);
+    for (i = 2; i < hexlen; i += 2)
+    {
+        int hi = hashlib_sketch_hex_value(str[i]);
+        int lo = hashlib_sketch_hex_value(str[i + 1]);
+
+        if (hi < 0 || lo < 0)
+            ereport(ERROR,
+                    (errcode(ERRCODE_INVALID_TEXT_REPRESENTATION),
+                     errmsg("invalid input syntax for type %s: \"%s\"", typname, str)));
+        data[(i - 2) / 2] = (uint8) ((hi << 4) | lo);
+    }
+    return result;
+}
+
+/* Binary form: the contents as they are; the caller validates them */
+struct varlena *
+hashlib_sketch_recv(StringInfo buf)
+{
+    int len = buf->len - buf->cursor;
+    struct varlena *result = (struct varlena *) palloc(VARHDRSZ + len);
+
+    SET_VARSIZE(result, VARHDRSZ + len);
+    pq_copymsgbytes(buf, VARDATA(result), len);
+    return result;
+}
+
+/* The validated sketch of argument argno, detoasted at most once per stored value */
+struct varlena *
+hashlib_sketch_getarg_cached(FunctionCallInfo fcinfo, int argno, HashlibDetoastCache *cache,
+                             hashlib_sketch_validate_fn validate)
+{
+    struct varlena *raw = (struct varlena *) DatumGetPointer(PG_GETARG_DATUM(argno));
+    struct varatt_external toast;
+    struct varlena *sketch;
+    MemoryContext old;
+
+    if (!VARATT_IS_EXTERNAL_ONDISK(raw))
+    {
+        sketch = PG_DETOAST_DATUM_PACKED(PG_GETARG_DATUM(argno));
+        validate(sketch);
+        return sketch;
+    }
+
+    VARATT_EXTERNAL_GET_POINTER(toast, raw);
+    if (cache->value != NULL && memcmp(&toast, &cache->toast, sizeof(toast)) == 0)
+        return cache->value;
+
+    if (cache->value != NULL)
+        pfree(cache->value);
+    cache->value = NULL;
+    old = MemoryContextSwitchTo(fcinfo->flinfo->fn_mcxt);
+    sketch = PG_DETOAST_DATUM_PACKED(PG_GETARG_DATUM(argno));
+    MemoryContextSwitchTo(old);
+    validate(sketch);
+    cache->toast = toast;
+    cache->value = sketch;
+    return sketch;
+}
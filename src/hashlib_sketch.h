@@ -0,0 +1,117 @@
+#ifndef HASHLIB_SKETCH_H
+#define HASHLIB_SKETCH_H
+
+#include "postgres.h"
+#include "fmgr.h"
+#include "lib/stringinfo.h"
+#if PG_VERSION_NUM >= 160000
+#include "varatt.h"
+#endif
+
+/*
+ * Helpers shared by the sketch types (hll and the ones built like it).
+ *
+ * Sketches take 64-bit hash values as bigint, typically from xxhash3_64 or
+ * wyhash.  The input is passed through a bijective finalizer first, so
+ * distinct inputs stay distinct and raw integer keys such as serial ids are
+ * also spread evenly over the 64-bit range.
+ *
+ * The stored form of every sketch is a varlena whose contents are a
+ * documented, byte-order independent layout (integers little-endian).  The
+ * text form is that layout as hex, prefixed with \x like bytea.
+ */
+
+/* MurmurHash3 fmix64: a bijection on 64-bit values with full avalanche */
+static inline uint64
+hashlib_mix64(uint64 h)
+{
+    h ^= h >> 33;
+    h *= UINT64CONST(0xff51afd7ed558ccd);
+    h ^= h >> 33;
+    h *= UINT64CONST(0xc4ceb9fe1a85ec53);
+    h ^= h >> 33;
+    return h;
+}
+
+/* Map a uniform 32-bit value to [0, n) without a division (Lemire) */
+static inline uint32
+hashlib_reduce32(uint32 x, uint32 n)
+{
+    return (uint32) (((uint64) x * (uint64) n) >> 32);
+}
+
+/* (x * n) >> 64 for a uniform 64-bit x, without 128-bit arithmetic */
+static inline uint32
+hashlib_reduce64(uint64 x, uint32 n)
+{
+    return (uint32) (((x >> 32) * n + (((x & 0xFFFFFFFF) * n) >> 32)) >> 32);
+}
+
+static inline void
+hashlib_write_le16(uint8 *p, uint16 v)
+{
+    p[0] = (uint8) v;
+    p[1] = (uint8) (v >> 8);
+}
+
+static inline uint16
+hashlib_read_le16(const uint8 *p)
+{
+    return (uint16) (p[0] | (p[1] << 8));
+}
+
+static inline void
+hashlib_write_le32(uint8 *p, uint32 v)
+{
+    p[0] = (uint8) v;
+    p[1] = (uint8) (v >> 8);
+    p[2] = (uint8) (v >> 16);
+    p[3] = (uint8) (v >> 24);
+}
+
+static inline uint32
+hashlib_read_le32(const uint8 *p)
+{
+    return (uint32) p[0] | ((uint32) p[1] << 8) | ((uint32) p[2] << 16) | ((uint32) p[3] << 24);
+}
+
+static inline void
+hashlib_write_le64(uint8 *p, uint64 v)
+{
+    hashlib_write_le32(p, (uint32) v);
+    hashlib_write_le32(p + 4, (uint32) (v >> 32));
+}
+
+static inline uint64
+hashlib_read_le64(const uint8 *p)
+{
+    return (uint64) hashlib_read_le32(p) | ((uint64) hashlib_read_le32(p + 4) << 32);
+}
+
+/*
+ * Detoasted copy of a sketch argument, kept across calls.  A sketch stored in
+ * a table is usually toasted, and probing it row by row (a join against a
+ * one-row table of sketches) would otherwise detoast it on every call.  The
+ * copy lives in fn_mcxt for as long as the same TOAST pointer is passed.
+ */
+typedef struct HashlibDetoastCache
+{
+    struct varatt_external toast;
+    struct varlena *value;
+} HashlibDetoastCache;
+
+typedef void (*hashlib_sketch_validate_fn) (const struct varlena *sketch);
+
+extern struct varlena *hashlib_sketch_getarg_cached(FunctionCallInfo fcinfo, int argno,
+                                                    HashlibDetoastCache *cache,
+                                                    hashlib_sketch_validate_fn validate);
+
+/* in xxhash3.c */
+extern uint64 hashlib_xxh3_64(const void *data, size_t len);
+extern uint64 hashlib_xxh3_64_seed(const void *data, size_t len, uint64 seed);
+
+extern char *hashlib_sketch_to_hex(const struct varlena *sketch);
+extern struct varlena *hashlib_sketch_from_hex(const char *str, const char *typname);
+extern struct varlena *hashlib_sketch_recv(StringInfo buf);
+
+#endif                          /* HASHLIB_SKETCH_H */
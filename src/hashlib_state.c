@@ -0,0 +1,275 @@
+#include "postgres.h"
+#include "fmgr.h"
+#include "utils/builtins.h"
+#include "mb/pg_wchar.h"
+#include "access/htup_details.h"
+#include "libpq/pqformat.h"
+
+#include "hashlib_state.h"
+
+/*
+ * hashlib_state type support: creation, validation and the text and binary
+ * I/O functions.  The init/update/final functions of each algorithm live next
+ * to its kernel (xxhash3.c, spookyhash.c, highwayhash.c).
+ *
+ * Text form:   <algorithm>:<hex of the binary form>
+ * Binary form: version (1 byte), algorithm (1 byte), buffered (2 bytes),
+ *              total_len (8 bytes), words (16 x 8 bytes), buf (320 bytes),
+ *              integers in network byte order.
+ */
+
+#define HASHLIB_STATE_WIRE_SIZE (1 + 1 + 2 + 8 + 8 * HASHLIB_STATE_WORDS + HASHLIB_STATE_BUFSIZE)
+
+static const char *
+hashlib_state_algorithm_name(uint8 algorithm)
+{
+    switch (algorithm)
+    {
+        case HASHLIB_STATE_XXH3:
+            return "xxh3";
+        case HASHLIB_STATE_SPOOKY:
+            return "spooky";
+        case HASHLIB_STATE_HIGHWAY:
+            return "highwayhash";
+        default:
+            return NULL;
+    }
+}
+
+HashlibState *
+hashlib_state_create(uint8 algorithm)
+{
+    HashlibState *state = (HashlibState *) palloc0(sizeof(HashlibState));
+
+    SET_VARSIZE(state, sizeof(HashlibState));
+    state->algorithm = algorithm;
+    state->version = HASHLIB_STATE_VERSION;
+    return state;
+}
+
+HashlibState *
+hashlib_state_copy(const HashlibState *state)
+{
+    HashlibState *copy = (HashlibState *) palloc(sizeof(HashlibState));
+
+    memcpy(copy, state, sizeof(HashlibState));
+    return copy;
+}
+
+/* Raise an error unless state was created by the init function of algorithm */
+void
+hashlib_state_check(const HashlibState *state, uint8 algorithm, const char *funcname)
+{
+    if (VARSIZE(state) != sizeof(HashlibState) || state->algorithm != algorithm)
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("%s requires a hashlib_state created by %s_init", funcname,
+                        hashlib_state_algorithm_name(algorithm)),
+                 errdetail("The state was created by %s_init.",
+                           hashlib_state_algorithm_name(state->algorithm) ?
+                           hashlib_state_algorithm_name(state->algorithm) : "unknown")));
+}
+
+/*
+ * Reject states that the update and final functions could not process
+ * safely.  Externally supplied states go through here before use.
+ */
+static bool
+hashlib_state_valid(const HashlibState *state)
+{
+    if (state->version != HASHLIB_STATE_VERSION)
+        return false;
+
+    switch (state->algorithm)
+    {
+        case HASHLIB_STATE_XXH3:
+            if (state->words[9] >= 16 || state->buffered > HASHLIB_XXH3_BUFFER)
+                return false;
+            if (state->total_len <= HASHLIB_XXH3_BUFFER)
+                return state->buffered == state->total_len;
+            return state->buffered > 0;
+        case HASHLIB_STATE_SPOOKY:
+            if (state->total_len < HASHLIB_SPOOKY_BUFFER)
+                return state->buffered == state->total_len;
+            return state->buffered < HASHLIB_SPOOKY_BUFFER / 2;
+        case HASHLIB_STATE_HIGHWAY:
+            return state->buffered == state->total_len % HASHLIB_HIGHWAY_BUFFER;
+        default:
+            return false;
+    }
+}
+
+static void
+hashlib_state_serialize(StringInfo buf, const HashlibState *state)
+{
+    int i;
+
+    pq_sendbyte(buf, state->version);
+    pq_sendbyte(buf, state->algorithm);
+    pq_sendint16(buf, state->buffered);
+    pq_sendint64(buf, state->total_len);
+    for (i = 0; i < HASHLIB_STATE_WORDS; i++)
+        pq_sendint64(buf, state->words[i]);
+    pq_sendbytes(buf, (const char *) state->buf, HASHLIB_STATE_BUFSIZE);
+}
+
+static HashlibState *
+hashlib_state_deserialize(StringInfo buf)
+{
+    HashlibState *state = hashlib_state_create(0);
+    int i;
+
+    state->version = (uint8) pq_getmsgbyte(buf);
+    state->algorithm = (uint8) pq_getmsgbyte(buf);
+    state->buffered = (uint16) pq_getmsgint(buf, 2);
+    state->total_len = (uint64) pq_getmsgint64(buf);
+    for (i = 0; i < HASHLIB_STATE_WORDS; i++)
+        state->words[i] = (uint64) pq_getmsgint64(buf);
+    pq_copymsgbytes(buf, (char *) state->buf, HASHLIB_STATE_BUFSIZE);
+
+    if (!hashlib_state_valid(state))
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+                 errmsg("invalid hashlib_state")));
+    return state;
+}
+
+static int
+hashlib_hex_value(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+/* hashlib_state_in(cstring) -> hashlib_state */
+PG_FUNCTION_INFO_V1(hashlib_state_in);
+
+Datum
+hashlib_state_in(PG_FUNCTION_ARGS)
+{
+    char *str = PG_GETARG_CSTRING(0);
+    char *hex = strchr(str, ':');
+    StringInfoData buf;
+    HashlibState *state;
+    const char *name;
+    size_t namelen;
+    size_t hexlen;
+    size_t i;
+
+    if (hex == NULL)
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_TEXT_REPRESENTATION),
+                 errmsg("invalid input syntax for type hashlib_state: \"%s\"", str)));
+    namelen = hex - str;
+    hex++;
+    hexlen = strlen(hex);
+    if (hexlen != 2 * HASHLIB_STATE_WIRE_SIZE)
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_TEXT_REPRESENTATION),
+                 errmsg("invalid input syntax for type hashlib_state: \"%s\"", str)));
+
+    initStringInfo(&buf);
+    for (i = 0; i < hexlen; i += 2)
+    {
+        int hi = hashlib_hex_value(hex[i]);
+        int lo = hashlib_hex_value(hex[i + 1]);
+
+        if (hi < 0 || lo < 0)
+            ereport(ERROR,
+                    (errcode(ERRCODE_INVALID_TEXT_REPRESENTATION),
+                     errmsg("invalid input syntax for type hashlib_state: \"%s\"", str)));
+        appendStringInfoChar(&buf, (char) ((hi << 4) | lo));
+    }
+
+    state = hashlib_state_deserialize(&buf);
+
+    /* the name prefix must agree with the encoded algorithm */
+    name = hashlib_state_algorithm_name(state->algorithm);
+    if (strlen(name) != namelen || strncmp(str, name, namelen) != 0)
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_TEXT_REPRESENTATION),
+                 errmsg("invalid input syntax for type hashlib_state: \"%s\"", str)));
+
+    PG_RETURN_HASHLIB_STATE_P(state);
+}
+
+/* hashlib_state_out(hashlib_state) -> cstring */
+PG_FUNCTION_INFO_V1(hashlib_state_out);
+
+Datum
+hashlib_state_out(PG_FUNCTION_ARGS)
+{
+    static const char hexdigits[] = "0123456789abcdef";
+    HashlibState *state = PG_GETARG_HASHLIB_STATE_P(0);
+    StringInfoData bin;
+    StringInfoData out;
+    int i;
+
+    initStringInfo(&bin);
+    hashlib_state_serialize(&bin, state);
+
+    initStringInfo(&out);
+    appendStringInfoString(&out, hashlib_state_algorithm_name(state->algorithm));
+    appendStringInfoChar(&out, ':');
+    for (i = 0; i < bin.len; i++)
+    {
+        appendStringInfoChar(&out, hexdigits[((uint8) bin.data[i]) >> 4]);
+        appendStringInfoChar(&out, hexdigits[((uint8) bin.data[i]) & 0xF]);
+    }
+
+    PG_RETURN_CSTRING(out.data);
+}
+
+/* hashlib_state_recv(internal) -> hashlib_state */
+PG_FUNCTION_INFO_V1(hashlib_state_recv);
+
+Datum
+hashlib_state_recv(PG_FUNCTION_ARGS)
+{
+    StringInfo buf = (StringInfo) PG_GETARG_POINTER(0);
+    HashlibState *state = hashlib_state_deserialize(buf);
+
+    pq_getmsgend(buf);
+    PG_RETURN_HASHLIB_STATE_P(state);
+}
+
+/* hashlib_state_send(hashlib_state) -> bytea */
+PG_FUNCTION_INFO_V1(hashlib_state_send);
+
+Datum
+hashlib_state_send(PG_FUNCTION_ARGS)
+{
+    HashlibState *state = PG_GETARG_HASHLIB_STATE_P(0);
+    StringInfoData buf;
+
+    pq_begintypsend(&buf);
+    hashlib_state_serialize(&buf, state);
+    PG_RETURN_BYTEA_P(pq_endtypsend(&buf));
+}
+
+/* hashlib_state_algorithm(hashlib_state) -> text */
+PG_FUNCTION_INFO_V1(hashlib_state_algorithm);
+
+Datum
+hashlib_state_algorithm(PG_FUNCTION_ARGS)
+{
+    HashlibState *state = PG_GETARG_HASHLIB_STATE_P(0);
+
+    PG_RETURN_TEXT_P(cstring_to_text(hashlib_state_algorithm_name(state->algorithm)));
+}
+
+/* hashlib_state_length(hashlib_state) -> bigint: bytes absorbed so far */
+PG_FUNCTION_INFO_V1(hashlib_state_length);
+
+Datum
+hashlib_state_length(PG_FUNCTION_ARGS)
+{
+    HashlibState *state = PG_GETARG_HASHLIB_STATE_P(0);
+
+    PG_RETURN_INT64((int64) state->total_len);
+}
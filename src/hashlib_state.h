@@ -0,0 +1,58 @@
+#ifndef HASHLIB_STATE_H
+#define HASHLIB_STATE_H
+
+#include "postgres.h"
+#include "fmgr.h"
+
+/*
+ * hashlib_state: an incremental (init/update/final) hash state.
+ *
+ * The state is a fixed-size varlena, so hashing an object of any size needs
+ * the same amount of memory.  It can be stored in a table and resumed later;
+ * the binary send/recv format is byte-order independent.
+ *
+ * Word and buffer usage per algorithm:
+ *
+ *   XXH3      words[0..7] accumulators, words[8] seed, words[9] stripes done
+ *             in the current block; buf[0..255] pending input,
+ *             buf[256..319] last 64 bytes already absorbed
+ *   SPOOKY    words[0..11] internal state, words[12..13] seeds;
+ *             buf[0..191] pending input
+ *   HIGHWAY   words[0..15] v0, v1, mul0, mul1 lanes; buf[0..31] pending input
+ */
+
+#define HASHLIB_STATE_VERSION   1
+
+#define HASHLIB_STATE_XXH3      1
+#define HASHLIB_STATE_SPOOKY    2
+#define HASHLIB_STATE_HIGHWAY   3
+
+#define HASHLIB_STATE_WORDS     16
+#define HASHLIB_STATE_BUFSIZE   320
+
+/* Pending-input capacity of each algorithm */
+#define HASHLIB_XXH3_BUFFER     256
+#define HASHLIB_SPOOKY_BUFFER   192
+#define HASHLIB_HIGHWAY_BUFFER  32
+
+typedef struct HashlibState
+{
+    int32       vl_len_;        /* varlena header (do not touch directly!) */
+    uint8       algorithm;      /* HASHLIB_STATE_* */
+    uint8       version;        /* HASHLIB_STATE_VERSION */
+    uint16      buffered;       /* bytes of pending input in buf */
+    uint32      reserved;
+    uint64      total_len;      /* bytes absorbed so far */
+    uint64      words[HASHLIB_STATE_WORDS];
+    uint8       buf[HASHLIB_STATE_BUFSIZE];
+} HashlibState;
+
+#define DatumGetHashlibStateP(X)        ((HashlibState *) PG_DETOAST_DATUM(X))
+#define PG_GETARG_HASHLIB_STATE_P(n)    DatumGetHashlibStateP(PG_GETARG_DATUM(n))
+#define PG_RETURN_HASHLIB_STATE_P(x)    PG_RETURN_POINTER(x)
+
+extern HashlibState *hashlib_state_create(uint8 algorithm);
+extern HashlibState *hashlib_state_copy(const HashlibState *state);
+extern void hashlib_state_check(const HashlibState *state, uint8 algorithm, const char *funcname);
+
+#endif                          /* HASHLIB_STATE_H */
@@ -0,0 +1,98 @@
+#include "postgres.h"
+#include "fmgr.h"
+#include "utils/builtins.h"
+#include "mb/pg_wchar.h"
+#include "access/htup_details.h"
+#include "miscadmin.h"
+#if PG_VERSION_NUM >= 130000
+#include "access/detoast.h"
+#include "access/heaptoast.h"
+#else
+#include "access/tuptoaster.h"
+#endif
+
+#include "hashlib_toast.h"
+
+/*
+ * Bytes fetched per slice: a whole number of TOAST chunks (about 1 MB), so
+ * no chunk is read twice.
+ */
+#define HASHLIB_TOAST_SLICE     (TOAST_MAX_CHUNK_SIZE * 512)
+
+/*
+ * Can value be hashed slice by slice?  Only values stored out of line without
+ * compression can be read piecewise without reading everything before the
+ * slice; compressed and inline values are detoasted as usual.
+ */
+bool
+hashlib_datum_streamable(Datum value)
+{
+    struct varlena *attr = (struct varlena *) DatumGetPointer(value);
+    struct varatt_external toast_pointer;
+
+    if (!VARATT_IS_EXTERNAL_ONDISK(attr))
+        return false;
+
+    VARATT_EXTERNAL_GET_POINTER(toast_pointer, attr);
+    if (VARATT_EXTERNAL_IS_COMPRESSED(toast_pointer))
+        return false;
+
+    return toast_pointer.va_rawsize - VARHDRSZ > HASHLIB_TOAST_SLICE;
+}
+
+/*
+ * Feed the data of a streamable value to fn one slice at a time.  Only one
+ * slice is held in memory at any point.
+ */
+void
+hashlib_stream_datum(Datum value, hashlib_stream_fn fn, void *arg)
+{
+    struct varlena *attr = (struct varlena *) DatumGetPointer(value);
+    struct varatt_external toast_pointer;
+    int32 total;
+    int32 offset;
+
+    VARATT_EXTERNAL_GET_POINTER(toast_pointer, attr);
+    total = toast_pointer.va_rawsize - VARHDRSZ;
+
+    for (offset = 0; offset < total; offset += HASHLIB_TOAST_SLICE)
+    {
+        int32 count = Min(HASHLIB_TOAST_SLICE, total - offset);
+        struct varlena *slice = PG_DETOAST_DATUM_SLICE(value, offset, count);
+
+        fn(arg, (const uint8 *) VARDATA_ANY(slice), VARSIZE_ANY_EXHDR(slice));
+        pfree(slice);
+        CHECK_FOR_INTERRUPTS();
+    }
+}
+
+/*
+ * Feed fn the 8-byte little-endian length of a text or bytea value followed
+ * by its data, or 8 bytes of 0xFF for NULL, so that a sequence of values
+ * cannot be confused with another sequence of the same concatenation.
+ */
+void
+hashlib_stream_framed_datum(Datum value, bool isnull, hashlib_stream_fn fn, void *arg)
+{
+    uint64 len = isnull ? PG_UINT64_MAX : (uint64) (toast_raw_datum_size(value) - VARHDRSZ);
+    uint8 frame[8];
+    int i;
+
+    for (i = 0; i < 8; i++)
+        frame[i] = (uint8) (len >> (8 * i));
+    fn(arg, frame, sizeof(frame));
+
+    if (isnull)
+        return;
+
+    if (hashlib_datum_streamable(value))
+        hashlib_stream_datum(value, fn, arg);
+    else
+    {
+        struct varlena *data = PG_DETOAST_DATUM_PACKED(value);
+
+        fn(arg, (const uint8 *) VARDATA_ANY(data), VARSIZE_ANY_EXHDR(data));
+        if ((Pointer) data != DatumGetPointer(value))
+            pfree(data);
+    }
+}
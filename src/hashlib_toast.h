@@ -0,0 +1,21 @@
+#ifndef HASHLIB_TOAST_H
+#define HASHLIB_TOAST_H
+
+#include "postgres.h"
+#include "fmgr.h"
+
+/*
+ * Hashing of large values without detoasting them in one piece.
+ *
+ * A value stored out of line and uncompressed can be read one slice of TOAST
+ * chunks at a time, so a streaming kernel can hash it with memory bounded by
+ * the slice size rather than by the size of the value.
+ */
+
+typedef void (*hashlib_stream_fn) (void *arg, const uint8 *data, size_t len);
+
+extern bool hashlib_datum_streamable(Datum value);
+extern void hashlib_stream_datum(Datum value, hashlib_stream_fn fn, void *arg);
+extern void hashlib_stream_framed_datum(Datum value, bool isnull, hashlib_stream_fn fn, void *arg);
+
+#endif                          /* HASHLIB_TOAST_H */
@@ -0,0 +1,885 @@
+#include "postgres.h"
+#include "fmgr.h"
+#include "funcapi.h"
+#include "access/htup_details.h"
+#include "catalog/pg_type.h"
+#include "utils/array.h"
+#include "utils/builtins.h"
+#include "utils/memutils.h"
+#include "libpq/pqformat.h"
+
+#include <math.h>
+
+#include "hashlib_sketch.h"
+
+/*
+ * Consistent-hash routing table: a Maglev lookup table (Eisenbud et al.,
+ * "Maglev: A Fast and Reliable Software Network Load Balancer", 2016) over
+ * named, weighted nodes, stored as a value so that routing a key is one
+ * table read instead of an ORDER BY token LIMIT 1 probe into a ring table.
+ *
+ * The table has M slots, M a prime of at least 65537 and 100 slots per
+ * node.  Each node has a permutation of the slots, offset + j * skip mod M,
+ * with offset and skip from the xxhash3_64 of its name, and the nodes take
+ * turns claiming their next free slot until the table is full; a node of
+ * weight w takes a turn in w / max weight of the rounds.  Each node gets its
+ * share of slots to within one slot per round, and removing or adding a node
+ * moves little more than that node's share of slots.  The nodes are sorted
+ * by name first, so the table depends only on the set of (node, weight).
+ *
+ * A key is routed to the node of slot (fmix64(key) * M) >> 64, where key is
+ * a bigint hash or the xxhash3_64 of text or bytea.
+ *
+ * Stored layout (integers little-endian):
+ *
+ *   byte 0       format version (1)
+ *   bytes 1-3    reserved (0)
+ *   bytes 4-7    number of slots M
+ *   bytes 8-11   number of nodes N
+ *   bytes 12-15  length of the node names in bytes
+ *   then         N nodes of 16 bytes, sorted by name: offset of the name in
+ *                the names (4 bytes), name length (4 bytes), weight
+ *                (IEEE 754 double, 8 bytes)
+ *   then         the node names
+ *   then         M slots of 2 bytes: the index of the slot's node
+ */
+
+#define HASHRING_VERSION        1
+#define HASHRING_HEADER_SIZE    16
+#define HASHRING_NODE_SIZE      16
+#define HASHRING_MIN_SLOTS      65537
+#define HASHRING_SLOTS_PER_NODE 100
+#define HASHRING_MAX_NODES      65535
+
+typedef struct HashringNode
+{
+    char       *name;
+    int         len;
+    double      weight;
+} HashringNode;
+
+typedef struct HashringState
+{
+    int         nnodes;
+    int         capacity;
+    HashringNode *nodes;
+} HashringState;
+
+static HashringState *
+hashring_state_create(MemoryContext context)
+{
+    HashringState *state = (HashringState *) MemoryContextAlloc(context, sizeof(HashringState));
+
+    state->nnodes = 0;
+    state->capacity = 16;
+    state->nodes = (HashringNode *) MemoryContextAlloc(context, sizeof(HashringNode) * state->capacity);
+    return state;
+}
+
+static void
+hashring_state_add(HashringState *state, const char *name, int len, double weight)
+{
+    MemoryContext context = GetMemoryChunkContext(state->nodes);
+    HashringNode *node;
+
+    if (isnan(weight) || isinf(weight) || weight < 0)
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("node weights must be finite and not negative")));
+    if (state->nnodes == HASHRING_MAX_NODES)
+        ereport(ERROR,
+                (errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+                 errmsg("hashring cannot have more than %d nodes", HASHRING_MAX_NODES)));
+    if (state->nnodes == state->capacity)
+    {
+        state->capacity *= 2;
+        state->nodes = (HashringNode *) repalloc(state->nodes, sizeof(HashringNode) * state->capacity);
+    }
+
+    node = &state->nodes[state->nnodes++];
+    node->name = (char *) MemoryContextAlloc(context, Max(len, 1));
+    memcpy(node->name, name, len);
+    node->len = len;
+    node->weight = weight;
+}
+
+static int
+hashring_node_cmp(const void *a, const void *b)
+{
+    const HashringNode *x = (const HashringNode *) a;
+    const HashringNode *y = (const HashringNode *) b;
+    int c = memcmp(x->name, y->name, Min(x->len, y->len));
+
+    if (c != 0)
+        return c;
+    return x->len < y->len ? -1 : x->len > y->len ? 1 : 0;
+}
+
+static uint32
+hashring_slot_count(int nnodes)
+{
+    uint32 m = Max(HASHRING_MIN_SLOTS, (uint32) nnodes * HASHRING_SLOTS_PER_NODE);
+
+    /* the smallest prime of at least m */
+    for (;; m++)
+    {
+        uint32 d;
+
+        for (d = 2; d * d <= m; d++)
+        {
+            if (m % d == 0)
+                break;
+        }
+        if (d * d > m)
+            return m;
+    }
+}
+
+static inline uint64
+hashring_double_bits(double v)
+{
+    uint64 bits;
+
+    memcpy(&bits, &v, sizeof(bits));
+    return bits;
+}
+
+static inline double
+hashring_bits_double(uint64 bits)
+{
+    double v;
+
+    memcpy(&v, &bits, sizeof(v));
+    return v;
+}
+
+/* Build the table of the nodes of state, which are sorted */
+static bytea *
+hashring_build(HashringState *state)
+{
+    int n = state->nnodes;
+    uint32 m;
+    double max_weight = 0;
+    uint32 *offset;
+    uint32 *skip;
+    uint32 *next;
+    double *credit;
+    int32 *slots;
+    uint32 filled = 0;
+    Size names_len = 0;
+    Size size;
+    bytea *result;
+    uint8 *data;
+    uint8 *names;
+    uint8 *table;
+    int i;
+
+    if (n == 0)
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("node array must not be empty")));
+
+    qsort(state->nodes, n, sizeof(HashringNode), hashring_node_cmp);
+    for (i = 0; i < n; i++)
+    {
+        if (i > 0 && hashring_node_cmp(&state->nodes[i - 1], &state->nodes[i]) == 0)
+            ereport(ERROR,
+                    (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                     errmsg("duplicate hashring node \"%.*s\"",
+                            state->nodes[i].len, state->nodes[i].name)));
+        max_weight = Max(max_weight, state->nodes[i].weight);
+        names_len += state->nodes[i].len;
+    }
+    if (max_weight <= 0)
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("at least one node weight must be positive")));
+    if (names_len > MaxAllocSize / 2)
+        ereport(ERROR,
+                (errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+                 errmsg("hashring node names are too long")));
+
+    m = hashring_slot_count(n);
+    offset = (uint32 *) palloc(sizeof(uint32) * n);
+    skip = (uint32 *) palloc(sizeof(uint32) * n);
+    next = (uint32 *) palloc0(sizeof(uint32) * n);
+    credit = (double *) palloc0(sizeof(double) * n);
+    slots = (int32 *) palloc(sizeof(int32) * m);
+    memset(slots, -1, sizeof(int32) * m);
+
+    for (i = 0; i < n; i++)
+    {
+        uint64 h = hashlib_xxh3_64(state->nodes[i].name, state->nodes[i].len);
+
+        offset[i] = (uint32) (h % m);
+        skip[i] = (uint32) (hashlib_mix64(h) % (m - 1)) + 1;
+    }
+
+    /* every round the heaviest node claims a slot, so this ends */
+    while (filled < m)
+    {
+        for (i = 0; i < n && filled < m; i++)
+        {
+            uint32 c;
+
+            credit[i] += state->nodes[i].weight / max_weight;
+            if (credit[i] < 1)
+                continue;
+            credit[i] -= 1;
+
+            /* the node's next slot in its permutation that is free */
+            do
+            {
+                c = (uint32) (((uint64) offset[i] + (uint64) next[i] * skip[i]) % m);
+                next[i]++;
+            } while (slots[c] >= 0);
+            slots[c] = i;
+            filled++;
+        }
+    }
+
+    size = HASHRING_HEADER_SIZE + (Size) HASHRING_NODE_SIZE * n + names_len + (Size) 2 * m;
+    result = (bytea *) palloc(VARHDRSZ + size);
+    SET_VARSIZE(result, VARHDRSZ + size);
+    data = (uint8 *) VARDATA(result);
+    data[0] = HASHRING_VERSION;
+    data[1] = data[2] = data[3] = 0;
+    hashlib_write_le32(data + 4, m);
+    hashlib_write_le32(data + 8, (uint32) n);
+    hashlib_write_le32(data + 12, (uint32) names_len);
+
+    names = data + HASHRING_HEADER_SIZE + HASHRING_NODE_SIZE * n;
+    names_len = 0;
+    for (i = 0; i < n; i++)
+    {
+        uint8 *node = data + HASHRING_HEADER_SIZE + HASHRING_NODE_SIZE * i;
+
+        hashlib_write_le32(node, (uint32) names_len);
+        hashlib_write_le32(node + 4, (uint32) state->nodes[i].len);
+        hashlib_write_le64(node + 8, hashring_double_bits(state->nodes[i].weight));
+        memcpy(names + names_len, state->nodes[i].name, state->nodes[i].len);
+        names_len += state->nodes[i].len;
+    }
+
+    table = names + names_len;
+    for (i = 0; i < (int) m; i++)
+        hashlib_write_le16(table + 2 * i, (uint16) slots[i]);
+
+    pfree(offset);
+    pfree(skip);
+    pfree(next);
+    pfree(credit);
+    pfree(slots);
+    return result;
+}
+
+static void
+hashring_invalid(void)
+{
+    ereport(ERROR,
+            (errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+             errmsg("invalid hashring")));
+}
+
+/*
+ * Check the header and the size.  The node entries and slots are checked
+ * when they are read, so that routing a key stays O(1).
+ */
+static void
+hashring_validate(const bytea *ring)
+{
+    const uint8 *data = (const uint8 *) VARDATA_ANY(ring);
+    Size size = VARSIZE_ANY_EXHDR(ring);
+    uint32 m;
+    uint32 n;
+
+    if (size < HASHRING_HEADER_SIZE || data[0] != HASHRING_VERSION ||
+        data[1] != 0 || data[2] != 0 || data[3] != 0)
+        hashring_invalid();
+
+    m = hashlib_read_le32(data + 4);
+    n = hashlib_read_le32(data + 8);
+    if (m < 2 || n == 0 || n > HASHRING_MAX_NODES ||
+        size != HASHRING_HEADER_SIZE + (uint64) HASHRING_NODE_SIZE * n +
+        hashlib_read_le32(data + 12) + (uint64) 2 * m)
+        hashring_invalid();
+}
+
+/* Name of node i of a validated ring */
+static text *
+hashring_node_name(const uint8 *data, uint32 i)
+{
+    uint32 n = hashlib_read_le32(data + 8);
+    uint32 names_len = hashlib_read_le32(data + 12);
+    const uint8 *node = data + HASHRING_HEADER_SIZE + HASHRING_NODE_SIZE * i;
+    uint32 offset;
+    uint32 len;
+
+    if (i >= n)
+        hashring_invalid();
+    offset = hashlib_read_le32(node);
+    len = hashlib_read_le32(node + 4);
+    if (offset > names_len || len > names_len - offset)
+        hashring_invalid();
+    return cstring_to_text_with_len((const char *) data + HASHRING_HEADER_SIZE +
+                                    HASHRING_NODE_SIZE * n + offset, len);
+}
+
+static inline const uint8 *
+hashring_table(const uint8 *data)
+{
+    return data + HASHRING_HEADER_SIZE + HASHRING_NODE_SIZE * hashlib_read_le32(data + 8) +
+        hashlib_read_le32(data + 12);
+}
+
+/* Node index of slot s */
+static inline uint32
+hashring_slot_node(const uint8 *data, uint32 s)
+{
+    return hashlib_read_le16(hashring_table(data) + 2 * s);
+}
+
+/* Key of ring_lookup: bigint, or text or bytea hashed */
+static uint64
+hashring_getarg_key(FunctionCallInfo fcinfo, int argno)
+{
+    if (get_fn_expr_argtype(fcinfo->flinfo, argno) == INT8OID)
+        return (uint64) PG_GETARG_INT64(argno);
+    return hashlib_xxh3_64(VARDATA_ANY(PG_GETARG_TEXT_PP(argno)),
+                           VARSIZE_ANY_EXHDR(PG_GETARG_TEXT_PP(argno)));
+}
+
+/* hashring_in(cstring) -> hashring */
+PG_FUNCTION_INFO_V1(hashring_in);
+
+Datum
+hashring_in(PG_FUNCTION_ARGS)
+{
+    bytea *ring = (bytea *) hashlib_sketch_from_hex(PG_GETARG_CSTRING(0), "hashring");
+
+    hashring_validate(ring);
+    PG_RETURN_BYTEA_P(ring);
+}
+
+/* hashring_out(hashring) -> cstring */
+PG_FUNCTION_INFO_V1(hashring_out);
+
+Datum
+hashring_out(PG_FUNCTION_ARGS)
+{
+    PG_RETURN_CSTRING(hashlib_sketch_to_hex((struct varlena *) PG_GETARG_BYTEA_PP(0)));
+}
+
+/* hashring_recv(internal) -> hashring */
+PG_FUNCTION_INFO_V1(hashring_recv);
+
+Datum
+hashring_recv(PG_FUNCTION_ARGS)
+{
+    bytea *ring = (bytea *) hashlib_sketch_recv((StringInfo) PG_GETARG_POINTER(0));
+
+    hashring_validate(ring);
+    PG_RETURN_BYTEA_P(ring);
+}
+
+/* hashring_send(hashring) -> bytea */
+PG_FUNCTION_INFO_V1(hashring_send);
+
+Datum
+hashring_send(PG_FUNCTION_ARGS)
+{
+    bytea *ring = PG_GETARG_BYTEA_PP(0);
+    StringInfoData buf;
+
+    pq_begintypsend(&buf);
+    pq_sendbytes(&buf, VARDATA_ANY(ring), VARSIZE_ANY_EXHDR(ring));
+    PG_RETURN_BYTEA_P(pq_endtypsend(&buf));
+}
+
+/* hashring(bytea) -> hashring: checks the stored layout, for the bytea cast */
+PG_FUNCTION_INFO_V1(hashring_from_bytea);
+
+Datum
+hashring_from_bytea(PG_FUNCTION_ARGS)
+{
+    bytea *ring = PG_GETARG_BYTEA_P_COPY(0);
+
+    hashring_validate(ring);
+    PG_RETURN_BYTEA_P(ring);
+}
+
+/* hashring(text[] [, double precision[]]) -> hashring */
+PG_FUNCTION_INFO_V1(hashring_from_arrays);
+
+Datum
+hashring_from_arrays(PG_FUNCTION_ARGS)
+{
+    ArrayType *nodes = PG_GETARG_ARRAYTYPE_P(0);
+    HashringState *state = hashring_state_create(CurrentMemoryContext);
+    Datum *names;
+    bool *name_nulls;
+    int nnames;
+    Datum *weights = NULL;
+    bool *weight_nulls = NULL;
+    int nweights = 0;
+    int i;
+
+    if (ARR_NDIM(nodes) > 1)
+        ereport(ERROR,
+                (errcode(ERRCODE_ARRAY_SUBSCRIPT_ERROR),
+                 errmsg("node array must be one-dimensional")));
+    deconstruct_array(nodes, TEXTOID, -1, false, 'i', &names, &name_nulls, &nnames);
+    if (PG_NARGS() > 1)
+    {
+        ArrayType *weight_array = PG_GETARG_ARRAYTYPE_P(1);
+
+        if (ARR_NDIM(weight_array) > 1)
+            ereport(ERROR,
+                    (errcode(ERRCODE_ARRAY_SUBSCRIPT_ERROR),
+                     errmsg("weight array must be one-dimensional")));
+        deconstruct_array(weight_array, FLOAT8OID, sizeof(float8), FLOAT8PASSBYVAL, 'd',
+                          &weights, &weight_nulls, &nweights);
+        if (nweights != nnames)
+            ereport(ERROR,
+                    (errcode(ERRCODE_ARRAY_SUBSCRIPT_ERROR),
+                     errmsg("node and weight arrays must have the same length")));
+    }
+
+    for (i = 0; i < nnames; i++)
+    {
+        text *name;
+
+        if (name_nulls[i])
+            ereport(ERROR,
+                    (errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED),
+                     errmsg("node names must not be null")));
+        if (weights != NULL && weight_nulls[i])
+            ereport(ERROR,
+                    (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                     errmsg("node weights must be finite and not negative")));
+        name = DatumGetTextPP(names[i]);
+        hashring_state_add(state, VARDATA_ANY(name), VARSIZE_ANY_EXHDR(name),
+                           weights != NULL ? DatumGetFloat8(weights[i]) : 1.0);
+    }
+    PG_RETURN_BYTEA_P(hashring_build(state));
+}
+
+/* ring_lookup(hashring, bigint | text | bytea) -> text: the key's node */
+PG_FUNCTION_INFO_V1(ring_lookup);
+
+Datum
+ring_lookup(PG_FUNCTION_ARGS)
+{
+    HashlibDetoastCache *cache = (HashlibDetoastCache *) fcinfo->flinfo->fn_extra;
+    const uint8 *data;
+    uint32 slot;
+
+    if (cache == NULL)
+    {
+        cache = (HashlibDetoastCache *) MemoryContextAllocZero(fcinfo->flinfo->fn_mcxt,
+                                                               sizeof(HashlibDetoastCache));
+        fcinfo->flinfo->fn_extra = cache;
+    }
+
+    data = (const uint8 *) VARDATA_ANY(hashlib_sketch_getarg_cached(fcinfo, 0, cache,
+                                                                    hashring_validate));
+    slot = hashlib_reduce64(hashlib_mix64(hashring_getarg_key(fcinfo, 1)), hashlib_read_le32(data + 4));
+    PG_RETURN_TEXT_P(hashring_node_name(data, hashring_slot_node(data, slot)));
+}
+
+/* State of ring_nodes: the ring and the number of slots of each node */
+typedef struct HashringNodesState
+{
+    const uint8 *data;
+    uint32     *counts;
+    uint32      m;
+} HashringNodesState;
+
+/*
+ * ring_nodes(hashring) -> setof (node text, weight double precision,
+ * share double precision): the nodes by name, with their share of keys
+ */
+PG_FUNCTION_INFO_V1(ring_nodes);
+
+Datum
+ring_nodes(PG_FUNCTION_ARGS)
+{
+    FuncCallContext *funcctx;
+    HashringNodesState *nodes;
+
+    if (SRF_IS_FIRSTCALL())
+    {
+        MemoryContext oldcontext;
+        TupleDesc tupdesc;
+        bytea *ring;
+        uint32 s;
+
+        funcctx = SRF_FIRSTCALL_INIT();
+        oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+        if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+            elog(ERROR, "return type must be a row type");
+
+        ring = PG_GETARG_BYTEA_P_COPY(0);
+        hashring_validate(ring);
+        nodes = (HashringNodesState *) palloc(sizeof(HashringNodesState));
+        nodes->data = (const uint8 *) VARDATA(ring);
+        nodes->m = hashlib_read_le32(nodes->data + 4);
+        funcctx->max_calls = hashlib_read_le32(nodes->data + 8);
+        nodes->counts = (uint32 *) palloc0(sizeof(uint32) * funcctx->max_calls);
+        for (s = 0; s < nodes->m; s++)
+        {
+            uint32 node = hashring_slot_node(nodes->data, s);
+
+            if (node >= funcctx->max_calls)
+                hashring_invalid();
+            nodes->counts[node]++;
+        }
+
+        funcctx->tuple_desc = BlessTupleDesc(tupdesc);
+        funcctx->user_fctx = nodes;
+        MemoryContextSwitchTo(oldcontext);
+    }
+
+    funcctx = SRF_PERCALL_SETUP();
+    nodes = (HashringNodesState *) funcctx->user_fctx;
+
+    if (funcctx->call_cntr < funcctx->max_calls)
+    {
+        uint32 i = (uint32) funcctx->call_cntr;
+        Datum values[3];
+        bool nulls[3] = {false, false, false};
+
+        values[0] = PointerGetDatum(hashring_node_name(nodes->data, i));
+        values[1] = Float8GetDatum(hashring_bits_double(
+            hashlib_read_le64(nodes->data + HASHRING_HEADER_SIZE + HASHRING_NODE_SIZE * i + 8)));
+        values[2] = Float8GetDatum((double) nodes->counts[i] / nodes->m);
+
+        SRF_RETURN_NEXT(funcctx, HeapTupleGetDatum(heap_form_tuple(funcctx->tuple_desc, values, nulls)));
+    }
+
+    SRF_RETURN_DONE(funcctx);
+}
+
+/* One row of ring_diff */
+typedef struct HashringMove
+{
+    text       *from;
+    text       *to;
+    double      share;
+} HashringMove;
+
+/* Byte order of two names, the order of the nodes in a ring */
+static int
+hashring_name_cmp(const text *x, const text *y)
+{
+    Size xlen = VARSIZE_ANY_EXHDR(x);
+    Size ylen = VARSIZE_ANY_EXHDR(y);
+    int c = memcmp(VARDATA_ANY(x), VARDATA_ANY(y), Min(xlen, ylen));
+
+    if (c != 0)
+        return c;
+    return xlen < ylen ? -1 : xlen > ylen ? 1 : 0;
+}
+
+static int
+hashring_move_cmp(const void *a, const void *b)
+{
+    const HashringMove *x = (const HashringMove *) a;
+    const HashringMove *y = (const HashringMove *) b;
+    int c = hashring_name_cmp(x->from, y->from);
+
+    if (c != 0)
+        return c;
+    return hashring_name_cmp(x->to, y->to);
+}
+
+/*
+ * The share of the key space that moves from each node of old to each other
+ * node of new.  Slot i of a ring of M slots holds the keys whose fmix64 lies
+ * in [i / M, (i + 1) / M) of the 64-bit range, so the slots of both rings are
+ * walked together in order of those boundaries.
+ */
+static HashringMove *
+hashring_diff(const uint8 *old, const uint8 *new, int *nmoves)
+{
+    uint32 m_old = hashlib_read_le32(old + 4);
+    uint32 m_new = hashlib_read_le32(new + 4);
+    uint32 n_old = hashlib_read_le32(old + 8);
+    uint32 n_new = hashlib_read_le32(new + 8);
+    text **names_old = (text **) palloc(sizeof(text *) * n_old);
+    text **names_new = (text **) palloc(sizeof(text *) * n_new);
+    double *shares = NULL;
+    uint32 *pairs_old = NULL;
+    uint32 *pairs_new = NULL;
+    int npairs = 0;
+    int capacity = 0;
+    HashringMove *moves;
+    uint32 i = 0;
+    uint32 j = 0;
+    double position = 0;
+    int k;
+
+    for (k = 0; k < (int) n_old; k++)
+        names_old[k] = hashring_node_name(old, k);
+    for (k = 0; k < (int) n_new; k++)
+        names_new[k] = hashring_node_name(new, k);
+
+    while (i < m_old && j < m_new)
+    {
+        uint32 a = hashring_slot_node(old, i);
+        uint32 b = hashring_slot_node(new, j);
+        double end;
+
+        if (a >= n_old || b >= n_new)
+            hashring_invalid();
+
+        /* the nearer of the two next boundaries, (i + 1) / m_old or (j + 1) / m_new */
+        if ((uint64) (i + 1) * m_new <= (uint64) (j + 1) * m_old)
+            end = (double) (i + 1) / m_old;
+        else
+            end = (double) (j + 1) / m_new;
+
+        if (hashring_name_cmp(names_old[a], names_new[b]) != 0)
+        {
+            /* few distinct pairs move, so a linear search is enough */
+            for (k = 0; k < npairs; k++)
+            {
+                if (pairs_old[k] == a && pairs_new[k] == b)
+                    break;
+            }
+            if (k == npairs)
+            {
+                if (npairs == capacity)
+                {
+                    capacity = Max(16, capacity * 2);
+                    shares = shares ? repalloc(shares, sizeof(double) * capacity) :
+                        palloc(sizeof(double) * capacity);
+                    pairs_old = pairs_old ? repalloc(pairs_old, sizeof(uint32) * capacity) :
+                        palloc(sizeof(uint32) * capacity);
+                    pairs_new = pairs_new ? repalloc(pairs_new, sizeof(uint32) * capacity) :
+                        palloc(sizeof(uint32) * capacity);
+                }
+                pairs_old[k] = a;
+                pairs_new[k] = b;
+                shares[k] = 0;
+                npairs++;
+            }
+            shares[k] += end - position;
+        }
+        position = end;
+
+        if ((uint64) (i + 1) * m_new <= (uint64) (j + 1) * m_old)
+        {
+            if ((uint64) (i + 1) * m_new == (uint64) (j + 1) * m_old)
+                j++;
+            i++;
+        }
+        else
+            j++;
+    }
+
+    moves = (HashringMove *) palloc(sizeof(HashringMove) * Max(npairs, 1));
+    for (k = 0; k < npairs; k++)
+    {
+        moves[k].from = names_old[pairs_old[k]];
+        moves[k].to = names_new[pairs_new[k]];
+        moves[k].share = shares[k];
+    }
+    qsort(moves, npairs, sizeof(HashringMove), hashring_move_cmp);
+    *nmoves = npairs;
+    return moves;
+}
+
+/*
+ * ring_diff(old hashring, new hashring) -> setof (old_node text,
+ * new_node text, share double precision): the share of keys that moves from
+ * each node to another when old is replaced by new
+ */
+PG_FUNCTION_INFO_V1(ring_diff);
+
+Datum
+ring_diff(PG_FUNCTION_ARGS)
+{
+    FuncCallContext *funcctx;
+    HashringMove *moves;
+
+    if (SRF_IS_FIRSTCALL())
+    {
+        MemoryContext oldcontext;
+        TupleDesc tupdesc;
+        bytea *old;
+        bytea *new;
+        int nmoves;
+
+        funcctx = SRF_FIRSTCALL_INIT();
+        oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+        if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+            elog(ERROR, "return type must be a row type");
+
+        old = PG_GETARG_BYTEA_PP(0);
+        new = PG_GETARG_BYTEA_PP(1);
+        hashring_validate(old);
+        hashring_validate(new);
+        funcctx->user_fctx = hashring_diff((const uint8 *) VARDATA_ANY(old),
+                                           (const uint8 *) VARDATA_ANY(new), &nmoves);
+        funcctx->max_calls = nmoves;
+        funcctx->tuple_desc = BlessTupleDesc(tupdesc);
+        MemoryContextSwitchTo(oldcontext);
+    }
+
+    funcctx = SRF_PERCALL_SETUP();
+    moves = (HashringMove *) funcctx->user_fctx;
+
+    if (funcctx->call_cntr < funcctx->max_calls)
+    {
+        HashringMove *move = &moves[funcctx->call_cntr];
+        Datum values[3];
+        bool nulls[3] = {false, false, false};
+
+        values[0] = PointerGetDatum(move->from);
+        values[1] = PointerGetDatum(move->to);
+        values[2] = Float8GetDatum(move->share);
+
+        SRF_RETURN_NEXT(funcctx, HeapTupleGetDatum(heap_form_tuple(funcctx->tuple_desc, values, nulls)));
+    }
+
+    SRF_RETURN_DONE(funcctx);
+}
+
+/* hashring_agg_transfn(internal, text [, double precision]) -> internal */
+PG_FUNCTION_INFO_V1(hashring_agg_transfn);
+
+Datum
+hashring_agg_transfn(PG_FUNCTION_ARGS)
+{
+    MemoryContext aggcontext;
+    HashringState *state;
+
+    if (!AggCheckCallContext(fcinfo, &aggcontext))
+        elog(ERROR, "hashring_agg_transfn called in non-aggregate context");
+
+    if (PG_ARGISNULL(0))
+        state = hashring_state_create(aggcontext);
+    else
+        state = (HashringState *) PG_GETARG_POINTER(0);
+
+    if (!PG_ARGISNULL(1))
+    {
+        text *name = PG_GETARG_TEXT_PP(1);
+
+        if (PG_NARGS() > 2 && PG_ARGISNULL(2))
+            ereport(ERROR,
+                    (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                     errmsg("node weights must be finite and not negative")));
+        hashring_state_add(state, VARDATA_ANY(name), VARSIZE_ANY_EXHDR(name),
+                           PG_NARGS() > 2 ? PG_GETARG_FLOAT8(2) : 1.0);
+    }
+
+    PG_RETURN_POINTER(state);
+}
+
+/* hashring_agg_combine(internal, internal) -> internal */
+PG_FUNCTION_INFO_V1(hashring_agg_combine);
+
+Datum
+hashring_agg_combine(PG_FUNCTION_ARGS)
+{
+    MemoryContext aggcontext;
+    HashringState *state;
+    HashringState *other;
+    int i;
+
+    if (!AggCheckCallContext(fcinfo, &aggcontext))
+        elog(ERROR, "hashring_agg_combine called in non-aggregate context");
+
+    if (PG_ARGISNULL(1))
+        PG_RETURN_POINTER(PG_ARGISNULL(0) ? NULL : PG_GETARG_POINTER(0));
+
+    other = (HashringState *) PG_GETARG_POINTER(1);
+    if (PG_ARGISNULL(0))
+        state = hashring_state_create(aggcontext);
+    else
+        state = (HashringState *) PG_GETARG_POINTER(0);
+    for (i = 0; i < other->nnodes; i++)
+        hashring_state_add(state, other->nodes[i].name, other->nodes[i].len, other->nodes[i].weight);
+
+    PG_RETURN_POINTER(state);
+}
+
+/*
+ * hashring_agg_serialize(internal) -> bytea
+ *
+ * A partial state is its nodes, each as the weight (8 bytes), the name
+ * length (4 bytes) and the name.
+ */
+PG_FUNCTION_INFO_V1(hashring_agg_serialize);
+
+Datum
+hashring_agg_serialize(PG_FUNCTION_ARGS)
+{
+    HashringState *state = (HashringState *) PG_GETARG_POINTER(0);
+    StringInfoData buf;
+    int i;
+
+    pq_begintypsend(&buf);
+    for (i = 0; i < state->nnodes; i++)
+    {
+        uint8 header[12];
+
+        hashlib_write_le64(header, hashring_double_bits(state->nodes[i].weight));
+        hashlib_write_le32(header + 8, (uint32) state->nodes[i].len);
+        appendBinaryStringInfo(&buf, (const char *) header, sizeof(header));
+        appendBinaryStringInfo(&buf, state->nodes[i].name, state->nodes[i].len);
+    }
+    PG_RETURN_BYTEA_P(pq_endtypsend(&buf));
+}
+
+/* hashring_agg_deserialize(bytea, internal) -> internal */
+PG_FUNCTION_INFO_V1(hashring_agg_deserialize);
+
+Datum
+hashring_agg_deserialize(PG_FUNCTION_ARGS)
+{
+    bytea *partial;
+    const uint8 *p;
+    const uint8 *end;
+    HashringState *state;
+
+    if (!AggCheckCallContext(fcinfo, NULL))
+        elog(ERROR, "hashring_agg_deserialize called in non-aggregate context");
+
+    partial = PG_GETARG_BYTEA_PP(0);
+    p = (const uint8 *) VARDATA_ANY(partial);
+    end = p + VARSIZE_ANY_EXHDR(partial);
+    state = hashring_state_create(CurrentMemoryContext);
+    while (p < end)
+    {
+        uint32 len;
+
+        if (end - p < 12 || (len = hashlib_read_le32(p + 8)) > (Size) (end - p - 12))
+            elog(ERROR, "invalid hashring partial state");
+        hashring_state_add(state, (const char *) p + 12, (int) len,
+                           hashring_bits_double(hashlib_read_le64(p)));
+        p += 12 + len;
+    }
+    PG_RETURN_POINTER(state);
+}
+
+/* hashring_agg_final(internal) -> hashring; NULL when there were no rows */
+PG_FUNCTION_INFO_V1(hashring_agg_final);
+
+Datum
+hashring_agg_final(PG_FUNCTION_ARGS)
+{
+    HashringState *state;
+
+    if (PG_ARGISNULL(0))
+        PG_RETURN_NULL();
+
+    state = (HashringState *) PG_GETARG_POINTER(0);
+    if (state->nnodes == 0)
+        PG_RETURN_NULL();
+    PG_RETURN_BYTEA_P(hashring_build(state));
+}
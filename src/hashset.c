@@ -0,0 +1,720 @@
+#include "postgres.h"
+#include "fmgr.h"
+#include "utils/builtins.h"
+#include "utils/lsyscache.h"
+#include "utils/memutils.h"
+#include "utils/array.h"
+#include "utils/uuid.h"
+#include "catalog/pg_type.h"
+#include "libpq/pqformat.h"
+
+#include "hashlib_sketch.h"
+
+/*
+ * Exact set of integers or uuids for membership tests.
+ *
+ * The set is an open-addressing hash table stored flat, so it is probed in
+ * place in the datum without being loaded.  The table is an array of 64-byte
+ * buckets, each holding eight 8-byte integer keys or four 16-byte uuid keys.
+ * A key hashes to a bucket and is stored in the first free slot of that
+ * bucket or the ones after it, so a probe compares whole buckets (with AVX2
+ * where available) until it finds the key or a free slot.  The table is kept
+ * at most three quarters full.
+ *
+ * Integer keys (integer and bigint values, which compare equal when equal as
+ * numbers) are hashed with fmix64, and uuid keys with fmix64 of the xor of
+ * one half with the mix of the other.  The all-zero key marks a free slot, so
+ * whether the set holds 0 or the nil uuid is a header flag.
+ *
+ * Stored layout (integers little-endian):
+ *
+ *   byte 0       format version (1)
+ *   byte 1       key width: 8 for integers, 16 for uuids
+ *   byte 2       log2 of the number of buckets
+ *   byte 3       flags: 1 if the set holds the zero key
+ *   bytes 4-7    reserved (0)
+ *   bytes 8-15   number of keys
+ *   then         buckets of 64 bytes; integer keys are stored as 8-byte
+ *                little-endian integers, uuids as their 16 bytes
+ */
+
+#if (defined(__x86_64__) || defined(_M_AMD64)) && (defined(__GNUC__) || defined(__clang__))
+#define HASHSET_USE_AVX2 1
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+#define HASHSET_VERSION         1
+#define HASHSET_HEADER_SIZE     16
+#define HASHSET_BUCKET_SIZE     64
+#define HASHSET_MAX_LOG2        23
+#define HASHSET_HAS_ZERO        1
+
+#define HASHSET_INT_WIDTH       8
+#define HASHSET_UUID_WIDTH      UUID_LEN
+
+typedef struct HashsetState
+{
+    int         width;          /* key width, 8 or 16 */
+    int         log2;           /* log2 of the number of buckets */
+    bool        has_zero;
+    int64       count;
+    uint8      *buckets;
+} HashsetState;
+
+/* A key in its stored form */
+typedef struct HashsetKey
+{
+    int         width;
+    uint8       bytes[HASHSET_UUID_WIDTH];
+} HashsetKey;
+
+static const uint8 hashset_zero[HASHSET_UUID_WIDTH];
+
+static inline Size
+hashset_nbuckets(int log2)
+{
+    return (Size) 1 << log2;
+}
+
+static inline Size
+hashset_slots(int log2, int width)
+{
+    return hashset_nbuckets(log2) * (HASHSET_BUCKET_SIZE / width);
+}
+
+static inline bool
+hashset_is_zero(const HashsetKey *key)
+{
+    return memcmp(key->bytes, hashset_zero, key->width) == 0;
+}
+
+static inline uint64
+hashset_hash(const HashsetKey *key)
+{
+    uint64 lo = hashlib_read_le64(key->bytes);
+
+    if (key->width == HASHSET_INT_WIDTH)
+        return hashlib_mix64(lo);
+    return hashlib_mix64(hashlib_read_le64(key->bytes + 8) ^ hashlib_mix64(lo));
+}
+
+static inline Size
+hashset_bucket(uint64 hash, int log2)
+{
+    return log2 == 0 ? 0 : (Size) (hash >> (64 - log2));
+}
+
+/* Reject element types a hashset cannot hold */
+static void
+hashset_check_type(Oid typid)
+{
+    if (typid != INT8OID && typid != INT4OID && typid != UUIDOID)
+        ereport(ERROR,
+                (errcode(ERRCODE_DATATYPE_MISMATCH),
+                 errmsg("hashset values must be integer, bigint or uuid")));
+}
+
+/* The key of a bigint, integer or uuid datum of type typid */
+static void
+hashset_datum_key(Oid typid, Datum value, HashsetKey *key)
+{
+    switch (typid)
+    {
+        case INT8OID:
+            key->width = HASHSET_INT_WIDTH;
+            hashlib_write_le64(key->bytes, (uint64) DatumGetInt64(value));
+            break;
+        case INT4OID:
+            key->width = HASHSET_INT_WIDTH;
+            hashlib_write_le64(key->bytes, (uint64) (int64) DatumGetInt32(value));
+            break;
+        case UUIDOID:
+            key->width = HASHSET_UUID_WIDTH;
+            memcpy(key->bytes, DatumGetUUIDP(value)->data, UUID_LEN);
+            break;
+        default:
+            hashset_check_type(typid);
+    }
+}
+
+static void
+hashset_getarg_key(FunctionCallInfo fcinfo, int argno, HashsetKey *key)
+{
+    Oid typid = get_fn_expr_argtype(fcinfo->flinfo, argno);
+
+    if (!OidIsValid(typid))
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("could not determine input data type")));
+    hashset_datum_key(typid, PG_GETARG_DATUM(argno), key);
+}
+
+static void
+hashset_check_width(int width, const HashsetKey *key)
+{
+    if (width != key->width)
+        ereport(ERROR,
+                (errcode(ERRCODE_DATATYPE_MISMATCH),
+                 errmsg("hashset of %s cannot hold %s values",
+                        width == HASHSET_UUID_WIDTH ? "uuids" : "integers",
+                        key->width == HASHSET_UUID_WIDTH ? "uuid" : "integer")));
+}
+
+/*
+ * Probe kernels: whether the non-zero key with the given hash is in the table
+ * of 2^log2 buckets.  A free slot ends the probe; a stored set is only checked
+ * for its header, so the probe also stops after visiting every bucket.
+ */
+typedef bool (*hashset_probe_fn) (const uint8 *buckets, int log2, const HashsetKey *key, uint64 hash);
+
+static bool
+hashset_probe_scalar(const uint8 *buckets, int log2, const HashsetKey *key, uint64 hash)
+{
+    Size mask = hashset_nbuckets(log2) - 1;
+    Size b = hashset_bucket(hash, log2);
+    int width = key->width;
+    Size n;
+
+    for (n = 0; n <= mask; n++)
+    {
+        const uint8 *slot = buckets + b * HASHSET_BUCKET_SIZE;
+        int i;
+
+        for (i = 0; i < HASHSET_BUCKET_SIZE; i += width)
+        {
+            if (memcmp(slot + i, key->bytes, width) == 0)
+                return true;
+            if (memcmp(slot + i, hashset_zero, width) == 0)
+                return false;
+        }
+        b = (b + 1) & mask;
+    }
+    return false;
+}
+
+#ifdef HASHSET_USE_AVX2
+/* A bucket as two 256-bit compares against the key and against zero */
+__attribute__((target("avx2")))
+static bool
+hashset_probe_avx2(const uint8 *buckets, int log2, const HashsetKey *key, uint64 hash)
+{
+    Size mask = hashset_nbuckets(log2) - 1;
+    Size b = hashset_bucket(hash, log2);
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i k;
+    uint32 slot_bits;
+    Size n;
+
+    if (key->width == HASHSET_INT_WIDTH)
+    {
+        k = _mm256_set1_epi64x((long long) hashlib_read_le64(key->bytes));
+        slot_bits = 0xFFFFFFFF;
+    }
+    else
+    {
+        k = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *) key->bytes));
+        slot_bits = 0x00010001;
+    }
+
+    for (n = 0; n <= mask; n++)
+    {
+        const uint8 *slot = buckets + b * HASHSET_BUCKET_SIZE;
+        __m256i lo = _mm256_loadu_si256((const __m256i *) slot);
+        __m256i hi = _mm256_loadu_si256((const __m256i *) (slot + 32));
+        uint64 found = (uint32) _mm256_movemask_epi8(_mm256_cmpeq_epi64(lo, k)) |
+            ((uint64) (uint32) _mm256_movemask_epi8(_mm256_cmpeq_epi64(hi, k)) << 32);
+        uint64 empty = (uint32) _mm256_movemask_epi8(_mm256_cmpeq_epi64(lo, zero)) |
+            ((uint64) (uint32) _mm256_movemask_epi8(_mm256_cmpeq_epi64(hi, zero)) << 32);
+
+        /* a uuid slot matches when both of its 8-byte halves do */
+        if (key->width == HASHSET_UUID_WIDTH)
+        {
+            found &= found >> 8;
+            empty &= empty >> 8;
+        }
+        if (found & (slot_bits | ((uint64) slot_bits << 32)))
+            return true;
+        if (empty & (slot_bits | ((uint64) slot_bits << 32)))
+            return false;
+        b = (b + 1) & mask;
+    }
+    return false;
+}
+#endif
+
+/* Runtime kernel selection */
+static bool hashset_probe_choose(const uint8 *buckets, int log2, const HashsetKey *key, uint64 hash);
+
+static hashset_probe_fn hashset_probe_impl = hashset_probe_choose;
+
+static bool
+hashset_probe_choose(const uint8 *buckets, int log2, const HashsetKey *key, uint64 hash)
+{
+#ifdef HASHSET_USE_AVX2
+    unsigned int eax, ebx, ecx, edx;
+    uint32 xcr0_lo;
+    uint32 xcr0_hi;
+
+    hashset_probe_impl = hashset_probe_scalar;
+    /* AVX2 in the CPU and 256-bit register state enabled by the OS */
+    if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) &&
+        (ecx & (bit_OSXSAVE | bit_AVX)) == (bit_OSXSAVE | bit_AVX))
+    {
+        __asm__ __volatile__("xgetbv" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+        if ((xcr0_lo & 0x6) == 0x6 &&
+            __get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) && (ebx & bit_AVX2))
+            hashset_probe_impl = hashset_probe_avx2;
+    }
+#else
+    hashset_probe_impl = hashset_probe_scalar;
+#endif
+    return hashset_probe_impl(buckets, log2, key, hash);
+}
+
+static HashsetState *
+hashset_state_create(MemoryContext context, int width, int log2)
+{
+    HashsetState *state = (HashsetState *) MemoryContextAlloc(context, sizeof(HashsetState));
+
+    state->width = width;
+    state->log2 = log2;
+    state->has_zero = false;
+    state->count = 0;
+    state->buckets = (uint8 *) MemoryContextAllocZero(context,
+                                                      hashset_nbuckets(log2) * HASHSET_BUCKET_SIZE);
+    return state;
+}
+
+/* Store a non-zero key not yet in the table, which has a free slot */
+static void
+hashset_store(uint8 *buckets, int log2, const HashsetKey *key, uint64 hash)
+{
+    Size mask = hashset_nbuckets(log2) - 1;
+    Size b = hashset_bucket(hash, log2);
+
+    for (;;)
+    {
+        uint8 *slot = buckets + b * HASHSET_BUCKET_SIZE;
+        int i;
+
+        for (i = 0; i < HASHSET_BUCKET_SIZE; i += key->width)
+        {
+            if (memcmp(slot + i, hashset_zero, key->width) == 0)
+            {
+                memcpy(slot + i, key->bytes, key->width);
+                return;
+            }
+        }
+        b = (b + 1) & mask;
+    }
+}
+
+static void
+hashset_state_grow(HashsetState *state)
+{
+    int log2 = state->log2 + 1;
+    uint8 *buckets;
+    Size n = hashset_slots(state->log2, state->width);
+    HashsetKey key;
+    Size i;
+
+    if (log2 > HASHSET_MAX_LOG2)
+        ereport(ERROR,
+                (errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+                 errmsg("hashset cannot hold more than " INT64_FORMAT " values",
+                        (int64) (hashset_slots(HASHSET_MAX_LOG2, state->width) / 4 * 3))));
+
+    buckets = (uint8 *) MemoryContextAllocZero(GetMemoryChunkContext(state->buckets),
+                                               hashset_nbuckets(log2) * HASHSET_BUCKET_SIZE);
+    key.width = state->width;
+    for (i = 0; i < n; i++)
+    {
+        memcpy(key.bytes, state->buckets + i * state->width, state->width);
+        if (!hashset_is_zero(&key))
+            hashset_store(buckets, log2, &key, hashset_hash(&key));
+    }
+    pfree(state->buckets);
+    state->buckets = buckets;
+    state->log2 = log2;
+}
+
+static void
+hashset_state_add(HashsetState *state, const HashsetKey *key)
+{
+    uint64 hash;
+
+    hashset_check_width(state->width, key);
+    if (hashset_is_zero(key))
+    {
+        if (!state->has_zero)
+            state->count++;
+        state->has_zero = true;
+        return;
+    }
+
+    hash = hashset_hash(key);
+    if (hashset_probe_impl(state->buckets, state->log2, key, hash))
+        return;
+
+    /* keep the table at most three quarters full */
+    if ((Size) (state->count - state->has_zero + 1) * 4 > hashset_slots(state->log2, state->width) * 3)
+    {
+        hashset_state_grow(state);
+    }
+    hashset_store(state->buckets, state->log2, key, hash);
+    state->count++;
+}
+
+static void
+hashset_state_merge(HashsetState *state, const HashsetState *other)
+{
+    Size n = hashset_slots(other->log2, other->width);
+    HashsetKey key;
+    Size i;
+
+    key.width = other->width;
+    if (other->has_zero)
+    {
+        memset(key.bytes, 0, sizeof(key.bytes));
+        hashset_state_add(state, &key);
+    }
+    for (i = 0; i < n; i++)
+    {
+        memcpy(key.bytes, other->buckets + i * other->width, other->width);
+        if (!hashset_is_zero(&key))
+            hashset_state_add(state, &key);
+    }
+}
+
+static bytea *
+hashset_state_serialize(const HashsetState *state)
+{
+    Size tablesize = hashset_nbuckets(state->log2) * HASHSET_BUCKET_SIZE;
+    Size size = HASHSET_HEADER_SIZE + tablesize;
+    bytea *result = (bytea *) palloc(VARHDRSZ + size);
+    uint8 *data;
+
+    SET_VARSIZE(result, VARHDRSZ + size);
+    data = (uint8 *) VARDATA(result);
+    data[0] = HASHSET_VERSION;
+    data[1] = (uint8) state->width;
+    data[2] = (uint8) state->log2;
+    data[3] = state->has_zero ? HASHSET_HAS_ZERO : 0;
+    data[4] = data[5] = data[6] = data[7] = 0;
+    hashlib_write_le64(data + 8, (uint64) state->count);
+    memcpy(data + HASHSET_HEADER_SIZE, state->buckets, tablesize);
+    return result;
+}
+
+static void
+hashset_invalid(void)
+{
+    ereport(ERROR,
+            (errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+             errmsg("invalid hashset")));
+}
+
+/* Check the header and that the size matches the table */
+static void
+hashset_validate(const bytea *set)
+{
+    const uint8 *data = (const uint8 *) VARDATA_ANY(set);
+    Size size = VARSIZE_ANY_EXHDR(set);
+
+    if (size < HASHSET_HEADER_SIZE || data[0] != HASHSET_VERSION ||
+        (data[1] != HASHSET_INT_WIDTH && data[1] != HASHSET_UUID_WIDTH) ||
+        data[2] > HASHSET_MAX_LOG2 || (data[3] & ~HASHSET_HAS_ZERO) != 0 ||
+        data[4] != 0 || data[5] != 0 || data[6] != 0 || data[7] != 0 ||
+        size != HASHSET_HEADER_SIZE + hashset_nbuckets(data[2]) * HASHSET_BUCKET_SIZE)
+        hashset_invalid();
+}
+
+/*
+ * Load a validated set for inserting into.  Inserts need a free slot, so the
+ * number of keys is checked against the table, which may be at most three
+ * quarters full.
+ */
+static HashsetState *
+hashset_state_load(MemoryContext context, const bytea *set)
+{
+    const uint8 *data = (const uint8 *) VARDATA_ANY(set);
+    HashsetState *state = hashset_state_create(context, data[1], data[2]);
+    Size nslots = hashset_slots(state->log2, state->width);
+    Size used = 0;
+    Size i;
+
+    state->has_zero = (data[3] & HASHSET_HAS_ZERO) != 0;
+    state->count = (int64) hashlib_read_le64(data + 8);
+    memcpy(state->buckets, data + HASHSET_HEADER_SIZE,
+           hashset_nbuckets(state->log2) * HASHSET_BUCKET_SIZE);
+
+    for (i = 0; i < nslots; i++)
+    {
+        if (memcmp(state->buckets + i * state->width, hashset_zero, state->width) != 0)
+            used++;
+    }
+    if (used * 4 > nslots * 3 || state->count != (int64) used + state->has_zero)
+        hashset_invalid();
+    return state;
+}
+
+/* Whether a stored, validated set holds key */
+static bool
+hashset_contains_key(const bytea *set, const HashsetKey *key)
+{
+    const uint8 *data = (const uint8 *) VARDATA_ANY(set);
+
+    hashset_check_width(data[1], key);
+    if (hashset_is_zero(key))
+        return (data[3] & HASHSET_HAS_ZERO) != 0;
+    return hashset_probe_impl(data + HASHSET_HEADER_SIZE, data[2], key, hashset_hash(key));
+}
+
+/* hashset_in(cstring) -> hashset */
+PG_FUNCTION_INFO_V1(hashset_in);
+
+Datum
+hashset_in(PG_FUNCTION_ARGS)
+{
+    bytea *set = (bytea *) hashlib_sketch_from_hex(PG_GETARG_CSTRING(0), "hashset");
+
+    hashset_validate(set);
+    PG_RETURN_BYTEA_P(set);
+}
+
+/* hashset_out(hashset) -> cstring */
+PG_FUNCTION_INFO_V1(hashset_out);
+
+Datum
+hashset_out(PG_FUNCTION_ARGS)
+{
+    PG_RETURN_CSTRING(hashlib_sketch_to_hex((struct varlena *) PG_GETARG_BYTEA_PP(0)));
+}
+
+/* hashset_recv(internal) -> hashset */
+PG_FUNCTION_INFO_V1(hashset_recv);
+
+Datum
+hashset_recv(PG_FUNCTION_ARGS)
+{
+    bytea *set = (bytea *) hashlib_sketch_recv((StringInfo) PG_GETARG_POINTER(0));
+
+    hashset_validate(set);
+    PG_RETURN_BYTEA_P(set);
+}
+
+/* hashset_send(hashset) -> bytea */
+PG_FUNCTION_INFO_V1(hashset_send);
+
+Datum
+hashset_send(PG_FUNCTION_ARGS)
+{
+    bytea *set = PG_GETARG_BYTEA_PP(0);
+    StringInfoData buf;
+
+    pq_begintypsend(&buf);
+    pq_sendbytes(&buf, VARDATA_ANY(set), VARSIZE_ANY_EXHDR(set));
+    PG_RETURN_BYTEA_P(pq_endtypsend(&buf));
+}
+
+/* hashset(bytea) -> hashset: checks the stored layout, for the bytea cast */
+PG_FUNCTION_INFO_V1(hashset_from_bytea);
+
+Datum
+hashset_from_bytea(PG_FUNCTION_ARGS)
+{
+    bytea *set = PG_GETARG_BYTEA_P_COPY(0);
+
+    hashset_validate(set);
+    PG_RETURN_BYTEA_P(set);
+}
+
+/* hashset(bigint[] | integer[] | uuid[]) -> hashset; NULL elements are ignored */
+PG_FUNCTION_INFO_V1(hashset_from_array);
+
+Datum
+hashset_from_array(PG_FUNCTION_ARGS)
+{
+    ArrayType *array = PG_GETARG_ARRAYTYPE_P(0);
+    Oid elemtype = ARR_ELEMTYPE(array);
+    int16 typlen;
+    bool typbyval;
+    char typalign;
+    Datum *elems;
+    bool *nulls;
+    int nelems;
+    HashsetState *state;
+    HashsetKey key;
+    int log2 = 0;
+    int i;
+
+    /* even when every element is NULL */
+    hashset_check_type(elemtype);
+    get_typlenbyvalalign(elemtype, &typlen, &typbyval, &typalign);
+    deconstruct_array(array, elemtype, typlen, typbyval, typalign, &elems, &nulls, &nelems);
+
+    /* size the table for all elements up front */
+    key.width = elemtype == UUIDOID ? HASHSET_UUID_WIDTH : HASHSET_INT_WIDTH;
+    while (log2 < HASHSET_MAX_LOG2 && (Size) nelems * 4 > hashset_slots(log2, key.width) * 3)
+        log2++;
+    state = hashset_state_create(CurrentMemoryContext, key.width, log2);
+
+    for (i = 0; i < nelems; i++)
+    {
+        if (nulls[i])
+            continue;
+        hashset_datum_key(elemtype, elems[i], &key);
+        hashset_state_add(state, &key);
+    }
+    PG_RETURN_BYTEA_P(hashset_state_serialize(state));
+}
+
+/* hashset_contains(hashset, bigint | integer | uuid) -> boolean */
+PG_FUNCTION_INFO_V1(hashset_contains);
+
+Datum
+hashset_contains(PG_FUNCTION_ARGS)
+{
+    HashlibDetoastCache *cache = (HashlibDetoastCache *) fcinfo->flinfo->fn_extra;
+    HashsetKey key;
+
+    if (cache == NULL)
+    {
+        cache = (HashlibDetoastCache *) MemoryContextAllocZero(fcinfo->flinfo->fn_mcxt,
+                                                               sizeof(HashlibDetoastCache));
+        fcinfo->flinfo->fn_extra = cache;
+    }
+
+    hashset_getarg_key(fcinfo, 1, &key);
+    PG_RETURN_BOOL(hashset_contains_key(hashlib_sketch_getarg_cached(fcinfo, 0, cache,
+                                                                     hashset_validate),
+                                        &key));
+}
+
+/* hashset_add(hashset, bigint | integer | uuid) -> hashset */
+PG_FUNCTION_INFO_V1(hashset_add);
+
+Datum
+hashset_add(PG_FUNCTION_ARGS)
+{
+    bytea *set = PG_GETARG_BYTEA_PP(0);
+    HashsetState *state;
+    HashsetKey key;
+
+    hashset_validate(set);
+    hashset_getarg_key(fcinfo, 1, &key);
+    if (hashset_contains_key(set, &key))
+        PG_RETURN_BYTEA_P(PG_GETARG_BYTEA_P_COPY(0));
+
+    state = hashset_state_load(CurrentMemoryContext, set);
+    hashset_state_add(state, &key);
+    PG_RETURN_BYTEA_P(hashset_state_serialize(state));
+}
+
+/* hashset_count(hashset) -> bigint */
+PG_FUNCTION_INFO_V1(hashset_count);
+
+Datum
+hashset_count(PG_FUNCTION_ARGS)
+{
+    bytea *set = PG_GETARG_BYTEA_PP(0);
+
+    hashset_validate(set);
+    PG_RETURN_INT64((int64) hashlib_read_le64((const uint8 *) VARDATA_ANY(set) + 8));
+}
+
+/* hashset_agg_transfn(internal, bigint | integer | uuid) -> internal */
+PG_FUNCTION_INFO_V1(hashset_agg_transfn);
+
+Datum
+hashset_agg_transfn(PG_FUNCTION_ARGS)
+{
+    MemoryContext aggcontext;
+    HashsetState *state;
+    HashsetKey key;
+
+    if (!AggCheckCallContext(fcinfo, &aggcontext))
+        elog(ERROR, "hashset_agg_transfn called in non-aggregate context");
+
+    if (PG_ARGISNULL(0))
+    {
+        Oid typid = get_fn_expr_argtype(fcinfo->flinfo, 1);
+
+        state = hashset_state_create(aggcontext,
+                                     typid == UUIDOID ? HASHSET_UUID_WIDTH : HASHSET_INT_WIDTH, 4);
+    }
+    else
+        state = (HashsetState *) PG_GETARG_POINTER(0);
+
+    if (!PG_ARGISNULL(1))
+    {
+        hashset_getarg_key(fcinfo, 1, &key);
+        hashset_state_add(state, &key);
+    }
+
+    PG_RETURN_POINTER(state);
+}
+
+/* hashset_agg_combine(internal, internal) -> internal */
+PG_FUNCTION_INFO_V1(hashset_agg_combine);
+
+Datum
+hashset_agg_combine(PG_FUNCTION_ARGS)
+{
+    MemoryContext aggcontext;
+    HashsetState *state;
+    HashsetState *other;
+
+    if (!AggCheckCallContext(fcinfo, &aggcontext))
+        elog(ERROR, "hashset_agg_combine called in non-aggregate context");
+
+    if (PG_ARGISNULL(1))
+        PG_RETURN_POINTER(PG_ARGISNULL(0) ? NULL : PG_GETARG_POINTER(0));
+
+    other = (HashsetState *) PG_GETARG_POINTER(1);
+    if (PG_ARGISNULL(0))
+        state = hashset_state_create(aggcontext, other->width, other->log2);
+    else
+        state = (HashsetState *) PG_GETARG_POINTER(0);
+    hashset_state_merge(state, other);
+
+    PG_RETURN_POINTER(state);
+}
+
+/* hashset_agg_serialize(internal) -> bytea: the stored form */
+PG_FUNCTION_INFO_V1(hashset_agg_serialize);
+
+Datum
+hashset_agg_serialize(PG_FUNCTION_ARGS)
+{
+    PG_RETURN_BYTEA_P(hashset_state_serialize((HashsetState *) PG_GETARG_POINTER(0)));
+}
+
+/* hashset_agg_deserialize(bytea, internal) -> internal */
+PG_FUNCTION_INFO_V1(hashset_agg_deserialize);
+
+Datum
+hashset_agg_deserialize(PG_FUNCTION_ARGS)
+{
+    bytea *set;
+
+    if (!AggCheckCallContext(fcinfo, NULL))
+        elog(ERROR, "hashset_agg_deserialize called in non-aggregate context");
+
+    set = PG_GETARG_BYTEA_PP(0);
+    hashset_validate(set);
+    PG_RETURN_POINTER(hashset_state_load(CurrentMemoryContext, set));
+}
+
+/* hashset_agg_final(internal) -> hashset; NULL when there were no rows */
+PG_FUNCTION_INFO_V1(hashset_agg_final);
+
+Datum
+hashset_agg_final(PG_FUNCTION_ARGS)
+{
+    if (PG_ARGISNULL(0))
+        PG_RETURN_NULL();
+
+    PG_RETURN_BYTEA_P(hashset_state_serialize((HashsetState *) PG_GETARG_POINTER(0)));
+}
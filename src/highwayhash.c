@@ -6,6 +6,9 @@
 #include "mb/pg_wchar.h"
 #include "access/htup_details.h"
 
+#include "hashlib_state.h"
+#include "hashlib_toast.h"
+
 /* HighwayHash constants and state */
 #define HH_LANES 4
 #define HH_KEY_BYTES 32
@@ -184,6 +187,36 @@ static const uint64_t HH_DEFAULT_KEY[4] = {
     0x1716151413121110ULL, 0x1F1E1D1C1B1A1918ULL
 };
 
+static void hh_stream_update(HashlibState *hstate, const char *bytes, size_t size);
+static void hh_stream_finish(const HashlibState *hstate, hh_state *state);
+static HashlibState *hh_stream_init(const uint64_t key[4]);
+
+static void hh_stream_update_cb(void *arg, const uint8 *bytes, size_t size)
+{
+    hh_stream_update((HashlibState *)arg, (const char *)bytes, size);
+}
+
+/*
+ * Absorb a text or bytea datum into state, streaming large out-of-line values;
+ * state is then ready for one of the finalize functions.
+ */
+static void hh_highway_hash_datum(const uint64_t key[4], Datum value, hh_state *state)
+{
+    bytea *input;
+    HashlibState *hstate;
+
+    if (hashlib_datum_streamable(value)) {
+        hstate = hh_stream_init(key);
+        hashlib_stream_datum(value, hh_stream_update_cb, hstate);
+        hh_stream_finish(hstate, state);
+        pfree(hstate);
+        return;
+    }
+
+    input = DatumGetByteaPP(value);
+    hh_highway_hash(key, VARDATA_ANY(input), VARSIZE_ANY_EXHDR(input), state);
+}
+
 /* PostgreSQL function wrappers for HighwayHash64 */
 
 /* HighwayHash64 for text input with default key */
@@ -192,13 +225,10 @@ PG_FUNCTION_INFO_V1(highwayhash64_text);
 Datum
 highwayhash64_text(PG_FUNCTION_ARGS)
 {
-    text *input = PG_GETARG_TEXT_PP(0);
-    char *data = VARDATA_ANY(input);
-    int len = VARSIZE_ANY_EXHDR(input);
     hh_state state;
     uint64_t hash;
     
-    hh_highway_hash(HH_DEFAULT_KEY, data, len, &state);
+    hh_highway_hash_datum(HH_DEFAULT_KEY, PG_GETARG_DATUM(0), &state);
     hash = hh_finalize64(&state);
     PG_RETURN_INT64((int64_t)hash);
 }
@@ -209,13 +239,10 @@ PG_FUNCTION_INFO_V1(highwayhash64_text_key);
 Datum
 highwayhash64_text_key(PG_FUNCTION_ARGS)
 {
-    text *input = PG_GETARG_TEXT_PP(0);
     int64_t key0 = PG_GETARG_INT64(1);
     int64_t key1 = PG_GETARG_INT64(2);
     int64_t key2 = PG_GETARG_INT64(3);
     int64_t key3 = PG_GETARG_INT64(4);
-    char *data = VARDATA_ANY(input);
-    int len = VARSIZE_ANY_EXHDR(input);
     uint64_t key[4];
     hh_state state;
     uint64_t hash;
@@ -225,7 +252,7 @@ highwayhash64_text_key(PG_FUNCTION_ARGS)
     key[2] = (uint64_t)key2;
     key[3] = (uint64_t)key3;
     
-    hh_highway_hash(key, data, len, &state);
+    hh_highway_hash_datum(key, PG_GETARG_DATUM(0), &state);
     hash = hh_finalize64(&state);
     PG_RETURN_INT64((int64_t)hash);
 }
@@ -236,13 +263,10 @@ PG_FUNCTION_INFO_V1(highwayhash64_bytea);
 Datum
 highwayhash64_bytea(PG_FUNCTION_ARGS)
 {
-    bytea *input = PG_GETARG_BYTEA_PP(0);
-    char *data = VARDATA_ANY(input);
-    int len = VARSIZE_ANY_EXHDR(input);
     hh_state state;
     uint64_t hash;
     
-    hh_highway_hash(HH_DEFAULT_KEY, data, len, &state);
+    hh_highway_hash_datum(HH_DEFAULT_KEY, PG_GETARG_DATUM(0), &state);
     hash = hh_finalize64(&state);
     PG_RETURN_INT64((int64_t)hash);
 }
@@ -253,13 +277,10 @@ PG_FUNCTION_INFO_V1(highwayhash64_bytea_key);
 Datum
 highwayhash64_bytea_key(PG_FUNCTION_ARGS)
 {
-    bytea *input = PG_GETARG_BYTEA_PP(0);
     int64_t key0 = PG_GETARG_INT64(1);
     int64_t key1 = PG_GETARG_INT64(2);
     int64_t key2 = PG_GETARG_INT64(3);
     int64_t key3 = PG_GETARG_INT64(4);
-    char *data = VARDATA_ANY(input);
-    int len = VARSIZE_ANY_EXHDR(input);
     uint64_t key[4];
     hh_state state;
     uint64_t hash;
@@ -269,7 +290,7 @@ highwayhash64_bytea_key(PG_FUNCTION_ARGS)
     key[2] = (uint64_t)key2;
     key[3] = (uint64_t)key3;
     
-    hh_highway_hash(key, data, len, &state);
+    hh_highway_hash_datum(key, PG_GETARG_DATUM(0), &state);
     hash = hh_finalize64(&state);
     PG_RETURN_INT64((int64_t)hash);
 }
@@ -322,15 +343,12 @@ PG_FUNCTION_INFO_V1(highwayhash128_text);
 Datum
 highwayhash128_text(PG_FUNCTION_ARGS)
 {
-    text *input = PG_GETARG_TEXT_PP(0);
-    char *data = VARDATA_ANY(input);
-    int len = VARSIZE_ANY_EXHDR(input);
     hh_state state;
     uint64_t hash[2];
     Datum result[2];
     ArrayType *array;
     
-    hh_highway_hash(HH_DEFAULT_KEY, data, len, &state);
+    hh_highway_hash_datum(HH_DEFAULT_KEY, PG_GETARG_DATUM(0), &state);
     hh_finalize128(&state, hash);
     
     result[0] = Int64GetDatum((int64_t)hash[0]);
@@ -346,13 +364,10 @@ PG_FUNCTION_INFO_V1(highwayhash128_text_key);
 Datum
 highwayhash128_text_key(PG_FUNCTION_ARGS)
 {
-    text *input = PG_GETARG_TEXT_PP(0);
     int64_t key0 = PG_GETARG_INT64(1);
     int64_t key1 = PG_GETARG_INT64(2);
     int64_t key2 = PG_GETARG_INT64(3);
     int64_t key3 = PG_GETARG_INT64(4);
-    char *data = VARDATA_ANY(input);
-    int len = VARSIZE_ANY_EXHDR(input);
     uint64_t key[4];
     hh_state state;
     uint64_t hash[2];
@@ -364,7 +379,7 @@ highwayhash128_text_key(PG_FUNCTION_ARGS)
     key[2] = (uint64_t)key2;
     key[3] = (uint64_t)key3;
     
-    hh_highway_hash(key, data, len, &state);
+    hh_highway_hash_datum(key, PG_GETARG_DATUM(0), &state);
     hh_finalize128(&state, hash);
     
     result[0] = Int64GetDatum((int64_t)hash[0]);
@@ -380,15 +395,12 @@ PG_FUNCTION_INFO_V1(highwayhash128_bytea);
 Datum
 highwayhash128_bytea(PG_FUNCTION_ARGS)
 {
-    bytea *input = PG_GETARG_BYTEA_PP(0);
-    char *data = VARDATA_ANY(input);
-    int len = VARSIZE_ANY_EXHDR(input);
     hh_state state;
     uint64_t hash[2];
     Datum result[2];
     ArrayType *array;
     
-    hh_highway_hash(HH_DEFAULT_KEY, data, len, &state);
+    hh_highway_hash_datum(HH_DEFAULT_KEY, PG_GETARG_DATUM(0), &state);
     hh_finalize128(&state, hash);
     
     result[0] = Int64GetDatum((int64_t)hash[0]);
@@ -404,13 +416,10 @@ PG_FUNCTION_INFO_V1(highwayhash128_bytea_key);
 Datum
 highwayhash128_bytea_key(PG_FUNCTION_ARGS)
 {
-    bytea *input = PG_GETARG_BYTEA_PP(0);
     int64_t key0 = PG_GETARG_INT64(1);
     int64_t key1 = PG_GETARG_INT64(2);
     int64_t key2 = PG_GETARG_INT64(3);
     int64_t key3 = PG_GETARG_INT64(4);
-    char *data = VARDATA_ANY(input);
-    int len = VARSIZE_ANY_EXHDR(input);
     uint64_t key[4];
     hh_state state;
     uint64_t hash[2];
@@ -422,7 +431,7 @@ highwayhash128_bytea_key(PG_FUNCTION_ARGS)
     key[2] = (uint64_t)key2;
     key[3] = (uint64_t)key3;
     
-    hh_highway_hash(key, data, len, &state);
+    hh_highway_hash_datum(key, PG_GETARG_DATUM(0), &state);
     hh_finalize128(&state, hash);
     
     result[0] = Int64GetDatum((int64_t)hash[0]);
@@ -494,16 +503,13 @@ PG_FUNCTION_INFO_V1(highwayhash256_text);
 Datum
 highwayhash256_text(PG_FUNCTION_ARGS)
 {
-    text *input = PG_GETARG_TEXT_PP(0);
-    char *data = VARDATA_ANY(input);
-    int len = VARSIZE_ANY_EXHDR(input);
     hh_state state;
     uint64_t hash[4];
     Datum result[4];
     ArrayType *array;
     int i;
     
-    hh_highway_hash(HH_DEFAULT_KEY, data, len, &state);
+    hh_highway_hash_datum(HH_DEFAULT_KEY, PG_GETARG_DATUM(0), &state);
     hh_finalize256(&state, hash);
     
     for (i = 0; i < 4; ++i) {
@@ -520,13 +526,10 @@ PG_FUNCTION_INFO_V1(highwayhash256_text_key);
 Datum
 highwayhash256_text_key(PG_FUNCTION_ARGS)
 {
-    text *input = PG_GETARG_TEXT_PP(0);
     int64_t key0 = PG_GETARG_INT64(1);
     int64_t key1 = PG_GETARG_INT64(2);
     int64_t key2 = PG_GETARG_INT64(3);
     int64_t key3 = PG_GETARG_INT64(4);
-    char *data = VARDATA_ANY(input);
-    int len = VARSIZE_ANY_EXHDR(input);
     uint64_t key[4];
     hh_state state;
     uint64_t hash[4];
@@ -539,7 +542,7 @@ highwayhash256_text_key(PG_FUNCTION_ARGS)
     key[2] = (uint64_t)key2;
     key[3] = (uint64_t)key3;
     
-    hh_highway_hash(key, data, len, &state);
+    hh_highway_hash_datum(key, PG_GETARG_DATUM(0), &state);
     hh_finalize256(&state, hash);
     
     for (i = 0; i < 4; ++i) {
@@ -556,16 +559,13 @@ PG_FUNCTION_INFO_V1(highwayhash256_bytea);
 Datum
 highwayhash256_bytea(PG_FUNCTION_ARGS)
 {
-    bytea *input = PG_GETARG_BYTEA_PP(0);
-    char *data = VARDATA_ANY(input);
-    int len = VARSIZE_ANY_EXHDR(input);
     hh_state state;
     uint64_t hash[4];
     Datum result[4];
     ArrayType *array;
     int i;
     
-    hh_highway_hash(HH_DEFAULT_KEY, data, len, &state);
+    hh_highway_hash_datum(HH_DEFAULT_KEY, PG_GETARG_DATUM(0), &state);
     hh_finalize256(&state, hash);
     
     for (i = 0; i < 4; ++i) {
@@ -582,13 +582,10 @@ PG_FUNCTION_INFO_V1(highwayhash256_bytea_key);
 Datum
 highwayhash256_bytea_key(PG_FUNCTION_ARGS)
 {
-    bytea *input = PG_GETARG_BYTEA_PP(0);
     int64_t key0 = PG_GETARG_INT64(1);
     int64_t key1 = PG_GETARG_INT64(2);
     int64_t key2 = PG_GETARG_INT64(3);
     int64_t key3 = PG_GETARG_INT64(4);
-    char *data = VARDATA_ANY(input);
-    int len = VARSIZE_ANY_EXHDR(input);
     uint64_t key[4];
     hh_state state;
     uint64_t hash[4];
@@ -601,7 +598,7 @@ highwayhash256_bytea_key(PG_FUNCTION_ARGS)
     key[2] = (uint64_t)key2;
     key[3] = (uint64_t)key3;
     
-    hh_highway_hash(key, data, len, &state);
+    hh_highway_hash_datum(key, PG_GETARG_DATUM(0), &state);
     hh_finalize256(&state, hash);
     
     for (i = 0; i < 4; ++i) {
@@ -668,4 +665,179 @@ highwayhash256_int_key(PG_FUNCTION_ARGS)
     
     array = construct_array(result, 4, INT8OID, 8, true, 'd');
     PG_RETURN_ARRAYTYPE_P(array);
-}
\ No newline at end of file
+}
+/*
+ * Streaming HighwayHash over a hashlib_state.  The four hh_state lane arrays
+ * are kept in words[0..15]; whole 32-byte packets are absorbed as soon as
+ * they are complete and the remainder waits in buf for the final step.
+ */
+
+static void hh_stream_load(const HashlibState *hstate, hh_state *state)
+{
+    memcpy(state, hstate->words, sizeof(hh_state));
+}
+
+static void hh_stream_update(HashlibState *hstate, const char *bytes, size_t size)
+{
+    hh_state state;
+    uint64_t lanes[HH_LANES];
+    int j;
+
+    hstate->total_len += size;
+
+    if (hstate->buffered + size < HASHLIB_HIGHWAY_BUFFER) {
+        memcpy(hstate->buf + hstate->buffered, bytes, size);
+        hstate->buffered += size;
+        return;
+    }
+
+    hh_stream_load(hstate, &state);
+
+    if (hstate->buffered > 0) {
+        size_t fill = HASHLIB_HIGHWAY_BUFFER - hstate->buffered;
+        memcpy(hstate->buf + hstate->buffered, bytes, fill);
+        bytes += fill;
+        size -= fill;
+        for (j = 0; j < HH_LANES; ++j) {
+            lanes[j] = hh_fetch64((const char *)hstate->buf + j * 8);
+        }
+        hh_update(lanes, &state);
+    }
+
+    while (size >= 32) {
+        for (j = 0; j < HH_LANES; ++j) {
+            lanes[j] = hh_fetch64(bytes + j * 8);
+        }
+        hh_update(lanes, &state);
+        bytes += 32;
+        size -= 32;
+    }
+
+    memcpy(hstate->buf, bytes, size);
+    hstate->buffered = (uint16)size;
+    memcpy(hstate->words, &state, sizeof(hh_state));
+}
+
+/* Load the state and absorb the pending remainder, as hh_highway_hash does */
+static void hh_stream_finish(const HashlibState *hstate, hh_state *state)
+{
+    hh_stream_load(hstate, state);
+    if (hstate->buffered != 0) {
+        hh_update_remainder((const char *)hstate->buf, hstate->buffered, state);
+    }
+}
+
+static HashlibState *hh_stream_init(const uint64_t key[4])
+{
+    HashlibState *hstate = hashlib_state_create(HASHLIB_STATE_HIGHWAY);
+    hh_state state;
+
+    StaticAssertStmt(sizeof(hh_state) == sizeof(uint64) * HASHLIB_STATE_WORDS,
+                     "hh_state must fit in hashlib_state words");
+    hh_reset(key, &state);
+    memcpy(hstate->words, &state, sizeof(hh_state));
+    return hstate;
+}
+
+/* highwayhash_init() -> hashlib_state with default key */
+PG_FUNCTION_INFO_V1(highwayhash_init);
+
+Datum
+highwayhash_init(PG_FUNCTION_ARGS)
+{
+    PG_RETURN_HASHLIB_STATE_P(hh_stream_init(HH_DEFAULT_KEY));
+}
+
+/* highwayhash_init(key0, key1, key2, key3) -> hashlib_state */
+PG_FUNCTION_INFO_V1(highwayhash_init_key);
+
+Datum
+highwayhash_init_key(PG_FUNCTION_ARGS)
+{
+    uint64_t key[4];
+
+    key[0] = (uint64_t)PG_GETARG_INT64(0);
+    key[1] = (uint64_t)PG_GETARG_INT64(1);
+    key[2] = (uint64_t)PG_GETARG_INT64(2);
+    key[3] = (uint64_t)PG_GETARG_INT64(3);
+
+    PG_RETURN_HASHLIB_STATE_P(hh_stream_init(key));
+}
+
+/* highwayhash_update(state, bytea/text) -> hashlib_state */
+PG_FUNCTION_INFO_V1(highwayhash_update);
+
+Datum
+highwayhash_update(PG_FUNCTION_ARGS)
+{
+    HashlibState *hstate = hashlib_state_copy(PG_GETARG_HASHLIB_STATE_P(0));
+    bytea *input = PG_GETARG_BYTEA_PP(1);
+
+    hashlib_state_check(hstate, HASHLIB_STATE_HIGHWAY, "highwayhash_update");
+    hh_stream_update(hstate, VARDATA_ANY(input), VARSIZE_ANY_EXHDR(input));
+    PG_RETURN_HASHLIB_STATE_P(hstate);
+}
+
+/* highwayhash_final(state) -> bigint, equal to highwayhash64 of all input */
+PG_FUNCTION_INFO_V1(highwayhash_final);
+
+Datum
+highwayhash_final(PG_FUNCTION_ARGS)
+{
+    HashlibState *hstate = PG_GETARG_HASHLIB_STATE_P(0);
+    hh_state state;
+    uint64_t hash;
+
+    hashlib_state_check(hstate, HASHLIB_STATE_HIGHWAY, "highwayhash_final");
+    hh_stream_finish(hstate, &state);
+    hash = hh_finalize64(&state);
+    PG_RETURN_INT64((int64_t)hash);
+}
+
+/* highwayhash_final128(state) -> bigint[], equal to highwayhash128 of all input */
+PG_FUNCTION_INFO_V1(highwayhash_final128);
+
+Datum
+highwayhash_final128(PG_FUNCTION_ARGS)
+{
+    HashlibState *hstate = PG_GETARG_HASHLIB_STATE_P(0);
+    hh_state state;
+    uint64_t hash[2];
+    Datum result[2];
+    ArrayType *array;
+
+    hashlib_state_check(hstate, HASHLIB_STATE_HIGHWAY, "highwayhash_final128");
+    hh_stream_finish(hstate, &state);
+    hh_finalize128(&state, hash);
+
+    result[0] = Int64GetDatum((int64_t)hash[0]);
+    result[1] = Int64GetDatum((int64_t)hash[1]);
+
+    array = construct_array(result, 2, INT8OID, 8, true, 'd');
+    PG_RETURN_ARRAYTYPE_P(array);
+}
+
+/* highwayhash_final256(state) -> bigint[], equal to highwayhash256 of all input */
+PG_FUNCTION_INFO_V1(highwayhash_final256);
+
+Datum
+highwayhash_final256(PG_FUNCTION_ARGS)
+{
+    HashlibState *hstate = PG_GETARG_HASHLIB_STATE_P(0);
+    hh_state state;
+    uint64_t hash[4];
+    Datum result[4];
+    ArrayType *array;
+    int i;
+
+    hashlib_state_check(hstate, HASHLIB_STATE_HIGHWAY, "highwayhash_final256");
+    hh_stream_finish(hstate, &state);
+    hh_finalize256(&state, hash);
+
+    for (i = 0; i < 4; i++) {
+        result[i] = Int64GetDatum((int64_t)hash[i]);
+    }
+
+    array = construct_array(result, 4, INT8OID, 8, true, 'd');
+    PG_RETURN_ARRAYTYPE_P(array);
+}
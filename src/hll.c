@@ -0,0 +1,762 @@
+#include "postgres.h"
+#include "fmgr.h"
+#include "utils/builtins.h"
+#include "mb/pg_wchar.h"
+#include "access/htup_details.h"
+#include "libpq/pqformat.h"
+#include "port/pg_bitutils.h"
+
+#include <math.h>
+
+#include "hashlib_datum.h"
+#include "hashlib_sketch.h"
+
+/*
+ * HyperLogLog distinct-count sketch.
+ *
+ * A sketch of precision p has m = 2^p registers.  A 64-bit hash selects
+ * register h >> (64 - p) and contributes the position of the first 1 bit
+ * among the remaining 64 - p bits (64 - p + 1 if they are all zero); each
+ * register keeps the largest contribution seen.  The cardinality is
+ * estimated with Ertl's improved estimator ("New cardinality estimation
+ * algorithms for HyperLogLog sketches", 2017), which is unbiased over the
+ * whole range without empirical bias tables.
+ *
+ * Stored layout (integers little-endian):
+ *
+ *   byte 0    format version (1)
+ *   byte 1    precision p
+ *   byte 2    encoding: 1 = sparse, 2 = dense
+ *   byte 3    reserved (0)
+ *   sparse    4 bytes per non-zero register, (index << 8) | value, sorted by
+ *             index with no duplicates
+ *   dense     one byte per register, 2^p bytes
+ *
+ * While aggregating, new entries are collected in a small unsorted buffer
+ * that is sorted and merged into the sparse list when full; the sketch
+ * switches to dense registers once the sparse list would be larger than a
+ * quarter of them.
+ *
+ * Sketches of different precisions are combined at the lower precision q, as
+ * the standard HLL merge does: a register of the finer sketch is exactly the
+ * register the same hashes would have set at precision q once the low p - q
+ * bits of its index are moved back in front of the remaining hash bits.
+ */
+
+#define HLL_VERSION             1
+#define HLL_SPARSE              1
+#define HLL_DENSE               2
+#define HLL_HEADER_SIZE         4
+
+#define HLL_MIN_PRECISION       4
+#define HLL_MAX_PRECISION       18
+#define HLL_DEFAULT_PRECISION   14
+
+#define HLL_PENDING             256
+
+#define HLL_ENTRY(index, value)     (((uint32) (index) << 8) | (uint32) (value))
+#define HLL_ENTRY_INDEX(entry)      ((entry) >> 8)
+#define HLL_ENTRY_VALUE(entry)      ((uint8) ((entry) & 0xFF))
+
+typedef struct HllState
+{
+    MemoryContext context;      /* where registers and sparse live */
+    int         precision;
+    uint8      *registers;      /* 2^p registers once dense, else NULL */
+    uint32     *sparse;         /* sorted entries, one per non-zero register */
+    int         nsparse;
+    int         npending;
+    uint32      pending[HLL_PENDING];
+} HllState;
+
+static void
+hll_check_precision(int32 precision)
+{
+    if (precision < HLL_MIN_PRECISION || precision > HLL_MAX_PRECISION)
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("hll precision must be between %d and %d",
+                        HLL_MIN_PRECISION, HLL_MAX_PRECISION)));
+}
+
+static HllState *
+hll_state_create(MemoryContext context, int precision)
+{
+    HllState *state = (HllState *) MemoryContextAllocZero(context, sizeof(HllState));
+
+    state->context = context;
+    state->precision = precision;
+    return state;
+}
+
+/* Register entry for a (mixed) 64-bit hash */
+static uint32
+hll_entry(uint64 hash, int precision)
+{
+    uint64 rest = hash << precision;
+    int value;
+
+    /* leading zeros of the remaining bits, plus one */
+    if (rest == 0)
+        value = 64 - precision + 1;
+    else
+        value = 64 - pg_leftmost_one_pos64(rest);
+    return HLL_ENTRY(hash >> (64 - precision), value);
+}
+
+static int
+hll_entry_cmp(const void *a, const void *b)
+{
+    uint32 x = *(const uint32 *) a;
+    uint32 y = *(const uint32 *) b;
+
+    return x < y ? -1 : x > y ? 1 : 0;
+}
+
+static void
+hll_state_to_dense(HllState *state)
+{
+    int i;
+
+    state->registers = (uint8 *) MemoryContextAllocZero(state->context, (Size) 1 << state->precision);
+    for (i = 0; i < state->nsparse; i++)
+        state->registers[HLL_ENTRY_INDEX(state->sparse[i])] = HLL_ENTRY_VALUE(state->sparse[i]);
+    for (i = 0; i < state->npending; i++)
+    {
+        uint32 index = HLL_ENTRY_INDEX(state->pending[i]);
+
+        state->registers[index] = Max(state->registers[index], HLL_ENTRY_VALUE(state->pending[i]));
+    }
+
+    if (state->sparse)
+        pfree(state->sparse);
+    state->sparse = NULL;
+    state->nsparse = 0;
+    state->npending = 0;
+}
+
+/* Sort the pending entries into the sparse list, going dense if it grows too big */
+static void
+hll_state_flush(HllState *state)
+{
+    uint32 *merged;
+    int nmerged = 0;
+    int i = 0;
+    int j = 0;
+
+    if (state->npending == 0 || state->registers != NULL)
+        return;
+
+    qsort(state->pending, state->npending, sizeof(uint32), hll_entry_cmp);
+
+    merged = (uint32 *) MemoryContextAlloc(state->context,
+                                           sizeof(uint32) * (state->nsparse + state->npending));
+    while (i < state->nsparse || j < state->npending)
+    {
+        uint32 entry;
+
+        if (j >= state->npending || (i < state->nsparse && state->sparse[i] <= state->pending[j]))
+            entry = state->sparse[i++];
+        else
+            entry = state->pending[j++];
+
+        /* entries are ordered by index, then value: keep the last per index */
+        if (nmerged > 0 && HLL_ENTRY_INDEX(merged[nmerged - 1]) == HLL_ENTRY_INDEX(entry))
+            merged[nmerged - 1] = entry;
+        else
+            merged[nmerged++] = entry;
+    }
+
+    if (state->sparse)
+        pfree(state->sparse);
+    state->sparse = merged;
+    state->nsparse = nmerged;
+    state->npending = 0;
+
+    if ((Size) state->nsparse * sizeof(uint32) > ((Size) 1 << state->precision) / 4)
+        hll_state_to_dense(state);
+}
+
+static void
+hll_state_add_entry(HllState *state, uint32 entry)
+{
+    if (state->registers != NULL)
+    {
+        uint32 index = HLL_ENTRY_INDEX(entry);
+
+        state->registers[index] = Max(state->registers[index], HLL_ENTRY_VALUE(entry));
+        return;
+    }
+
+    state->pending[state->npending++] = entry;
+    if (state->npending == HLL_PENDING)
+        hll_state_flush(state);
+}
+
+static void
+hll_state_add_hash(HllState *state, uint64 hash)
+{
+    hll_state_add_entry(state, hll_entry(hashlib_mix64(hash), state->precision));
+}
+
+/* The entry at precision q of a non-zero register entry at precision p > q */
+static uint32
+hll_entry_fold(uint32 entry, int precision, int q)
+{
+    int shift = precision - q;
+    uint32 index = HLL_ENTRY_INDEX(entry);
+    uint32 low = index & (((uint32) 1 << shift) - 1);
+    int value;
+
+    /* the dropped index bits come first among the remaining hash bits */
+    if (low == 0)
+        value = shift + HLL_ENTRY_VALUE(entry);
+    else
+        value = shift - pg_leftmost_one_pos32(low);
+    return HLL_ENTRY(index >> shift, value);
+}
+
+/* Reduce the state to precision q, below its own */
+static void
+hll_state_fold(HllState *state, int q)
+{
+    int precision = state->precision;
+    uint8 *registers;
+    uint32 *sparse;
+    int nsparse;
+    int i;
+
+    hll_state_flush(state);
+    registers = state->registers;
+    sparse = state->sparse;
+    nsparse = state->nsparse;
+
+    state->precision = q;
+    state->registers = NULL;
+    state->sparse = NULL;
+    state->nsparse = 0;
+
+    if (registers != NULL)
+    {
+        int m = 1 << precision;
+
+        state->registers = (uint8 *) MemoryContextAllocZero(state->context, (Size) 1 << q);
+        for (i = 0; i < m; i++)
+        {
+            if (registers[i] != 0)
+                hll_state_add_entry(state, hll_entry_fold(HLL_ENTRY(i, registers[i]), precision, q));
+        }
+        pfree(registers);
+        return;
+    }
+
+    for (i = 0; i < nsparse; i++)
+        hll_state_add_entry(state, hll_entry_fold(sparse[i], precision, q));
+    if (sparse)
+        pfree(sparse);
+}
+
+static void
+hll_state_merge(HllState *state, HllState *other)
+{
+    int i;
+
+    if (state->precision > other->precision)
+        hll_state_fold(state, other->precision);
+    else if (other->precision > state->precision)
+        hll_state_fold(other, state->precision);
+
+    hll_state_flush(other);
+    if (other->registers != NULL)
+    {
+        int m = 1 << state->precision;
+
+        hll_state_flush(state);
+        if (state->registers == NULL)
+            hll_state_to_dense(state);
+        for (i = 0; i < m; i++)
+            state->registers[i] = Max(state->registers[i], other->registers[i]);
+        return;
+    }
+
+    for (i = 0; i < other->nsparse; i++)
+        hll_state_add_entry(state, other->sparse[i]);
+}
+
+/* Stored form of the state */
+static bytea *
+hll_state_serialize(HllState *state)
+{
+    bytea *result;
+    uint8 *data;
+    Size size;
+    int i;
+
+    hll_state_flush(state);
+    if (state->registers != NULL)
+        size = HLL_HEADER_SIZE + ((Size) 1 << state->precision);
+    else
+        size = HLL_HEADER_SIZE + (Size) state->nsparse * 4;
+
+    result = (bytea *) palloc(VARHDRSZ + size);
+    SET_VARSIZE(result, VARHDRSZ + size);
+    data = (uint8 *) VARDATA(result);
+    data[0] = HLL_VERSION;
+    data[1] = (uint8) state->precision;
+    data[2] = state->registers != NULL ? HLL_DENSE : HLL_SPARSE;
+    data[3] = 0;
+
+    if (state->registers != NULL)
+        memcpy(data + HLL_HEADER_SIZE, state->registers, (Size) 1 << state->precision);
+    else
+    {
+        for (i = 0; i < state->nsparse; i++)
+            hashlib_write_le32(data + HLL_HEADER_SIZE + 4 * i, state->sparse[i]);
+    }
+    return result;
+}
+
+static void
+hll_invalid(void)
+{
+    ereport(ERROR,
+            (errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+             errmsg("invalid hll sketch")));
+}
+
+/* Check a stored sketch and return its precision */
+static int
+hll_validate(const bytea *hll)
+{
+    const uint8 *data = (const uint8 *) VARDATA_ANY(hll);
+    Size size = VARSIZE_ANY_EXHDR(hll);
+    int precision;
+    int maxvalue;
+    Size i;
+
+    if (size < HLL_HEADER_SIZE || data[0] != HLL_VERSION || data[3] != 0)
+        hll_invalid();
+    precision = data[1];
+    if (precision < HLL_MIN_PRECISION || precision > HLL_MAX_PRECISION)
+        hll_invalid();
+    maxvalue = 64 - precision + 1;
+
+    if (data[2] == HLL_DENSE)
+    {
+        if (size != HLL_HEADER_SIZE + ((Size) 1 << precision))
+            hll_invalid();
+        for (i = HLL_HEADER_SIZE; i < size; i++)
+        {
+            if (data[i] > maxvalue)
+                hll_invalid();
+        }
+    }
+    else if (data[2] == HLL_SPARSE)
+    {
+        uint32 previous = 0;
+
+        if ((size - HLL_HEADER_SIZE) % 4 != 0)
+            hll_invalid();
+        for (i = HLL_HEADER_SIZE; i < size; i += 4)
+        {
+            uint32 entry = hashlib_read_le32(data + i);
+
+            if (HLL_ENTRY_INDEX(entry) >= ((uint32) 1 << precision) ||
+                HLL_ENTRY_VALUE(entry) == 0 || HLL_ENTRY_VALUE(entry) > maxvalue ||
+                (i > HLL_HEADER_SIZE && HLL_ENTRY_INDEX(entry) <= HLL_ENTRY_INDEX(previous)))
+                hll_invalid();
+            previous = entry;
+        }
+    }
+    else
+        hll_invalid();
+
+    return precision;
+}
+
+/* Load a stored sketch (already validated) into a new state */
+static HllState *
+hll_state_load(MemoryContext context, const bytea *hll)
+{
+    const uint8 *data = (const uint8 *) VARDATA_ANY(hll);
+    Size size = VARSIZE_ANY_EXHDR(hll);
+    HllState *state = hll_state_create(context, data[1]);
+    int i;
+
+    if (data[2] == HLL_DENSE)
+    {
+        state->registers = (uint8 *) MemoryContextAlloc(context, (Size) 1 << state->precision);
+        memcpy(state->registers, data + HLL_HEADER_SIZE, (Size) 1 << state->precision);
+    }
+    else
+    {
+        state->nsparse = (int) ((size - HLL_HEADER_SIZE) / 4);
+        state->sparse = (uint32 *) MemoryContextAlloc(context, sizeof(uint32) * Max(state->nsparse, 1));
+        for (i = 0; i < state->nsparse; i++)
+            state->sparse[i] = hashlib_read_le32(data + HLL_HEADER_SIZE + 4 * i);
+    }
+    return state;
+}
+
+static double
+hll_sigma(double x)
+{
+    double y = 1.0;
+    double z = x;
+    double previous;
+
+    if (x == 1.0)
+        return INFINITY;
+    do
+    {
+        x *= x;
+        previous = z;
+        z += x * y;
+        y += y;
+    } while (z != previous);
+    return z;
+}
+
+static double
+hll_tau(double x)
+{
+    double y = 1.0;
+    double z = 1.0 - x;
+    double previous;
+
+    if (x == 0.0 || x == 1.0)
+        return 0.0;
+    do
+    {
+        x = sqrt(x);
+        previous = z;
+        y *= 0.5;
+        z -= (1.0 - x) * (1.0 - x) * y;
+    } while (z != previous);
+    return z / 3.0;
+}
+
+/* Ertl's improved estimator from the histogram of register values */
+static double
+hll_estimate(const bytea *hll)
+{
+    const uint8 *data = (const uint8 *) VARDATA_ANY(hll);
+    Size size = VARSIZE_ANY_EXHDR(hll);
+    int precision = data[1];
+    int q = 64 - precision;
+    double m = (double) ((uint64) 1 << precision);
+    double counts[64 - HLL_MIN_PRECISION + 2];
+    double z;
+    Size i;
+    int k;
+
+    memset(counts, 0, sizeof(counts));
+    if (data[2] == HLL_DENSE)
+    {
+        for (i = HLL_HEADER_SIZE; i < size; i++)
+            counts[data[i]] += 1.0;
+    }
+    else
+    {
+        counts[0] = m - (double) ((size - HLL_HEADER_SIZE) / 4);
+        for (i = HLL_HEADER_SIZE; i < size; i += 4)
+            counts[HLL_ENTRY_VALUE(hashlib_read_le32(data + i))] += 1.0;
+    }
+
+    if (counts[0] == m)
+        return 0.0;
+
+    z = m * hll_tau(1.0 - counts[q + 1] / m);
+    for (k = q; k >= 1; k--)
+        z = 0.5 * (z + counts[k]);
+    z += m * hll_sigma(counts[0] / m);
+
+    return m * m / (2.0 * log(2.0) * z);
+}
+
+#define PG_GETARG_HLL_P(n)  PG_GETARG_BYTEA_PP(n)
+
+/* hll_in(cstring) -> hll */
+PG_FUNCTION_INFO_V1(hll_in);
+
+Datum
+hll_in(PG_FUNCTION_ARGS)
+{
+    bytea *hll = (bytea *) hashlib_sketch_from_hex(PG_GETARG_CSTRING(0), "hll");
+
+    hll_validate(hll);
+    PG_RETURN_BYTEA_P(hll);
+}
+
+/* hll_out(hll) -> cstring */
+PG_FUNCTION_INFO_V1(hll_out);
+
+Datum
+hll_out(PG_FUNCTION_ARGS)
+{
+    PG_RETURN_CSTRING(hashlib_sketch_to_hex((struct varlena *) PG_GETARG_HLL_P(0)));
+}
+
+/* hll_recv(internal) -> hll */
+PG_FUNCTION_INFO_V1(hll_recv);
+
+Datum
+hll_recv(PG_FUNCTION_ARGS)
+{
+    bytea *hll = (bytea *) hashlib_sketch_recv((StringInfo) PG_GETARG_POINTER(0));
+
+    hll_validate(hll);
+    PG_RETURN_BYTEA_P(hll);
+}
+
+/* hll_send(hll) -> bytea */
+PG_FUNCTION_INFO_V1(hll_send);
+
+Datum
+hll_send(PG_FUNCTION_ARGS)
+{
+    bytea *hll = PG_GETARG_HLL_P(0);
+    StringInfoData buf;
+
+    pq_begintypsend(&buf);
+    pq_sendbytes(&buf, VARDATA_ANY(hll), VARSIZE_ANY_EXHDR(hll));
+    PG_RETURN_BYTEA_P(pq_endtypsend(&buf));
+}
+
+/* hll(bytea) -> hll: checks the stored layout, for the bytea cast */
+PG_FUNCTION_INFO_V1(hll_from_bytea);
+
+Datum
+hll_from_bytea(PG_FUNCTION_ARGS)
+{
+    bytea *hll = PG_GETARG_BYTEA_P_COPY(0);
+
+    hll_validate(hll);
+    PG_RETURN_BYTEA_P(hll);
+}
+
+/* hll_empty() -> hll with default precision */
+PG_FUNCTION_INFO_V1(hll_empty);
+
+Datum
+hll_empty(PG_FUNCTION_ARGS)
+{
+    int32 precision = PG_NARGS() > 0 ? PG_GETARG_INT32(0) : HLL_DEFAULT_PRECISION;
+
+    hll_check_precision(precision);
+    PG_RETURN_BYTEA_P(hll_state_serialize(hll_state_create(CurrentMemoryContext, precision)));
+}
+
+/* hll_add(hll, bigint) -> hll */
+PG_FUNCTION_INFO_V1(hll_add);
+
+Datum
+hll_add(PG_FUNCTION_ARGS)
+{
+    bytea *hll = PG_GETARG_HLL_P(0);
+    HllState *state;
+
+    hll_validate(hll);
+    state = hll_state_load(CurrentMemoryContext, hll);
+    hll_state_add_hash(state, (uint64) PG_GETARG_INT64(1));
+    PG_RETURN_BYTEA_P(hll_state_serialize(state));
+}
+
+/* hll_union(hll, hll) -> hll */
+PG_FUNCTION_INFO_V1(hll_union);
+
+Datum
+hll_union(PG_FUNCTION_ARGS)
+{
+    bytea *a = PG_GETARG_HLL_P(0);
+    bytea *b = PG_GETARG_HLL_P(1);
+    HllState *state;
+
+    hll_validate(a);
+    hll_validate(b);
+    state = hll_state_load(CurrentMemoryContext, a);
+    hll_state_merge(state, hll_state_load(CurrentMemoryContext, b));
+    PG_RETURN_BYTEA_P(hll_state_serialize(state));
+}
+
+/* hll_cardinality(hll) -> double precision */
+PG_FUNCTION_INFO_V1(hll_cardinality);
+
+Datum
+hll_cardinality(PG_FUNCTION_ARGS)
+{
+    bytea *hll = PG_GETARG_HLL_P(0);
+
+    hll_validate(hll);
+    PG_RETURN_FLOAT8(hll_estimate(hll));
+}
+
+/* hll_precision(hll) -> integer */
+PG_FUNCTION_INFO_V1(hll_precision);
+
+Datum
+hll_precision(PG_FUNCTION_ARGS)
+{
+    PG_RETURN_INT32(hll_validate(PG_GETARG_HLL_P(0)));
+}
+
+/* hll_add_agg_transfn(internal, bigint [, integer]) -> internal */
+PG_FUNCTION_INFO_V1(hll_add_agg_transfn);
+
+Datum
+hll_add_agg_transfn(PG_FUNCTION_ARGS)
+{
+    MemoryContext aggcontext;
+    HllState *state;
+
+    if (!AggCheckCallContext(fcinfo, &aggcontext))
+        elog(ERROR, "hll_add_agg_transfn called in non-aggregate context");
+
+    if (PG_ARGISNULL(0))
+    {
+        int32 precision = HLL_DEFAULT_PRECISION;
+
+        if (PG_NARGS() > 2 && !PG_ARGISNULL(2))
+            precision = PG_GETARG_INT32(2);
+        hll_check_precision(precision);
+        state = hll_state_create(aggcontext, precision);
+    }
+    else
+        state = (HllState *) PG_GETARG_POINTER(0);
+
+    if (!PG_ARGISNULL(1))
+        hll_state_add_hash(state, (uint64) PG_GETARG_INT64(1));
+
+    PG_RETURN_POINTER(state);
+}
+
+/* approx_count_distinct_transfn(internal, anyelement) -> internal */
+PG_FUNCTION_INFO_V1(approx_count_distinct_transfn);
+
+Datum
+approx_count_distinct_transfn(PG_FUNCTION_ARGS)
+{
+    MemoryContext aggcontext;
+    HllState *state;
+
+    if (!AggCheckCallContext(fcinfo, &aggcontext))
+        elog(ERROR, "approx_count_distinct_transfn called in non-aggregate context");
+
+    if (PG_ARGISNULL(0))
+        state = hll_state_create(aggcontext, HLL_DEFAULT_PRECISION);
+    else
+        state = (HllState *) PG_GETARG_POINTER(0);
+
+    if (!PG_ARGISNULL(1))
+    {
+        bytea *bytes = hashlib_value_bytes(hashlib_arg_type_io(fcinfo, 1), PG_GETARG_DATUM(1));
+
+        hll_state_add_hash(state, hashlib_xxh3_64(VARDATA(bytes), VARSIZE(bytes) - VARHDRSZ));
+        pfree(bytes);
+    }
+
+    PG_RETURN_POINTER(state);
+}
+
+/* hll_union_agg_transfn(internal, hll) -> internal */
+PG_FUNCTION_INFO_V1(hll_union_agg_transfn);
+
+Datum
+hll_union_agg_transfn(PG_FUNCTION_ARGS)
+{
+    MemoryContext aggcontext;
+    HllState *state;
+    HllState *other;
+    bytea *hll;
+
+    if (!AggCheckCallContext(fcinfo, &aggcontext))
+        elog(ERROR, "hll_union_agg_transfn called in non-aggregate context");
+
+    if (PG_ARGISNULL(1))
+        PG_RETURN_POINTER(PG_ARGISNULL(0) ? NULL : PG_GETARG_POINTER(0));
+
+    hll = PG_GETARG_HLL_P(1);
+    hll_validate(hll);
+    other = hll_state_load(CurrentMemoryContext, hll);
+    if (PG_ARGISNULL(0))
+        state = hll_state_create(aggcontext, other->precision);
+    else
+        state = (HllState *) PG_GETARG_POINTER(0);
+    hll_state_merge(state, other);
+
+    PG_RETURN_POINTER(state);
+}
+
+/* hll_agg_combine(internal, internal) -> internal */
+PG_FUNCTION_INFO_V1(hll_agg_combine);
+
+Datum
+hll_agg_combine(PG_FUNCTION_ARGS)
+{
+    MemoryContext aggcontext;
+    HllState *state;
+    HllState *other;
+
+    if (!AggCheckCallContext(fcinfo, &aggcontext))
+        elog(ERROR, "hll_agg_combine called in non-aggregate context");
+
+    if (PG_ARGISNULL(1))
+        PG_RETURN_POINTER(PG_ARGISNULL(0) ? NULL : PG_GETARG_POINTER(0));
+
+    other = (HllState *) PG_GETARG_POINTER(1);
+    if (PG_ARGISNULL(0))
+        state = hll_state_create(aggcontext, other->precision);
+    else
+        state = (HllState *) PG_GETARG_POINTER(0);
+    hll_state_merge(state, other);
+
+    PG_RETURN_POINTER(state);
+}
+
+/* hll_agg_serialize(internal) -> bytea: the stored form */
+PG_FUNCTION_INFO_V1(hll_agg_serialize);
+
+Datum
+hll_agg_serialize(PG_FUNCTION_ARGS)
+{
+    PG_RETURN_BYTEA_P(hll_state_serialize((HllState *) PG_GETARG_POINTER(0)));
+}
+
+/* hll_agg_deserialize(bytea, internal) -> internal */
+PG_FUNCTION_INFO_V1(hll_agg_deserialize);
+
+Datum
+hll_agg_deserialize(PG_FUNCTION_ARGS)
+{
+    bytea *hll = PG_GETARG_BYTEA_PP(0);
+
+    if (!AggCheckCallContext(fcinfo, NULL))
+        elog(ERROR, "hll_agg_deserialize called in non-aggregate context");
+
+    hll_validate(hll);
+    PG_RETURN_POINTER(hll_state_load(CurrentMemoryContext, hll));
+}
+
+/* hll_agg_final(internal) -> hll; NULL when there were no rows */
+PG_FUNCTION_INFO_V1(hll_agg_final);
+
+Datum
+hll_agg_final(PG_FUNCTION_ARGS)
+{
+    if (PG_ARGISNULL(0))
+        PG_RETURN_NULL();
+
+    PG_RETURN_BYTEA_P(hll_state_serialize((HllState *) PG_GETARG_POINTER(0)));
+}
+
+/* approx_count_distinct_final(internal) -> double precision (0 when there were no rows) */
+PG_FUNCTION_INFO_V1(approx_count_distinct_final);
+
+Datum
+approx_count_distinct_final(PG_FUNCTION_ARGS)
+{
+    if (PG_ARGISNULL(0))
+        PG_RETURN_FLOAT8(0.0);
+
+    PG_RETURN_FLOAT8(hll_estimate(hll_state_serialize((HllState *) PG_GETARG_POINTER(0))));
+}
@@ -0,0 +1,363 @@
+#include "postgres.h"
+#include "fmgr.h"
+#include "utils/builtins.h"
+#include "mb/pg_wchar.h"
+#include "access/htup_details.h"
+
+#include "hashlib_bucket.h"
+
+/* komihash algorithm implementation (version 5)
+ * Based on komihash by Aleksey Vaneev
+ * Released under the MIT License
+ */
+
+/* Endian detection */
+#ifndef KOMIHASH_LITTLE_ENDIAN
+#if defined(_WIN32) || defined(__LITTLE_ENDIAN__) || (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#define KOMIHASH_LITTLE_ENDIAN 1
+#elif defined(__BIG_ENDIAN__) || (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+#define KOMIHASH_LITTLE_ENDIAN 0
+#else
+#warning "Unable to determine endianness, assuming little endian"
+#define KOMIHASH_LITTLE_ENDIAN 1
+#endif
+#endif
+
+/* Byte reading functions */
+static inline uint64_t
+kh_lu32ec(const uint8_t *p)
+{
+    uint32_t v;
+    memcpy(&v, p, 4);
+#if KOMIHASH_LITTLE_ENDIAN
+    return v;
+#else
+    return __builtin_bswap32(v);
+#endif
+}
+
+static inline uint64_t
+kh_lu64ec(const uint8_t *p)
+{
+    uint64_t v;
+    memcpy(&v, p, 8);
+#if KOMIHASH_LITTLE_ENDIAN
+    return v;
+#else
+    return __builtin_bswap64(v);
+#endif
+}
+
+/*
+ * Padded reads of the message tail.  The "l3" and "l4" variants may read up
+ * to 3 or 4 bytes *before* the pointer, so they are only used once at least
+ * 8 bytes of the message have been consumed.  The "nz" variant never looks
+ * back and handles 1-7 byte messages.  A single 1 bit is placed right after
+ * the last message byte.
+ */
+static inline uint64_t
+kh_lpu64ec_l3(const uint8_t *msg, size_t len)
+{
+    const int ml8 = (int)(len * 8);
+
+    if (len < 4)
+    {
+        const uint8_t *msg3 = msg + len - 3;
+        const uint64_t m = (uint64_t)msg3[0] | (uint64_t)msg3[1] << 8 | (uint64_t)msg3[2] << 16;
+        return ((uint64_t)1 << ml8) | (m >> (24 - ml8));
+    }
+    else
+    {
+        const uint64_t mh = kh_lu32ec(msg + len - 4);
+        const uint64_t ml = kh_lu32ec(msg);
+        return ((uint64_t)1 << ml8) | ml | ((mh >> (64 - ml8)) << 32);
+    }
+}
+
+static inline uint64_t
+kh_lpu64ec_nz(const uint8_t *msg, size_t len)
+{
+    const int ml8 = (int)(len * 8);
+
+    if (len < 4)
+    {
+        uint64_t m = msg[0];
+        if (len > 1)
+        {
+            m |= (uint64_t)msg[1] << 8;
+            if (len > 2)
+                m |= (uint64_t)msg[2] << 16;
+        }
+        return ((uint64_t)1 << ml8) | m;
+    }
+    else
+    {
+        const uint64_t mh = kh_lu32ec(msg + len - 4);
+        const uint64_t ml = kh_lu32ec(msg);
+        return ((uint64_t)1 << ml8) | ml | ((mh >> (64 - ml8)) << 32);
+    }
+}
+
+static inline uint64_t
+kh_lpu64ec_l4(const uint8_t *msg, size_t len)
+{
+    const int ml8 = (int)(len * 8);
+
+    if (len < 5)
+    {
+        const uint64_t m = kh_lu32ec(msg + len - 4);
+        return ((uint64_t)1 << ml8) | (m >> (32 - ml8));
+    }
+    else
+    {
+        const uint64_t m = kh_lu64ec(msg + len - 8);
+        return ((uint64_t)1 << ml8) | (m >> (64 - ml8));
+    }
+}
+
+/* 64x64 -> 128 bit multiplication */
+static inline void
+kh_m128(uint64_t u, uint64_t v, uint64_t *rl, uint64_t *rh)
+{
+#ifdef __SIZEOF_INT128__
+    __uint128_t r = (__uint128_t)u * v;
+    *rl = (uint64_t)r;
+    *rh = (uint64_t)(r >> 64);
+#else
+    /* Fallback for systems without 128-bit integers */
+    uint64_t ha = u >> 32, hb = v >> 32, la = (uint32_t)u, lb = (uint32_t)v;
+    uint64_t rh0 = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl0 = la * lb;
+    uint64_t t = rl0 + (rm0 << 32), c = t < rl0, lo;
+    lo = t + (rm1 << 32);
+    c += lo < t;
+    *rl = lo;
+    *rh = rh0 + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+}
+
+/* Mixing round shared by the initialisation and finalisation steps */
+#define KOMIHASH_HASHROUND() \
+    kh_m128(seed1, seed5, &seed1, &r1h); \
+    seed5 += r1h; \
+    seed1 ^= seed5
+
+#define KOMIHASH_HASH16(m) \
+    kh_m128(seed1 ^ kh_lu64ec(m), seed5 ^ kh_lu64ec((m) + 8), &seed1, &r1h); \
+    seed5 += r1h; \
+    seed1 ^= seed5
+
+#define KOMIHASH_HASHFINAL() \
+    kh_m128(r1h, r2h, &seed1, &r1h); \
+    seed5 += r1h; \
+    seed1 ^= seed5; \
+    KOMIHASH_HASHROUND()
+
+/* Main komihash function */
+static uint64_t
+komihash(const void *key, size_t len, uint64_t seed)
+{
+    const uint8_t *msg = (const uint8_t *)key;
+    uint64_t seed1 = 0x243F6A8885A308D3ULL ^ (seed & 0x5555555555555555ULL);
+    uint64_t seed5 = 0x452821E638D01377ULL ^ (seed & 0xAAAAAAAAAAAAAAAAULL);
+    uint64_t r1h, r2h;
+
+    KOMIHASH_HASHROUND();
+
+    if (len < 16)
+    {
+        r1h = seed1;
+        r2h = seed5;
+
+        if (len > 7)
+        {
+            r2h ^= kh_lpu64ec_l3(msg + 8, len - 8);
+            r1h ^= kh_lu64ec(msg);
+        }
+        else if (len != 0)
+        {
+            r1h ^= kh_lpu64ec_nz(msg, len);
+        }
+
+        KOMIHASH_HASHFINAL();
+        return seed1;
+    }
+
+    if (len < 32)
+    {
+        KOMIHASH_HASH16(msg);
+
+        if (len > 23)
+        {
+            r2h = seed5 ^ kh_lpu64ec_l4(msg + 24, len - 24);
+            r1h = seed1 ^ kh_lu64ec(msg + 16);
+        }
+        else
+        {
+            r1h = seed1 ^ kh_lpu64ec_l4(msg + 16, len - 16);
+            r2h = seed5;
+        }
+
+        KOMIHASH_HASHFINAL();
+        return seed1;
+    }
+
+    if (len > 63)
+    {
+        uint64_t seed2 = 0x13198A2E03707344ULL ^ seed1;
+        uint64_t seed3 = 0xA4093822299F31D0ULL ^ seed1;
+        uint64_t seed4 = 0x082EFA98EC4E6C89ULL ^ seed1;
+        uint64_t seed6 = 0xBE5466CF34E90C6CULL ^ seed5;
+        uint64_t seed7 = 0xC0AC29B7C97C50DDULL ^ seed5;
+        uint64_t seed8 = 0x3F84D5B5B5470917ULL ^ seed5;
+        uint64_t r3h, r4h;
+
+        do
+        {
+            kh_m128(seed1 ^ kh_lu64ec(msg), seed5 ^ kh_lu64ec(msg + 32), &seed1, &r1h);
+            kh_m128(seed2 ^ kh_lu64ec(msg + 8), seed6 ^ kh_lu64ec(msg + 40), &seed2, &r2h);
+            kh_m128(seed3 ^ kh_lu64ec(msg + 16), seed7 ^ kh_lu64ec(msg + 48), &seed3, &r3h);
+            kh_m128(seed4 ^ kh_lu64ec(msg + 24), seed8 ^ kh_lu64ec(msg + 56), &seed4, &r4h);
+
+            msg += 64;
+            len -= 64;
+
+            seed5 += r1h;
+            seed6 += r2h;
+            seed7 += r3h;
+            seed8 += r4h;
+            seed2 ^= seed5;
+            seed3 ^= seed6;
+            seed4 ^= seed7;
+            seed1 ^= seed8;
+        } while (len > 63);
+
+        seed5 ^= seed6 ^ seed7 ^ seed8;
+        seed1 ^= seed2 ^ seed3 ^ seed4;
+    }
+
+    if (len > 31)
+    {
+        KOMIHASH_HASH16(msg);
+        KOMIHASH_HASH16(msg + 16);
+        msg += 32;
+        len -= 32;
+    }
+
+    if (len > 15)
+    {
+        KOMIHASH_HASH16(msg);
+        msg += 16;
+        len -= 16;
+    }
+
+    if (len > 7)
+    {
+        r2h = seed5 ^ kh_lpu64ec_l4(msg + 8, len - 8);
+        r1h = seed1 ^ kh_lu64ec(msg);
+    }
+    else
+    {
+        r1h = seed1 ^ kh_lpu64ec_l4(msg, len);
+        r2h = seed5;
+    }
+
+    KOMIHASH_HASHFINAL();
+    return seed1;
+}
+
+/* hash_bucket support: komihash with seed 0 */
+static uint64
+komihash_bucket_hash(const void *data, size_t len)
+{
+    return komihash(data, len, 0);
+}
+
+const HashlibBucketHasher komihash_bucket_hasher = {
+    "komihash", komihash_bucket_hash
+};
+
+/* PostgreSQL function wrappers */
+
+/* komihash(text) -> bigint */
+PG_FUNCTION_INFO_V1(komihash_text);
+Datum
+komihash_text(PG_FUNCTION_ARGS)
+{
+    text *input = PG_GETARG_TEXT_PP(0);
+    uint64_t hash = komihash(VARDATA_ANY(input), VARSIZE_ANY_EXHDR(input), 0);
+    PG_RETURN_INT64((int64_t)hash);
+}
+
+/* komihash(text, bigint) -> bigint */
+PG_FUNCTION_INFO_V1(komihash_text_seed);
+Datum
+komihash_text_seed(PG_FUNCTION_ARGS)
+{
+    text *input = PG_GETARG_TEXT_PP(0);
+    uint64_t seed = (uint64_t)PG_GETARG_INT64(1);
+    uint64_t hash = komihash(VARDATA_ANY(input), VARSIZE_ANY_EXHDR(input), seed);
+    PG_RETURN_INT64((int64_t)hash);
+}
+
+/* komihash(bytea) -> bigint */
+PG_FUNCTION_INFO_V1(komihash_bytea);
+Datum
+komihash_bytea(PG_FUNCTION_ARGS)
+{
+    bytea *input = PG_GETARG_BYTEA_PP(0);
+    uint64_t hash = komihash(VARDATA_ANY(input), VARSIZE_ANY_EXHDR(input), 0);
+    PG_RETURN_INT64((int64_t)hash);
+}
+
+/* komihash(bytea, bigint) -> bigint */
+PG_FUNCTION_INFO_V1(komihash_bytea_seed);
+Datum
+komihash_bytea_seed(PG_FUNCTION_ARGS)
+{
+    bytea *input = PG_GETARG_BYTEA_PP(0);
+    uint64_t seed = (uint64_t)PG_GETARG_INT64(1);
+    uint64_t hash = komihash(VARDATA_ANY(input), VARSIZE_ANY_EXHDR(input), seed);
+    PG_RETURN_INT64((int64_t)hash);
+}
+
+/* komihash(integer) -> bigint */
+PG_FUNCTION_INFO_V1(komihash_int4);
+Datum
+komihash_int4(PG_FUNCTION_ARGS)
+{
+    int32 val = PG_GETARG_INT32(0);
+    uint64_t hash = komihash(&val, sizeof(int32), 0);
+    PG_RETURN_INT64((int64_t)hash);
+}
+
+/* komihash(integer, bigint) -> bigint */
+PG_FUNCTION_INFO_V1(komihash_int4_seed);
+Datum
+komihash_int4_seed(PG_FUNCTION_ARGS)
+{
+    int32 val = PG_GETARG_INT32(0);
+    uint64_t seed = (uint64_t)PG_GETARG_INT64(1);
+    uint64_t hash = komihash(&val, sizeof(int32), seed);
+    PG_RETURN_INT64((int64_t)hash);
+}
+
+/* komihash(bigint) -> bigint */
+PG_FUNCTION_INFO_V1(komihash_int8);
+Datum
+komihash_int8(PG_FUNCTION_ARGS)
+{
+    int64 val = PG_GETARG_INT64(0);
+    uint64_t hash = komihash(&val, sizeof(int64), 0);
+    PG_RETURN_INT64((int64_t)hash);
+}
+
+/* komihash(bigint, bigint) -> bigint */
+PG_FUNCTION_INFO_V1(komihash_int8_seed);
+Datum
+komihash_int8_seed(PG_FUNCTION_ARGS)
+{
+    int64 val = PG_GETARG_INT64(0);
+    uint64_t seed = (uint64_t)PG_GETARG_INT64(1);
+    uint64_t hash = komihash(&val, sizeof(int64), seed);
+    PG_RETURN_INT64((int64_t)hash);
+}
@@ -6,6 +6,8 @@
 #include "mb/pg_wchar.h"
 #include "access/htup_details.h"
 
+#include "hashlib_bucket.h"
+
 /* MetroHash64 constants */
 static const uint64_t k0_64 = 0xD6D018F5;
 static const uint64_t k1_64 = 0xA2AA033B;
@@ -208,6 +210,17 @@ metrohash128(const char *buffer, size_t length, uint64_t seed)
     return result;
 }
 
+/* hash_bucket support: MetroHash64 with seed 0 */
+static uint64
+metrohash64_bucket_hash(const void *data, size_t len)
+{
+    return metrohash64((const char *)data, len, 0);
+}
+
+const HashlibBucketHasher metrohash64_bucket_hasher = {
+    "metrohash64", metrohash64_bucket_hash
+};
+
 /* PostgreSQL function wrappers for MetroHash64 */
 
 /* MetroHash64 for text input with default seed */
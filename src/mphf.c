@@ -0,0 +1,574 @@
+#include "postgres.h"
+#include "fmgr.h"
+#include "utils/builtins.h"
+#include "utils/memutils.h"
+#include "libpq/pqformat.h"
+#include "port/pg_bitutils.h"
+
+#include "hashlib_datum.h"
+#include "hashlib_sketch.h"
+
+/*
+ * Minimal perfect hash function: maps each of n distinct values to its own
+ * index in [0, n), in a few bits per value.
+ *
+ * The construction is BBHash (Limasset et al., "Fast and Scalable Minimal
+ * Perfect Hashing for Massive Key Sets", 2017).  Level 0 is a bit array of
+ * about gamma * n bits, with gamma = 2; every key hashes to one bit, and the
+ * bits hit by exactly one key are set.  The keys that collided go on to level
+ * 1, sized for them, and so on until every key has a bit of its own.  The
+ * index of a key is the number of set bits before its bit, across the levels
+ * concatenated, read from a rank sample every 512 bits plus a few popcounts.
+ * This takes gamma * e^(1/gamma), about 3.3, bits per key plus the samples.
+ *
+ * Values are hashed once with xxhash3_64 over their canonical bytes (see
+ * hashlib_datum.h), and the hash of a key at level i is
+ * fmix64(key + (i + 1) * 0x9E3779B97F4A7C15), reduced to the level size with
+ * a multiply-shift.  The aggregate collects the 64-bit keys, sorts them to
+ * remove duplicates and builds in the final step; the result depends only on
+ * the set of keys.  A value that is not in the set gets either some index or
+ * NULL.
+ *
+ * Stored layout (integers little-endian):
+ *
+ *   byte 0       format version (1)
+ *   byte 1       number of levels L
+ *   bytes 2-3    reserved (0)
+ *   bytes 4-7    number of distinct keys n
+ *   then         L level sizes in 64-bit words, 4 bytes each
+ *   then         W 64-bit words of level bits, W the sum of the level sizes;
+ *                bit j of a level is bit j % 64 of its word j / 64
+ *   then         ceil(W / 8) ranks of 4 bytes: the number of set bits in the
+ *                words before each group of 8 words
+ */
+
+#define MPHF_VERSION            1
+#define MPHF_HEADER_SIZE        8
+#define MPHF_MAX_LEVELS         64
+#define MPHF_MAX_KEYS           100000000
+#define MPHF_GAMMA              2
+#define MPHF_RANK_WORDS         8
+#define MPHF_LEVEL_INCREMENT    UINT64CONST(0x9E3779B97F4A7C15)
+
+typedef struct MphfState
+{
+    int64       nkeys;
+    int64       capacity;
+    uint64     *keys;           /* xxhash3_64 of the values; duplicates are
+                                 * removed when the buffer fills */
+} MphfState;
+
+static MphfState *
+mphf_state_create(MemoryContext context)
+{
+    MphfState *state = (MphfState *) MemoryContextAlloc(context, sizeof(MphfState));
+
+    state->nkeys = 0;
+    state->capacity = 1024;
+    state->keys = (uint64 *) MemoryContextAlloc(context, sizeof(uint64) * state->capacity);
+    return state;
+}
+
+static int
+mphf_key_cmp(const void *a, const void *b)
+{
+    uint64 x = *(const uint64 *) a;
+    uint64 y = *(const uint64 *) b;
+
+    return x < y ? -1 : x > y ? 1 : 0;
+}
+
+static void
+mphf_state_dedupe(MphfState *state)
+{
+    int64 n = 0;
+    int64 i;
+
+    qsort(state->keys, state->nkeys, sizeof(uint64), mphf_key_cmp);
+    for (i = 0; i < state->nkeys; i++)
+    {
+        if (n == 0 || state->keys[n - 1] != state->keys[i])
+            state->keys[n++] = state->keys[i];
+    }
+    state->nkeys = n;
+}
+
+/*
+ * Make room for n more keys.  A full buffer is first sorted and deduplicated,
+ * so that the limit applies to distinct keys; it only grows when that leaves
+ * it more than half full, which keeps the sorting amortized.
+ */
+static void
+mphf_state_reserve(MphfState *state, int64 n)
+{
+    if (state->nkeys + n <= state->capacity)
+        return;
+    mphf_state_dedupe(state);
+    if (state->nkeys + n <= state->capacity / 2)
+        return;
+    if (state->nkeys + n > MPHF_MAX_KEYS)
+        ereport(ERROR,
+                (errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+                 errmsg("minimal perfect hash function cannot hold more than %d keys",
+                        MPHF_MAX_KEYS)));
+    state->capacity = Min(Max(state->capacity * 2, state->nkeys + n), MPHF_MAX_KEYS);
+    state->keys = (uint64 *) repalloc_huge(state->keys, sizeof(uint64) * state->capacity);
+}
+
+static void
+mphf_state_add(MphfState *state, uint64 key)
+{
+    mphf_state_reserve(state, 1);
+    state->keys[state->nkeys++] = key;
+}
+
+static void
+mphf_state_merge(MphfState *state, const MphfState *other)
+{
+    int64 i;
+
+    /* key by key, so that keys the states share are dropped as the buffer fills */
+    for (i = 0; i < other->nkeys; i++)
+        mphf_state_add(state, other->keys[i]);
+}
+
+/* Bit of key in a level of nbits bits */
+static inline uint32
+mphf_position(uint64 key, int level, uint32 nbits)
+{
+    uint64 hash = hashlib_mix64(key + (uint64) (level + 1) * MPHF_LEVEL_INCREMENT);
+
+    return hashlib_reduce32((uint32) (hash >> 32), nbits);
+}
+
+static inline Size
+mphf_rank_count(uint64 nwords)
+{
+    return (Size) ((nwords + MPHF_RANK_WORDS - 1) / MPHF_RANK_WORDS);
+}
+
+/*
+ * Build from distinct keys.  The keys are copied, since a window aggregate
+ * calls the final function again on the same state.
+ */
+static bytea *
+mphf_build(const uint64 *input, uint32 nkeys)
+{
+    uint64     *keys;
+    uint64     *levels[MPHF_MAX_LEVELS];
+    uint32      level_words[MPHF_MAX_LEVELS];
+    int         nlevels = 0;
+    uint32      remaining = nkeys;
+    uint64      nwords = 0;
+    uint64      rank = 0;
+    Size        size;
+    bytea      *result;
+    uint8      *data;
+    uint8      *words;
+    uint8      *ranks;
+    uint64      w;
+    int         l;
+
+    keys = (uint64 *) palloc_extended(sizeof(uint64) * Max(nkeys, 1), MCXT_ALLOC_HUGE);
+    memcpy(keys, input, sizeof(uint64) * nkeys);
+    while (remaining > 0)
+    {
+        uint32 nw;
+        uint32 nbits;
+        uint64 *hit;
+        uint64 *collision;
+        uint32 next = 0;
+        uint32 i;
+
+        if (nlevels == MPHF_MAX_LEVELS)
+            ereport(ERROR,
+                    (errcode(ERRCODE_INTERNAL_ERROR),
+                     errmsg("could not build minimal perfect hash function of %u keys", nkeys)));
+
+        nw = (uint32) (((uint64) remaining * MPHF_GAMMA + 63) / 64);
+        nbits = nw * 64;
+        hit = (uint64 *) palloc_extended(sizeof(uint64) * nw, MCXT_ALLOC_HUGE | MCXT_ALLOC_ZERO);
+        collision = (uint64 *) palloc_extended(sizeof(uint64) * nw, MCXT_ALLOC_HUGE | MCXT_ALLOC_ZERO);
+
+        /* mark the bits hit by one key, then drop the ones hit more than once */
+        for (i = 0; i < remaining; i++)
+        {
+            uint32 pos = mphf_position(keys[i], nlevels, nbits);
+            uint64 bit = UINT64CONST(1) << (pos % 64);
+
+            if (hit[pos / 64] & bit)
+                collision[pos / 64] |= bit;
+            hit[pos / 64] |= bit;
+        }
+        for (i = 0; i < nw; i++)
+            hit[i] &= ~collision[i];
+
+        /* the keys without a bit of their own go on to the next level */
+        for (i = 0; i < remaining; i++)
+        {
+            uint32 pos = mphf_position(keys[i], nlevels, nbits);
+
+            if ((hit[pos / 64] & (UINT64CONST(1) << (pos % 64))) == 0)
+                keys[next++] = keys[i];
+        }
+
+        pfree(collision);
+        levels[nlevels] = hit;
+        level_words[nlevels] = nw;
+        nlevels++;
+        nwords += nw;
+        remaining = next;
+    }
+    pfree(keys);
+
+    size = MPHF_HEADER_SIZE + 4 * nlevels + 8 * nwords + 4 * mphf_rank_count(nwords);
+    result = (bytea *) palloc_extended(VARHDRSZ + size, MCXT_ALLOC_HUGE);
+    SET_VARSIZE(result, VARHDRSZ + size);
+    data = (uint8 *) VARDATA(result);
+    data[0] = MPHF_VERSION;
+    data[1] = (uint8) nlevels;
+    data[2] = data[3] = 0;
+    hashlib_write_le32(data + 4, nkeys);
+
+    words = data + MPHF_HEADER_SIZE + 4 * nlevels;
+    ranks = words + 8 * nwords;
+    w = 0;
+    for (l = 0; l < nlevels; l++)
+    {
+        uint32 i;
+
+        hashlib_write_le32(data + MPHF_HEADER_SIZE + 4 * l, level_words[l]);
+        for (i = 0; i < level_words[l]; i++, w++)
+        {
+            if (w % MPHF_RANK_WORDS == 0)
+                hashlib_write_le32(ranks + 4 * (w / MPHF_RANK_WORDS), (uint32) rank);
+            hashlib_write_le64(words + 8 * w, levels[l][i]);
+            rank += pg_popcount64(levels[l][i]);
+        }
+        pfree(levels[l]);
+    }
+    Assert(rank == nkeys);
+
+    return result;
+}
+
+static void
+mphf_invalid(void)
+{
+    ereport(ERROR,
+            (errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+             errmsg("invalid minimal perfect hash function")));
+}
+
+static void
+mphf_validate(const bytea *mphf)
+{
+    const uint8 *data = (const uint8 *) VARDATA_ANY(mphf);
+    Size size = VARSIZE_ANY_EXHDR(mphf);
+    uint64 nwords = 0;
+    int nlevels;
+    int l;
+
+    if (size < MPHF_HEADER_SIZE || data[0] != MPHF_VERSION || data[1] > MPHF_MAX_LEVELS ||
+        data[2] != 0 || data[3] != 0 || hashlib_read_le32(data + 4) > MPHF_MAX_KEYS ||
+        (data[1] == 0) != (hashlib_read_le32(data + 4) == 0) ||
+        size < MPHF_HEADER_SIZE + 4 * (Size) data[1])
+        mphf_invalid();
+
+    nlevels = data[1];
+    for (l = 0; l < nlevels; l++)
+    {
+        uint32 nw = hashlib_read_le32(data + MPHF_HEADER_SIZE + 4 * l);
+
+        /* a level's bits are addressed with 32-bit positions */
+        if (nw == 0 || nw > PG_UINT32_MAX / 64)
+            mphf_invalid();
+        nwords += nw;
+    }
+    if (size != MPHF_HEADER_SIZE + 4 * nlevels + 8 * nwords + 4 * mphf_rank_count(nwords))
+        mphf_invalid();
+}
+
+/*
+ * Index of the key with xxhash3_64 value key, or -1 when it falls through
+ * every level (and so is not in the set)
+ */
+static int64
+mphf_index(const uint8 *data, uint64 key)
+{
+    int nlevels = data[1];
+    uint32 nkeys = hashlib_read_le32(data + 4);
+    const uint8 *words = data + MPHF_HEADER_SIZE + 4 * nlevels;
+    uint64 nwords = 0;
+    uint64 offset = 0;
+    int l;
+
+    for (l = 0; l < nlevels; l++)
+        nwords += hashlib_read_le32(data + MPHF_HEADER_SIZE + 4 * l);
+
+    for (l = 0; l < nlevels; l++)
+    {
+        uint32 nw = hashlib_read_le32(data + MPHF_HEADER_SIZE + 4 * l);
+        uint32 pos = mphf_position(key, l, nw * 64);
+        uint64 w = offset + pos / 64;
+        uint64 word = hashlib_read_le64(words + 8 * w);
+
+        if (word & (UINT64CONST(1) << (pos % 64)))
+        {
+            uint64 rank = hashlib_read_le32(words + 8 * nwords + 4 * (w / MPHF_RANK_WORDS));
+            uint64 i;
+
+            for (i = w - w % MPHF_RANK_WORDS; i < w; i++)
+                rank += pg_popcount64(hashlib_read_le64(words + 8 * i));
+            rank += pg_popcount64(word & ((UINT64CONST(1) << (pos % 64)) - 1));
+
+            /* only a corrupt rank sample can point past the last key */
+            return rank < nkeys ? (int64) rank : -1;
+        }
+        offset += nw;
+    }
+    return -1;
+}
+
+/* Hash of a non-null value of the type described by io */
+static uint64
+mphf_hash_value(HashlibTypeIO *io, Datum value)
+{
+    bytea *bytes = hashlib_value_bytes(io, value);
+    uint64 hash = hashlib_xxh3_64(VARDATA(bytes), VARSIZE(bytes) - VARHDRSZ);
+
+    pfree(bytes);
+    return hash;
+}
+
+/* fn_extra of mphf_lookup */
+typedef struct MphfCache
+{
+    HashlibTypeIO *io;
+    HashlibDetoastCache mphf;
+} MphfCache;
+
+/* mphf_in(cstring) -> mphf */
+PG_FUNCTION_INFO_V1(mphf_in);
+
+Datum
+mphf_in(PG_FUNCTION_ARGS)
+{
+    bytea *mphf = (bytea *) hashlib_sketch_from_hex(PG_GETARG_CSTRING(0), "mphf");
+
+    mphf_validate(mphf);
+    PG_RETURN_BYTEA_P(mphf);
+}
+
+/* mphf_out(mphf) -> cstring */
+PG_FUNCTION_INFO_V1(mphf_out);
+
+Datum
+mphf_out(PG_FUNCTION_ARGS)
+{
+    PG_RETURN_CSTRING(hashlib_sketch_to_hex((struct varlena *) PG_GETARG_BYTEA_PP(0)));
+}
+
+/* mphf_recv(internal) -> mphf */
+PG_FUNCTION_INFO_V1(mphf_recv);
+
+Datum
+mphf_recv(PG_FUNCTION_ARGS)
+{
+    bytea *mphf = (bytea *) hashlib_sketch_recv((StringInfo) PG_GETARG_POINTER(0));
+
+    mphf_validate(mphf);
+    PG_RETURN_BYTEA_P(mphf);
+}
+
+/* mphf_send(mphf) -> bytea */
+PG_FUNCTION_INFO_V1(mphf_send);
+
+Datum
+mphf_send(PG_FUNCTION_ARGS)
+{
+    bytea *mphf = PG_GETARG_BYTEA_PP(0);
+    StringInfoData buf;
+
+    pq_begintypsend(&buf);
+    pq_sendbytes(&buf, VARDATA_ANY(mphf), VARSIZE_ANY_EXHDR(mphf));
+    PG_RETURN_BYTEA_P(pq_endtypsend(&buf));
+}
+
+/* mphf(bytea) -> mphf: checks the stored layout, for the bytea cast */
+PG_FUNCTION_INFO_V1(mphf_from_bytea);
+
+Datum
+mphf_from_bytea(PG_FUNCTION_ARGS)
+{
+    bytea *mphf = PG_GETARG_BYTEA_P_COPY(0);
+
+    mphf_validate(mphf);
+    PG_RETURN_BYTEA_P(mphf);
+}
+
+/*
+ * mphf_lookup(mphf, anyelement) -> bigint
+ *
+ * The index in [0, n) of a value in the set.  A value not in the set gives
+ * some index or NULL.
+ */
+PG_FUNCTION_INFO_V1(mphf_lookup);
+
+Datum
+mphf_lookup(PG_FUNCTION_ARGS)
+{
+    MphfCache *cache = (MphfCache *) fcinfo->flinfo->fn_extra;
+    const uint8 *data;
+    HashlibTypeIO *io;
+    int64 index;
+
+    if (cache == NULL)
+    {
+        cache = (MphfCache *) MemoryContextAllocZero(fcinfo->flinfo->fn_mcxt, sizeof(MphfCache));
+        fcinfo->flinfo->fn_extra = cache;
+    }
+
+    data = (const uint8 *) VARDATA_ANY(hashlib_sketch_getarg_cached(fcinfo, 0, &cache->mphf,
+                                                                    mphf_validate));
+    io = hashlib_type_io(fcinfo->flinfo, hashlib_arg_type(fcinfo, 1), &cache->io);
+    index = mphf_index(data, mphf_hash_value(io, PG_GETARG_DATUM(1)));
+    if (index < 0)
+        PG_RETURN_NULL();
+    PG_RETURN_INT64(index);
+}
+
+/* mphf_count(mphf) -> bigint: number of distinct keys */
+PG_FUNCTION_INFO_V1(mphf_count);
+
+Datum
+mphf_count(PG_FUNCTION_ARGS)
+{
+    bytea *mphf = PG_GETARG_BYTEA_PP(0);
+
+    mphf_validate(mphf);
+    PG_RETURN_INT64((int64) hashlib_read_le32((const uint8 *) VARDATA_ANY(mphf) + 4));
+}
+
+/* mphf_agg_transfn(internal, anyelement) -> internal */
+PG_FUNCTION_INFO_V1(mphf_agg_transfn);
+
+Datum
+mphf_agg_transfn(PG_FUNCTION_ARGS)
+{
+    MemoryContext aggcontext;
+    MphfState *state;
+
+    if (!AggCheckCallContext(fcinfo, &aggcontext))
+        elog(ERROR, "mphf_agg_transfn called in non-aggregate context");
+
+    if (PG_ARGISNULL(0))
+        state = mphf_state_create(aggcontext);
+    else
+        state = (MphfState *) PG_GETARG_POINTER(0);
+
+    if (!PG_ARGISNULL(1))
+        mphf_state_add(state, mphf_hash_value(hashlib_arg_type_io(fcinfo, 1), PG_GETARG_DATUM(1)));
+
+    PG_RETURN_POINTER(state);
+}
+
+/* mphf_agg_combine(internal, internal) -> internal */
+PG_FUNCTION_INFO_V1(mphf_agg_combine);
+
+Datum
+mphf_agg_combine(PG_FUNCTION_ARGS)
+{
+    MemoryContext aggcontext;
+    MphfState *state;
+
+    if (!AggCheckCallContext(fcinfo, &aggcontext))
+        elog(ERROR, "mphf_agg_combine called in non-aggregate context");
+
+    if (PG_ARGISNULL(1))
+        PG_RETURN_POINTER(PG_ARGISNULL(0) ? NULL : PG_GETARG_POINTER(0));
+
+    if (PG_ARGISNULL(0))
+        state = mphf_state_create(aggcontext);
+    else
+        state = (MphfState *) PG_GETARG_POINTER(0);
+    mphf_state_merge(state, (MphfState *) PG_GETARG_POINTER(1));
+
+    PG_RETURN_POINTER(state);
+}
+
+/*
+ * mphf_agg_serialize(internal) -> bytea
+ *
+ * A partial state is the distinct collected keys as little-endian 64-bit
+ * integers.
+ */
+PG_FUNCTION_INFO_V1(mphf_agg_serialize);
+
+Datum
+mphf_agg_serialize(PG_FUNCTION_ARGS)
+{
+    MphfState *state = (MphfState *) PG_GETARG_POINTER(0);
+    Size size;
+    bytea *result;
+    uint8 *data;
+    int64 i;
+
+    /* removing repeated keys leaves the state describing the same set */
+    mphf_state_dedupe(state);
+    size = sizeof(uint64) * state->nkeys;
+    result = (bytea *) palloc_extended(VARHDRSZ + size, MCXT_ALLOC_HUGE);
+    SET_VARSIZE(result, VARHDRSZ + size);
+    data = (uint8 *) VARDATA(result);
+    for (i = 0; i < state->nkeys; i++)
+        hashlib_write_le64(data + 8 * i, state->keys[i]);
+    PG_RETURN_BYTEA_P(result);
+}
+
+/* mphf_agg_deserialize(bytea, internal) -> internal */
+PG_FUNCTION_INFO_V1(mphf_agg_deserialize);
+
+Datum
+mphf_agg_deserialize(PG_FUNCTION_ARGS)
+{
+    bytea *partial;
+    const uint8 *data;
+    Size size;
+    MphfState *state;
+    int64 n;
+    int64 i;
+
+    if (!AggCheckCallContext(fcinfo, NULL))
+        elog(ERROR, "mphf_agg_deserialize called in non-aggregate context");
+
+    partial = PG_GETARG_BYTEA_PP(0);
+    data = (const uint8 *) VARDATA_ANY(partial);
+    size = VARSIZE_ANY_EXHDR(partial);
+    if (size % 8 != 0)
+        elog(ERROR, "invalid minimal perfect hash function partial state");
+
+    n = (int64) size / 8;
+    state = mphf_state_create(CurrentMemoryContext);
+    mphf_state_reserve(state, n);
+    for (i = 0; i < n; i++)
+        state->keys[i] = hashlib_read_le64(data + 8 * i);
+    state->nkeys = n;
+    PG_RETURN_POINTER(state);
+}
+
+/* mphf_agg_final(internal) -> mphf; NULL when there were no rows */
+PG_FUNCTION_INFO_V1(mphf_agg_final);
+
+Datum
+mphf_agg_final(PG_FUNCTION_ARGS)
+{
+    MphfState *state;
+
+    if (PG_ARGISNULL(0))
+        PG_RETURN_NULL();
+
+    /* removing repeated keys leaves the state describing the same set */
+    state = (MphfState *) PG_GETARG_POINTER(0);
+    mphf_state_dedupe(state);
+    PG_RETURN_BYTEA_P(mphf_build(state->keys, (uint32) state->nkeys));
+}
@@ -0,0 +1,207 @@
+#include "postgres.h"
+#include "fmgr.h"
+#include "funcapi.h"
+
+#include "hashlib_sketch.h"
+
+/*
+ * hash_permute(i, n, seed): a pseudorandom permutation of [0, n), so that
+ * hash_permute(i, n, seed) for i in [0, n) visits every value of [0, n) once
+ * in random order, with no sort and no state.
+ *
+ * The permutation is a balanced Feistel network over the smallest domain of
+ * 2^(2h) values that holds n, with h >= 1.  Each of the rounds maps the
+ * halves (L, R) of h bits to (R, L ^ F(r, R)), where F(r, R) is the low h
+ * bits of the xxhash3_64 of (le64 R, le64 r) with the seed.  Each round is a
+ * bijection, so the network is, and values that land at or above n are
+ * encrypted again (cycle walking) until they land below n.  The domain is
+ * less than 4n, so that takes fewer than 4 rounds of the network on average.
+ * hash_permute_inverse runs the rounds backwards.
+ */
+
+#define PERMUTE_ROUNDS          6
+
+typedef struct HashlibPermutation
+{
+    uint64      n;
+    uint64      seed;
+    int         halfbits;
+    uint64      mask;           /* of a half */
+} HashlibPermutation;
+
+static void
+hashlib_permutation_init(HashlibPermutation *perm, int64 n, int64 seed)
+{
+    int bits = 0;
+
+    if (n <= 0)
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("permutation size must be positive")));
+
+    /* bits of the largest value, n - 1 */
+    while (bits < 64 && ((uint64) (n - 1) >> bits) != 0)
+        bits++;
+
+    perm->n = (uint64) n;
+    perm->seed = (uint64) seed;
+    perm->halfbits = Max((bits + 1) / 2, 1);
+    perm->mask = (UINT64CONST(1) << perm->halfbits) - 1;
+}
+
+static inline uint64
+hashlib_permutation_round(const HashlibPermutation *perm, int round, uint64 half)
+{
+    uint8 buf[16];
+
+    hashlib_write_le64(buf, half);
+    hashlib_write_le64(buf + 8, (uint64) round);
+    return hashlib_xxh3_64_seed(buf, sizeof(buf), perm->seed) & perm->mask;
+}
+
+/* One pass of the Feistel network over the 2^(2h) domain */
+static uint64
+hashlib_permutation_encrypt(const HashlibPermutation *perm, uint64 x)
+{
+    uint64 left = x >> perm->halfbits;
+    uint64 right = x & perm->mask;
+    int r;
+
+    for (r = 0; r < PERMUTE_ROUNDS; r++)
+    {
+        uint64 next = left ^ hashlib_permutation_round(perm, r, right);
+
+        left = right;
+        right = next;
+    }
+    return (left << perm->halfbits) | right;
+}
+
+static uint64
+hashlib_permutation_decrypt(const HashlibPermutation *perm, uint64 x)
+{
+    uint64 left = x >> perm->halfbits;
+    uint64 right = x & perm->mask;
+    int r;
+
+    for (r = PERMUTE_ROUNDS - 1; r >= 0; r--)
+    {
+        uint64 prev = right ^ hashlib_permutation_round(perm, r, left);
+
+        right = left;
+        left = prev;
+    }
+    return (left << perm->halfbits) | right;
+}
+
+/* The image of i in [0, n), by cycle walking */
+static uint64
+hashlib_permute(const HashlibPermutation *perm, uint64 i)
+{
+    do
+        i = hashlib_permutation_encrypt(perm, i);
+    while (i >= perm->n);
+    return i;
+}
+
+static uint64
+hashlib_permute_inverse(const HashlibPermutation *perm, uint64 j)
+{
+    do
+        j = hashlib_permutation_decrypt(perm, j);
+    while (j >= perm->n);
+    return j;
+}
+
+static void
+hashlib_permutation_check_index(const HashlibPermutation *perm, int64 i)
+{
+    if (i < 0 || (uint64) i >= perm->n)
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("permutation index " INT64_FORMAT " is out of range for size " UINT64_FORMAT,
+                        i, perm->n)));
+}
+
+/* hash_permute(i, n, seed) -> bigint: the position of i in [0, n) */
+PG_FUNCTION_INFO_V1(hash_permute);
+
+Datum
+hash_permute(PG_FUNCTION_ARGS)
+{
+    HashlibPermutation perm;
+
+    hashlib_permutation_init(&perm, PG_GETARG_INT64(1), PG_GETARG_INT64(2));
+    hashlib_permutation_check_index(&perm, PG_GETARG_INT64(0));
+    PG_RETURN_INT64((int64) hashlib_permute(&perm, (uint64) PG_GETARG_INT64(0)));
+}
+
+/* hash_permute_inverse(j, n, seed) -> bigint: the i with hash_permute(i, n, seed) = j */
+PG_FUNCTION_INFO_V1(hash_permute_inverse);
+
+Datum
+hash_permute_inverse(PG_FUNCTION_ARGS)
+{
+    HashlibPermutation perm;
+
+    hashlib_permutation_init(&perm, PG_GETARG_INT64(1), PG_GETARG_INT64(2));
+    hashlib_permutation_check_index(&perm, PG_GETARG_INT64(0));
+    PG_RETURN_INT64((int64) hashlib_permute_inverse(&perm, (uint64) PG_GETARG_INT64(0)));
+}
+
+typedef struct HashlibPermuteSeries
+{
+    HashlibPermutation perm;
+    uint64      next;           /* the next index */
+    uint64      end;            /* one past the last index */
+} HashlibPermuteSeries;
+
+/*
+ * hash_permute_series(n, seed [, start, count]) -> setof bigint:
+ * hash_permute(i, n, seed) for i from start (default 0), for count values
+ * (default all), stopping at n
+ */
+PG_FUNCTION_INFO_V1(hash_permute_series);
+
+Datum
+hash_permute_series(PG_FUNCTION_ARGS)
+{
+    FuncCallContext *funcctx;
+    HashlibPermuteSeries *series;
+
+    if (SRF_IS_FIRSTCALL())
+    {
+        MemoryContext oldcontext;
+
+        funcctx = SRF_FIRSTCALL_INIT();
+        oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+        series = (HashlibPermuteSeries *) palloc(sizeof(HashlibPermuteSeries));
+        hashlib_permutation_init(&series->perm, PG_GETARG_INT64(0), PG_GETARG_INT64(1));
+        series->next = 0;
+        series->end = series->perm.n;
+        if (PG_NARGS() > 2)
+        {
+            int64 start = PG_GETARG_INT64(2);
+            int64 count = PG_GETARG_INT64(3);
+
+            if (start < 0 || count < 0)
+                ereport(ERROR,
+                        (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                         errmsg("start and count must not be negative")));
+            series->next = Min((uint64) start, series->perm.n);
+            series->end = series->next + Min((uint64) count, series->perm.n - series->next);
+        }
+
+        funcctx->user_fctx = series;
+        MemoryContextSwitchTo(oldcontext);
+    }
+
+    funcctx = SRF_PERCALL_SETUP();
+    series = (HashlibPermuteSeries *) funcctx->user_fctx;
+
+    if (series->next < series->end)
+        SRF_RETURN_NEXT(funcctx, Int64GetDatum((int64) hashlib_permute(&series->perm, series->next++)));
+
+    SRF_RETURN_DONE(funcctx);
+}
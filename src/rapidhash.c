@@ -0,0 +1,251 @@
+#include "postgres.h"
+#include "fmgr.h"
+#include "utils/builtins.h"
+#include "mb/pg_wchar.h"
+#include "access/htup_details.h"
+
+#include "hashlib_bucket.h"
+
+/* rapidhash algorithm implementation
+ * Based on rapidhash by Nicolas De Carli, the official successor to wyhash
+ * Released under the BSD 2-Clause License
+ */
+
+/* Default seed used when no seed is supplied */
+#define RAPID_SEED 0xbdd89aa982704029ULL
+
+/* rapidhash default secret parameters */
+static const uint64_t rapid_secret[3] = {
+    0x2d358dccaa6c78a5ULL,
+    0x8bb84b93962eacc9ULL,
+    0x4b33a62ed433d4a3ULL
+};
+
+/* Endian detection */
+#ifndef RAPIDHASH_LITTLE_ENDIAN
+#if defined(_WIN32) || defined(__LITTLE_ENDIAN__) || (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#define RAPIDHASH_LITTLE_ENDIAN 1
+#elif defined(__BIG_ENDIAN__) || (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+#define RAPIDHASH_LITTLE_ENDIAN 0
+#else
+#warning "Unable to determine endianness, assuming little endian"
+#define RAPIDHASH_LITTLE_ENDIAN 1
+#endif
+#endif
+
+/* Byte reading functions */
+static inline uint64_t
+rapid_read64(const uint8_t *p)
+{
+    uint64_t v;
+    memcpy(&v, p, 8);
+#if RAPIDHASH_LITTLE_ENDIAN
+    return v;
+#else
+    return __builtin_bswap64(v);
+#endif
+}
+
+static inline uint64_t
+rapid_read32(const uint8_t *p)
+{
+    uint32_t v;
+    memcpy(&v, p, 4);
+#if RAPIDHASH_LITTLE_ENDIAN
+    return v;
+#else
+    return __builtin_bswap32(v);
+#endif
+}
+
+static inline uint64_t
+rapid_readSmall(const uint8_t *p, size_t k)
+{
+    return (((uint64_t)p[0]) << 56) | (((uint64_t)p[k >> 1]) << 32) | p[k - 1];
+}
+
+/* 128-bit multiplication function */
+static inline void
+rapid_mum(uint64_t *A, uint64_t *B)
+{
+#ifdef __SIZEOF_INT128__
+    __uint128_t r = *A;
+    r *= *B;
+    *A = (uint64_t)r;
+    *B = (uint64_t)(r >> 64);
+#else
+    /* Fallback for systems without 128-bit integers */
+    uint64_t ha = *A >> 32, hb = *B >> 32, la = (uint32_t)*A, lb = (uint32_t)*B, hi, lo;
+    uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb, t = rl + (rm0 << 32), c = t < rl;
+    lo = t + (rm1 << 32);
+    c += lo < t;
+    hi = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+    *A = lo;
+    *B = hi;
+#endif
+}
+
+/* Mixing function */
+static inline uint64_t
+rapid_mix(uint64_t A, uint64_t B)
+{
+    rapid_mum(&A, &B);
+    return A ^ B;
+}
+
+/* Main rapidhash function */
+static uint64_t
+rapidhash(const void *key, size_t len, uint64_t seed, const uint64_t *secret)
+{
+    const uint8_t *p = (const uint8_t *)key;
+    uint64_t a, b;
+
+    seed ^= rapid_mix(seed ^ secret[0], secret[1]) ^ len;
+
+    if (len <= 16)
+    {
+        if (len >= 4)
+        {
+            const uint8_t *plast = p + len - 4;
+            const uint64_t delta = ((len & 24) >> (len >> 3));
+            a = (rapid_read32(p) << 32) | rapid_read32(plast);
+            b = (rapid_read32(p + delta) << 32) | rapid_read32(plast - delta);
+        }
+        else if (len > 0)
+        {
+            a = rapid_readSmall(p, len);
+            b = 0;
+        }
+        else
+        {
+            a = b = 0;
+        }
+    }
+    else
+    {
+        size_t i = len;
+        if (i > 48)
+        {
+            uint64_t see1 = seed, see2 = seed;
+            do
+            {
+                seed = rapid_mix(rapid_read64(p) ^ secret[0], rapid_read64(p + 8) ^ seed);
+                see1 = rapid_mix(rapid_read64(p + 16) ^ secret[1], rapid_read64(p + 24) ^ see1);
+                see2 = rapid_mix(rapid_read64(p + 32) ^ secret[2], rapid_read64(p + 40) ^ see2);
+                p += 48;
+                i -= 48;
+            } while (i >= 48);
+            seed ^= see1 ^ see2;
+        }
+        if (i > 16)
+        {
+            seed = rapid_mix(rapid_read64(p) ^ secret[2], rapid_read64(p + 8) ^ seed ^ secret[1]);
+            if (i > 32)
+                seed = rapid_mix(rapid_read64(p + 16) ^ secret[2], rapid_read64(p + 24) ^ seed);
+        }
+        a = rapid_read64(p + i - 16);
+        b = rapid_read64(p + i - 8);
+    }
+
+    a ^= secret[1];
+    b ^= seed;
+    rapid_mum(&a, &b);
+    return rapid_mix(a ^ secret[0] ^ len, b ^ secret[1]);
+}
+
+/* hash_bucket support: rapidhash with the default seed and secret */
+static uint64
+rapidhash_bucket_hash(const void *data, size_t len)
+{
+    return rapidhash(data, len, RAPID_SEED, rapid_secret);
+}
+
+const HashlibBucketHasher rapidhash_bucket_hasher = {
+    "rapidhash", rapidhash_bucket_hash
+};
+
+/* PostgreSQL function wrappers */
+
+/* rapidhash(text) -> bigint */
+PG_FUNCTION_INFO_V1(rapidhash_text);
+Datum
+rapidhash_text(PG_FUNCTION_ARGS)
+{
+    text *input = PG_GETARG_TEXT_PP(0);
+    uint64_t hash = rapidhash(VARDATA_ANY(input), VARSIZE_ANY_EXHDR(input), RAPID_SEED, rapid_secret);
+    PG_RETURN_INT64((int64_t)hash);
+}
+
+/* rapidhash(text, bigint) -> bigint */
+PG_FUNCTION_INFO_V1(rapidhash_text_seed);
+Datum
+rapidhash_text_seed(PG_FUNCTION_ARGS)
+{
+    text *input = PG_GETARG_TEXT_PP(0);
+    uint64_t seed = (uint64_t)PG_GETARG_INT64(1);
+    uint64_t hash = rapidhash(VARDATA_ANY(input), VARSIZE_ANY_EXHDR(input), seed, rapid_secret);
+    PG_RETURN_INT64((int64_t)hash);
+}
+
+/* rapidhash(bytea) -> bigint */
+PG_FUNCTION_INFO_V1(rapidhash_bytea);
+Datum
+rapidhash_bytea(PG_FUNCTION_ARGS)
+{
+    bytea *input = PG_GETARG_BYTEA_PP(0);
+    uint64_t hash = rapidhash(VARDATA_ANY(input), VARSIZE_ANY_EXHDR(input), RAPID_SEED, rapid_secret);
+    PG_RETURN_INT64((int64_t)hash);
+}
+
+/* rapidhash(bytea, bigint) -> bigint */
+PG_FUNCTION_INFO_V1(rapidhash_bytea_seed);
+Datum
+rapidhash_bytea_seed(PG_FUNCTION_ARGS)
+{
+    bytea *input = PG_GETARG_BYTEA_PP(0);
+    uint64_t seed = (uint64_t)PG_GETARG_INT64(1);
+    uint64_t hash = rapidhash(VARDATA_ANY(input), VARSIZE_ANY_EXHDR(input), seed, rapid_secret);
+    PG_RETURN_INT64((int64_t)hash);
+}
+
+/* rapidhash(integer) -> bigint */
+PG_FUNCTION_INFO_V1(rapidhash_int4);
+Datum
+rapidhash_int4(PG_FUNCTION_ARGS)
+{
+    int32 val = PG_GETARG_INT32(0);
+    uint64_t hash = rapidhash(&val, sizeof(int32), RAPID_SEED, rapid_secret);
+    PG_RETURN_INT64((int64_t)hash);
+}
+
+/* rapidhash(integer, bigint) -> bigint */
+PG_FUNCTION_INFO_V1(rapidhash_int4_seed);
+Datum
+rapidhash_int4_seed(PG_FUNCTION_ARGS)
+{
+    int32 val = PG_GETARG_INT32(0);
+    uint64_t seed = (uint64_t)PG_GETARG_INT64(1);
+    uint64_t hash = rapidhash(&val, sizeof(int32), seed, rapid_secret);
+    PG_RETURN_INT64((int64_t)hash);
+}
+
+/* rapidhash(bigint) -> bigint */
+PG_FUNCTION_INFO_V1(rapidhash_int8);
+Datum
+rapidhash_int8(PG_FUNCTION_ARGS)
+{
+    int64 val = PG_GETARG_INT64(0);
+    uint64_t hash = rapidhash(&val, sizeof(int64), RAPID_SEED, rapid_secret);
+    PG_RETURN_INT64((int64_t)hash);
+}
+
+/* rapidhash(bigint, bigint) -> bigint */
+PG_FUNCTION_INFO_V1(rapidhash_int8_seed);
+Datum
+rapidhash_int8_seed(PG_FUNCTION_ARGS)
+{
+    int64 val = PG_GETARG_INT64(0);
+    uint64_t seed = (uint64_t)PG_GETARG_INT64(1);
+    uint64_t hash = rapidhash(&val, sizeof(int64), seed, rapid_secret);
+    PG_RETURN_INT64((int64_t)hash);
+}
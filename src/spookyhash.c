@@ -6,6 +6,9 @@
 #include "utils/array.h"
 #include "catalog/pg_type.h"
 
+#include "hashlib_state.h"
+#include "hashlib_toast.h"
+
 /* SpookyHash constants */
 static const uint64_t sc_const = 0xdeadbeefdeadbeefULL;
 
@@ -202,16 +205,55 @@ spookyhash_64(const void *message, size_t length, uint64_t seed)
     return hash1;
 }
 
+static void spooky_stream_update(HashlibState *state, const uint8_t *input, size_t len);
+static void spooky_stream_final(const HashlibState *state, uint64_t *hash1, uint64_t *hash2);
+static HashlibState *spooky_stream_init(uint64_t seed1, uint64_t seed2);
+
+static void
+spooky_stream_update_cb(void *arg, const uint8 *input, size_t len)
+{
+    spooky_stream_update((HashlibState *)arg, input, len);
+}
+
+/*
+ * SpookyHash128 of a text or bytea datum, streaming large out-of-line values.
+ * hash1 and hash2 hold the seeds on entry, as for spookyhash_128.
+ */
+static void
+spookyhash_128_datum(Datum value, uint64_t *hash1, uint64_t *hash2)
+{
+    bytea *input;
+    HashlibState *state;
+
+    if (hashlib_datum_streamable(value))
+    {
+        state = spooky_stream_init(*hash1, *hash2);
+        hashlib_stream_datum(value, spooky_stream_update_cb, state);
+        spooky_stream_final(state, hash1, hash2);
+        pfree(state);
+        return;
+    }
+
+    input = DatumGetByteaPP(value);
+    spookyhash_128(VARDATA_ANY(input), VARSIZE_ANY_EXHDR(input), hash1, hash2);
+}
+
+static uint64_t
+spookyhash_64_datum(Datum value, uint64_t seed)
+{
+    uint64_t hash1 = seed;
+    uint64_t hash2 = seed;
+    spookyhash_128_datum(value, &hash1, &hash2);
+    return hash1;
+}
+
 /* SpookyHash64 for text input with default seed */
 PG_FUNCTION_INFO_V1(spookyhash64_text);
 
 Datum
 spookyhash64_text(PG_FUNCTION_ARGS)
 {
-    text *input = PG_GETARG_TEXT_PP(0);
-    char *data = VARDATA_ANY(input);
-    int len = VARSIZE_ANY_EXHDR(input);
-    uint64_t hash = spookyhash_64(data, len, 0);
+    uint64_t hash = spookyhash_64_datum(PG_GETARG_DATUM(0), 0);
     PG_RETURN_INT64((int64_t)hash);
 }
 
@@ -221,11 +263,8 @@ PG_FUNCTION_INFO_V1(spookyhash64_text_seed);
 Datum
 spookyhash64_text_seed(PG_FUNCTION_ARGS)
 {
-    text *input = PG_GETARG_TEXT_PP(0);
     int64_t seed = PG_GETARG_INT64(1);
-    char *data = VARDATA_ANY(input);
-    int len = VARSIZE_ANY_EXHDR(input);
-    uint64_t hash = spookyhash_64(data, len, (uint64_t)seed);
+    uint64_t hash = spookyhash_64_datum(PG_GETARG_DATUM(0), (uint64_t)seed);
     PG_RETURN_INT64((int64_t)hash);
 }
 
@@ -235,10 +274,7 @@ PG_FUNCTION_INFO_V1(spookyhash64_bytea);
 Datum
 spookyhash64_bytea(PG_FUNCTION_ARGS)
 {
-    bytea *input = PG_GETARG_BYTEA_PP(0);
-    char *data = VARDATA_ANY(input);
-    int len = VARSIZE_ANY_EXHDR(input);
-    uint64_t hash = spookyhash_64(data, len, 0);
+    uint64_t hash = spookyhash_64_datum(PG_GETARG_DATUM(0), 0);
     PG_RETURN_INT64((int64_t)hash);
 }
 
@@ -248,11 +284,8 @@ PG_FUNCTION_INFO_V1(spookyhash64_bytea_seed);
 Datum
 spookyhash64_bytea_seed(PG_FUNCTION_ARGS)
 {
-    bytea *input = PG_GETARG_BYTEA_PP(0);
     int64_t seed = PG_GETARG_INT64(1);
-    char *data = VARDATA_ANY(input);
-    int len = VARSIZE_ANY_EXHDR(input);
-    uint64_t hash = spookyhash_64(data, len, (uint64_t)seed);
+    uint64_t hash = spookyhash_64_datum(PG_GETARG_DATUM(0), (uint64_t)seed);
     PG_RETURN_INT64((int64_t)hash);
 }
 
@@ -285,9 +318,6 @@ PG_FUNCTION_INFO_V1(spookyhash128_text);
 Datum
 spookyhash128_text(PG_FUNCTION_ARGS)
 {
-    text *input = PG_GETARG_TEXT_PP(0);
-    char *data = VARDATA_ANY(input);
-    int len = VARSIZE_ANY_EXHDR(input);
     uint64_t hash1 = 0, hash2 = 0;
     
     Datum elems[2];
@@ -295,7 +325,7 @@ spookyhash128_text(PG_FUNCTION_ARGS)
     int dims[1];
     int lbs[1];
     
-    spookyhash_128(data, len, &hash1, &hash2);
+    spookyhash_128_datum(PG_GETARG_DATUM(0), &hash1, &hash2);
     
     elems[0] = Int64GetDatum((int64_t)hash1);
     elems[1] = Int64GetDatum((int64_t)hash2);
@@ -315,11 +345,8 @@ PG_FUNCTION_INFO_V1(spookyhash128_text_seed);
 Datum
 spookyhash128_text_seed(PG_FUNCTION_ARGS)
 {
-    text *input = PG_GETARG_TEXT_PP(0);
     int64_t seed1 = PG_GETARG_INT64(1);
     int64_t seed2 = PG_GETARG_INT64(2);
-    char *data = VARDATA_ANY(input);
-    int len = VARSIZE_ANY_EXHDR(input);
     uint64_t hash1 = (uint64_t)seed1, hash2 = (uint64_t)seed2;
     
     Datum elems[2];
@@ -327,7 +354,7 @@ spookyhash128_text_seed(PG_FUNCTION_ARGS)
     int dims[1];
     int lbs[1];
     
-    spookyhash_128(data, len, &hash1, &hash2);
+    spookyhash_128_datum(PG_GETARG_DATUM(0), &hash1, &hash2);
     
     elems[0] = Int64GetDatum((int64_t)hash1);
     elems[1] = Int64GetDatum((int64_t)hash2);
@@ -347,9 +374,6 @@ PG_FUNCTION_INFO_V1(spookyhash128_bytea);
 Datum
 spookyhash128_bytea(PG_FUNCTION_ARGS)
 {
-    bytea *input = PG_GETARG_BYTEA_PP(0);
-    char *data = VARDATA_ANY(input);
-    int len = VARSIZE_ANY_EXHDR(input);
     uint64_t hash1 = 0, hash2 = 0;
     
     Datum elems[2];
@@ -357,7 +381,7 @@ spookyhash128_bytea(PG_FUNCTION_ARGS)
     int dims[1];
     int lbs[1];
     
-    spookyhash_128(data, len, &hash1, &hash2);
+    spookyhash_128_datum(PG_GETARG_DATUM(0), &hash1, &hash2);
     
     elems[0] = Int64GetDatum((int64_t)hash1);
     elems[1] = Int64GetDatum((int64_t)hash2);
@@ -377,11 +401,8 @@ PG_FUNCTION_INFO_V1(spookyhash128_bytea_seed);
 Datum
 spookyhash128_bytea_seed(PG_FUNCTION_ARGS)
 {
-    bytea *input = PG_GETARG_BYTEA_PP(0);
     int64_t seed1 = PG_GETARG_INT64(1);
     int64_t seed2 = PG_GETARG_INT64(2);
-    char *data = VARDATA_ANY(input);
-    int len = VARSIZE_ANY_EXHDR(input);
     uint64_t hash1 = (uint64_t)seed1, hash2 = (uint64_t)seed2;
     
     Datum elems[2];
@@ -389,7 +410,7 @@ spookyhash128_bytea_seed(PG_FUNCTION_ARGS)
     int dims[1];
     int lbs[1];
     
-    spookyhash_128(data, len, &hash1, &hash2);
+    spookyhash_128_datum(PG_GETARG_DATUM(0), &hash1, &hash2);
     
     elems[0] = Int64GetDatum((int64_t)hash1);
     elems[1] = Int64GetDatum((int64_t)hash2);
@@ -459,4 +480,204 @@ spookyhash128_int_seed(PG_FUNCTION_ARGS)
                                INT8OID, 8, true, 'd');
     
     PG_RETURN_ARRAYTYPE_P(result);
-}
\ No newline at end of file
+}
+/*
+ * Streaming SpookyHash over a hashlib_state.
+ *
+ * Inputs shorter than 192 bytes are kept whole so that the final step can
+ * take the Short() path; after that, 96-byte blocks are mixed as they fill.
+ */
+
+static void
+spooky_stream_block(uint64 *h, const uint8_t *block)
+{
+    uint64_t data[12];
+    int i;
+
+    memcpy(data, block, sizeof(data));
+    for (i = 0; i < 12; i++)
+        h[i] += data[i];
+    EndPartial((uint64_t *)&h[0], (uint64_t *)&h[1], (uint64_t *)&h[2], (uint64_t *)&h[3],
+               (uint64_t *)&h[4], (uint64_t *)&h[5], (uint64_t *)&h[6], (uint64_t *)&h[7],
+               (uint64_t *)&h[8], (uint64_t *)&h[9], (uint64_t *)&h[10], (uint64_t *)&h[11]);
+}
+
+static void
+spooky_stream_absorb(HashlibState *state, const uint8_t *input, size_t len)
+{
+    if (state->buffered > 0)
+    {
+        size_t fill = Min(96 - (size_t)state->buffered, len);
+
+        memcpy(state->buf + state->buffered, input, fill);
+        state->buffered += fill;
+        input += fill;
+        len -= fill;
+        if (state->buffered < 96)
+            return;
+        spooky_stream_block(state->words, state->buf);
+        state->buffered = 0;
+    }
+
+    while (len >= 96)
+    {
+        spooky_stream_block(state->words, input);
+        input += 96;
+        len -= 96;
+    }
+
+    memcpy(state->buf, input, len);
+    state->buffered = (uint16)len;
+}
+
+static void
+spooky_stream_update(HashlibState *state, const uint8_t *input, size_t len)
+{
+    uint8_t pending[HASHLIB_SPOOKY_BUFFER];
+    size_t npending;
+    uint64 *h = state->words;
+
+    if (state->total_len + len < HASHLIB_SPOOKY_BUFFER)
+    {
+        memcpy(state->buf + state->buffered, input, len);
+        state->buffered += len;
+        state->total_len += len;
+        return;
+    }
+
+    if (state->total_len < HASHLIB_SPOOKY_BUFFER)
+    {
+        /* switching to the long-input path: replay what was buffered */
+        npending = state->buffered;
+        memcpy(pending, state->buf, npending);
+        h[0] = h[3] = h[6] = h[9] = h[12];
+        h[1] = h[4] = h[7] = h[10] = h[13];
+        h[2] = h[5] = h[8] = h[11] = sc_const;
+        state->buffered = 0;
+        spooky_stream_absorb(state, pending, npending);
+    }
+
+    state->total_len += len;
+    spooky_stream_absorb(state, input, len);
+}
+
+static void
+spooky_stream_final(const HashlibState *state, uint64_t *hash1, uint64_t *hash2)
+{
+    uint64_t h0, h1, h2, h3, h4, h5, h6, h7, h8, h9, h10, h11;
+    uint64_t buf[12];
+    const uint64 *h = state->words;
+
+    *hash1 = h[12];
+    *hash2 = h[13];
+    if (state->total_len < HASHLIB_SPOOKY_BUFFER)
+    {
+        spookyhash_128(state->buf, (size_t)state->total_len, hash1, hash2);
+        return;
+    }
+
+    h0 = h[0]; h1 = h[1]; h2 = h[2]; h3 = h[3];
+    h4 = h[4]; h5 = h[5]; h6 = h[6]; h7 = h[7];
+    h8 = h[8]; h9 = h[9]; h10 = h[10]; h11 = h[11];
+
+    /* handle the last partial block of 96 bytes, as spookyhash_128 does */
+    memcpy(buf, state->buf, state->buffered);
+    memset(((uint8_t *)buf) + state->buffered, 0, 96 - state->buffered);
+    ((uint8_t *)buf)[95] = (uint8_t)state->buffered;
+
+    h0 += buf[0]; h1 += buf[1]; h2 += buf[2]; h3 += buf[3];
+    h4 += buf[4]; h5 += buf[5]; h6 += buf[6]; h7 += buf[7];
+    h8 += buf[8]; h9 += buf[9]; h10+= buf[10]; h11+= buf[11];
+    End(buf, &h0,&h1,&h2,&h3,&h4,&h5,&h6,&h7,&h8,&h9,&h10,&h11);
+
+    *hash1 = h0;
+    *hash2 = h1;
+}
+
+static HashlibState *
+spooky_stream_init(uint64_t seed1, uint64_t seed2)
+{
+    HashlibState *state = hashlib_state_create(HASHLIB_STATE_SPOOKY);
+
+    state->words[12] = seed1;
+    state->words[13] = seed2;
+    return state;
+}
+
+/* spooky_init() -> hashlib_state with default seed */
+PG_FUNCTION_INFO_V1(spooky_init);
+
+Datum
+spooky_init(PG_FUNCTION_ARGS)
+{
+    PG_RETURN_HASHLIB_STATE_P(spooky_stream_init(0, 0));
+}
+
+/* spooky_init(seed) -> hashlib_state, matching spookyhash64(data, seed) */
+PG_FUNCTION_INFO_V1(spooky_init_seed);
+
+Datum
+spooky_init_seed(PG_FUNCTION_ARGS)
+{
+    int64_t seed = PG_GETARG_INT64(0);
+    PG_RETURN_HASHLIB_STATE_P(spooky_stream_init((uint64_t)seed, (uint64_t)seed));
+}
+
+/* spooky_init(seed1, seed2) -> hashlib_state, matching spookyhash128(data, seed1, seed2) */
+PG_FUNCTION_INFO_V1(spooky_init_seeds);
+
+Datum
+spooky_init_seeds(PG_FUNCTION_ARGS)
+{
+    int64_t seed1 = PG_GETARG_INT64(0);
+    int64_t seed2 = PG_GETARG_INT64(1);
+    PG_RETURN_HASHLIB_STATE_P(spooky_stream_init((uint64_t)seed1, (uint64_t)seed2));
+}
+
+/* spooky_update(state, bytea/text) -> hashlib_state */
+PG_FUNCTION_INFO_V1(spooky_update);
+
+Datum
+spooky_update(PG_FUNCTION_ARGS)
+{
+    HashlibState *state = hashlib_state_copy(PG_GETARG_HASHLIB_STATE_P(0));
+    bytea *input = PG_GETARG_BYTEA_PP(1);
+
+    hashlib_state_check(state, HASHLIB_STATE_SPOOKY, "spooky_update");
+    spooky_stream_update(state, (const uint8_t *)VARDATA_ANY(input), VARSIZE_ANY_EXHDR(input));
+    PG_RETURN_HASHLIB_STATE_P(state);
+}
+
+/* spooky_final(state) -> bigint, equal to spookyhash64 of all input */
+PG_FUNCTION_INFO_V1(spooky_final);
+
+Datum
+spooky_final(PG_FUNCTION_ARGS)
+{
+    HashlibState *state = PG_GETARG_HASHLIB_STATE_P(0);
+    uint64_t hash1, hash2;
+
+    hashlib_state_check(state, HASHLIB_STATE_SPOOKY, "spooky_final");
+    spooky_stream_final(state, &hash1, &hash2);
+    PG_RETURN_INT64((int64_t)hash1);
+}
+
+/* spooky_final128(state) -> bigint[], equal to spookyhash128 of all input */
+PG_FUNCTION_INFO_V1(spooky_final128);
+
+Datum
+spooky_final128(PG_FUNCTION_ARGS)
+{
+    HashlibState *state = PG_GETARG_HASHLIB_STATE_P(0);
+    uint64_t hash1, hash2;
+    Datum elems[2];
+    ArrayType *result;
+
+    hashlib_state_check(state, HASHLIB_STATE_SPOOKY, "spooky_final128");
+    spooky_stream_final(state, &hash1, &hash2);
+
+    elems[0] = Int64GetDatum((int64_t)hash1);
+    elems[1] = Int64GetDatum((int64_t)hash2);
+    result = construct_array(elems, 2, INT8OID, 8, true, 'd');
+    PG_RETURN_ARRAYTYPE_P(result);
+}
@@ -0,0 +1,228 @@
+#include "postgres.h"
+#include "fmgr.h"
+#include "access/tsmapi.h"
+#include "catalog/pg_type.h"
+#include "nodes/execnodes.h"
+#include "optimizer/optimizer.h"
+#include "utils/rel.h"
+
+#include <math.h>
+
+#include "hashlib_sketch.h"
+
+/*
+ * Deterministic hash-based TABLESAMPLE methods:
+ *
+ *   TABLESAMPLE hashlib_block(percent, seed)
+ *   TABLESAMPLE hashlib_row(percent, seed)
+ *
+ * hashlib_block reads only the sampled blocks, so its I/O scales with the
+ * sample rate; hashlib_row reads every block and samples the tuples in them.
+ *
+ * A block is sampled when the xxhash3_64 of (table OID, block number, seed),
+ * as 16 bytes (le32 OID, le32 block, le64 seed), lies in the lowest percent
+ * of the 64-bit range.  A row is sampled likewise with the hash of 20 bytes
+ * (le32 OID, le32 block, le32 offset, le64 seed).  The table OID, unlike its
+ * relfilenode, survives VACUUM FULL, CLUSTER and TRUNCATE, and it is the
+ * same on physical replicas, so the same blocks and tuples are sampled on
+ * every run and on every replica.  The seed is an argument, so REPEATABLE is
+ * not needed and has no effect.
+ */
+
+typedef struct HashlibSampler
+{
+    uint32      relid;
+    uint64      seed;
+    uint64      cutoff;         /* hashes >> 11 below cutoff are sampled */
+    BlockNumber nextblock;      /* next block to hash (hashlib_block) */
+    OffsetNumber lt;            /* last tuple returned from the block */
+} HashlibSampler;
+
+/* The sampled fraction of the constant percent argument, or 10% if unknown */
+static double
+hashlib_sample_fraction(PlannerInfo *root, List *paramexprs)
+{
+    Node *pctnode = estimate_expression_value(root, (Node *) linitial(paramexprs));
+
+    if (IsA(pctnode, Const) && !((Const *) pctnode)->constisnull)
+    {
+        float4 percent = DatumGetFloat4(((Const *) pctnode)->constvalue);
+
+        if (percent >= 0 && percent <= 100 && !isnan(percent))
+            return percent / 100.0;
+    }
+    return 0.1;
+}
+
+static void
+hashlib_block_samplescangetsamplesize(PlannerInfo *root, RelOptInfo *baserel,
+                                      List *paramexprs, BlockNumber *pages, double *tuples)
+{
+    double fraction = hashlib_sample_fraction(root, paramexprs);
+
+    *pages = (BlockNumber) clamp_row_est(baserel->pages * fraction);
+    *tuples = clamp_row_est(baserel->tuples * fraction);
+}
+
+static void
+hashlib_row_samplescangetsamplesize(PlannerInfo *root, RelOptInfo *baserel,
+                                    List *paramexprs, BlockNumber *pages, double *tuples)
+{
+    /* every block is read */
+    *pages = baserel->pages;
+    *tuples = clamp_row_est(baserel->tuples * hashlib_sample_fraction(root, paramexprs));
+}
+
+static void
+hashlib_initsamplescan(SampleScanState *node, int eflags)
+{
+    node->tsm_state = palloc0(sizeof(HashlibSampler));
+}
+
+static void
+hashlib_sampler_begin(SampleScanState *node, Datum *params)
+{
+    HashlibSampler *sampler = (HashlibSampler *) node->tsm_state;
+    double percent = DatumGetFloat4(params[0]);
+
+    if (percent < 0 || percent > 100 || isnan(percent))
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_TABLESAMPLE_ARGUMENT),
+                 errmsg("sample percentage must be between 0 and 100")));
+
+    /* compare the top 53 bits, so that 100% is a cutoff of 2^53 */
+    sampler->cutoff = (uint64) rint((double) (UINT64CONST(1) << 53) * percent / 100);
+    sampler->relid = RelationGetRelid(node->ss.ss_currentRelation);
+    sampler->seed = (uint64) DatumGetInt64(params[1]);
+    sampler->nextblock = 0;
+    sampler->lt = InvalidOffsetNumber;
+}
+
+static void
+hashlib_block_beginsamplescan(SampleScanState *node, Datum *params, int nparams, uint32 seed)
+{
+    hashlib_sampler_begin(node, params);
+
+    /* as for SYSTEM: bulk reads unless the sample is small */
+    node->use_bulkread = DatumGetFloat4(params[0]) >= 1;
+    node->use_pagemode = true;
+}
+
+static void
+hashlib_row_beginsamplescan(SampleScanState *node, Datum *params, int nparams, uint32 seed)
+{
+    hashlib_sampler_begin(node, params);
+
+    /* as for BERNOULLI: page mode only pays off when many tuples are kept */
+    node->use_bulkread = true;
+    node->use_pagemode = DatumGetFloat4(params[0]) >= 25;
+}
+
+static inline bool
+hashlib_sampled(const HashlibSampler *sampler, uint8 *buf, size_t len)
+{
+    return (hashlib_xxh3_64(buf, len) >> 11) < sampler->cutoff;
+}
+
+/* The next sampled block, or InvalidBlockNumber after the last one */
+static BlockNumber
+hashlib_block_nextsampleblock(SampleScanState *node, BlockNumber nblocks)
+{
+    HashlibSampler *sampler = (HashlibSampler *) node->tsm_state;
+    BlockNumber block;
+    uint8 buf[16];
+
+    hashlib_write_le32(buf, sampler->relid);
+    hashlib_write_le64(buf + 8, sampler->seed);
+    for (block = sampler->nextblock; block < nblocks; block++)
+    {
+        hashlib_write_le32(buf + 4, block);
+        if (hashlib_sampled(sampler, buf, sizeof(buf)))
+        {
+            sampler->nextblock = block + 1;
+            return block;
+        }
+    }
+
+    sampler->nextblock = 0;
+    return InvalidBlockNumber;
+}
+
+/* Every tuple of a sampled block */
+static OffsetNumber
+hashlib_block_nextsampletuple(SampleScanState *node, BlockNumber blockno, OffsetNumber maxoffset)
+{
+    HashlibSampler *sampler = (HashlibSampler *) node->tsm_state;
+    OffsetNumber offset = sampler->lt == InvalidOffsetNumber ? FirstOffsetNumber : sampler->lt + 1;
+
+    if (offset > maxoffset)
+        offset = InvalidOffsetNumber;
+    sampler->lt = offset;
+    return offset;
+}
+
+/* The next sampled tuple of the block */
+static OffsetNumber
+hashlib_row_nextsampletuple(SampleScanState *node, BlockNumber blockno, OffsetNumber maxoffset)
+{
+    HashlibSampler *sampler = (HashlibSampler *) node->tsm_state;
+    OffsetNumber offset = sampler->lt == InvalidOffsetNumber ? FirstOffsetNumber : sampler->lt + 1;
+    uint8 buf[20];
+
+    hashlib_write_le32(buf, sampler->relid);
+    hashlib_write_le32(buf + 4, blockno);
+    hashlib_write_le64(buf + 12, sampler->seed);
+    for (; offset <= maxoffset; offset++)
+    {
+        hashlib_write_le32(buf + 8, offset);
+        if (hashlib_sampled(sampler, buf, sizeof(buf)))
+            break;
+    }
+
+    if (offset > maxoffset)
+        offset = InvalidOffsetNumber;
+    sampler->lt = offset;
+    return offset;
+}
+
+/* hashlib_block(internal) -> tsm_handler */
+PG_FUNCTION_INFO_V1(hashlib_block);
+
+Datum
+hashlib_block(PG_FUNCTION_ARGS)
+{
+    TsmRoutine *tsm = makeNode(TsmRoutine);
+
+    tsm->parameterTypes = list_make2_oid(FLOAT4OID, INT8OID);
+    tsm->repeatable_across_queries = true;
+    tsm->repeatable_across_scans = true;
+    tsm->SampleScanGetSampleSize = hashlib_block_samplescangetsamplesize;
+    tsm->InitSampleScan = hashlib_initsamplescan;
+    tsm->BeginSampleScan = hashlib_block_beginsamplescan;
+    tsm->NextSampleBlock = hashlib_block_nextsampleblock;
+    tsm->NextSampleTuple = hashlib_block_nextsampletuple;
+    tsm->EndSampleScan = NULL;
+
+    PG_RETURN_POINTER(tsm);
+}
+
+/* hashlib_row(internal) -> tsm_handler */
+PG_FUNCTION_INFO_V1(hashlib_row);
+
+Datum
+hashlib_row(PG_FUNCTION_ARGS)
+{
+    TsmRoutine *tsm = makeNode(TsmRoutine);
+
+    tsm->parameterTypes = list_make2_oid(FLOAT4OID, INT8OID);
+    tsm->repeatable_across_queries = true;
+    tsm->repeatable_across_scans = true;
+    tsm->SampleScanGetSampleSize = hashlib_row_samplescangetsamplesize;
+    tsm->InitSampleScan = hashlib_initsamplescan;
+    tsm->BeginSampleScan = hashlib_row_beginsamplescan;
+    tsm->NextSampleBlock = NULL;
+    tsm->NextSampleTuple = hashlib_row_nextsampletuple;
+    tsm->EndSampleScan = NULL;
+
+    PG_RETURN_POINTER(tsm);
+}
@@ -0,0 +1,606 @@
+#include "postgres.h"
+#include "fmgr.h"
+#include "utils/builtins.h"
+#include "mb/pg_wchar.h"
+#include "access/htup_details.h"
+#include "libpq/pqformat.h"
+
+#include <math.h>
+
+#include "hashlib_sketch.h"
+
+/*
+ * Theta (KMV) sketch: the k smallest distinct 64-bit hash values of a set.
+ *
+ * theta is an exclusive upper bound on the retained hashes, as a fraction
+ * theta / 2^64 of the hash space.  While fewer than k distinct hashes have
+ * been seen theta is 2^64 - 1 (meaning 1.0) and the sketch is exact; after
+ * that theta is the (k+1)-th smallest hash and exactly the hashes below it
+ * are kept.  Every hash below theta of the underlying set is retained, so
+ * the estimate is count / theta, and sketches support set operations: the
+ * result of a union, intersection or difference uses the smallest theta of
+ * the inputs and keeps the hashes below it that belong to the result.
+ *
+ * Stored layout (integers little-endian):
+ *
+ *   byte 0       format version (1)
+ *   bytes 1-3    reserved (0)
+ *   bytes 4-7    k
+ *   bytes 8-15   theta
+ *   then         the retained hashes, 8 bytes each, strictly increasing,
+ *                all below theta, at most k of them
+ *
+ * While aggregating, hashes below theta are appended to a buffer of 2k
+ * entries that is sorted, deduplicated and cut back to k when full.
+ */
+
+#define THETA_VERSION           1
+#define THETA_HEADER_SIZE       16
+
+#define THETA_MIN_K             16
+#define THETA_MAX_K             (1 << 20)
+#define THETA_DEFAULT_K         4096
+
+#define THETA_MAX               PG_UINT64_MAX
+
+typedef struct ThetaState
+{
+    int         k;
+    uint64      theta;
+    uint64     *values;         /* retained hashes, sorted up to nsorted */
+    int         nvalues;
+    int         nsorted;
+    int         capacity;
+} ThetaState;
+
+static void
+theta_check_k(int32 k)
+{
+    if (k < THETA_MIN_K || k > THETA_MAX_K)
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("theta sketch size must be between %d and %d",
+                        THETA_MIN_K, THETA_MAX_K)));
+}
+
+static ThetaState *
+theta_state_create(MemoryContext context, int k, int capacity)
+{
+    ThetaState *state = (ThetaState *) MemoryContextAllocZero(context, sizeof(ThetaState));
+
+    state->k = k;
+    state->theta = THETA_MAX;
+    state->capacity = Max(capacity, 1);
+    state->values = (uint64 *) MemoryContextAlloc(context, sizeof(uint64) * state->capacity);
+    return state;
+}
+
+static int
+theta_value_cmp(const void *a, const void *b)
+{
+    uint64 x = *(const uint64 *) a;
+    uint64 y = *(const uint64 *) b;
+
+    return x < y ? -1 : x > y ? 1 : 0;
+}
+
+/* Sort and deduplicate the values, keep the k smallest and lower theta */
+static void
+theta_state_compact(ThetaState *state)
+{
+    int n = 0;
+    int i;
+
+    if (state->nsorted == state->nvalues)
+        return;
+
+    qsort(state->values, state->nvalues, sizeof(uint64), theta_value_cmp);
+    for (i = 0; i < state->nvalues; i++)
+    {
+        if (state->values[i] >= state->theta)
+            break;
+        if (n == 0 || state->values[n - 1] != state->values[i])
+            state->values[n++] = state->values[i];
+    }
+
+    if (n > state->k)
+    {
+        state->theta = state->values[state->k];
+        n = state->k;
+    }
+    state->nvalues = n;
+    state->nsorted = n;
+}
+
+static void
+theta_state_add(ThetaState *state, uint64 hash)
+{
+    if (hash >= state->theta)
+        return;
+
+    if (state->nvalues == state->capacity)
+    {
+        theta_state_compact(state);
+        /* a buffer that is mostly retained values grows, up to twice k */
+        if (state->nvalues > state->capacity / 2)
+        {
+            state->capacity = Min(state->capacity * 2, 2 * state->k);
+            state->values = (uint64 *) repalloc(state->values, sizeof(uint64) * state->capacity);
+        }
+        if (hash >= state->theta)
+            return;
+    }
+    state->values[state->nvalues++] = hash;
+}
+
+/* Union other into state */
+static void
+theta_state_union(ThetaState *state, ThetaState *other)
+{
+    int i;
+
+    theta_state_compact(other);
+    state->k = Min(state->k, other->k);
+    state->theta = Min(state->theta, other->theta);
+    for (i = 0; i < other->nvalues; i++)
+        theta_state_add(state, other->values[i]);
+    /* apply the new k and theta to the values that were already there */
+    state->nsorted = 0;
+    theta_state_compact(state);
+}
+
+/* Intersect (or, with difference, subtract) other from state */
+static void
+theta_state_filter(ThetaState *state, ThetaState *other, bool difference)
+{
+    int n = 0;
+    int i;
+    int j = 0;
+
+    theta_state_compact(state);
+    theta_state_compact(other);
+
+    state->theta = Min(state->theta, other->theta);
+    if (!difference)
+        state->k = Min(state->k, other->k);
+
+    for (i = 0; i < state->nvalues && state->values[i] < state->theta; i++)
+    {
+        while (j < other->nvalues && other->values[j] < state->values[i])
+            j++;
+        if ((j < other->nvalues && other->values[j] == state->values[i]) != difference)
+            state->values[n++] = state->values[i];
+    }
+    state->nvalues = n;
+    state->nsorted = n;
+}
+
+static bytea *
+theta_state_serialize(ThetaState *state)
+{
+    bytea *result;
+    uint8 *data;
+    Size size;
+    int i;
+
+    theta_state_compact(state);
+    size = THETA_HEADER_SIZE + (Size) state->nvalues * 8;
+    result = (bytea *) palloc(VARHDRSZ + size);
+    SET_VARSIZE(result, VARHDRSZ + size);
+    data = (uint8 *) VARDATA(result);
+    data[0] = THETA_VERSION;
+    data[1] = data[2] = data[3] = 0;
+    hashlib_write_le32(data + 4, (uint32) state->k);
+    hashlib_write_le64(data + 8, state->theta);
+    for (i = 0; i < state->nvalues; i++)
+        hashlib_write_le64(data + THETA_HEADER_SIZE + 8 * i, state->values[i]);
+    return result;
+}
+
+static void
+theta_invalid(void)
+{
+    ereport(ERROR,
+            (errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+             errmsg("invalid theta sketch")));
+}
+
+static void
+theta_validate(const bytea *sketch)
+{
+    const uint8 *data = (const uint8 *) VARDATA_ANY(sketch);
+    Size size = VARSIZE_ANY_EXHDR(sketch);
+    uint32 k;
+    uint64 theta;
+    uint64 previous = 0;
+    Size count;
+    Size i;
+
+    if (size < THETA_HEADER_SIZE || (size - THETA_HEADER_SIZE) % 8 != 0 ||
+        data[0] != THETA_VERSION || data[1] != 0 || data[2] != 0 || data[3] != 0)
+        theta_invalid();
+
+    k = hashlib_read_le32(data + 4);
+    theta = hashlib_read_le64(data + 8);
+    count = (size - THETA_HEADER_SIZE) / 8;
+    if (k < THETA_MIN_K || k > THETA_MAX_K || count > k)
+        theta_invalid();
+
+    for (i = 0; i < count; i++)
+    {
+        uint64 value = hashlib_read_le64(data + THETA_HEADER_SIZE + 8 * i);
+
+        if (value >= theta || (i > 0 && value <= previous))
+            theta_invalid();
+        previous = value;
+    }
+}
+
+static ThetaState *
+theta_state_load(MemoryContext context, const bytea *sketch)
+{
+    const uint8 *data = (const uint8 *) VARDATA_ANY(sketch);
+    int count = (int) ((VARSIZE_ANY_EXHDR(sketch) - THETA_HEADER_SIZE) / 8);
+    ThetaState *state = theta_state_create(context, (int) hashlib_read_le32(data + 4), count);
+    int i;
+
+    state->theta = hashlib_read_le64(data + 8);
+    for (i = 0; i < count; i++)
+        state->values[i] = hashlib_read_le64(data + THETA_HEADER_SIZE + 8 * i);
+    state->nvalues = count;
+    state->nsorted = count;
+    return state;
+}
+
+static ThetaState *
+theta_getarg_state(FunctionCallInfo fcinfo, int argno)
+{
+    bytea *sketch = PG_GETARG_BYTEA_PP(argno);
+
+    theta_validate(sketch);
+    return theta_state_load(CurrentMemoryContext, sketch);
+}
+
+/* Fraction of the hash space below theta */
+static double
+theta_fraction(const ThetaState *state)
+{
+    if (state->theta == THETA_MAX)
+        return 1.0;
+    return (double) state->theta / 18446744073709551616.0;
+}
+
+static double
+theta_estimate_value(const ThetaState *state)
+{
+    return (double) state->nvalues / theta_fraction(state);
+}
+
+/*
+ * Approximate bound num_std_devs standard deviations from the estimate.  The
+ * retained count is Binomial(n, p) for a set of n distinct values and
+ * p = theta, which gives a standard deviation of sqrt(count * (1 - p)) / p
+ * for the estimate; a count of zero is treated as one so an empty result
+ * still gets an upper bound.  The lower bound is never below the retained
+ * count, and both bounds equal the estimate while the sketch is exact.
+ */
+static double
+theta_bound(const ThetaState *state, int32 num_std_devs, bool upper)
+{
+    double p = theta_fraction(state);
+    double estimate = theta_estimate_value(state);
+    double deviation;
+
+    if (num_std_devs < 1 || num_std_devs > 3)
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("number of standard deviations must be 1, 2 or 3")));
+
+    if (p == 1.0)
+        return estimate;
+
+    deviation = num_std_devs * sqrt(Max(state->nvalues, 1) * (1.0 - p)) / p;
+    if (upper)
+        return estimate + deviation;
+    return Max(estimate - deviation, (double) state->nvalues);
+}
+
+/* theta_sketch_in(cstring) -> theta_sketch */
+PG_FUNCTION_INFO_V1(theta_sketch_in);
+
+Datum
+theta_sketch_in(PG_FUNCTION_ARGS)
+{
+    bytea *sketch = (bytea *) hashlib_sketch_from_hex(PG_GETARG_CSTRING(0), "theta_sketch");
+
+    theta_validate(sketch);
+    PG_RETURN_BYTEA_P(sketch);
+}
+
+/* theta_sketch_out(theta_sketch) -> cstring */
+PG_FUNCTION_INFO_V1(theta_sketch_out);
+
+Datum
+theta_sketch_out(PG_FUNCTION_ARGS)
+{
+    PG_RETURN_CSTRING(hashlib_sketch_to_hex((struct varlena *) PG_GETARG_BYTEA_PP(0)));
+}
+
+/* theta_sketch_recv(internal) -> theta_sketch */
+PG_FUNCTION_INFO_V1(theta_sketch_recv);
+
+Datum
+theta_sketch_recv(PG_FUNCTION_ARGS)
+{
+    bytea *sketch = (bytea *) hashlib_sketch_recv((StringInfo) PG_GETARG_POINTER(0));
+
+    theta_validate(sketch);
+    PG_RETURN_BYTEA_P(sketch);
+}
+
+/* theta_sketch_send(theta_sketch) -> bytea */
+PG_FUNCTION_INFO_V1(theta_sketch_send);
+
+Datum
+theta_sketch_send(PG_FUNCTION_ARGS)
+{
+    bytea *sketch = PG_GETARG_BYTEA_PP(0);
+    StringInfoData buf;
+
+    pq_begintypsend(&buf);
+    pq_sendbytes(&buf, VARDATA_ANY(sketch), VARSIZE_ANY_EXHDR(sketch));
+    PG_RETURN_BYTEA_P(pq_endtypsend(&buf));
+}
+
+/* theta_sketch(bytea) -> theta_sketch: checks the stored layout, for the bytea cast */
+PG_FUNCTION_INFO_V1(theta_sketch_from_bytea);
+
+Datum
+theta_sketch_from_bytea(PG_FUNCTION_ARGS)
+{
+    bytea *sketch = PG_GETARG_BYTEA_P_COPY(0);
+
+    theta_validate(sketch);
+    PG_RETURN_BYTEA_P(sketch);
+}
+
+/* theta_union(theta_sketch, theta_sketch) -> theta_sketch */
+PG_FUNCTION_INFO_V1(theta_union);
+
+Datum
+theta_union(PG_FUNCTION_ARGS)
+{
+    ThetaState *state = theta_getarg_state(fcinfo, 0);
+
+    theta_state_union(state, theta_getarg_state(fcinfo, 1));
+    PG_RETURN_BYTEA_P(theta_state_serialize(state));
+}
+
+/* theta_intersect(theta_sketch, theta_sketch) -> theta_sketch */
+PG_FUNCTION_INFO_V1(theta_intersect);
+
+Datum
+theta_intersect(PG_FUNCTION_ARGS)
+{
+    ThetaState *state = theta_getarg_state(fcinfo, 0);
+
+    theta_state_filter(state, theta_getarg_state(fcinfo, 1), false);
+    PG_RETURN_BYTEA_P(theta_state_serialize(state));
+}
+
+/* theta_a_not_b(theta_sketch, theta_sketch) -> theta_sketch */
+PG_FUNCTION_INFO_V1(theta_a_not_b);
+
+Datum
+theta_a_not_b(PG_FUNCTION_ARGS)
+{
+    ThetaState *state = theta_getarg_state(fcinfo, 0);
+
+    theta_state_filter(state, theta_getarg_state(fcinfo, 1), true);
+    PG_RETURN_BYTEA_P(theta_state_serialize(state));
+}
+
+/* theta_estimate(theta_sketch) -> double precision */
+PG_FUNCTION_INFO_V1(theta_estimate);
+
+Datum
+theta_estimate(PG_FUNCTION_ARGS)
+{
+    PG_RETURN_FLOAT8(theta_estimate_value(theta_getarg_state(fcinfo, 0)));
+}
+
+/* theta_lower_bound(theta_sketch, integer) -> double precision */
+PG_FUNCTION_INFO_V1(theta_lower_bound);
+
+Datum
+theta_lower_bound(PG_FUNCTION_ARGS)
+{
+    PG_RETURN_FLOAT8(theta_bound(theta_getarg_state(fcinfo, 0), PG_GETARG_INT32(1), false));
+}
+
+/* theta_upper_bound(theta_sketch, integer) -> double precision */
+PG_FUNCTION_INFO_V1(theta_upper_bound);
+
+Datum
+theta_upper_bound(PG_FUNCTION_ARGS)
+{
+    PG_RETURN_FLOAT8(theta_bound(theta_getarg_state(fcinfo, 0), PG_GETARG_INT32(1), true));
+}
+
+/* theta_retained(theta_sketch) -> integer: number of hashes kept */
+PG_FUNCTION_INFO_V1(theta_retained);
+
+Datum
+theta_retained(PG_FUNCTION_ARGS)
+{
+    bytea *sketch = PG_GETARG_BYTEA_PP(0);
+
+    theta_validate(sketch);
+    PG_RETURN_INT32((int32) ((VARSIZE_ANY_EXHDR(sketch) - THETA_HEADER_SIZE) / 8));
+}
+
+/* theta_sketch_agg_transfn(internal, bigint [, integer]) -> internal */
+PG_FUNCTION_INFO_V1(theta_sketch_agg_transfn);
+
+Datum
+theta_sketch_agg_transfn(PG_FUNCTION_ARGS)
+{
+    MemoryContext aggcontext;
+    ThetaState *state;
+
+    if (!AggCheckCallContext(fcinfo, &aggcontext))
+        elog(ERROR, "theta_sketch_agg_transfn called in non-aggregate context");
+
+    if (PG_ARGISNULL(0))
+    {
+        int32 k = THETA_DEFAULT_K;
+
+        if (PG_NARGS() > 2 && !PG_ARGISNULL(2))
+            k = PG_GETARG_INT32(2);
+        theta_check_k(k);
+        /* start small; the buffer grows towards 2k as values arrive */
+        state = theta_state_create(aggcontext, k, Min(k, 64));
+    }
+    else
+        state = (ThetaState *) PG_GETARG_POINTER(0);
+
+    if (!PG_ARGISNULL(1))
+        theta_state_add(state, hashlib_mix64((uint64) PG_GETARG_INT64(1)));
+
+    PG_RETURN_POINTER(state);
+}
+
+/* Copy of other in the aggregate context, the first input of a set operation */
+static ThetaState *
+theta_state_copy(MemoryContext context, ThetaState *other)
+{
+    ThetaState *state;
+
+    theta_state_compact(other);
+    state = theta_state_create(context, other->k, Max(other->nvalues, 64));
+    state->theta = other->theta;
+    memcpy(state->values, other->values, sizeof(uint64) * other->nvalues);
+    state->nvalues = other->nvalues;
+    state->nsorted = other->nsorted;
+    return state;
+}
+
+/* theta_union_agg_transfn(internal, theta_sketch) -> internal */
+PG_FUNCTION_INFO_V1(theta_union_agg_transfn);
+
+Datum
+theta_union_agg_transfn(PG_FUNCTION_ARGS)
+{
+    MemoryContext aggcontext;
+    ThetaState *other;
+
+    if (!AggCheckCallContext(fcinfo, &aggcontext))
+        elog(ERROR, "theta_union_agg_transfn called in non-aggregate context");
+
+    if (PG_ARGISNULL(1))
+        PG_RETURN_POINTER(PG_ARGISNULL(0) ? NULL : PG_GETARG_POINTER(0));
+
+    other = theta_getarg_state(fcinfo, 1);
+    if (PG_ARGISNULL(0))
+        PG_RETURN_POINTER(theta_state_copy(aggcontext, other));
+
+    theta_state_union((ThetaState *) PG_GETARG_POINTER(0), other);
+    PG_RETURN_POINTER(PG_GETARG_POINTER(0));
+}
+
+/* theta_intersect_agg_transfn(internal, theta_sketch) -> internal */
+PG_FUNCTION_INFO_V1(theta_intersect_agg_transfn);
+
+Datum
+theta_intersect_agg_transfn(PG_FUNCTION_ARGS)
+{
+    MemoryContext aggcontext;
+    ThetaState *other;
+
+    if (!AggCheckCallContext(fcinfo, &aggcontext))
+        elog(ERROR, "theta_intersect_agg_transfn called in non-aggregate context");
+
+    if (PG_ARGISNULL(1))
+        PG_RETURN_POINTER(PG_ARGISNULL(0) ? NULL : PG_GETARG_POINTER(0));
+
+    other = theta_getarg_state(fcinfo, 1);
+    if (PG_ARGISNULL(0))
+        PG_RETURN_POINTER(theta_state_copy(aggcontext, other));
+
+    theta_state_filter((ThetaState *) PG_GETARG_POINTER(0), other, false);
+    PG_RETURN_POINTER(PG_GETARG_POINTER(0));
+}
+
+/* theta_agg_combine(internal, internal) -> internal: union of partial states */
+PG_FUNCTION_INFO_V1(theta_agg_combine);
+
+Datum
+theta_agg_combine(PG_FUNCTION_ARGS)
+{
+    MemoryContext aggcontext;
+
+    if (!AggCheckCallContext(fcinfo, &aggcontext))
+        elog(ERROR, "theta_agg_combine called in non-aggregate context");
+
+    if (PG_ARGISNULL(1))
+        PG_RETURN_POINTER(PG_ARGISNULL(0) ? NULL : PG_GETARG_POINTER(0));
+    if (PG_ARGISNULL(0))
+        PG_RETURN_POINTER(theta_state_copy(aggcontext, (ThetaState *) PG_GETARG_POINTER(1)));
+
+    theta_state_union((ThetaState *) PG_GETARG_POINTER(0), (ThetaState *) PG_GETARG_POINTER(1));
+    PG_RETURN_POINTER(PG_GETARG_POINTER(0));
+}
+
+/* theta_intersect_agg_combine(internal, internal) -> internal */
+PG_FUNCTION_INFO_V1(theta_intersect_agg_combine);
+
+Datum
+theta_intersect_agg_combine(PG_FUNCTION_ARGS)
+{
+    MemoryContext aggcontext;
+
+    if (!AggCheckCallContext(fcinfo, &aggcontext))
+        elog(ERROR, "theta_intersect_agg_combine called in non-aggregate context");
+
+    /* a worker that saw no sketches contributes nothing */
+    if (PG_ARGISNULL(1))
+        PG_RETURN_POINTER(PG_ARGISNULL(0) ? NULL : PG_GETARG_POINTER(0));
+    if (PG_ARGISNULL(0))
+        PG_RETURN_POINTER(theta_state_copy(aggcontext, (ThetaState *) PG_GETARG_POINTER(1)));
+
+    theta_state_filter((ThetaState *) PG_GETARG_POINTER(0), (ThetaState *) PG_GETARG_POINTER(1), false);
+    PG_RETURN_POINTER(PG_GETARG_POINTER(0));
+}
+
+/* theta_agg_serialize(internal) -> bytea: the stored form */
+PG_FUNCTION_INFO_V1(theta_agg_serialize);
+
+Datum
+theta_agg_serialize(PG_FUNCTION_ARGS)
+{
+    PG_RETURN_BYTEA_P(theta_state_serialize((ThetaState *) PG_GETARG_POINTER(0)));
+}
+
+/* theta_agg_deserialize(bytea, internal) -> internal */
+PG_FUNCTION_INFO_V1(theta_agg_deserialize);
+
+Datum
+theta_agg_deserialize(PG_FUNCTION_ARGS)
+{
+    if (!AggCheckCallContext(fcinfo, NULL))
+        elog(ERROR, "theta_agg_deserialize called in non-aggregate context");
+
+    PG_RETURN_POINTER(theta_getarg_state(fcinfo, 0));
+}
+
+/* theta_agg_final(internal) -> theta_sketch; NULL when there were no rows */
+PG_FUNCTION_INFO_V1(theta_agg_final);
+
+Datum
+theta_agg_final(PG_FUNCTION_ARGS)
+{
+    if (PG_ARGISNULL(0))
+        PG_RETURN_NULL();
+
+    PG_RETURN_BYTEA_P(theta_state_serialize((ThetaState *) PG_GETARG_POINTER(0)));
+}
@@ -0,0 +1,740 @@
+#include "postgres.h"
+#include "fmgr.h"
+#include "utils/builtins.h"
+#include "mb/pg_wchar.h"
+#include "access/htup_details.h"
+#include "libpq/pqformat.h"
+#include "funcapi.h"
+#include "utils/lsyscache.h"
+
+#include "hashlib_datum.h"
+#include "hashlib_sketch.h"
+
+/*
+ * Heavy hitters with the Space-Saving algorithm (Metwally et al., 2005).
+ *
+ * A summary has k counters.  A value that already has a counter increments
+ * it; otherwise it takes a free counter, or when there is none, it replaces
+ * the value with the smallest count m and gets count m + 1 and error m.
+ * Every value's true count lies between count - error and count, and any
+ * value occurring more than total / k times is guaranteed to be kept.
+ *
+ * Values are identified by their canonical bytes (hashlib_datum.h) and found
+ * through an open-addressing table keyed by their XXH3-64, with a min-heap
+ * on count to find the counter to replace.  The text output form of a value
+ * is kept alongside, made only when the value gets a counter.
+ *
+ * Summaries are merged as in Agarwal et al., "Mergeable Summaries" (2012):
+ * a value missing from a full summary is given that summary's smallest
+ * count as both count and error, the counts are added, and the k largest
+ * are kept.
+ *
+ * Stored layout (integers little-endian):
+ *
+ *   byte 0       format version (1)
+ *   bytes 1-3    reserved (0)
+ *   bytes 4-7    k
+ *   bytes 8-15   total count of values
+ *   bytes 16-19  number of items n (at most k)
+ *   then n items, largest count first:
+ *     8 bytes count, 8 bytes error, 4 bytes key length, key bytes,
+ *     4 bytes text length, text bytes
+ */
+
+#define TOPK_VERSION            1
+#define TOPK_HEADER_SIZE        20
+
+#define TOPK_MAX_K              100000
+
+typedef struct TopkItem
+{
+    uint64      hash;
+    int64       count;
+    int64       error;
+    char       *key;            /* canonical bytes */
+    int         keylen;
+    char       *text;           /* output form, NUL-terminated */
+    int         heap_pos;
+} TopkItem;
+
+typedef struct TopkState
+{
+    MemoryContext context;      /* where everything below lives */
+    int         k;
+    int         nitems;
+    int64       total;
+    TopkItem   *items;          /* k items */
+    int        *heap;           /* item indexes, min-heap on count */
+    int        *table;          /* item index or -1, probed linearly */
+    uint32      table_mask;
+    /* transition function only: output function of the values */
+    FmgrInfo   *output;
+} TopkState;
+
+static void
+topk_check_k(int32 k)
+{
+    if (k < 1 || k > TOPK_MAX_K)
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("topk size must be between 1 and %d", TOPK_MAX_K)));
+}
+
+static TopkState *
+topk_state_create(MemoryContext context, int k)
+{
+    TopkState *state = (TopkState *) MemoryContextAllocZero(context, sizeof(TopkState));
+    uint32 table_size = 16;
+
+    /* keep the table at most half full */
+    while (table_size < 2 * (uint32) k)
+        table_size *= 2;
+
+    state->context = context;
+    state->k = k;
+    state->items = (TopkItem *) MemoryContextAllocZero(context, sizeof(TopkItem) * k);
+    state->heap = (int *) MemoryContextAlloc(context, sizeof(int) * k);
+    state->table = (int *) MemoryContextAlloc(context, sizeof(int) * table_size);
+    memset(state->table, -1, sizeof(int) * table_size);
+    state->table_mask = table_size - 1;
+    return state;
+}
+
+static void
+topk_state_free(TopkState *state)
+{
+    int i;
+
+    for (i = 0; i < state->nitems; i++)
+    {
+        pfree(state->items[i].key);
+        pfree(state->items[i].text);
+    }
+    pfree(state->items);
+    pfree(state->heap);
+    pfree(state->table);
+}
+
+static int
+topk_find(const TopkState *state, uint64 hash, const char *key, int keylen)
+{
+    uint32 pos = (uint32) hash & state->table_mask;
+
+    while (state->table[pos] >= 0)
+    {
+        const TopkItem *item = &state->items[state->table[pos]];
+
+        if (item->hash == hash && item->keylen == keylen && memcmp(item->key, key, keylen) == 0)
+            return state->table[pos];
+        pos = (pos + 1) & state->table_mask;
+    }
+    return -1;
+}
+
+static void
+topk_table_insert(TopkState *state, int index)
+{
+    uint32 pos = (uint32) state->items[index].hash & state->table_mask;
+
+    while (state->table[pos] >= 0)
+        pos = (pos + 1) & state->table_mask;
+    state->table[pos] = index;
+}
+
+/* Remove an item from the table, shifting later entries of its run back */
+static void
+topk_table_delete(TopkState *state, int index)
+{
+    uint32 mask = state->table_mask;
+    uint32 hole = (uint32) state->items[index].hash & mask;
+    uint32 pos;
+
+    while (state->table[hole] != index)
+        hole = (hole + 1) & mask;
+
+    for (pos = (hole + 1) & mask; state->table[pos] >= 0; pos = (pos + 1) & mask)
+    {
+        uint32 home = (uint32) state->items[state->table[pos]].hash & mask;
+
+        /* move the entry into the hole unless its home lies after the hole */
+        if (((pos - home) & mask) >= ((pos - hole) & mask))
+        {
+            state->table[hole] = state->table[pos];
+            hole = pos;
+        }
+    }
+    state->table[hole] = -1;
+}
+
+static void
+topk_heap_swap(TopkState *state, int a, int b)
+{
+    int ia = state->heap[a];
+    int ib = state->heap[b];
+
+    state->heap[a] = ib;
+    state->heap[b] = ia;
+    state->items[ib].heap_pos = a;
+    state->items[ia].heap_pos = b;
+}
+
+static void
+topk_heap_up(TopkState *state, int pos)
+{
+    while (pos > 0)
+    {
+        int parent = (pos - 1) / 2;
+
+        if (state->items[state->heap[parent]].count <= state->items[state->heap[pos]].count)
+            break;
+        topk_heap_swap(state, pos, parent);
+        pos = parent;
+    }
+}
+
+static void
+topk_heap_down(TopkState *state, int pos)
+{
+    for (;;)
+    {
+        int smallest = pos;
+        int child = 2 * pos + 1;
+
+        if (child < state->nitems &&
+            state->items[state->heap[child]].count < state->items[state->heap[smallest]].count)
+            smallest = child;
+        child++;
+        if (child < state->nitems &&
+            state->items[state->heap[child]].count < state->items[state->heap[smallest]].count)
+            smallest = child;
+        if (smallest == pos)
+            break;
+        topk_heap_swap(state, pos, smallest);
+        pos = smallest;
+    }
+}
+
+static void
+topk_increment(TopkState *state, int index, int64 count)
+{
+    state->items[index].count += count;
+    topk_heap_down(state, state->items[index].heap_pos);
+}
+
+/*
+ * Give a value that has no counter one, replacing the smallest when all are
+ * taken.  key and text are copied.
+ */
+static void
+topk_insert(TopkState *state, uint64 hash, const char *key, int keylen,
+            const char *text, int64 count, int64 error)
+{
+    TopkItem *item;
+    int index;
+
+    if (state->nitems < state->k)
+    {
+        index = state->nitems++;
+        item = &state->items[index];
+        item->heap_pos = index;
+        state->heap[index] = index;
+    }
+    else
+    {
+        index = state->heap[0];
+        item = &state->items[index];
+        topk_table_delete(state, index);
+        count += item->count;
+        error += item->count;
+        pfree(item->key);
+        pfree(item->text);
+    }
+
+    item->hash = hash;
+    item->count = count;
+    item->error = error;
+    item->keylen = keylen;
+    item->key = MemoryContextAlloc(state->context, Max(keylen, 1));
+    memcpy(item->key, key, keylen);
+    item->text = MemoryContextStrdup(state->context, text);
+    topk_table_insert(state, index);
+    topk_heap_up(state, item->heap_pos);
+    topk_heap_down(state, item->heap_pos);
+}
+
+/* Largest count first; ties by key so the order does not depend on history */
+static int
+topk_item_cmp(const void *a, const void *b)
+{
+    const TopkItem *x = (const TopkItem *) a;
+    const TopkItem *y = (const TopkItem *) b;
+    int cmp;
+
+    if (x->count != y->count)
+        return x->count > y->count ? -1 : 1;
+    if (x->error != y->error)
+        return x->error < y->error ? -1 : 1;
+    cmp = memcmp(x->key, y->key, Min(x->keylen, y->keylen));
+    if (cmp != 0)
+        return cmp;
+    return x->keylen < y->keylen ? -1 : x->keylen > y->keylen ? 1 : 0;
+}
+
+static int64
+topk_state_min(const TopkState *state)
+{
+    return state->nitems < state->k ? 0 : state->items[state->heap[0]].count;
+}
+
+/* Merge other into state, keeping the smaller k */
+static void
+topk_state_merge(TopkState *state, TopkState *other)
+{
+    int64 state_min = topk_state_min(state);
+    int64 other_min = topk_state_min(other);
+    int k = Min(state->k, other->k);
+    TopkItem *merged;
+    int nmerged = 0;
+    TopkState *result;
+    MemoryContext context = state->context;
+    int i;
+
+    merged = (TopkItem *) palloc(sizeof(TopkItem) * (state->nitems + other->nitems + 1));
+    for (i = 0; i < state->nitems; i++)
+    {
+        TopkItem item = state->items[i];
+        int match = topk_find(other, item.hash, item.key, item.keylen);
+
+        if (match >= 0)
+        {
+            item.count += other->items[match].count;
+            item.error += other->items[match].error;
+        }
+        else
+        {
+            item.count += other_min;
+            item.error += other_min;
+        }
+        merged[nmerged++] = item;
+    }
+    for (i = 0; i < other->nitems; i++)
+    {
+        TopkItem item = other->items[i];
+
+        if (topk_find(state, item.hash, item.key, item.keylen) >= 0)
+            continue;
+        item.count += state_min;
+        item.error += state_min;
+        merged[nmerged++] = item;
+    }
+    qsort(merged, nmerged, sizeof(TopkItem), topk_item_cmp);
+
+    result = topk_state_create(context, k);
+    for (i = 0; i < Min(nmerged, k); i++)
+        topk_insert(result, merged[i].hash, merged[i].key, merged[i].keylen,
+                    merged[i].text, merged[i].count, merged[i].error);
+    pfree(merged);
+
+    topk_state_free(state);
+    state->k = k;
+    state->nitems = result->nitems;
+    state->total += other->total;
+    state->items = result->items;
+    state->heap = result->heap;
+    state->table = result->table;
+    state->table_mask = result->table_mask;
+    pfree(result);
+}
+
+static bytea *
+topk_state_serialize(TopkState *state)
+{
+    TopkItem *items = (TopkItem *) palloc(sizeof(TopkItem) * Max(state->nitems, 1));
+    Size size = TOPK_HEADER_SIZE;
+    bytea *result;
+    uint8 *p;
+    int i;
+
+    memcpy(items, state->items, sizeof(TopkItem) * state->nitems);
+    qsort(items, state->nitems, sizeof(TopkItem), topk_item_cmp);
+    for (i = 0; i < state->nitems; i++)
+        size += 24 + items[i].keylen + strlen(items[i].text);
+
+    result = (bytea *) palloc(VARHDRSZ + size);
+    SET_VARSIZE(result, VARHDRSZ + size);
+    p = (uint8 *) VARDATA(result);
+    p[0] = TOPK_VERSION;
+    p[1] = p[2] = p[3] = 0;
+    hashlib_write_le32(p + 4, (uint32) state->k);
+    hashlib_write_le64(p + 8, (uint64) state->total);
+    hashlib_write_le32(p + 16, (uint32) state->nitems);
+    p += TOPK_HEADER_SIZE;
+    for (i = 0; i < state->nitems; i++)
+    {
+        Size textlen = strlen(items[i].text);
+
+        hashlib_write_le64(p, (uint64) items[i].count);
+        hashlib_write_le64(p + 8, (uint64) items[i].error);
+        hashlib_write_le32(p + 16, (uint32) items[i].keylen);
+        memcpy(p + 20, items[i].key, items[i].keylen);
+        p += 20 + items[i].keylen;
+        hashlib_write_le32(p, (uint32) textlen);
+        memcpy(p + 4, items[i].text, textlen);
+        p += 4 + textlen;
+    }
+    pfree(items);
+    return result;
+}
+
+static void
+topk_invalid(void)
+{
+    ereport(ERROR,
+            (errcode(ERRCODE_INVALID_BINARY_REPRESENTATION),
+             errmsg("invalid topk summary")));
+}
+
+/*
+ * Check a stored summary; with a state, also load its items into it.  The
+ * items must be in the stored order, largest count first.
+ */
+static TopkState *
+topk_parse(MemoryContext context, const bytea *topk, bool load)
+{
+    const uint8 *p = (const uint8 *) VARDATA_ANY(topk);
+    const uint8 *end = p + VARSIZE_ANY_EXHDR(topk);
+    TopkState *state = NULL;
+    uint32 k;
+    uint32 n;
+    int64 total;
+    int64 previous = PG_INT64_MAX;
+    uint32 i;
+
+    if (end - p < TOPK_HEADER_SIZE || p[0] != TOPK_VERSION || p[1] != 0 || p[2] != 0 || p[3] != 0)
+        topk_invalid();
+    k = hashlib_read_le32(p + 4);
+    total = (int64) hashlib_read_le64(p + 8);
+    n = hashlib_read_le32(p + 16);
+    if (k < 1 || k > TOPK_MAX_K || n > k || total < 0)
+        topk_invalid();
+
+    if (load)
+    {
+        state = topk_state_create(context, (int) k);
+        state->total = total;
+    }
+
+    p += TOPK_HEADER_SIZE;
+    for (i = 0; i < n; i++)
+    {
+        int64 count;
+        int64 error;
+        uint32 keylen;
+        uint32 textlen;
+        const uint8 *key;
+        char *text;
+
+        if (end - p < 20)
+            topk_invalid();
+        count = (int64) hashlib_read_le64(p);
+        error = (int64) hashlib_read_le64(p + 8);
+        keylen = hashlib_read_le32(p + 16);
+        if (count < 1 || count > previous || error < 0 || error >= count ||
+            (uint64) (end - p - 20) < (uint64) keylen + 4)
+            topk_invalid();
+        key = p + 20;
+        p += 20 + keylen;
+        textlen = hashlib_read_le32(p);
+        if ((uint64) (end - p - 4) < textlen || memchr(p + 4, '\0', textlen) != NULL)
+            topk_invalid();
+        previous = count;
+
+        if (load)
+        {
+            uint64 hash = hashlib_xxh3_64(key, keylen);
+
+            if (topk_find(state, hash, (const char *) key, (int) keylen) >= 0)
+                topk_invalid();
+            text = pnstrdup((const char *) p + 4, textlen);
+            topk_insert(state, hash, (const char *) key, (int) keylen, text, count, error);
+            pfree(text);
+        }
+        p += 4 + textlen;
+    }
+    if (p != end)
+        topk_invalid();
+
+    return state;
+}
+
+/* topk_in(cstring) -> topk */
+PG_FUNCTION_INFO_V1(topk_in);
+
+Datum
+topk_in(PG_FUNCTION_ARGS)
+{
+    bytea *topk = (bytea *) hashlib_sketch_from_hex(PG_GETARG_CSTRING(0), "topk");
+
+    topk_parse(CurrentMemoryContext, topk, true);
+    PG_RETURN_BYTEA_P(topk);
+}
+
+/* topk_out(topk) -> cstring */
+PG_FUNCTION_INFO_V1(topk_out);
+
+Datum
+topk_out(PG_FUNCTION_ARGS)
+{
+    PG_RETURN_CSTRING(hashlib_sketch_to_hex((struct varlena *) PG_GETARG_BYTEA_PP(0)));
+}
+
+/* topk_recv(internal) -> topk */
+PG_FUNCTION_INFO_V1(topk_recv);
+
+Datum
+topk_recv(PG_FUNCTION_ARGS)
+{
+    bytea *topk = (bytea *) hashlib_sketch_recv((StringInfo) PG_GETARG_POINTER(0));
+
+    topk_parse(CurrentMemoryContext, topk, true);
+    PG_RETURN_BYTEA_P(topk);
+}
+
+/* topk_send(topk) -> bytea */
+PG_FUNCTION_INFO_V1(topk_send);
+
+Datum
+topk_send(PG_FUNCTION_ARGS)
+{
+    bytea *topk = PG_GETARG_BYTEA_PP(0);
+    StringInfoData buf;
+
+    pq_begintypsend(&buf);
+    pq_sendbytes(&buf, VARDATA_ANY(topk), VARSIZE_ANY_EXHDR(topk));
+    PG_RETURN_BYTEA_P(pq_endtypsend(&buf));
+}
+
+/* topk_total(topk) -> bigint: number of values summarized */
+PG_FUNCTION_INFO_V1(topk_total);
+
+Datum
+topk_total(PG_FUNCTION_ARGS)
+{
+    bytea *topk = PG_GETARG_BYTEA_PP(0);
+
+    topk_parse(CurrentMemoryContext, topk, false);
+    PG_RETURN_INT64((int64) hashlib_read_le64((const uint8 *) VARDATA_ANY(topk) + 8));
+}
+
+/* topk_union(topk, topk) -> topk */
+PG_FUNCTION_INFO_V1(topk_union);
+
+Datum
+topk_union(PG_FUNCTION_ARGS)
+{
+    TopkState *state = topk_parse(CurrentMemoryContext, PG_GETARG_BYTEA_PP(0), true);
+
+    topk_state_merge(state, topk_parse(CurrentMemoryContext, PG_GETARG_BYTEA_PP(1), true));
+    PG_RETURN_BYTEA_P(topk_state_serialize(state));
+}
+
+/*
+ * topk_items(topk [, n]) -> setof (value text, count bigint, error bigint):
+ * the items, largest count first, optionally only the first n
+ */
+PG_FUNCTION_INFO_V1(topk_items);
+
+Datum
+topk_items(PG_FUNCTION_ARGS)
+{
+    FuncCallContext *funcctx;
+    const uint8 *p;
+
+    if (SRF_IS_FIRSTCALL())
+    {
+        MemoryContext oldcontext;
+        TupleDesc tupdesc;
+        bytea *topk;
+        int32 limit = PG_NARGS() > 1 ? PG_GETARG_INT32(1) : PG_INT32_MAX;
+
+        funcctx = SRF_FIRSTCALL_INIT();
+        oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+        if (limit < 0)
+            ereport(ERROR,
+                    (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                     errmsg("number of topk items cannot be negative")));
+        if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+            elog(ERROR, "return type must be a row type");
+
+        topk = PG_GETARG_BYTEA_P_COPY(0);
+        topk_parse(CurrentMemoryContext, topk, false);
+        funcctx->tuple_desc = BlessTupleDesc(tupdesc);
+        funcctx->max_calls = Min((uint32) limit, hashlib_read_le32((uint8 *) VARDATA(topk) + 16));
+        funcctx->user_fctx = VARDATA(topk) + TOPK_HEADER_SIZE;
+        MemoryContextSwitchTo(oldcontext);
+    }
+
+    funcctx = SRF_PERCALL_SETUP();
+    p = (const uint8 *) funcctx->user_fctx;
+
+    if (funcctx->call_cntr < funcctx->max_calls)
+    {
+        Datum values[3];
+        bool nulls[3] = {false, false, false};
+        uint32 keylen = hashlib_read_le32(p + 16);
+        uint32 textlen = hashlib_read_le32(p + 20 + keylen);
+
+        values[0] = PointerGetDatum(cstring_to_text_with_len((const char *) p + 24 + keylen, textlen));
+        values[1] = Int64GetDatum((int64) hashlib_read_le64(p));
+        values[2] = Int64GetDatum((int64) hashlib_read_le64(p + 8));
+        funcctx->user_fctx = (void *) (p + 24 + keylen + textlen);
+
+        SRF_RETURN_NEXT(funcctx, HeapTupleGetDatum(heap_form_tuple(funcctx->tuple_desc, values, nulls)));
+    }
+
+    SRF_RETURN_DONE(funcctx);
+}
+
+/* topk_agg_transfn(internal, anyelement, integer) -> internal */
+PG_FUNCTION_INFO_V1(topk_agg_transfn);
+
+Datum
+topk_agg_transfn(PG_FUNCTION_ARGS)
+{
+    MemoryContext aggcontext;
+    TopkState *state;
+    HashlibTypeIO *io;
+    bytea *bytes;
+    uint64 hash;
+    int index;
+
+    if (!AggCheckCallContext(fcinfo, &aggcontext))
+        elog(ERROR, "topk_agg_transfn called in non-aggregate context");
+
+    if (PG_ARGISNULL(0))
+    {
+        Oid typoutput;
+        bool typisvarlena;
+
+        if (PG_ARGISNULL(2))
+            ereport(ERROR,
+                    (errcode(ERRCODE_NULL_VALUE_NOT_ALLOWED),
+                     errmsg("topk size must not be null")));
+        topk_check_k(PG_GETARG_INT32(2));
+        state = topk_state_create(aggcontext, PG_GETARG_INT32(2));
+
+        getTypeOutputInfo(get_fn_expr_argtype(fcinfo->flinfo, 1), &typoutput, &typisvarlena);
+        state->output = (FmgrInfo *) MemoryContextAlloc(aggcontext, sizeof(FmgrInfo));
+        fmgr_info_cxt(typoutput, state->output, aggcontext);
+    }
+    else
+        state = (TopkState *) PG_GETARG_POINTER(0);
+
+    if (PG_ARGISNULL(1))
+        PG_RETURN_POINTER(state);
+
+    io = hashlib_arg_type_io(fcinfo, 1);
+    bytes = hashlib_value_bytes(io, PG_GETARG_DATUM(1));
+    hash = hashlib_xxh3_64(VARDATA(bytes), VARSIZE(bytes) - VARHDRSZ);
+    state->total++;
+
+    index = topk_find(state, hash, VARDATA(bytes), VARSIZE(bytes) - VARHDRSZ);
+    if (index >= 0)
+        topk_increment(state, index, 1);
+    else
+    {
+        char *text = OutputFunctionCall(state->output, PG_GETARG_DATUM(1));
+
+        topk_insert(state, hash, VARDATA(bytes), VARSIZE(bytes) - VARHDRSZ, text, 1, 0);
+        pfree(text);
+    }
+    pfree(bytes);
+
+    PG_RETURN_POINTER(state);
+}
+
+/* topk_union_agg_transfn(internal, topk) -> internal */
+PG_FUNCTION_INFO_V1(topk_union_agg_transfn);
+
+Datum
+topk_union_agg_transfn(PG_FUNCTION_ARGS)
+{
+    MemoryContext aggcontext;
+    TopkState *other;
+
+    if (!AggCheckCallContext(fcinfo, &aggcontext))
+        elog(ERROR, "topk_union_agg_transfn called in non-aggregate context");
+
+    if (PG_ARGISNULL(1))
+        PG_RETURN_POINTER(PG_ARGISNULL(0) ? NULL : PG_GETARG_POINTER(0));
+
+    if (PG_ARGISNULL(0))
+        PG_RETURN_POINTER(topk_parse(aggcontext, PG_GETARG_BYTEA_PP(1), true));
+
+    other = topk_parse(CurrentMemoryContext, PG_GETARG_BYTEA_PP(1), true);
+    topk_state_merge((TopkState *) PG_GETARG_POINTER(0), other);
+    PG_RETURN_POINTER(PG_GETARG_POINTER(0));
+}
+
+/* topk_agg_combine(internal, internal) -> internal */
+PG_FUNCTION_INFO_V1(topk_agg_combine);
+
+Datum
+topk_agg_combine(PG_FUNCTION_ARGS)
+{
+    MemoryContext aggcontext;
+    TopkState *state;
+    TopkState *other;
+
+    if (!AggCheckCallContext(fcinfo, &aggcontext))
+        elog(ERROR, "topk_agg_combine called in non-aggregate context");
+
+    if (PG_ARGISNULL(1))
+        PG_RETURN_POINTER(PG_ARGISNULL(0) ? NULL : PG_GETARG_POINTER(0));
+
+    other = (TopkState *) PG_GETARG_POINTER(1);
+    if (PG_ARGISNULL(0))
+    {
+        /* an empty summary of the same size, which the merge copies into */
+        state = topk_state_create(aggcontext, other->k);
+    }
+    else
+        state = (TopkState *) PG_GETARG_POINTER(0);
+    topk_state_merge(state, other);
+
+    PG_RETURN_POINTER(state);
+}
+
+/* topk_agg_serialize(internal) -> bytea: the stored form */
+PG_FUNCTION_INFO_V1(topk_agg_serialize);
+
+Datum
+topk_agg_serialize(PG_FUNCTION_ARGS)
+{
+    PG_RETURN_BYTEA_P(topk_state_serialize((TopkState *) PG_GETARG_POINTER(0)));
+}
+
+/* topk_agg_deserialize(bytea, internal) -> internal */
+PG_FUNCTION_INFO_V1(topk_agg_deserialize);
+
+Datum
+topk_agg_deserialize(PG_FUNCTION_ARGS)
+{
+    if (!AggCheckCallContext(fcinfo, NULL))
+        elog(ERROR, "topk_agg_deserialize called in non-aggregate context");
+
+    PG_RETURN_POINTER(topk_parse(CurrentMemoryContext, PG_GETARG_BYTEA_PP(0), true));
+}
+
+/* topk_agg_final(internal) -> topk; NULL when there were no rows */
+PG_FUNCTION_INFO_V1(topk_agg_final);
+
+Datum
+topk_agg_final(PG_FUNCTION_ARGS)
+{
+    if (PG_ARGISNULL(0))
+        PG_RETURN_NULL();
+
+    PG_RETURN_BYTEA_P(topk_state_serialize((TopkState *) PG_GETARG_POINTER(0)));
+}
@@ -6,6 +6,8 @@
 #include "mb/pg_wchar.h"
 #include "access/htup_details.h"
 
+#include "hashlib_bucket.h"
+
 /* WyHash algorithm implementation
  * Based on the wyhash algorithm by Wang Yi
  * Released into the public domain under The Unlicense
@@ -175,6 +177,17 @@ get_text_data_and_length(Datum input, Oid input_type, const uint8_t **data, size
     }
 }
 
+/* hash_bucket support: wyhash with seed 0 and the default secret */
+static uint64
+wyhash_bucket_hash(const void *data, size_t len)
+{
+    return wyhash(data, len, 0, _wyp);
+}
+
+const HashlibBucketHasher wyhash_bucket_hasher = {
+    "wyhash", wyhash_bucket_hash
+};
+
 /* wyhash(text) -> bigint */
 PG_FUNCTION_INFO_V1(wyhash_text);
 Datum
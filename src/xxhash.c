@@ -4,6 +4,9 @@
 #include "mb/pg_wchar.h"
 #include "access/htup_details.h"
 
+#include "hashlib_bucket.h"
+#include "hashlib_toast.h"
+
 /* xxHash constants */
 #define XXH32_PRIME_1   0x9E3779B1U
 #define XXH32_PRIME_2   0x85EBCA77U  
@@ -131,6 +134,33 @@ static uint64_t XXH64_avalanche(uint64_t hash)
     return hash;
 }
 
+/* Mix in the last 0..31 bytes and avalanche */
+static uint64_t
+XXH64_finalize(uint64_t h64, const uint8_t* p, size_t len)
+{
+    const uint8_t* const bEnd = p + len;
+
+    while (p + 8 <= bEnd) {
+        uint64_t k1 = XXH64_round(0, XXH_read64(p));
+        h64 ^= k1;
+        h64 = XXH64_rotl(h64, 27) * XXH64_PRIME_1 + XXH64_PRIME_4;
+        p += 8;
+    }
+
+    if (p + 4 <= bEnd) {
+        h64 ^= (uint64_t)(XXH_read32(p)) * XXH64_PRIME_1;
+        h64 = XXH64_rotl(h64, 23) * XXH64_PRIME_2 + XXH64_PRIME_3;
+        p += 4;
+    }
+
+    while (p < bEnd) {
+        h64 ^= (*p++) * XXH64_PRIME_5;
+        h64 = XXH64_rotl(h64, 11) * XXH64_PRIME_1;
+    }
+
+    return XXH64_avalanche(h64);
+}
+
 static uint64_t
 xxhash64(const void* input, size_t len, uint64_t seed)
 {
@@ -164,27 +194,121 @@ xxhash64(const void* input, size_t len, uint64_t seed)
 
     h64 += (uint64_t)len;
 
-    while (p + 8 <= bEnd) {
-        uint64_t k1 = XXH64_round(0, XXH_read64(p));
-        h64 ^= k1;
-        h64 = XXH64_rotl(h64, 27) * XXH64_PRIME_1 + XXH64_PRIME_4;
-        p += 8;
+    return XXH64_finalize(h64, p, (size_t)(bEnd - p));
+}
+
+/* Streaming XXH64, used for large out-of-line values */
+typedef struct {
+    uint64_t v[4];
+    uint64_t seed;
+    uint64_t total_len;
+    uint8_t mem[32];
+    size_t memsize;
+} XXH64_stream;
+
+static void
+XXH64_stream_reset(XXH64_stream* state, uint64_t seed)
+{
+    state->v[0] = seed + XXH64_PRIME_1 + XXH64_PRIME_2;
+    state->v[1] = seed + XXH64_PRIME_2;
+    state->v[2] = seed + 0;
+    state->v[3] = seed - XXH64_PRIME_1;
+    state->seed = seed;
+    state->total_len = 0;
+    state->memsize = 0;
+}
+
+static void
+XXH64_stream_stripe(XXH64_stream* state, const uint8_t* p)
+{
+    state->v[0] = XXH64_round(state->v[0], XXH_read64(p));
+    state->v[1] = XXH64_round(state->v[1], XXH_read64(p + 8));
+    state->v[2] = XXH64_round(state->v[2], XXH_read64(p + 16));
+    state->v[3] = XXH64_round(state->v[3], XXH_read64(p + 24));
+}
+
+static void
+XXH64_stream_update(void* arg, const uint8 *input, size_t len)
+{
+    XXH64_stream* state = (XXH64_stream*)arg;
+    const uint8_t* p = (const uint8_t*)input;
+
+    state->total_len += len;
+
+    if (state->memsize + len < 32) {
+        memcpy(state->mem + state->memsize, p, len);
+        state->memsize += len;
+        return;
     }
 
-    if (p + 4 <= bEnd) {
-        h64 ^= (uint64_t)(XXH_read32(p)) * XXH64_PRIME_1;
-        h64 = XXH64_rotl(h64, 23) * XXH64_PRIME_2 + XXH64_PRIME_3;
-        p += 4;
+    if (state->memsize > 0) {
+        size_t fill = 32 - state->memsize;
+        memcpy(state->mem + state->memsize, p, fill);
+        XXH64_stream_stripe(state, state->mem);
+        p += fill;
+        len -= fill;
+        state->memsize = 0;
     }
 
-    while (p < bEnd) {
-        h64 ^= (*p++) * XXH64_PRIME_5;
-        h64 = XXH64_rotl(h64, 11) * XXH64_PRIME_1;
+    while (len >= 32) {
+        XXH64_stream_stripe(state, p);
+        p += 32;
+        len -= 32;
     }
 
-    return XXH64_avalanche(h64);
+    memcpy(state->mem, p, len);
+    state->memsize = len;
 }
 
+static uint64_t
+XXH64_stream_digest(const XXH64_stream* state)
+{
+    uint64_t h64;
+
+    if (state->total_len >= 32) {
+        h64 = XXH64_rotl(state->v[0], 1) + XXH64_rotl(state->v[1], 7) +
+              XXH64_rotl(state->v[2], 12) + XXH64_rotl(state->v[3], 18);
+        h64 = XXH64_mergeRound(h64, state->v[0]);
+        h64 = XXH64_mergeRound(h64, state->v[1]);
+        h64 = XXH64_mergeRound(h64, state->v[2]);
+        h64 = XXH64_mergeRound(h64, state->v[3]);
+    } else {
+        h64 = state->seed + XXH64_PRIME_5;
+    }
+
+    h64 += state->total_len;
+
+    return XXH64_finalize(h64, state->mem, state->memsize);
+}
+
+/* XXH64 of a text or bytea datum, streaming large out-of-line values */
+static uint64_t
+xxhash64_datum(Datum value, uint64_t seed)
+{
+    bytea *input;
+    XXH64_stream state;
+
+    if (hashlib_datum_streamable(value)) {
+        XXH64_stream_reset(&state, seed);
+        hashlib_stream_datum(value, XXH64_stream_update, &state);
+        return XXH64_stream_digest(&state);
+    }
+
+    input = DatumGetByteaPP(value);
+    return xxhash64(VARDATA_ANY(input), VARSIZE_ANY_EXHDR(input), seed);
+}
+
+/* hash_bucket support: XXH64 with seed 0 */
+static uint64
+xxhash64_bucket_hash(const void *data, size_t len)
+{
+    return xxhash64(data, len, 0);
+}
+
+const HashlibBucketHasher xxhash64_bucket_hasher = {
+    "xxhash64", xxhash64_bucket_hash
+};
+
 /* PostgreSQL function wrappers for XXH32 */
 
 /* XXH32 for text input with default seed */
@@ -272,10 +396,7 @@ PG_FUNCTION_INFO_V1(xxhash64_text);
 Datum
 xxhash64_text(PG_FUNCTION_ARGS)
 {
-    text *input = PG_GETARG_TEXT_PP(0);
-    char *data = VARDATA_ANY(input);
-    int len = VARSIZE_ANY_EXHDR(input);
-    uint64_t hash = xxhash64(data, len, 0);
+    uint64_t hash = xxhash64_datum(PG_GETARG_DATUM(0), 0);
     PG_RETURN_INT64((int64_t)hash);
 }
 
@@ -285,11 +406,8 @@ PG_FUNCTION_INFO_V1(xxhash64_text_seed);
 Datum
 xxhash64_text_seed(PG_FUNCTION_ARGS)
 {
-    text *input = PG_GETARG_TEXT_PP(0);
     int64_t seed = PG_GETARG_INT64(1);
-    char *data = VARDATA_ANY(input);
-    int len = VARSIZE_ANY_EXHDR(input);
-    uint64_t hash = xxhash64(data, len, (uint64_t)seed);
+    uint64_t hash = xxhash64_datum(PG_GETARG_DATUM(0), (uint64_t)seed);
     PG_RETURN_INT64((int64_t)hash);
 }
 
@@ -299,10 +417,7 @@ PG_FUNCTION_INFO_V1(xxhash64_bytea);
 Datum
 xxhash64_bytea(PG_FUNCTION_ARGS)
 {
-    bytea *input = PG_GETARG_BYTEA_PP(0);
-    char *data = VARDATA_ANY(input);
-    int len = VARSIZE_ANY_EXHDR(input);
-    uint64_t hash = xxhash64(data, len, 0);
+    uint64_t hash = xxhash64_datum(PG_GETARG_DATUM(0), 0);
     PG_RETURN_INT64((int64_t)hash);
 }
 
@@ -312,11 +427,8 @@ PG_FUNCTION_INFO_V1(xxhash64_bytea_seed);
 Datum
 xxhash64_bytea_seed(PG_FUNCTION_ARGS)
 {
-    bytea *input = PG_GETARG_BYTEA_PP(0);
     int64_t seed = PG_GETARG_INT64(1);
-    char *data = VARDATA_ANY(input);
-    int len = VARSIZE_ANY_EXHDR(input);
-    uint64_t hash = xxhash64(data, len, (uint64_t)seed);
+    uint64_t hash = xxhash64_datum(PG_GETARG_DATUM(0), (uint64_t)seed);
     PG_RETURN_INT64((int64_t)hash);
 }
 
@@ -3,6 +3,20 @@
 #include "utils/builtins.h"
 #include "mb/pg_wchar.h"
 #include "access/htup_details.h"
+#include "libpq/pqformat.h"
+
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include "hashlib_bucket.h"
+#include "hashlib_datum.h"
+#include "hashlib_file.h"
+#include "hashlib_guc.h"
+#include "hashlib_lo.h"
+#include "hashlib_sketch.h"
+#include "hashlib_state.h"
+#include "hashlib_toast.h"
 
 /* xxHash3 constants */
 #define XXH3_SECRET_SIZE_MIN    136
@@ -46,6 +60,8 @@ static XXH128_hash_t XXH3_mix16B_128b(const uint8_t* input, const uint8_t* secre
 static void XXH3_hashLong_internal_loop(uint64_t* acc, const uint8_t* input, size_t len, const uint8_t* secret, size_t secretSize);
 static uint64_t XXH3_64bits_withSecret(const void* input, size_t len, const void* secret, size_t secretSize);
 static XXH128_hash_t XXH3_128bits_withSecret(const void* input, size_t len, const void* secret, size_t secretSize);
+static uint64_t xxhash3_64_datum(Datum value, uint64_t seed);
+static XXH128_hash_t xxhash3_128_datum(Datum value, uint64_t seed);
 
 /* Default secret array - 192 bytes of pseudorandom data */
 static const uint8_t kSecret[XXH3_SECRET_DEFAULT_SIZE] = {
@@ -322,7 +338,7 @@ static void XXH3_accumulate(uint64_t* acc, const uint8_t* input, const uint8_t*
 static void XXH3_hashLong_internal_loop(uint64_t* acc, const uint8_t* input, size_t len, const uint8_t* secret, size_t secretSize) {
     size_t const nb_rounds = (secretSize - XXH3_STRIPE_LEN) / XXH3_SECRET_CONSUME_RATE;
     size_t const block_len = XXH3_STRIPE_LEN * nb_rounds;
-    size_t const nb_blocks = len / block_len;
+    size_t const nb_blocks = (len - 1) / block_len;
     size_t const nbStripes = ((len - 1) - (block_len * nb_blocks)) / XXH3_STRIPE_LEN;
     
     for (size_t n = 0; n < nb_blocks; n++) {
@@ -542,10 +558,7 @@ PG_FUNCTION_INFO_V1(xxhash3_64_text);
 Datum
 xxhash3_64_text(PG_FUNCTION_ARGS)
 {
-    text *input = PG_GETARG_TEXT_PP(0);
-    char *data = VARDATA_ANY(input);
-    int len = VARSIZE_ANY_EXHDR(input);
-    uint64_t hash = XXH3_64bits(data, len);
+    uint64_t hash = xxhash3_64_datum(PG_GETARG_DATUM(0), 0);
     PG_RETURN_INT64((int64_t)hash);
 }
 
@@ -555,11 +568,8 @@ PG_FUNCTION_INFO_V1(xxhash3_64_text_seed);
 Datum
 xxhash3_64_text_seed(PG_FUNCTION_ARGS)
 {
-    text *input = PG_GETARG_TEXT_PP(0);
     int64_t seed = PG_GETARG_INT64(1);
-    char *data = VARDATA_ANY(input);
-    int len = VARSIZE_ANY_EXHDR(input);
-    uint64_t hash = XXH3_64bits_withSeed(data, len, (uint64_t)seed);
+    uint64_t hash = xxhash3_64_datum(PG_GETARG_DATUM(0), (uint64_t)seed);
     PG_RETURN_INT64((int64_t)hash);
 }
 
@@ -569,10 +579,7 @@ PG_FUNCTION_INFO_V1(xxhash3_64_bytea);
 Datum
 xxhash3_64_bytea(PG_FUNCTION_ARGS)
 {
-    bytea *input = PG_GETARG_BYTEA_PP(0);
-    char *data = VARDATA_ANY(input);
-    int len = VARSIZE_ANY_EXHDR(input);
-    uint64_t hash = XXH3_64bits(data, len);
+    uint64_t hash = xxhash3_64_datum(PG_GETARG_DATUM(0), 0);
     PG_RETURN_INT64((int64_t)hash);
 }
 
@@ -582,11 +589,8 @@ PG_FUNCTION_INFO_V1(xxhash3_64_bytea_seed);
 Datum
 xxhash3_64_bytea_seed(PG_FUNCTION_ARGS)
 {
-    bytea *input = PG_GETARG_BYTEA_PP(0);
     int64_t seed = PG_GETARG_INT64(1);
-    char *data = VARDATA_ANY(input);
-    int len = VARSIZE_ANY_EXHDR(input);
-    uint64_t hash = XXH3_64bits_withSeed(data, len, (uint64_t)seed);
+    uint64_t hash = xxhash3_64_datum(PG_GETARG_DATUM(0), (uint64_t)seed);
     PG_RETURN_INT64((int64_t)hash);
 }
 
@@ -622,10 +626,7 @@ PG_FUNCTION_INFO_V1(xxhash3_128_text);
 Datum
 xxhash3_128_text(PG_FUNCTION_ARGS)
 {
-    text *input = PG_GETARG_TEXT_PP(0);
-    char *data = VARDATA_ANY(input);
-    int len = VARSIZE_ANY_EXHDR(input);
-    XXH128_hash_t hash = XXH3_128bits(data, len);
+    XXH128_hash_t hash = xxhash3_128_datum(PG_GETARG_DATUM(0), 0);
     
     /* Format as hex string: high64:low64 */
     char result[33]; /* 32 chars + null terminator */
@@ -642,11 +643,8 @@ PG_FUNCTION_INFO_V1(xxhash3_128_text_seed);
 Datum
 xxhash3_128_text_seed(PG_FUNCTION_ARGS)
 {
-    text *input = PG_GETARG_TEXT_PP(0);
     int64_t seed = PG_GETARG_INT64(1);
-    char *data = VARDATA_ANY(input);
-    int len = VARSIZE_ANY_EXHDR(input);
-    XXH128_hash_t hash = XXH3_128bits_withSeed(data, len, (uint64_t)seed);
+    XXH128_hash_t hash = xxhash3_128_datum(PG_GETARG_DATUM(0), (uint64_t)seed);
     
     /* Format as hex string: high64:low64 */
     char result[33]; /* 32 chars + null terminator */
@@ -663,10 +661,7 @@ PG_FUNCTION_INFO_V1(xxhash3_128_bytea);
 Datum
 xxhash3_128_bytea(PG_FUNCTION_ARGS)
 {
-    bytea *input = PG_GETARG_BYTEA_PP(0);
-    char *data = VARDATA_ANY(input);
-    int len = VARSIZE_ANY_EXHDR(input);
-    XXH128_hash_t hash = XXH3_128bits(data, len);
+    XXH128_hash_t hash = xxhash3_128_datum(PG_GETARG_DATUM(0), 0);
     
     /* Format as hex string: high64:low64 */
     char result[33]; /* 32 chars + null terminator */
@@ -683,11 +678,8 @@ PG_FUNCTION_INFO_V1(xxhash3_128_bytea_seed);
 Datum
 xxhash3_128_bytea_seed(PG_FUNCTION_ARGS)
 {
-    bytea *input = PG_GETARG_BYTEA_PP(0);
     int64_t seed = PG_GETARG_INT64(1);
-    char *data = VARDATA_ANY(input);
-    int len = VARSIZE_ANY_EXHDR(input);
-    XXH128_hash_t hash = XXH3_128bits_withSeed(data, len, (uint64_t)seed);
+    XXH128_hash_t hash = xxhash3_128_datum(PG_GETARG_DATUM(0), (uint64_t)seed);
     
     /* Format as hex string: high64:low64 */
     char result[33]; /* 32 chars + null terminator */
@@ -733,4 +725,739 @@ xxhash3_128_int_seed(PG_FUNCTION_ARGS)
              (unsigned long long)hash.low64);
     
     PG_RETURN_TEXT_P(cstring_to_text(result));
-}
\ No newline at end of file
+}
+/*
+ * Streaming XXH3 over a hashlib_state.
+ *
+ * Input is buffered until more than HASHLIB_XXH3_BUFFER bytes have arrived,
+ * so short inputs still take the one-shot short/midsize paths.  After that,
+ * stripes are absorbed exactly as XXH3_hashLong_internal_loop would, but only
+ * once it is known that more input follows them; the last stripe is left for
+ * the final step together with a copy of the last absorbed 64 bytes, which
+ * the overlapping last-stripe read may need.
+ */
+
+/* Absorb one stripe that is not the last stripe of the input */
+static void XXH3_stream_stripe(uint64_t* acc, uint64_t* nb_stripes, const uint8_t* stripe) {
+    size_t const nb_rounds = (XXH3_SECRET_DEFAULT_SIZE - XXH3_STRIPE_LEN) / XXH3_SECRET_CONSUME_RATE;
+
+    XXH3_accumulate_512_64b(acc, stripe, kSecret + *nb_stripes * XXH3_SECRET_CONSUME_RATE);
+    if (++(*nb_stripes) == nb_rounds) {
+        XXH3_scrambleAcc(acc, kSecret + XXH3_SECRET_DEFAULT_SIZE - XXH3_STRIPE_LEN);
+        *nb_stripes = 0;
+    }
+}
+
+/* Absorb len bytes (a multiple of the stripe length) and remember the last stripe */
+static void XXH3_stream_consume(HashlibState* state, const uint8_t* input, size_t len) {
+    size_t i;
+
+    for (i = 0; i < len; i += XXH3_STRIPE_LEN) {
+        XXH3_stream_stripe((uint64_t*)state->words, (uint64_t*)&state->words[9], input + i);
+    }
+    memcpy(state->buf + HASHLIB_XXH3_BUFFER, input + len - XXH3_STRIPE_LEN, XXH3_STRIPE_LEN);
+}
+
+static void XXH3_stream_update(HashlibState* state, const uint8_t* input, size_t len) {
+    state->total_len += len;
+
+    if (state->buffered + len <= HASHLIB_XXH3_BUFFER) {
+        memcpy(state->buf + state->buffered, input, len);
+        state->buffered += len;
+        return;
+    }
+
+    /* more input follows the buffered bytes, so they can all be absorbed */
+    if (state->buffered > 0) {
+        size_t const fill = HASHLIB_XXH3_BUFFER - state->buffered;
+        memcpy(state->buf + state->buffered, input, fill);
+        input += fill;
+        len -= fill;
+        XXH3_stream_consume(state, state->buf, HASHLIB_XXH3_BUFFER);
+    }
+
+    /* absorb directly from the input, keeping 1..HASHLIB_XXH3_BUFFER bytes back */
+    if (len > HASHLIB_XXH3_BUFFER) {
+        size_t const n = ((len - 1) / HASHLIB_XXH3_BUFFER) * HASHLIB_XXH3_BUFFER;
+        XXH3_stream_consume(state, input, n);
+        input += n;
+        len -= n;
+    }
+
+    memcpy(state->buf, input, len);
+    state->buffered = (uint16)len;
+}
+
+/* Finish the long-input loop on a copy of the accumulators */
+static void XXH3_stream_digest(const HashlibState* state, uint64_t* acc) {
+    uint64_t nb_stripes = state->words[9];
+    size_t const buffered = state->buffered;
+    uint8_t last_stripe[XXH3_STRIPE_LEN];
+    const uint8_t* p;
+    size_t i;
+
+    memcpy(acc, state->words, sizeof(uint64_t) * XXH3_ACC_NB);
+
+    for (i = 0; i + XXH3_STRIPE_LEN < buffered; i += XXH3_STRIPE_LEN) {
+        XXH3_stream_stripe(acc, &nb_stripes, state->buf + i);
+    }
+
+    if (state->total_len & (XXH3_STRIPE_LEN - 1)) {
+        if (buffered >= XXH3_STRIPE_LEN) {
+            p = state->buf + buffered - XXH3_STRIPE_LEN;
+        } else {
+            memcpy(last_stripe, state->buf + HASHLIB_XXH3_BUFFER + buffered, XXH3_STRIPE_LEN - buffered);
+            memcpy(last_stripe + XXH3_STRIPE_LEN - buffered, state->buf, buffered);
+            p = last_stripe;
+        }
+        XXH3_accumulate_512_64b(acc, p, kSecret + XXH3_SECRET_DEFAULT_SIZE - XXH3_STRIPE_LEN - XXH3_SECRET_LASTACC_START);
+    }
+}
+
+static uint64_t XXH3_stream_final64(const HashlibState* state) {
+    uint64_t acc[XXH3_ACC_NB];
+
+    if (state->total_len <= XXH3_MIDSIZE_MAX) {
+        return XXH3_64bits_withSeed(state->buf, (size_t)state->total_len, state->words[8]);
+    }
+
+    XXH3_stream_digest(state, acc);
+    return XXH3_mergeAccs(acc, kSecret + XXH3_SECRET_MERGEACCS_START, state->total_len * PRIME64_1);
+}
+
+static XXH128_hash_t XXH3_stream_final128(const HashlibState* state) {
+    uint64_t acc[XXH3_ACC_NB];
+    XXH128_hash_t h128;
+
+    if (state->total_len <= XXH3_MIDSIZE_MAX) {
+        return XXH3_128bits_withSeed(state->buf, (size_t)state->total_len, state->words[8]);
+    }
+
+    XXH3_stream_digest(state, acc);
+    h128.low64 = XXH3_mergeAccs(acc, kSecret + XXH3_SECRET_MERGEACCS_START, state->total_len * PRIME64_1);
+    h128.high64 = XXH3_mergeAccs(acc, kSecret + XXH3_SECRET_DEFAULT_SIZE - sizeof(acc) - XXH3_SECRET_MERGEACCS_START,
+                                 ~(state->total_len * PRIME64_2));
+    return h128;
+}
+
+static HashlibState* XXH3_stream_init(uint64_t seed) {
+    static const uint64_t init_acc[XXH3_ACC_NB] = {PRIME32_3, PRIME64_1, PRIME64_2, PRIME64_3, PRIME64_4, PRIME32_2, PRIME64_5, PRIME32_1};
+    HashlibState* state = hashlib_state_create(HASHLIB_STATE_XXH3);
+
+    memcpy(state->words, init_acc, sizeof(init_acc));
+    state->words[8] = seed;
+    return state;
+}
+
+static void XXH3_stream_update_cb(void* arg, const uint8* input, size_t len) {
+    XXH3_stream_update((HashlibState*)arg, input, len);
+}
+
+/* hash_file support: xxhash3_64 with the default seed */
+static void* XXH3_file_start(void) {
+    return XXH3_stream_init(0);
+}
+
+static int64 XXH3_file_finish(void* state) {
+    return (int64)XXH3_stream_final64((HashlibState*)state);
+}
+
+const HashlibFileHasher xxhash3_64_file_hasher = {
+    "xxhash3_64", XXH3_file_start, XXH3_stream_update_cb, XXH3_file_finish
+};
+
+/* hash_bucket support: XXH3-64 with seed 0 */
+static uint64
+xxhash3_64_bucket_hash(const void *data, size_t len)
+{
+    return XXH3_64bits(data, len);
+}
+
+const HashlibBucketHasher xxhash3_64_bucket_hasher = {
+    "xxhash3_64", xxhash3_64_bucket_hash
+};
+
+/* XXH3-64 (seed 0) of a key, for the sketches that hash values themselves */
+uint64
+hashlib_xxh3_64(const void *data, size_t len)
+{
+    return XXH3_64bits(data, len);
+}
+
+/* XXH3-64 with a seed, as xxhash3_64(bytea, bigint) */
+uint64
+hashlib_xxh3_64_seed(const void *data, size_t len, uint64 seed)
+{
+    return XXH3_64bits_withSeed(data, len, seed);
+}
+
+/* XXH3 of a text or bytea datum, streaming large out-of-line values */
+static uint64_t xxhash3_64_datum(Datum value, uint64_t seed) {
+    bytea* input;
+    HashlibState* state;
+    uint64_t hash;
+
+    if (hashlib_datum_streamable(value)) {
+        state = XXH3_stream_init(seed);
+        hashlib_stream_datum(value, XXH3_stream_update_cb, state);
+        hash = XXH3_stream_final64(state);
+        pfree(state);
+        return hash;
+    }
+
+    input = DatumGetByteaPP(value);
+    return XXH3_64bits_withSeed(VARDATA_ANY(input), VARSIZE_ANY_EXHDR(input), seed);
+}
+
+static XXH128_hash_t xxhash3_128_datum(Datum value, uint64_t seed) {
+    bytea* input;
+    HashlibState* state;
+    XXH128_hash_t hash;
+
+    if (hashlib_datum_streamable(value)) {
+        state = XXH3_stream_init(seed);
+        hashlib_stream_datum(value, XXH3_stream_update_cb, state);
+        hash = XXH3_stream_final128(state);
+        pfree(state);
+        return hash;
+    }
+
+    input = DatumGetByteaPP(value);
+    return XXH3_128bits_withSeed(VARDATA_ANY(input), VARSIZE_ANY_EXHDR(input), seed);
+}
+
+/* xxh3_init() -> hashlib_state with default seed */
+PG_FUNCTION_INFO_V1(xxh3_init);
+
+Datum
+xxh3_init(PG_FUNCTION_ARGS)
+{
+    PG_RETURN_HASHLIB_STATE_P(XXH3_stream_init(0));
+}
+
+/* xxh3_init(seed) -> hashlib_state */
+PG_FUNCTION_INFO_V1(xxh3_init_seed);
+
+Datum
+xxh3_init_seed(PG_FUNCTION_ARGS)
+{
+    int64_t seed = PG_GETARG_INT64(0);
+    PG_RETURN_HASHLIB_STATE_P(XXH3_stream_init((uint64_t)seed));
+}
+
+/* xxh3_update(state, bytea/text) -> hashlib_state */
+PG_FUNCTION_INFO_V1(xxh3_update);
+
+Datum
+xxh3_update(PG_FUNCTION_ARGS)
+{
+    HashlibState *state = hashlib_state_copy(PG_GETARG_HASHLIB_STATE_P(0));
+    bytea *input = PG_GETARG_BYTEA_PP(1);
+
+    hashlib_state_check(state, HASHLIB_STATE_XXH3, "xxh3_update");
+    XXH3_stream_update(state, (const uint8_t *)VARDATA_ANY(input), VARSIZE_ANY_EXHDR(input));
+    PG_RETURN_HASHLIB_STATE_P(state);
+}
+
+/*
+ * xxh3_agg_transfn(state, bytea/text) -> hashlib_state, for the ordered
+ * aggregates: each value is framed with its length (see
+ * hashlib_stream_framed_datum) and absorbed into the state in place.
+ */
+PG_FUNCTION_INFO_V1(xxh3_agg_transfn);
+
+Datum
+xxh3_agg_transfn(PG_FUNCTION_ARGS)
+{
+    HashlibState *state;
+
+    if (!AggCheckCallContext(fcinfo, NULL))
+        elog(ERROR, "xxh3_agg_transfn called in non-aggregate context");
+
+    /* the first state is copied into the aggregate context by the executor */
+    state = PG_ARGISNULL(0) ? XXH3_stream_init(0) : PG_GETARG_HASHLIB_STATE_P(0);
+    hashlib_stream_framed_datum(PG_GETARG_DATUM(1), PG_ARGISNULL(1), XXH3_stream_update_cb, state);
+
+    PG_RETURN_HASHLIB_STATE_P(state);
+}
+
+/* xxh3_agg_final(state) -> bigint; no rows gives the hash of empty input */
+PG_FUNCTION_INFO_V1(xxh3_agg_final);
+
+Datum
+xxh3_agg_final(PG_FUNCTION_ARGS)
+{
+    HashlibState *state = PG_ARGISNULL(0) ? XXH3_stream_init(0) : PG_GETARG_HASHLIB_STATE_P(0);
+    uint64_t hash = XXH3_stream_final64(state);
+
+    PG_RETURN_INT64((int64_t)hash);
+}
+
+/* xxh3_agg_final128(state) -> text; no rows gives the hash of empty input */
+PG_FUNCTION_INFO_V1(xxh3_agg_final128);
+
+Datum
+xxh3_agg_final128(PG_FUNCTION_ARGS)
+{
+    HashlibState *state = PG_ARGISNULL(0) ? XXH3_stream_init(0) : PG_GETARG_HASHLIB_STATE_P(0);
+    XXH128_hash_t hash = XXH3_stream_final128(state);
+    char result[33];
+
+    /* Format as hex string: high64:low64 */
+    snprintf(result, sizeof(result), "%016llx%016llx",
+             (unsigned long long)hash.high64,
+             (unsigned long long)hash.low64);
+
+    PG_RETURN_TEXT_P(cstring_to_text(result));
+}
+
+/* xxh3_final(state) -> bigint, equal to xxhash3_64 of all input */
+PG_FUNCTION_INFO_V1(xxh3_final);
+
+Datum
+xxh3_final(PG_FUNCTION_ARGS)
+{
+    HashlibState *state = PG_GETARG_HASHLIB_STATE_P(0);
+    uint64_t hash;
+
+    hashlib_state_check(state, HASHLIB_STATE_XXH3, "xxh3_final");
+    hash = XXH3_stream_final64(state);
+    PG_RETURN_INT64((int64_t)hash);
+}
+
+/* xxh3_final128(state) -> text, equal to xxhash3_128 of all input */
+PG_FUNCTION_INFO_V1(xxh3_final128);
+
+Datum
+xxh3_final128(PG_FUNCTION_ARGS)
+{
+    HashlibState *state = PG_GETARG_HASHLIB_STATE_P(0);
+    XXH128_hash_t hash;
+    char result[33];
+
+    hashlib_state_check(state, HASHLIB_STATE_XXH3, "xxh3_final128");
+    hash = XXH3_stream_final128(state);
+
+    /* Format as hex string: high64:low64 */
+    snprintf(result, sizeof(result), "%016llx%016llx",
+             (unsigned long long)hash.high64,
+             (unsigned long long)hash.low64);
+
+    PG_RETURN_TEXT_P(cstring_to_text(result));
+}
+
+/* PostgreSQL function wrappers for large objects */
+
+/* XXH3 of the contents of a large object, read a few pages at a time */
+static HashlibState* xxhash3_large_object(Oid loid, uint64_t seed) {
+    HashlibState* state = XXH3_stream_init(seed);
+
+    hashlib_stream_large_object(loid, XXH3_stream_update_cb, state);
+    return state;
+}
+
+/* XXH3_64bits for a large object with default seed */
+PG_FUNCTION_INFO_V1(lo_xxhash3_64);
+
+Datum
+lo_xxhash3_64(PG_FUNCTION_ARGS)
+{
+    HashlibState *state = xxhash3_large_object(PG_GETARG_OID(0), 0);
+    uint64_t hash = XXH3_stream_final64(state);
+    PG_RETURN_INT64((int64_t)hash);
+}
+
+/* XXH3_64bits for a large object with custom seed */
+PG_FUNCTION_INFO_V1(lo_xxhash3_64_seed);
+
+Datum
+lo_xxhash3_64_seed(PG_FUNCTION_ARGS)
+{
+    int64_t seed = PG_GETARG_INT64(1);
+    HashlibState *state = xxhash3_large_object(PG_GETARG_OID(0), (uint64_t)seed);
+    uint64_t hash = XXH3_stream_final64(state);
+    PG_RETURN_INT64((int64_t)hash);
+}
+
+/* XXH3_128bits for a large object with default seed */
+PG_FUNCTION_INFO_V1(lo_xxhash3_128);
+
+Datum
+lo_xxhash3_128(PG_FUNCTION_ARGS)
+{
+    HashlibState *state = xxhash3_large_object(PG_GETARG_OID(0), 0);
+    XXH128_hash_t hash = XXH3_stream_final128(state);
+    char result[33];
+
+    /* Format as hex string: high64:low64 */
+    snprintf(result, sizeof(result), "%016llx%016llx",
+             (unsigned long long)hash.high64,
+             (unsigned long long)hash.low64);
+
+    PG_RETURN_TEXT_P(cstring_to_text(result));
+}
+
+/* XXH3_128bits for a large object with custom seed */
+PG_FUNCTION_INFO_V1(lo_xxhash3_128_seed);
+
+Datum
+lo_xxhash3_128_seed(PG_FUNCTION_ARGS)
+{
+    int64_t seed = PG_GETARG_INT64(1);
+    HashlibState *state = xxhash3_large_object(PG_GETARG_OID(0), (uint64_t)seed);
+    XXH128_hash_t hash = XXH3_stream_final128(state);
+    char result[33];
+
+    /* Format as hex string: high64:low64 */
+    snprintf(result, sizeof(result), "%016llx%016llx",
+             (unsigned long long)hash.high64,
+             (unsigned long long)hash.low64);
+
+    PG_RETURN_TEXT_P(cstring_to_text(result));
+}
+
+/*
+ * Tree hashing: the input is split into leaves of chunk_size bytes, each leaf
+ * is hashed with XXH3_128bits, and the root is XXH3_128bits of the leaf
+ * digests (16 bytes each, low64 then high64, little-endian) followed by the
+ * total length and the chunk size (8 bytes each, little-endian).  The tree
+ * shape depends only on the length and the chunk size, so the result does
+ * not depend on how many threads hashed the leaves.
+ *
+ * Leaves are hashed by a pool of pthreads, each taking a contiguous run of
+ * leaves.  The workers only read the input and write their own digest slots;
+ * everything they touch is allocated by the calling backend beforehand, and
+ * they never call into PostgreSQL.  All signals are blocked in the workers so
+ * that the backend's signal handlers only ever run in the main thread.
+ *
+ * Code run on a worker thread must never call palloc, ereport/elog or any
+ * other backend function: none of them is thread-safe, and an error thrown
+ * there would longjmp out of the wrong thread's stack.  Everything that can
+ * fail is done in the calling thread before the workers start.
+ *
+ * The number of threads a backend may use, its own included, is capped by
+ * hashlib.tree_max_threads, so that a query cannot take more cores than the
+ * administrator allows; like max_parallel_workers_per_gather it defaults to 2.
+ */
+
+#define XXH3_TREE_MIN_CHUNK     1024
+#define XXH3_TREE_MAX_CHUNK     (1024 * 1024 * 1024)
+
+/* Inputs shorter than this are hashed in the calling thread only */
+#define XXH3_TREE_PARALLEL_MIN  (1024 * 1024)
+
+typedef struct {
+    const uint8_t* input;
+    size_t len;
+    size_t chunk_size;
+    size_t first_leaf;
+    size_t end_leaf;
+    XXH128_hash_t* digests;
+} XXH3_tree_task;
+
+static void XXH3_tree_hash_leaves(const XXH3_tree_task* task) {
+    size_t i;
+
+    for (i = task->first_leaf; i < task->end_leaf; i++) {
+        size_t offset = i * task->chunk_size;
+        size_t n = task->len - offset < task->chunk_size ? task->len - offset : task->chunk_size;
+
+        task->digests[i] = XXH3_128bits(task->input + offset, n);
+    }
+}
+
+static void* XXH3_tree_worker(void* arg) {
+    XXH3_tree_hash_leaves((const XXH3_tree_task*)arg);
+    return NULL;
+}
+
+static void XXH_writeLE64(uint8_t* p, uint64_t v) {
+    int i;
+
+    for (i = 0; i < 8; i++)
+        p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static XXH128_hash_t XXH3_tree_128(const uint8_t* input, size_t len, size_t chunk_size, int nthreads) {
+    size_t nleaves = len == 0 ? 1 : (len + chunk_size - 1) / chunk_size;
+    XXH128_hash_t* digests = (XXH128_hash_t*)palloc(nleaves * sizeof(XXH128_hash_t));
+    size_t root_len = nleaves * 16 + 16;
+    uint8_t* root = (uint8_t*)palloc(root_len);
+    XXH3_tree_task* tasks;
+    pthread_t* threads;
+    bool* started;
+    sigset_t all_signals;
+    sigset_t old_signals;
+    XXH128_hash_t hash;
+    size_t i;
+    int t;
+
+    if (len < XXH3_TREE_PARALLEL_MIN || (size_t)nthreads > nleaves)
+        nthreads = len < XXH3_TREE_PARALLEL_MIN ? 1 : (int)nleaves;
+
+    tasks = (XXH3_tree_task*)palloc(nthreads * sizeof(XXH3_tree_task));
+    threads = (pthread_t*)palloc(nthreads * sizeof(pthread_t));
+    started = (bool*)palloc0(nthreads * sizeof(bool));
+
+    for (t = 0; t < nthreads; t++) {
+        tasks[t].input = input;
+        tasks[t].len = len;
+        tasks[t].chunk_size = chunk_size;
+        tasks[t].first_leaf = nleaves * t / nthreads;
+        tasks[t].end_leaf = nleaves * (t + 1) / nthreads;
+        tasks[t].digests = digests;
+    }
+
+    /* task 0 runs in this thread; a worker that fails to start is run here too */
+    if (nthreads > 1) {
+        sigfillset(&all_signals);
+        pthread_sigmask(SIG_SETMASK, &all_signals, &old_signals);
+        for (t = 1; t < nthreads; t++)
+            started[t] = pthread_create(&threads[t], NULL, XXH3_tree_worker, &tasks[t]) == 0;
+        pthread_sigmask(SIG_SETMASK, &old_signals, NULL);
+    }
+
+    XXH3_tree_hash_leaves(&tasks[0]);
+    for (t = 1; t < nthreads; t++) {
+        if (started[t])
+            pthread_join(threads[t], NULL);
+        else
+            XXH3_tree_hash_leaves(&tasks[t]);
+    }
+
+    for (i = 0; i < nleaves; i++) {
+        XXH_writeLE64(root + i * 16, digests[i].low64);
+        XXH_writeLE64(root + i * 16 + 8, digests[i].high64);
+    }
+    XXH_writeLE64(root + nleaves * 16, (uint64_t)len);
+    XXH_writeLE64(root + nleaves * 16 + 8, (uint64_t)chunk_size);
+
+    hash = XXH3_128bits(root, root_len);
+
+    pfree(digests);
+    pfree(root);
+    pfree(tasks);
+    pfree(threads);
+    pfree(started);
+    return hash;
+}
+
+static int XXH3_tree_default_threads(void) {
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+
+    if (ncpu < 1)
+        return 1;
+    return ncpu < hashlib_tree_max_threads ? (int)ncpu : hashlib_tree_max_threads;
+}
+
+static Datum xxh3_tree_128_result(Datum value, int32 chunk_size, int32 nthreads) {
+    bytea* input;
+    XXH128_hash_t hash;
+    char result[33];
+
+    if (chunk_size < XXH3_TREE_MIN_CHUNK || chunk_size > XXH3_TREE_MAX_CHUNK)
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("chunk_size must be between %d and %d",
+                        XXH3_TREE_MIN_CHUNK, XXH3_TREE_MAX_CHUNK)));
+    if (nthreads < 1 || nthreads > HASHLIB_TREE_MAX_THREADS)
+        ereport(ERROR,
+                (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+                 errmsg("threads must be between 1 and %d", HASHLIB_TREE_MAX_THREADS)));
+    if (nthreads > hashlib_tree_max_threads)
+        nthreads = hashlib_tree_max_threads;
+
+    input = DatumGetByteaPP(value);
+    hash = XXH3_tree_128((const uint8_t*)VARDATA_ANY(input), VARSIZE_ANY_EXHDR(input),
+                         (size_t)chunk_size, nthreads);
+
+    /* Format as hex string: high64:low64 */
+    snprintf(result, sizeof(result), "%016llx%016llx",
+             (unsigned long long)hash.high64,
+             (unsigned long long)hash.low64);
+
+    return PointerGetDatum(cstring_to_text(result));
+}
+
+/* Tree-mode XXH3_128bits for text or bytea input, default thread count */
+PG_FUNCTION_INFO_V1(xxh3_tree_128);
+
+Datum
+xxh3_tree_128(PG_FUNCTION_ARGS)
+{
+    return xxh3_tree_128_result(PG_GETARG_DATUM(0), PG_GETARG_INT32(1),
+                                XXH3_tree_default_threads());
+}
+
+/* Tree-mode XXH3_128bits for text or bytea input with explicit thread count */
+PG_FUNCTION_INFO_V1(xxh3_tree_128_threads);
+
+Datum
+xxh3_tree_128_threads(PG_FUNCTION_ARGS)
+{
+    return xxh3_tree_128_result(PG_GETARG_DATUM(0), PG_GETARG_INT32(1),
+                                PG_GETARG_INT32(2));
+}
+
+/*
+ * Set fingerprints: xxh3_set_agg hashes every non-null value to 128 bits with
+ * XXH3_128bits of its canonical bytes (see hashlib_datum.h) and combines the
+ * value hashes with operations that do not depend on order: a count, a sum
+ * modulo 2^128 and an XOR of the avalanche-mixed halves.  Equal multisets of
+ * values therefore give equal fingerprints whatever the scan order or the
+ * split between parallel workers.  The result is XXH3_128bits of the state.
+ */
+
+typedef struct {
+    int64 count;
+    uint64_t sum_low;
+    uint64_t sum_high;
+    uint64_t xor_low;
+    uint64_t xor_high;
+} XXH3_set_state;
+
+static XXH3_set_state* XXH3_set_state_create(MemoryContext context) {
+    return (XXH3_set_state*)MemoryContextAllocZero(context, sizeof(XXH3_set_state));
+}
+
+static void XXH3_set_add(XXH3_set_state* state, XXH128_hash_t h) {
+    state->count++;
+    state->sum_low += h.low64;
+    state->sum_high += h.high64 + (state->sum_low < h.low64);
+    state->xor_low ^= XXH64_avalanche(h.low64 ^ PRIME64_1);
+    state->xor_high ^= XXH64_avalanche(h.high64 ^ PRIME64_2);
+}
+
+static void XXH3_set_merge(XXH3_set_state* state, const XXH3_set_state* other) {
+    state->count += other->count;
+    state->sum_low += other->sum_low;
+    state->sum_high += other->sum_high + (state->sum_low < other->sum_low);
+    state->xor_low ^= other->xor_low;
+    state->xor_high ^= other->xor_high;
+}
+
+/* xxh3_set_agg_transfn(internal, anyelement) -> internal */
+PG_FUNCTION_INFO_V1(xxh3_set_agg_transfn);
+
+Datum
+xxh3_set_agg_transfn(PG_FUNCTION_ARGS)
+{
+    MemoryContext aggcontext;
+    XXH3_set_state *state;
+    HashlibTypeIO *io;
+    bytea *bytes;
+
+    if (!AggCheckCallContext(fcinfo, &aggcontext))
+        elog(ERROR, "xxh3_set_agg_transfn called in non-aggregate context");
+
+    state = PG_ARGISNULL(0) ? XXH3_set_state_create(aggcontext)
+                            : (XXH3_set_state *) PG_GETARG_POINTER(0);
+
+    if (!PG_ARGISNULL(1)) {
+        io = hashlib_arg_type_io(fcinfo, 1);
+        bytes = hashlib_value_bytes(io, PG_GETARG_DATUM(1));
+        XXH3_set_add(state, XXH3_128bits(VARDATA(bytes), VARSIZE(bytes) - VARHDRSZ));
+        pfree(bytes);
+    }
+
+    PG_RETURN_POINTER(state);
+}
+
+/* xxh3_set_agg_combine(internal, internal) -> internal */
+PG_FUNCTION_INFO_V1(xxh3_set_agg_combine);
+
+Datum
+xxh3_set_agg_combine(PG_FUNCTION_ARGS)
+{
+    MemoryContext aggcontext;
+    XXH3_set_state *state;
+
+    if (!AggCheckCallContext(fcinfo, &aggcontext))
+        elog(ERROR, "xxh3_set_agg_combine called in non-aggregate context");
+
+    if (PG_ARGISNULL(1))
+        PG_RETURN_POINTER(PG_ARGISNULL(0) ? NULL : PG_GETARG_POINTER(0));
+
+    state = PG_ARGISNULL(0) ? XXH3_set_state_create(aggcontext)
+                            : (XXH3_set_state *) PG_GETARG_POINTER(0);
+    XXH3_set_merge(state, (XXH3_set_state *) PG_GETARG_POINTER(1));
+
+    PG_RETURN_POINTER(state);
+}
+
+/* xxh3_set_agg_serialize(internal) -> bytea */
+PG_FUNCTION_INFO_V1(xxh3_set_agg_serialize);
+
+Datum
+xxh3_set_agg_serialize(PG_FUNCTION_ARGS)
+{
+    XXH3_set_state *state = (XXH3_set_state *) PG_GETARG_POINTER(0);
+    StringInfoData buf;
+
+    pq_begintypsend(&buf);
+    pq_sendint64(&buf, state->count);
+    pq_sendint64(&buf, (int64)state->sum_low);
+    pq_sendint64(&buf, (int64)state->sum_high);
+    pq_sendint64(&buf, (int64)state->xor_low);
+    pq_sendint64(&buf, (int64)state->xor_high);
+    PG_RETURN_BYTEA_P(pq_endtypsend(&buf));
+}
+
+/* xxh3_set_agg_deserialize(bytea, internal) -> internal */
+PG_FUNCTION_INFO_V1(xxh3_set_agg_deserialize);
+
+Datum
+xxh3_set_agg_deserialize(PG_FUNCTION_ARGS)
+{
+    bytea *input = PG_GETARG_BYTEA_PP(0);
+    MemoryContext aggcontext;
+    XXH3_set_state *state;
+    StringInfoData buf;
+
+    if (!AggCheckCallContext(fcinfo, &aggcontext))
+        elog(ERROR, "xxh3_set_agg_deserialize called in non-aggregate context");
+
+    initStringInfo(&buf);
+    appendBinaryStringInfo(&buf, VARDATA_ANY(input), VARSIZE_ANY_EXHDR(input));
+    state = XXH3_set_state_create(CurrentMemoryContext);
+    state->count = pq_getmsgint64(&buf);
+    state->sum_low = (uint64_t)pq_getmsgint64(&buf);
+    state->sum_high = (uint64_t)pq_getmsgint64(&buf);
+    state->xor_low = (uint64_t)pq_getmsgint64(&buf);
+    state->xor_high = (uint64_t)pq_getmsgint64(&buf);
+    pq_getmsgend(&buf);
+
+    PG_RETURN_POINTER(state);
+}
+
+/* xxh3_set_agg_final(internal) -> text: 128-bit fingerprint as hex */
+PG_FUNCTION_INFO_V1(xxh3_set_agg_final);
+
+Datum
+xxh3_set_agg_final(PG_FUNCTION_ARGS)
+{
+    XXH3_set_state empty;
+    const XXH3_set_state *state = &empty;
+    uint8_t bytes[40];
+    XXH128_hash_t hash;
+    char result[33];
+
+    /* no rows: the fingerprint of the empty set */
+    memset(&empty, 0, sizeof(empty));
+    if (!PG_ARGISNULL(0))
+        state = (const XXH3_set_state *) PG_GETARG_POINTER(0);
+
+    XXH_writeLE64(bytes, (uint64_t)state->count);
+    XXH_writeLE64(bytes + 8, state->sum_low);
+    XXH_writeLE64(bytes + 16, state->sum_high);
+    XXH_writeLE64(bytes + 24, state->xor_low);
+    XXH_writeLE64(bytes + 32, state->xor_high);
+    hash = XXH3_128bits(bytes, sizeof(bytes));
+
+    /* Format as hex string: high64:low64 */
+    snprintf(result, sizeof(result), "%016llx%016llx",
+             (unsigned long long)hash.high64,
+             (unsigned long long)hash.low64);
+
+    PG_RETURN_TEXT_P(cstring_to_text(result));
+}
@@ -0,0 +1,146 @@
+-- Test basic hash functionality with text
+SELECT aeshash64('hello world');
+SELECT aeshash128('hello world');
+
+-- Test hash with different text inputs
+SELECT aeshash64('test string');
+SELECT aeshash64('another test');
+
+-- Test text input with custom seed
+SELECT aeshash64('hello world', 42);
+SELECT aeshash128('hello world', 42);
+
+-- Test bytea input
+SELECT aeshash64('hello world'::bytea);
+SELECT aeshash128('hello world'::bytea);
+
+-- Test bytea input with custom seed
+SELECT aeshash64('hello world'::bytea, 42);
+SELECT aeshash128('hello world'::bytea, 42);
+
+-- Test integer input
+SELECT aeshash64(12345);
+SELECT aeshash128(-12345);
+
+-- Test integer input with custom seed
+SELECT aeshash64(12345, 42);
+SELECT aeshash128(-12345, 84);
+
+-- Test bigint input
+SELECT aeshash64(123456789012345::bigint);
+SELECT aeshash128(-123456789012345::bigint);
+
+-- Test bigint input with custom seed
+SELECT aeshash64(123456789012345::bigint, 42);
+SELECT aeshash128(-123456789012345::bigint, 84);
+
+-- Test that the 64-bit hash is the low half of the 128-bit hash
+SELECT aeshash64('hello world') = (aeshash128('hello world'))[1];
+SELECT aeshash64('hello world', 7) = (aeshash128('hello world', 7))[1];
+
+-- Test consistency (same input should give same hash)
+SELECT aeshash64('consistent test') = aeshash64('consistent test');
+
+-- Test seed effect (same input, different seeds should give different hashes)
+SELECT aeshash64('seed test', 1) != aeshash64('seed test', 2);
+
+-- Test that length is part of the hash (zero padding is not ambiguous)
+SELECT aeshash64('\x00'::bytea) != aeshash64('\x0000'::bytea);
+
+-- Test empty string
+SELECT aeshash64('');
+SELECT aeshash128('');
+
+-- Test single character
+SELECT aeshash64('a');
+
+-- Test various input lengths to test different code paths
+SELECT aeshash64('123456789012345');   -- 15 bytes
+SELECT aeshash64('1234567890123456');  -- 16 bytes
+SELECT aeshash64('12345678901234567'); -- 17 bytes
+SELECT aeshash64(repeat('0123456789abcdef', 4));        -- 64 bytes
+SELECT aeshash64(repeat('0123456789abcdef', 4) || 'x'); -- 65 bytes
+SELECT aeshash64(repeat('0123456789abcdef', 7) || 'x'); -- 113 bytes
+SELECT aeshash128(repeat('0123456789abcdef', 64));      -- 1024 bytes
+
+-- Test a difference in one block cannot be cancelled by the next block of its lane:
+-- byte 0 set, and bytes 64..67 set to the MixColumns image (2g, g, g, 3g) of each g
+SELECT s AS seed,
+       count(*) FILTER (WHERE aeshash128(msg, s) = aeshash128(decode(repeat('00', 128), 'hex'), s)) AS collisions
+FROM (SELECT set_byte(set_byte(set_byte(set_byte(set_byte(decode(repeat('00', 128), 'hex'), 0, 1),
+                                                 64, x), 65, g), 66, g), 67, x # g) AS msg
+      FROM (SELECT g, ((g << 1) & 255) # CASE WHEN g & 128 <> 0 THEN 27 ELSE 0 END AS x
+            FROM generate_series(1, 255) g) t) m,
+     (VALUES (0), (1), (42), (-7)) v(s)
+GROUP BY s ORDER BY s;
+
+-- Test known answers that every kernel must reproduce, over the short, 16-byte,
+-- 64-byte bulk and tail paths; byte i of each input is (31 * i + 7) % 256
+CREATE TEMP TABLE aeshash_kat (seed bigint, len integer, low bigint, high bigint);
+INSERT INTO aeshash_kat VALUES
+       (0, 0, -8512025318118999611, 2794820078633613372),
+       (0, 1, 5210264204541352413, -8955375865499717866),
+       (0, 3, 4114135270379298507, 4116094858966982577),
+       (0, 8, -3672039224190223046, -3602956431931912297),
+       (0, 15, -6981892374125921084, 4145518356120365022),
+       (0, 16, -8196597527103723915, 283812726087038007),
+       (0, 17, -6064087454414792260, 5566544451412341171),
+       (0, 31, -147994508741786063, 8973046712445565279),
+       (0, 32, -2122533425651008404, -7957164436345152786),
+       (0, 33, 1116742674919509346, -4918972736227865985),
+       (0, 48, -5991069924914158457, 4355803865076075918),
+       (0, 63, 1471766555179591742, 3705864841745009412),
+       (0, 64, -7589682349788334532, 6822869735033738874),
+       (0, 65, 8233211955516909185, 8572022069620714796),
+       (0, 100, -8842108549567059029, -4029778993065402970),
+       (0, 127, 7635176826529098625, -1124383667513505071),
+       (0, 128, -6334284191709468003, -3400718463463393073),
+       (0, 129, -4827720639018627084, -3795558585049678164),
+       (0, 255, -6482795889578924914, 9164370754747499063),
+       (0, 256, -1300044595124997617, -8369199979726942292),
+       (0, 1000, 4587167566948563035, -5204568223446163511),
+       (81985529216486895, 0, -5355930493870228282, 6688714192865846042),
+       (81985529216486895, 1, 6974480514997139375, 2150442467888606106),
+       (81985529216486895, 3, 1191405033987581154, 6754215946470059079),
+       (81985529216486895, 8, 7572310695362958802, -3450942207489180145),
+       (81985529216486895, 15, 8696177391356808044, -967832549900904062),
+       (81985529216486895, 16, 8797003598748930620, -6635245012008739808),
+       (81985529216486895, 17, 7275110492427146943, 9191812264852589458),
+       (81985529216486895, 31, 7141239583237687829, 2083549486046595823),
+       (81985529216486895, 32, 6560133958579184383, 1917820361463218134),
+       (81985529216486895, 33, -1846308856309010234, 1430976217348730339),
+       (81985529216486895, 48, -2389076944746746903, 5050423098712260384),
+       (81985529216486895, 63, -3172744320575081412, -1435557400832745680),
+       (81985529216486895, 64, 4545580505184901567, -8962983614871328296),
+       (81985529216486895, 65, -4101501109816524121, -2909780208902550980),
+       (81985529216486895, 100, -3684669227241816617, 6732714273128027260),
+       (81985529216486895, 127, -789685462540983996, 7852222369646802907),
+       (81985529216486895, 128, -5882252171205475846, 7649664207543679659),
+       (81985529216486895, 129, 5710774191235793502, -4030458506712573704),
+       (81985529216486895, 255, -4477498635059986858, 5019073911279432040),
+       (81985529216486895, 256, -1682568760365965759, 6053734187958549480),
+       (81985529216486895, 1000, -6063993023423392039, -502480149912882278);
+SELECT seed, len, aeshash128(msg, seed) AS got, ARRAY[low, high] AS expected
+FROM (SELECT k.*, coalesce((SELECT decode(string_agg(lpad(to_hex((31 * i + 7) % 256), 2, '0'), '' ORDER BY i), 'hex')
+                             FROM generate_series(0, len - 1) i), ''::bytea) AS msg
+      FROM aeshash_kat k) t
+WHERE aeshash128(msg, seed) IS DISTINCT FROM ARRAY[low, high];
+
+-- Test that a kernel was selected
+SELECT aeshash_implementation() IN ('aesni', 'armv8-crypto', 'portable');
+
+-- Test function properties
+SELECT 
+    proname,
+    provolatile,
+    proisstrict
+FROM pg_proc 
+WHERE proname IN ('aeshash64', 'aeshash128')
+ORDER BY proname, proargtypes;
+
+-- Test extension metadata
+SELECT 
+    extname,
+    extversion
+FROM pg_extension 
+WHERE extname = 'hashlib';
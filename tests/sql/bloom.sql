@@ -0,0 +1,107 @@
+-- Split-block Bloom filters
+CREATE TEMP TABLE bloom_test AS
+SELECT i AS id, 'user' || i AS name FROM generate_series(1, 100000) i;
+
+CREATE TEMP TABLE bloom_filter AS
+SELECT bloom_agg(id, 100000, 0.01) AS f FROM bloom_test;
+
+-- Test added values are always found and the false positive rate is near fpp
+SELECT bool_and(bloom_contains(f, id)) AS all_found FROM bloom_test, bloom_filter;
+SELECT count(*) FILTER (WHERE bloom_contains(f, i)) BETWEEN 700 AND 1300 AS near_fpp
+FROM generate_series(100001, 200000) i, bloom_filter;
+SELECT bloom_blocks(f), length(f::bytea) FROM bloom_filter;
+
+-- Test probing several stored filters row by row
+CREATE TEMP TABLE bloom_filters AS
+SELECT id % 3 AS g, bloom_agg(id, 100000, 0.01) AS f FROM bloom_test GROUP BY id % 3;
+SELECT g, i, bloom_contains(f, i) FROM bloom_filters, (VALUES (3), (4), (5)) v(i) ORDER BY i, g;
+
+-- Test values of other types, which must be probed with the type they were added as
+SELECT bloom_contains(f, 'user42'::text), bloom_contains(f, 'user0'::text)
+FROM (SELECT bloom_agg(name, 1000, 0.001) AS f FROM bloom_test WHERE id <= 1000) t;
+SELECT bloom_contains(f, 7::int4), bloom_contains(f, '2024-01-01'::date + 7)
+FROM (SELECT bloom_agg('2024-01-01'::date + i, 100, 0.01) AS f FROM generate_series(1, 10) i) t;
+
+-- Test bloom_contains_any
+SELECT bloom_contains_any(f, ARRAY[0, -1, 5]),
+       bloom_contains_any(f, ARRAY[0, -1, -2]),
+       bloom_contains_any(f, ARRAY[NULL, 99999]),
+       bloom_contains_any(f, '{}'::int[]),
+       bloom_contains_any(f, ARRAY[NULL]::int[])
+FROM bloom_filter;
+SELECT bool_and(bloom_contains_any(f, ARRAY[-i, -i - 1, i])) AS all_found
+FROM generate_series(1, 100000, 7) i, bloom_filter;
+SELECT count(*) FILTER (WHERE bloom_contains_any(f, ARRAY[-i, -i - 1, -i - 2])) BETWEEN 2100 AND 3900 AS near_3fpp
+FROM generate_series(1, 300000, 3) i, bloom_filter;
+SELECT bloom_contains_any(f, ARRAY(SELECT -i FROM generate_series(1, 1000) i) || 12345)
+FROM bloom_filter;
+
+-- Test union gives the single-pass filter
+SELECT bloom_union(a, b)::text = (SELECT f::text FROM bloom_filter),
+       bloom_union(a, b)::text = bloom_union(b, a)::text
+FROM (SELECT bloom_agg(id, 100000, 0.01) FILTER (WHERE id <= 30000) AS a,
+             bloom_agg(id, 100000, 0.01) FILTER (WHERE id > 30000) AS b
+      FROM bloom_test) t;
+
+-- Test the stored layout of a one-block filter
+SELECT bloom_agg(v, 1, 0.5) FROM (VALUES (1)) s(v);
+SELECT bloom_blocks(bloom_agg(v, 1000000, 0.001)) FROM (VALUES (1::bigint)) s(v);
+
+-- Test NULLs are ignored and no rows give NULL
+SELECT bloom_agg(v, 1, 0.5)::text = bloom_agg(v, 1, 0.5) FILTER (WHERE v IS NOT NULL)::text
+FROM (VALUES (1), (NULL)) s(v);
+SELECT bloom_agg(id, 10, 0.01) FROM bloom_test WHERE false;
+
+-- Test text and bytea round trips
+SELECT f::text::bloom::text = f::text, bloom(f::bytea)::bytea = f::bytea FROM bloom_filter;
+
+-- Test text added under one client_encoding is found under another
+CREATE TEMP TABLE bloom_text AS
+SELECT bloom_agg(U&'caf\00e9' || i, 1000, 0.01) AS f FROM generate_series(1, 100) i;
+SET client_encoding = 'LATIN1';
+SELECT bool_and(bloom_contains(f, U&'caf\00e9' || i)) AS all_found,
+       bool_and(bloom_contains_any(f, ARRAY[U&'caf\00e9' || i, 'x'])) AS any_found
+FROM bloom_text, generate_series(1, 100) i;
+RESET client_encoding;
+
+-- Test parallel aggregation gives the serial result
+CREATE TABLE bloom_test_parallel AS SELECT id FROM bloom_test;
+ANALYZE bloom_test_parallel;
+SET parallel_setup_cost = 0;
+SET parallel_tuple_cost = 0;
+SET min_parallel_table_scan_size = 0;
+SET max_parallel_workers_per_gather = 2;
+EXPLAIN (COSTS OFF) SELECT bloom_agg(id, 100000, 0.01) FROM bloom_test_parallel;
+SELECT bloom_agg(id, 100000, 0.01)::text = (SELECT f::text FROM bloom_filter) FROM bloom_test_parallel;
+RESET parallel_setup_cost;
+RESET parallel_tuple_cost;
+RESET min_parallel_table_scan_size;
+RESET max_parallel_workers_per_gather;
+DROP TABLE bloom_test_parallel;
+
+-- Test errors
+SELECT bloom_agg(id, 0, 0.01) FROM bloom_test;
+SELECT bloom_agg(id, 10, 1.0) FROM bloom_test;
+SELECT bloom_agg(id, 10, NULL) FROM bloom_test;
+SELECT bloom_agg(id, 1000000000000, 0.0001) FROM bloom_test;
+SELECT bloom_union(a, b) FROM (SELECT bloom_agg(1, 10, 0.1) AS a, bloom_agg(1, 1000, 0.1) AS b) t;
+SELECT 'xyz'::bloom;
+SELECT '\x0100000000000000'::bloom;
+SELECT '\x010000000100000000'::bloom;
+
+-- Test function properties
+SELECT 
+    proname,
+    provolatile,
+    proisstrict,
+    proparallel
+FROM pg_proc 
+WHERE proname LIKE 'bloom%'
+ORDER BY proname, proargtypes;
+
+-- Test extension metadata
+SELECT 
+    extname,
+    extversion
+FROM pg_extension 
+WHERE extname = 'hashlib';
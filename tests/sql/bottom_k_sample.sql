@@ -0,0 +1,82 @@
+-- Test bottom_k_sample aggregate
+
+CREATE TABLE bottom_k_test AS
+SELECT i AS id, 'user-' || i AS name FROM generate_series(1, 20000) i;
+
+-- The sample is the k values with the smallest unsigned xxhash3_64 with the seed
+CREATE FUNCTION bottom_k_unsigned(h bigint) RETURNS numeric
+LANGUAGE sql IMMUTABLE AS
+$$ SELECT h::numeric + CASE WHEN h < 0 THEN 18446744073709551616 ELSE 0 END $$;
+SELECT bottom_k_sample(id, 100, 42) = ARRAY(SELECT id FROM bottom_k_test
+                                            ORDER BY bottom_k_unsigned(xxhash3_64(id, 42)) LIMIT 100) AS integer_key,
+       bottom_k_sample(name, 100, 42) = ARRAY(SELECT name FROM bottom_k_test
+                                              ORDER BY bottom_k_unsigned(xxhash3_64(name, 42)) LIMIT 100) AS text_key,
+       bottom_k_sample(name::bytea, 100, -1) = ARRAY(SELECT name::bytea FROM bottom_k_test
+                                                     ORDER BY bottom_k_unsigned(xxhash3_64(name::bytea, -1)) LIMIT 100) AS bytea_key
+FROM bottom_k_test;
+DROP FUNCTION bottom_k_unsigned(bigint);
+
+-- Test the sample agreeing with hash_sample
+SELECT bool_and(hash_sample(x, 0.01, 7)) AS all_in_1_percent
+FROM unnest((SELECT bottom_k_sample(id, 50, 7) FROM bottom_k_test)) x;
+
+-- Test small inputs, duplicates, NULLs and other types
+SELECT bottom_k_sample(x, 3, 1) FROM (VALUES (1), (1), (2), (2), (NULL)) v(x);
+SELECT bottom_k_sample(x, 1, 1) FROM (VALUES (1), (2), (3)) v(x);
+SELECT bottom_k_sample(x, 3, 1) FROM (VALUES (NULL::int)) v(x);
+SELECT bottom_k_sample(id, 3, 1) FROM bottom_k_test WHERE false;
+SELECT array_length(bottom_k_sample(x, 5, 1), 1) FROM (VALUES ('1.5'::numeric), ('2.5'), ('3.5')) v(x);
+SELECT array_length(bottom_k_sample(ROW(id, name), 5, 1), 1) FROM bottom_k_test;
+SELECT (SELECT bottom_k_sample(name::varchar, 5, 1) FROM bottom_k_test)::text[] =
+       (SELECT bottom_k_sample(name, 5, 1) FROM bottom_k_test) AS varchar_as_text;
+
+-- Test coordinated samples: the sample of a subset is the sample of the set restricted to it
+SELECT (SELECT bottom_k_sample(id, 100, 3) FROM bottom_k_test WHERE id % 2 = 0) =
+       ARRAY(SELECT x FROM unnest((SELECT bottom_k_sample(id, 200, 3) FROM bottom_k_test)) WITH ORDINALITY u(x, n)
+             WHERE x % 2 = 0 ORDER BY n LIMIT 100) AS coordinated;
+
+-- Test samples per group
+SELECT id % 3 AS g, array_length(bottom_k_sample(name, 10, 5), 1)
+FROM bottom_k_test GROUP BY 1 ORDER BY 1;
+
+-- Test parallel aggregation
+ANALYZE bottom_k_test;
+SET parallel_setup_cost = 0;
+SET parallel_tuple_cost = 0;
+SET min_parallel_table_scan_size = 0;
+SET max_parallel_workers_per_gather = 2;
+EXPLAIN (COSTS OFF) SELECT bottom_k_sample(name, 100, 42) FROM bottom_k_test;
+CREATE TABLE bottom_k_parallel AS
+SELECT bottom_k_sample(name, 100, 42) AS names, bottom_k_sample(id, 5000, 42) AS ids FROM bottom_k_test;
+RESET parallel_setup_cost;
+RESET parallel_tuple_cost;
+RESET min_parallel_table_scan_size;
+RESET max_parallel_workers_per_gather;
+SELECT p.names = s.names AS names_match, p.ids = s.ids AS ids_match
+FROM bottom_k_parallel p,
+     (SELECT bottom_k_sample(name, 100, 42) AS names, bottom_k_sample(id, 5000, 42) AS ids FROM bottom_k_test) s;
+DROP TABLE bottom_k_parallel;
+
+-- Test errors
+SELECT bottom_k_sample(id, 0, 1) FROM bottom_k_test;
+SELECT bottom_k_sample(id, NULL, 1) FROM bottom_k_test;
+SELECT bottom_k_sample(id, id, 1) FROM bottom_k_test;
+SELECT bottom_k_sample(id, 10, id) FROM bottom_k_test;
+DROP TABLE bottom_k_test;
+
+-- Test function properties
+SELECT 
+    proname,
+    provolatile,
+    proisstrict,
+    proparallel
+FROM pg_proc 
+WHERE proname LIKE 'bottom_k_sample%'
+ORDER BY proname, proargtypes;
+
+-- Test extension metadata
+SELECT 
+    extname,
+    extversion
+FROM pg_extension 
+WHERE extname = 'hashlib';
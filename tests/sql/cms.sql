@@ -0,0 +1,87 @@
+-- Count-min sketches
+CREATE TEMP TABLE cms_test AS
+SELECT i AS id, 'ip' || (CASE WHEN i % 10 = 0 THEN i % 7 ELSE i END) AS ip
+FROM generate_series(1, 100000) i;
+
+CREATE TEMP TABLE cms_sketch AS
+SELECT cms_add_agg(wyhash(ip)) AS s FROM cms_test;
+
+-- Test estimates never undercount and are close for heavy keys
+SELECT ip, count(*) AS actual,
+       (SELECT cms_estimate(s, wyhash(ip)) FROM cms_sketch) - count(*) < 200 AS close
+FROM cms_test
+GROUP BY ip
+ORDER BY count(*) DESC, ip
+LIMIT 7;
+SELECT bool_and(e >= c) AS never_under, max(e - c) < 200 AS bounded
+FROM (SELECT count(*) AS c, (SELECT cms_estimate(s, wyhash(ip)) FROM cms_sketch) AS e
+      FROM cms_test GROUP BY ip) t;
+SELECT cms_total(s), cms_width(s), cms_depth(s), length(s::bytea) FROM cms_sketch;
+
+-- Test cms_add, weighted counts and the empty sketch
+SELECT cms_total(s), cms_width(s), cms_depth(s), length(s::bytea) FROM (SELECT cms_empty(16, 2) AS s) t;
+SELECT cms_add(cms_empty(16, 1), 42);
+SELECT cms_estimate(cms_add(cms_add(cms_empty(), 42, 1000), 42), 42), cms_estimate(cms_empty(), 42);
+SELECT cms_add(cms_add(cms_empty(64, 3), 1), 2)::text = (SELECT cms_add_agg(v, 64, 3)::text FROM (VALUES (2), (1)) s(v));
+
+-- Test merge and the merge aggregate give the single-pass sketch
+SELECT cms_merge(a, b)::text = (SELECT s::text FROM cms_sketch),
+       cms_merge(a, b)::text = cms_merge(b, a)::text
+FROM (SELECT cms_add_agg(wyhash(ip)) FILTER (WHERE id <= 30000) AS a,
+             cms_add_agg(wyhash(ip)) FILTER (WHERE id > 30000) AS b
+      FROM cms_test) t;
+SELECT cms_merge_agg(s)::text = (SELECT s::text FROM cms_sketch)
+FROM (SELECT cms_add_agg(wyhash(ip)) AS s FROM cms_test GROUP BY id % 5) t;
+
+-- Test saturation at 2^32 - 1
+SELECT cms_estimate(cms_add(cms_add(cms_empty(16, 1), 7, 4294967290), 7, 10), 7);
+SELECT cms_total(cms_add(cms_add(cms_empty(16, 1), 7, 4294967290), 7, 10));
+
+-- Test NULLs are ignored and no rows give NULL
+SELECT cms_total(cms_add_agg(v)) FROM (VALUES (1::bigint), (NULL)) s(v);
+SELECT cms_add_agg(id) FROM cms_test WHERE false;
+
+-- Test text and bytea round trips
+SELECT s::text::cms::text = s::text, cms(s::bytea)::bytea = s::bytea FROM cms_sketch;
+
+-- Test parallel aggregation gives the serial result
+CREATE TABLE cms_test_parallel AS SELECT id, wyhash(ip) AS h FROM cms_test;
+ANALYZE cms_test_parallel;
+SET parallel_setup_cost = 0;
+SET parallel_tuple_cost = 0;
+SET min_parallel_table_scan_size = 0;
+SET max_parallel_workers_per_gather = 2;
+EXPLAIN (COSTS OFF) SELECT cms_add_agg(h) FROM cms_test_parallel;
+SELECT cms_add_agg(h)::text = (SELECT s::text FROM cms_sketch) FROM cms_test_parallel;
+RESET parallel_setup_cost;
+RESET parallel_tuple_cost;
+RESET min_parallel_table_scan_size;
+RESET max_parallel_workers_per_gather;
+DROP TABLE cms_test_parallel;
+
+-- Test errors
+SELECT cms_empty(8, 2);
+SELECT cms_empty(16, 17);
+SELECT cms_add_agg(id, 16, NULL) FROM cms_test;
+SELECT cms_add(cms_empty(), 1, -1);
+SELECT cms_merge(cms_empty(16, 2), cms_empty(32, 2));
+SELECT 'xyz'::cms;
+SELECT '\x010100001000000000000000000000'::cms;
+SELECT '\x01000000100000000000000000000000'::cms;
+
+-- Test function properties
+SELECT 
+    proname,
+    provolatile,
+    proisstrict,
+    proparallel
+FROM pg_proc 
+WHERE proname LIKE 'cms%'
+ORDER BY proname, proargtypes;
+
+-- Test extension metadata
+SELECT 
+    extname,
+    extversion
+FROM pg_extension 
+WHERE extname = 'hashlib';
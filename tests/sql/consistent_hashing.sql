@@ -0,0 +1,82 @@
+-- Consistent hashing
+-- Test jump_consistent_hash against the reference implementation
+SELECT jump_consistent_hash(1, 1), jump_consistent_hash(42, 57),
+       jump_consistent_hash(3735883980, 1), jump_consistent_hash(3735883980, 666),
+       jump_consistent_hash(256, 1024), jump_consistent_hash(-1, 100);
+
+-- Test text and bytea keys are hashed with xxhash3_64
+SELECT jump_consistent_hash('hello'::text, 100) = jump_consistent_hash(xxhash3_64('hello'::text), 100),
+       jump_consistent_hash('\x0102'::bytea, 100) = jump_consistent_hash(xxhash3_64('\x0102'::bytea), 100),
+       rendezvous_hash('hello'::text, ARRAY['a', 'b', 'c']) =
+           rendezvous_hash(xxhash3_64('hello'::text), ARRAY['a', 'b', 'c']),
+       multiprobe_hash('\x0102'::bytea, ARRAY['a', 'b', 'c']) =
+           multiprobe_hash(xxhash3_64('\x0102'::bytea), ARRAY['a', 'b', 'c']);
+
+-- Test growing from 10 to 11 buckets only moves keys to the new bucket
+SELECT count(*) FILTER (WHERE b10 <> b11) BETWEEN 8000 AND 10200 AS moved_near_1_11,
+       bool_and(b10 = b11 OR b11 = 10) AS only_to_new, min(b10), max(b10)
+FROM (SELECT jump_consistent_hash(xxhash3_64(i), 10) AS b10,
+             jump_consistent_hash(xxhash3_64(i), 11) AS b11
+      FROM generate_series(1, 100000) i) s;
+
+-- Test rendezvous hashing balances nodes and removing a node only moves its keys
+SELECT node, count(*) BETWEEN 24000 AND 26000 AS balanced
+FROM (SELECT rendezvous_hash(i::text, ARRAY['a', 'b', 'c', 'd']) AS node
+      FROM generate_series(1, 100000) i) s
+GROUP BY node ORDER BY node;
+SELECT bool_and(n4 = n3 OR n4 = 'd') AS only_removed_moved
+FROM (SELECT rendezvous_hash(i::text, ARRAY['a', 'b', 'c', 'd']) AS n4,
+             rendezvous_hash(i::text, ARRAY['c', 'a', 'b']) AS n3
+      FROM generate_series(1, 100000) i) s;
+
+-- Test weighted rendezvous hashing
+SELECT node, round(count(*) / 1000.0) AS thousands
+FROM (SELECT rendezvous_hash(i::text, ARRAY['a', 'b', 'c', 'd'], ARRAY[1, 1, 2, 0]::float8[]) AS node
+      FROM generate_series(1, 40000) i) s
+GROUP BY node ORDER BY node;
+SELECT bool_and(rendezvous_hash(i::text, ARRAY['a', 'b', 'c'], ARRAY[2, 2, 2]::float8[]) =
+                rendezvous_hash(i::text, ARRAY['a', 'b', 'c'])) AS equal_weights_unweighted
+FROM generate_series(1, 10000) i;
+
+-- Test multi-probe hashing balances nodes and adding a node only moves keys to it
+SELECT max(c) * 100 / 100000 < 112 AS peak_to_mean_under_1_12, count(*) AS nodes
+FROM (SELECT multiprobe_hash(i::text, ARRAY(SELECT 'node' || g FROM generate_series(1, 100) g)) AS node,
+             count(*) AS c
+      FROM generate_series(1, 100000) i GROUP BY 1) s;
+SELECT bool_and(n3 = n4 OR n4 = 'd') AS only_to_new
+FROM (SELECT multiprobe_hash(i::text, ARRAY['a', 'b', 'c']) AS n3,
+             multiprobe_hash(i::text, ARRAY['a', 'b', 'c', 'd']) AS n4
+      FROM generate_series(1, 100000) i) s;
+SELECT multiprobe_hash(42, ARRAY['a', 'b', 'c'], 1), multiprobe_hash(42, ARRAY['only']);
+
+-- Test node lists changing between rows
+SELECT i, rendezvous_hash(7, nodes), multiprobe_hash(7, nodes)
+FROM (VALUES (1, ARRAY['a']), (2, ARRAY['b']), (3, ARRAY['a'])) s(i, nodes)
+ORDER BY i;
+
+-- Test errors
+SELECT jump_consistent_hash(1, 0);
+SELECT rendezvous_hash(1, '{}'::text[]);
+SELECT rendezvous_hash(1, ARRAY['a', NULL]);
+SELECT rendezvous_hash(1, ARRAY['a', 'b'], ARRAY[1]::float8[]);
+SELECT rendezvous_hash(1, ARRAY['a', 'b'], ARRAY[1, -1]::float8[]);
+SELECT rendezvous_hash(1, ARRAY['a', 'b'], ARRAY[0, 0]::float8[]);
+SELECT rendezvous_hash(1, ARRAY[['a'], ['b']]);
+SELECT multiprobe_hash(1, ARRAY['a'], 0);
+
+-- Test function properties
+SELECT 
+    proname,
+    provolatile,
+    proisstrict,
+    proparallel
+FROM pg_proc 
+WHERE proname IN ('jump_consistent_hash', 'rendezvous_hash', 'multiprobe_hash')
+ORDER BY proname, proargtypes;
+
+-- Test extension metadata
+SELECT 
+    extname,
+    extversion
+FROM pg_extension 
+WHERE extname = 'hashlib';
@@ -0,0 +1,78 @@
+-- Test catalogue check values (CRC of '123456789')
+SELECT to_hex(crc64('123456789'));
+SELECT to_hex(crc64_nvme('123456789'));
+SELECT to_hex(crc64_ecma('123456789'));
+
+-- Test basic hash functionality with text
+SELECT crc64('hello world');
+SELECT crc64_nvme('hello world');
+SELECT crc64_ecma('hello world');
+
+-- Test hash with different text inputs
+SELECT crc64('test string');
+SELECT crc64('another test');
+
+-- Test text input with custom initial CRC
+SELECT crc64('hello world', 42);
+SELECT crc64_nvme('hello world', 42);
+SELECT crc64_ecma('hello world', 42);
+
+-- Test bytea input
+SELECT crc64('hello world'::bytea);
+SELECT crc64_nvme('hello world'::bytea);
+SELECT crc64_ecma('hello world'::bytea);
+
+-- Test bytea input with custom initial CRC
+SELECT crc64('hello world'::bytea, 42);
+
+-- Test integer input
+SELECT crc64(12345);
+SELECT crc64_nvme(-12345);
+SELECT crc64_ecma(12345);
+
+-- Test integer input with custom initial CRC
+SELECT crc64(12345, 42);
+SELECT crc64_ecma(-12345, 123);
+
+-- Test empty string
+SELECT crc64(''), crc64_nvme(''), crc64_ecma('');
+
+-- Test that text and bytea agree
+SELECT crc64('hello world') = crc64('hello world'::bytea);
+
+-- Test chaining: crc(a || b) = crc(b, crc(a))
+SELECT crc64('hello world') = crc64(' world', crc64('hello'));
+SELECT crc64_nvme('hello world') = crc64_nvme(' world', crc64_nvme('hello'));
+SELECT crc64_ecma('hello world') = crc64_ecma(' world', crc64_ecma('hello'));
+
+-- Test long inputs that take the carry-less multiply folding path
+SELECT crc64(repeat('0123456789abcdef', 8));      -- 128 bytes
+SELECT crc64(repeat('0123456789abcdef', 64) || 'tail');  -- 1028 bytes
+SELECT crc64_nvme(repeat('0123456789abcdef', 64) || 'tail');
+SELECT crc64_ecma(repeat('0123456789abcdef', 64) || 'tail');
+
+-- Test chaining across the folding threshold
+SELECT crc64(repeat('x', 5000)) = crc64(repeat('x', 4000), crc64(repeat('x', 1000)));
+SELECT crc64_nvme(repeat('x', 5000)) = crc64_nvme(repeat('x', 4000), crc64_nvme(repeat('x', 1000)));
+
+-- Test consistency (same input should give same hash)
+SELECT crc64('consistent test') = crc64('consistent test');
+
+-- Test seed effect (same input, different initial CRCs should give different hashes)
+SELECT crc64('seed test', 1) != crc64('seed test', 2);
+
+-- Test function properties
+SELECT 
+    proname,
+    provolatile,
+    proisstrict
+FROM pg_proc 
+WHERE proname IN ('crc64', 'crc64_nvme', 'crc64_ecma')
+ORDER BY proname, proargtypes;
+
+-- Test extension metadata
+SELECT 
+    extname,
+    extversion
+FROM pg_extension 
+WHERE extname = 'hashlib';
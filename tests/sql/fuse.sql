@@ -0,0 +1,101 @@
+-- Binary fuse filters
+CREATE TEMP TABLE fuse_test AS
+SELECT i AS id, 'user' || (i % 50000) AS name FROM generate_series(1, 100000) i;
+
+CREATE TEMP TABLE fuse_filters AS
+SELECT fuse_agg(id) AS f8, fuse_agg(id, 16) AS f16 FROM fuse_test;
+
+-- Test added values are always found and the false positive rate is near 2^-bits
+SELECT bool_and(fuse_contains(f8, id)) AND bool_and(fuse_contains(f16, id)) AS all_found
+FROM fuse_test, fuse_filters;
+SELECT count(*) FILTER (WHERE fuse_contains(f8, i)) BETWEEN 300 AND 480 AS near_fpp8,
+       count(*) FILTER (WHERE fuse_contains(f16, i)) < 10 AS near_fpp16
+FROM generate_series(100001, 200000) i, fuse_filters;
+SELECT fuse_count(f8), fuse_bits(f8), length(f8::bytea), fuse_bits(f16), length(f16::bytea)
+FROM fuse_filters;
+
+-- Test duplicates are counted once and values of other types
+SELECT fuse_count(f), fuse_contains(f, 'user42'::text), fuse_contains(f, 'user50000'::text)
+FROM (SELECT fuse_agg(name) AS f FROM fuse_test) t;
+SELECT fuse_contains(f, 7::int4), fuse_contains(f, 7::int8)
+FROM (SELECT fuse_agg(i::int8) AS f FROM generate_series(1, 10) i) t;
+
+-- Test fuse_contains_any
+SELECT fuse_contains_any(f8, ARRAY[0, -1, 5]),
+       fuse_contains_any(f8, ARRAY[0, -1, -2]),
+       fuse_contains_any(f8, ARRAY[NULL, 99999]),
+       fuse_contains_any(f8, '{}'::int[]),
+       fuse_contains_any(f16, ARRAY[NULL]::int[])
+FROM fuse_filters;
+SELECT bool_and(fuse_contains_any(f8, ARRAY[-i, -i - 1, i])) AS all_found
+FROM generate_series(1, 100000, 7) i, fuse_filters;
+SELECT fuse_contains_any(f16, ARRAY(SELECT -i FROM generate_series(1, 1000) i) || 12345)
+FROM fuse_filters;
+
+-- Test the filter does not depend on the order or repetition of values
+SELECT (SELECT fuse_agg(v ORDER BY v DESC)::text FROM generate_series(1, 1000) v) =
+       (SELECT fuse_agg(v % 1000 + 1)::text FROM generate_series(1, 5000) v);
+
+-- Test small filters
+SELECT fuse_agg(v) FROM (VALUES (1)) s(v);
+SELECT fuse_contains(f, 1), fuse_contains(f, 2), fuse_count(f)
+FROM (SELECT fuse_agg(v, 16) AS f FROM (VALUES (1), (2)) s(v)) t;
+
+-- Test NULLs are ignored and no rows give NULL
+SELECT fuse_count(fuse_agg(v)) FROM (VALUES (1), (NULL)) s(v);
+SELECT fuse_agg(id) FROM fuse_test WHERE false;
+
+-- Test text and bytea round trips
+SELECT f8::text::fuse_filter::text = f8::text, fuse_filter(f16::bytea)::bytea = f16::bytea
+FROM fuse_filters;
+
+-- Test text added under one client_encoding is found under another
+CREATE TEMP TABLE fuse_text AS
+SELECT fuse_agg(U&'caf\00e9' || i) AS f FROM generate_series(1, 100) i;
+SET client_encoding = 'LATIN1';
+SELECT bool_and(fuse_contains(f, U&'caf\00e9' || i)) AS all_found,
+       bool_and(fuse_contains_any(f, ARRAY[U&'caf\00e9' || i, 'x'])) AS any_found
+FROM fuse_text, generate_series(1, 100) i;
+RESET client_encoding;
+
+-- Test parallel aggregation gives the serial result
+CREATE TABLE fuse_test_parallel AS SELECT id FROM fuse_test;
+ANALYZE fuse_test_parallel;
+SET parallel_setup_cost = 0;
+SET parallel_tuple_cost = 0;
+SET min_parallel_table_scan_size = 0;
+SET max_parallel_workers_per_gather = 2;
+EXPLAIN (COSTS OFF) SELECT fuse_agg(id) FROM fuse_test_parallel;
+SELECT fuse_agg(id)::text = (SELECT f8::text FROM fuse_filters),
+       fuse_agg(id, 16)::text = (SELECT f16::text FROM fuse_filters)
+FROM fuse_test_parallel;
+RESET parallel_setup_cost;
+RESET parallel_tuple_cost;
+RESET min_parallel_table_scan_size;
+RESET max_parallel_workers_per_gather;
+DROP TABLE fuse_test_parallel;
+
+-- Test errors
+SELECT fuse_agg(id, 4) FROM fuse_test;
+SELECT fuse_agg(id, NULL) FROM fuse_test;
+SELECT 'xyz'::fuse_filter;
+SELECT '\x010800000400000001000000000000000000000000000000'::fuse_filter;
+SELECT '\x010900000400000001000000000000006734d23725b2f66d000000000000000000000000'::fuse_filter;
+SELECT '\x010800000300000001000000000000006734d23725b2f66d000000000000000000000000'::fuse_filter;
+
+-- Test function properties
+SELECT 
+    proname,
+    provolatile,
+    proisstrict,
+    proparallel
+FROM pg_proc 
+WHERE proname LIKE 'fuse%'
+ORDER BY proname, proargtypes;
+
+-- Test extension metadata
+SELECT 
+    extname,
+    extversion
+FROM pg_extension 
+WHERE extname = 'hashlib';
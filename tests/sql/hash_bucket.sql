@@ -0,0 +1,95 @@
+-- Test hash_bucket functions
+
+-- Test values
+SELECT hash_bucket('abc', 10) AS text_key,
+       hash_bucket('abc'::bytea, 10) AS bytea_key,
+       hash_bucket(42, 10) AS integer_key,
+       hash_bucket(42::bigint, 10) AS bigint_key,
+       hash_bucket(42::smallint, 10) AS smallint_key,
+       hash_bucket('a0eebc99-9c0b-4ef8-bb6d-6bb9bd380a11'::uuid, 10) AS uuid_key;
+SELECT hash_bucket('abc', 1) AS one_bucket, hash_bucket('abc', 2147483647) AS max_buckets;
+
+-- Test text-like keys are placed as the same text, whatever the client_encoding
+SELECT hash_bucket(U&'caf\00e9', 1000) AS bucket \gset
+SET client_encoding = 'LATIN1';
+SELECT hash_bucket(U&'caf\00e9', 1000) = :bucket AS text_key,
+       hash_bucket(U&'caf\00e9'::varchar, 1000) = :bucket AS varchar_key,
+       hash_bucket(U&'caf\00e9'::char(4), 1000) = :bucket AS char_key,
+       hash_bucket(U&'caf\00e9'::name, 1000) = :bucket AS name_key,
+       hash_bucket('"a"'::json, 1000, 'wyhash') = hash_bucket('"a"', 1000, 'wyhash') AS json_key;
+RESET client_encoding;
+
+-- Test char(n) keys are placed without their pad spaces, as char(n) compares
+CREATE DOMAIN hash_bucket_code AS char(8);
+SELECT hash_bucket('a'::char(3), 1000) = hash_bucket('a'::char(5), 1000) AS padding_ignored,
+       hash_bucket('a'::char(3), 1000) = hash_bucket('a', 1000) AS same_as_text,
+       hash_bucket('a'::hash_bucket_code, 1000) = hash_bucket('a', 1000) AS domain_key;
+SELECT bool_and(hash_sample(('k' || i)::char(10), 0.5, i) = hash_sample('k' || i, 0.5, i)) AS sample_key
+FROM generate_series(1, 200) i;
+DROP DOMAIN hash_bucket_code;
+
+-- The bucket is (hash * n) >> 64 of the hash the SQL function returns
+CREATE FUNCTION hash_bucket_reference(h bigint, n integer) RETURNS integer
+LANGUAGE sql IMMUTABLE AS
+$$ SELECT floor(((h::numeric + CASE WHEN h < 0 THEN 18446744073709551616 ELSE 0 END) * n)
+                / 18446744073709551616)::integer $$;
+SELECT bool_and(hash_bucket(i::text, 1000) = hash_bucket_reference(xxhash3_64(i::text), 1000)) AS xxhash3_64_text,
+       bool_and(hash_bucket(i, 1000) = hash_bucket_reference(xxhash3_64(i), 1000)) AS xxhash3_64_integer,
+       bool_and(hash_bucket(i::text, 7, 'xxhash64') = hash_bucket_reference(xxhash64(i::text), 7)) AS xxhash64,
+       bool_and(hash_bucket(i::bigint, 7, 'wyhash') = hash_bucket_reference(wyhash(i::bigint), 7)) AS wyhash,
+       bool_and(hash_bucket(i::bigint, 7, 'rapidhash') = hash_bucket_reference(rapidhash(i::bigint), 7)) AS rapidhash,
+       bool_and(hash_bucket(i::text::bytea, 7, 'komihash') = hash_bucket_reference(komihash(i::text::bytea), 7)) AS komihash,
+       bool_and(hash_bucket(i, 7, 'cityhash64') = hash_bucket_reference(cityhash64(i), 7)) AS cityhash64,
+       bool_and(hash_bucket(i::text, 7, 'farmhash64') = hash_bucket_reference(farmhash64(i::text), 7)) AS farmhash64,
+       bool_and(hash_bucket(i::text, 7, 'metrohash64') = hash_bucket_reference(metrohash64(i::text), 7)) AS metrohash64
+FROM generate_series(1, 1000) i;
+DROP FUNCTION hash_bucket_reference(bigint, integer);
+
+-- Test the distribution over a bucket count that is not a power of two
+SELECT b, round(count(*) / 1000.0) AS thousands
+FROM (SELECT hash_bucket(i, 3) AS b FROM generate_series(1, 30000) i) s
+GROUP BY b ORDER BY b;
+
+-- Test the algorithm changing between rows
+SELECT a, hash_bucket('abc', 1000, a)
+FROM (VALUES (1, 'xxhash3_64'), (2, 'wyhash'), (3, 'xxhash3_64')) v(i, a)
+ORDER BY i;
+
+-- Test weighted buckets
+SELECT hash_bucket_weighted('abc', ARRAY[1, 1]::float8[]) AS two,
+       hash_bucket_weighted('abc', ARRAY[5]::float8[]) AS one,
+       hash_bucket_weighted('abc'::bytea, ARRAY[1, 2, 3]::float8[], 'wyhash') AS bytea_key;
+SELECT b, round(count(*) / 1000.0) AS thousands
+FROM (SELECT hash_bucket_weighted(i, ARRAY[1, 0, 2, 0]::float8[]) AS b FROM generate_series(1, 30000) i) s
+GROUP BY b ORDER BY b;
+SELECT bool_and(hash_bucket_weighted(i, ARRAY[1, 1, 1, 1]::float8[]) = hash_bucket(i, 4)) AS equal_weights_match
+FROM generate_series(1, 10000) i;
+SELECT i, hash_bucket_weighted(7, w)
+FROM (VALUES (1, ARRAY[1, 0]::float8[]), (2, ARRAY[0, 1]::float8[]), (3, ARRAY[1, 0]::float8[])) v(i, w)
+ORDER BY i;
+
+-- Test errors
+SELECT hash_bucket('abc', 0);
+SELECT hash_bucket('abc', 10, 'md5');
+SELECT hash_bucket_weighted('abc', '{}'::float8[]);
+SELECT hash_bucket_weighted('abc', ARRAY[1, NULL]::float8[]);
+SELECT hash_bucket_weighted('abc', ARRAY[1, -1]::float8[]);
+SELECT hash_bucket_weighted('abc', ARRAY[0, 0]::float8[]);
+SELECT hash_bucket_weighted('abc', ARRAY[[1], [2]]::float8[]);
+
+-- Test function properties
+SELECT 
+    proname,
+    provolatile,
+    proisstrict,
+    proparallel
+FROM pg_proc 
+WHERE proname IN ('hash_bucket', 'hash_bucket_weighted')
+ORDER BY proname, proargtypes;
+
+-- Test extension metadata
+SELECT 
+    extname,
+    extversion
+FROM pg_extension 
+WHERE extname = 'hashlib';
@@ -0,0 +1,71 @@
+-- Server-side files are hashed one block at a time; results must match the
+-- bytea functions applied to pg_read_binary_file
+SELECT current_setting('data_directory') || '/pg_stat_tmp/hashlib_hash_file.dat' AS path \gset
+SELECT current_setting('data_directory') || '/pg_stat_tmp/hashlib_check.dat' AS check_path \gset
+COPY (SELECT string_agg(md5(i::text), '') FROM generate_series(1, 70000) i) TO :'path';
+COPY (SELECT '123456789') TO :'check_path';
+
+SELECT length(pg_read_binary_file(:'path'));
+
+-- Test whole-file hashes against the bytea variants
+SELECT hash_file(:'path', 'xxhash3_64') = xxhash3_64(pg_read_binary_file(:'path')) AS xxhash3_64,
+       hash_file(:'path', 'crc32') = crc32(pg_read_binary_file(:'path')) AS crc32,
+       hash_file(:'path', 'crc64') = crc64(pg_read_binary_file(:'path')) AS crc64,
+       hash_file(:'path', 'crc64_nvme') = crc64_nvme(pg_read_binary_file(:'path')) AS crc64_nvme,
+       hash_file(:'path', 'crc64_ecma') = crc64_ecma(pg_read_binary_file(:'path')) AS crc64_ecma;
+
+-- Test check values ('123456789' plus the newline COPY writes)
+SELECT to_hex(hash_file(:'check_path', 'crc32c', 0, 9)::int) AS crc32c,
+       to_hex(hash_file(:'check_path', 'crc32', 0, 9)::int) AS crc32,
+       to_hex(hash_file(:'check_path', 'crc64', 0, 9)) AS crc64;
+
+-- Test ranges, including ones crossing block boundaries and past the end
+SELECT hash_file(:'path', 'xxhash3_64', 100, 5000) = xxhash3_64(pg_read_binary_file(:'path', 100, 5000)) AS small,
+       hash_file(:'path', 'crc64', 1048000, 2000) = crc64(pg_read_binary_file(:'path', 1048000, 2000)) AS boundary,
+       hash_file(:'path', 'crc32c', 2000000, 1000000) = hash_file(:'path', 'crc32c', 2000000, 240001) AS past_end,
+       hash_file(:'path', 'xxhash3_64', 5000000, 10) = xxhash3_64(''::bytea) AS beyond_eof,
+       hash_file(:'path', 'crc32', 0, 0) = crc32(''::bytea) AS empty;
+
+-- Test multi-range variant
+SELECT hash_file(:'path', 'xxhash3_64', ARRAY[0, 1048576, 2239990]::bigint[], ARRAY[1048576, 1048576, 100]::bigint[])
+     = ARRAY[xxhash3_64(pg_read_binary_file(:'path', 0, 1048576)),
+             xxhash3_64(pg_read_binary_file(:'path', 1048576, 1048576)),
+             xxhash3_64(pg_read_binary_file(:'path', 2239990, 100))] AS ranges;
+SELECT hash_file(:'path', 'crc32', '{}'::bigint[], '{}'::bigint[]);
+
+-- Test invalid arguments
+SELECT hash_file(:'path', 'md5');
+SELECT hash_file(:'path', 'crc32', -1, 10);
+SELECT hash_file(:'path', 'crc32', 0, -10);
+SELECT hash_file(:'path', 'crc32', ARRAY[0, 10]::bigint[], ARRAY[10]::bigint[]);
+SELECT hash_file(:'path', 'crc32', ARRAY[0, NULL]::bigint[], ARRAY[10, 10]::bigint[]);
+SELECT hash_file('hashlib_no_such_file', 'crc32') IS NULL;
+
+-- Test privilege check
+CREATE ROLE regress_hashlib_file_user;
+SET ROLE regress_hashlib_file_user;
+SELECT hash_file(:'path', 'crc32');
+RESET ROLE;
+DROP ROLE regress_hashlib_file_user;
+
+-- Test empty file (also leaves the scratch files empty)
+COPY (SELECT WHERE false) TO :'path';
+COPY (SELECT WHERE false) TO :'check_path';
+SELECT hash_file(:'path', 'xxhash3_64') = xxhash3_64(''::bytea) AS xxhash3_64,
+       hash_file(:'path', 'crc32c') AS crc32c;
+
+-- Test function properties
+SELECT 
+    proname,
+    provolatile,
+    proisstrict
+FROM pg_proc 
+WHERE proname IN ('hash_file')
+ORDER BY proname, proargtypes;
+
+-- Test extension metadata
+SELECT 
+    extname,
+    extversion
+FROM pg_extension 
+WHERE extname = 'hashlib';
@@ -0,0 +1,55 @@
+-- Test hash_permute functions
+
+-- Test values
+SELECT hash_permute(0, 10, 1) AS first, hash_permute(9, 10, 1) AS last,
+       hash_permute(0, 1, 1) AS size_1, hash_permute(12345, 1000000, -1) AS large;
+SELECT array_agg(p) AS permutation FROM hash_permute_series(10, 1) p;
+
+-- Test that every size gives a bijection of [0, n) and its inverse
+SELECT n,
+       (SELECT count(DISTINCT p) = n AND min(p) = 0 AND max(p) = n - 1
+        FROM hash_permute_series(n, 7) p) AS bijective,
+       (SELECT bool_and(hash_permute_inverse(hash_permute(i, n, 7), n, 7) = i)
+        FROM generate_series(0, n - 1) i) AS inverse
+FROM (VALUES (1::bigint), (2), (3), (4), (5), (17), (100), (1000), (65537)) v(n);
+SELECT hash_permute_inverse(hash_permute(9223372036854775806, 9223372036854775807, 1),
+                            9223372036854775807, 1) AS largest_size;
+
+-- Test the series against the scalar function, and pages of it
+SELECT bool_and(p = hash_permute(i - 1, 1000, 3)) AS series_matches
+FROM hash_permute_series(1000, 3) WITH ORDINALITY s(p, i);
+SELECT array_agg(p) AS page FROM hash_permute_series(10, 1, 3, 4) p;
+SELECT count(*) AS clipped FROM hash_permute_series(10, 1, 8, 100);
+SELECT count(*) AS past_end FROM hash_permute_series(10, 1, 20, 5);
+
+-- Test that seeds give different orders and that the order is shuffled
+SELECT (SELECT array_agg(p) FROM hash_permute_series(1000, 1) p) <>
+       (SELECT array_agg(p) FROM hash_permute_series(1000, 2) p) AS seeds_differ;
+SELECT round(corr(i, hash_permute(i, 100000, 5))::numeric, 1) AS correlation,
+       count(*) FILTER (WHERE hash_permute(i, 100000, 5) = i) < 10 AS few_fixed_points
+FROM generate_series(0, 99999) i;
+
+-- Test errors
+SELECT hash_permute(0, 0, 1);
+SELECT hash_permute(10, 10, 1);
+SELECT hash_permute(-1, 10, 1);
+SELECT hash_permute_inverse(10, 10, 1);
+SELECT hash_permute_series(-5, 1);
+SELECT hash_permute_series(10, 1, -1, 5);
+
+-- Test function properties
+SELECT 
+    proname,
+    provolatile,
+    proisstrict,
+    proparallel
+FROM pg_proc 
+WHERE proname LIKE 'hash_permute%'
+ORDER BY proname, proargtypes;
+
+-- Test extension metadata
+SELECT 
+    extname,
+    extversion
+FROM pg_extension 
+WHERE extname = 'hashlib';
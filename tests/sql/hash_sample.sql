@@ -0,0 +1,76 @@
+-- Test hash_sample and ab_bucket functions
+
+-- Test values
+SELECT hash_sample('abc', 0.5, 42) AS text_key,
+       hash_sample('abc'::bytea, 0.5, 42) AS bytea_key,
+       hash_sample(42, 0.5, 42) AS integer_key,
+       hash_sample('a0eebc99-9c0b-4ef8-bb6d-6bb9bd380a11'::uuid, 0.5, 42) AS uuid_key;
+SELECT hash_sample('abc', 0, 42) AS rate_0, hash_sample('abc', 1, 42) AS rate_1;
+
+-- A key is sampled when its unsigned xxhash3_64 with the seed is below rate * 2^64
+CREATE FUNCTION hash_sample_reference(h bigint, rate float8) RETURNS boolean
+LANGUAGE sql IMMUTABLE AS
+$$ SELECT h::numeric + CASE WHEN h < 0 THEN 18446744073709551616 ELSE 0 END
+          < rate::numeric * 18446744073709551616 $$;
+SELECT bool_and(hash_sample(i::text, 0.3, 7) = hash_sample_reference(xxhash3_64(i::text, 7), 0.3)) AS text_key,
+       bool_and(hash_sample(i::text::bytea, 0.3, -1) = hash_sample_reference(xxhash3_64(i::text::bytea, -1), 0.3)) AS bytea_key,
+       bool_and(hash_sample(i, 0.3, 7) = hash_sample_reference(xxhash3_64(i, 7), 0.3)) AS integer_key,
+       bool_and(hash_sample(i::varchar, 0.3, 7) = hash_sample_reference(xxhash3_64(i::text, 7), 0.3)) AS varchar_key
+FROM generate_series(1, 1000) i;
+DROP FUNCTION hash_sample_reference(bigint, float8);
+
+-- Test the sampled share, nesting and independence of seeds
+SELECT round(avg(hash_sample(i, 0.1, 1)::int), 2) AS rate_10,
+       bool_and(NOT hash_sample(i, 0.1, 1) OR hash_sample(i, 0.2, 1)) AS nested,
+       round(avg((hash_sample(i, 0.5, 1) AND hash_sample(i, 0.5, 2))::int), 2) AS two_seeds
+FROM generate_series(1, 100000) i;
+
+-- Test the rate changing between rows
+SELECT i, hash_sample('abc', r, 42)
+FROM (VALUES (1, 0.0::float8), (2, 1.0), (3, 0.0)) v(i, r)
+ORDER BY i;
+
+-- Test the row estimate from the sample rate
+CREATE TABLE hash_sample_test AS SELECT i AS id FROM generate_series(1, 10000) i;
+ANALYZE hash_sample_test;
+EXPLAIN (COSTS ON, SUMMARY OFF, TIMING OFF)
+SELECT * FROM hash_sample_test WHERE hash_sample(id, 0.05, 42);
+EXPLAIN (COSTS ON, SUMMARY OFF, TIMING OFF)
+SELECT * FROM hash_sample_test WHERE hash_sample(id, 0.25 * 2, 42);
+DROP TABLE hash_sample_test;
+
+-- Test experiment arms
+SELECT ab_bucket('user-1', ARRAY[1, 1]::float8[], 42) AS text_key,
+       ab_bucket('user-1'::bytea, ARRAY[1, 1]::float8[], 42) AS bytea_key,
+       ab_bucket(1, ARRAY[1, 1, 1]::float8[], 42) AS integer_key;
+SELECT b, round(count(*) / 1000.0) AS thousands
+FROM (SELECT ab_bucket(i, ARRAY[0.9, 0.05, 0.05]::float8[], 42) AS b FROM generate_series(1, 100000) i) s
+GROUP BY b ORDER BY b;
+SELECT bool_and((ab_bucket(i, ARRAY[1, 1]::float8[], 42) = 0) = hash_sample(i, 0.5, 42)) AS arms_match_sample,
+       round(avg((ab_bucket(i, ARRAY[1, 1]::float8[], 1) = ab_bucket(i, ARRAY[1, 1]::float8[], 2))::int), 2) AS two_seeds
+FROM generate_series(1, 100000) i;
+
+-- Test errors
+SELECT hash_sample('abc', -0.1, 42);
+SELECT hash_sample('abc', 1.5, 42);
+SELECT hash_sample('abc', 'NaN', 42);
+SELECT ab_bucket('abc', '{}'::float8[], 42);
+SELECT ab_bucket('abc', ARRAY[0, 0]::float8[], 42);
+
+-- Test function properties
+SELECT 
+    proname,
+    provolatile,
+    proisstrict,
+    proparallel,
+    prosupport
+FROM pg_proc 
+WHERE proname IN ('hash_sample', 'hash_sample_support', 'ab_bucket')
+ORDER BY proname, proargtypes;
+
+-- Test extension metadata
+SELECT 
+    extname,
+    extversion
+FROM pg_extension 
+WHERE extname = 'hashlib';
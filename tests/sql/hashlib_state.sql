@@ -0,0 +1,91 @@
+-- Test streaming XXH3 against the one-shot functions
+SELECT xxh3_final(xxh3_init());
+SELECT xxh3_final(xxh3_update(xxh3_init(), 'hello world'));
+SELECT xxh3_final(xxh3_update(xxh3_update(xxh3_init(), 'hello '), 'world')) = xxhash3_64('hello world');
+SELECT xxh3_final(xxh3_update(xxh3_update(xxh3_init(42), 'hello '), 'world'::bytea)) = xxhash3_64('hello world', 42);
+SELECT xxh3_final128(xxh3_update(xxh3_update(xxh3_init(), 'hello '), 'world')) = xxhash3_128('hello world');
+
+-- Test XXH3 across the short, midsize and long-input paths
+SELECT len,
+       xxh3_final(xxh3_update(xxh3_update(xxh3_init(), left(repeat('0123456789abcdef', 200), len / 3)),
+                              substr(repeat('0123456789abcdef', 200), len / 3 + 1, len - len / 3)))
+         = xxhash3_64(left(repeat('0123456789abcdef', 200), len)) AS xxh3_64,
+       xxh3_final128(xxh3_update(xxh3_update(xxh3_init(), left(repeat('0123456789abcdef', 200), len / 3)),
+                                 substr(repeat('0123456789abcdef', 200), len / 3 + 1, len - len / 3)))
+         = xxhash3_128(left(repeat('0123456789abcdef', 200), len)) AS xxh3_128
+FROM unnest(ARRAY[0, 16, 17, 128, 129, 240, 241, 256, 257, 320, 1024, 1025, 3000]) len;
+
+-- Test XXH3 with many small updates
+SELECT xxh3_final(s) = xxhash3_64(repeat('abcdefg', 500))
+FROM (SELECT xxh3_update(xxh3_update(xxh3_update(xxh3_update(xxh3_update(xxh3_init(),
+             repeat('abcdefg', 100)), repeat('abcdefg', 100)), repeat('abcdefg', 100)),
+             repeat('abcdefg', 100)), repeat('abcdefg', 100)) AS s) q;
+
+-- Test streaming SpookyHash against the one-shot functions
+SELECT spooky_final(spooky_update(spooky_init(), 'hello world'));
+SELECT spooky_final(spooky_update(spooky_update(spooky_init(7), 'hello '), 'world')) = spookyhash64('hello world', 7);
+SELECT spooky_final128(spooky_update(spooky_update(spooky_init(1, 2), 'hello '), 'world')) = spookyhash128('hello world', 1, 2);
+SELECT len,
+       spooky_final(spooky_update(spooky_update(spooky_init(), left(repeat('0123456789abcdef', 200), len / 3)),
+                                  substr(repeat('0123456789abcdef', 200), len / 3 + 1, len - len / 3)))
+         = spookyhash64(left(repeat('0123456789abcdef', 200), len)) AS spooky
+FROM unnest(ARRAY[0, 15, 32, 191, 192, 193, 287, 288, 289, 3000]) len;
+
+-- Test streaming HighwayHash against the one-shot functions
+SELECT highwayhash_final(highwayhash_update(highwayhash_init(), 'hello world'));
+SELECT highwayhash_final(highwayhash_update(highwayhash_update(highwayhash_init(), 'hello '), 'world')) = highwayhash64('hello world');
+SELECT highwayhash_final128(highwayhash_update(highwayhash_update(highwayhash_init(1, 2, 3, 4), 'hello '), 'world'))
+       = highwayhash128('hello world', 1, 2, 3, 4);
+SELECT highwayhash_final256(highwayhash_update(highwayhash_update(highwayhash_init(), repeat('x', 45)), repeat('y', 50)))
+       = highwayhash256(repeat('x', 45) || repeat('y', 50));
+
+-- Test state inspection
+SELECT hashlib_state_algorithm(xxh3_init()), hashlib_state_algorithm(spooky_init()), hashlib_state_algorithm(highwayhash_init());
+SELECT hashlib_state_length(xxh3_update(xxh3_update(xxh3_init(), repeat('a', 1000)), repeat('b', 500)));
+
+-- Test that a state survives a text round trip and a table checkpoint
+SELECT xxh3_final(xxh3_update(xxh3_update(xxh3_init(), repeat('a', 1000))::text::hashlib_state, 'end'))
+       = xxhash3_64(repeat('a', 1000) || 'end');
+CREATE TEMP TABLE upload_state (id int PRIMARY KEY, state hashlib_state);
+INSERT INTO upload_state VALUES (1, xxh3_init());
+UPDATE upload_state SET state = xxh3_update(state, repeat('chunk one ', 50)) WHERE id = 1;
+UPDATE upload_state SET state = xxh3_update(state, repeat('chunk two ', 50)) WHERE id = 1;
+SELECT xxh3_final(state) = xxhash3_64(repeat('chunk one ', 50) || repeat('chunk two ', 50)),
+       hashlib_state_length(state)
+FROM upload_state WHERE id = 1;
+
+-- Test binary output size (constant regardless of input size)
+SELECT length(hashlib_state_send(xxh3_init())), length(hashlib_state_send(xxh3_update(xxh3_init(), repeat('x', 100000))));
+
+-- Test binary COPY round trip, and that trailing bytes are rejected
+CREATE TEMP TABLE state_wire (wire bytea);
+CREATE TEMP TABLE state_copy (state hashlib_state);
+INSERT INTO state_wire SELECT hashlib_state_send(xxh3_update(xxh3_init(), 'abc'));
+\copy state_wire TO 'results/hashlib_state_wire.copy' WITH (FORMAT binary)
+\copy state_copy FROM 'results/hashlib_state_wire.copy' WITH (FORMAT binary)
+SELECT xxh3_final(state) = xxhash3_64('abc') FROM state_copy;
+UPDATE state_wire SET wire = wire || '\x00'::bytea;
+\copy state_wire TO 'results/hashlib_state_wire.copy' WITH (FORMAT binary)
+\copy state_copy FROM 'results/hashlib_state_wire.copy' WITH (FORMAT binary)
+
+-- Test error handling
+SELECT xxh3_final(spooky_init());
+SELECT spooky_update(highwayhash_init(), 'data');
+SELECT 'xxh3:00'::hashlib_state;
+SELECT 'nonsense'::hashlib_state;
+
+-- Test function properties
+SELECT 
+    proname,
+    provolatile,
+    proisstrict
+FROM pg_proc 
+WHERE proname ~ '^(xxh3|spooky|highwayhash)_(init|update|final)'
+ORDER BY proname, proargtypes;
+
+-- Test extension metadata
+SELECT 
+    extname,
+    extversion
+FROM pg_extension 
+WHERE extname = 'hashlib';
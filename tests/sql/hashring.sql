@@ -0,0 +1,114 @@
+-- Test hashring functions
+
+-- Test nodes and shares
+SELECT node, weight, round(share::numeric, 4) AS share
+FROM ring_nodes(hashring(ARRAY['c', 'a', 'b']));
+SELECT node, weight, round(share::numeric, 4) AS share
+FROM ring_nodes(hashring(ARRAY['a', 'b', 'c'], ARRAY[1, 1, 2]::float8[]));
+SELECT node, weight, share
+FROM ring_nodes(hashring(ARRAY['a', 'b'], ARRAY[1, 0]::float8[]));
+
+-- Test the table size: 65537 slots of 2 bytes at least, 100 slots per node
+SELECT length(hashring(ARRAY['a', 'b', 'c'])::bytea) AS three,
+       length(hashring(ARRAY(SELECT 'node' || g FROM generate_series(1, 1000) g))::bytea) AS thousand;
+
+-- Test lookups
+SELECT ring_lookup(hashring(ARRAY['a', 'b', 'c']), 42::bigint) AS bigint_key,
+       ring_lookup(hashring(ARRAY['a', 'b', 'c']), 'abc'::text) AS text_key,
+       ring_lookup(hashring(ARRAY['a', 'b', 'c']), 'abc'::bytea) AS bytea_key;
+SELECT ring_lookup(hashring(ARRAY['a', 'b', 'c']), 'abc'::text) =
+       ring_lookup(hashring(ARRAY['a', 'b', 'c']), xxhash3_64('abc'::text)) AS text_is_xxhash3;
+SELECT ring_lookup(hashring(ARRAY['only']), 7::bigint);
+
+-- The ring depends only on the nodes and weights, not their order
+SELECT hashring(ARRAY['a', 'b', 'c'])::bytea = hashring(ARRAY['c', 'b', 'a'])::bytea AS same_ring;
+
+-- Test balance and movement
+SELECT node, round(count(*) / 1000.0) AS thousands
+FROM (SELECT ring_lookup(hashring(ARRAY['a', 'b', 'c', 'd']), i::text) AS node
+      FROM generate_series(1, 100000) i) s
+GROUP BY node ORDER BY node;
+SELECT round(avg((n3 <> n4)::int), 2) AS moved,
+       round(avg((n3 <> n4 AND n4 <> 'd')::int), 2) AS moved_between_old
+FROM (SELECT ring_lookup(hashring(ARRAY['a', 'b', 'c']), i::text) AS n3,
+             ring_lookup(hashring(ARRAY['a', 'b', 'c', 'd']), i::text) AS n4
+      FROM generate_series(1, 100000) i) s;
+
+-- Test diffs
+SELECT old_node, new_node, round(share::numeric, 2) AS share
+FROM ring_diff(hashring(ARRAY['a', 'b', 'c']), hashring(ARRAY['a', 'c']))
+WHERE share > 0.01;
+SELECT round(sum(share)::numeric, 2) AS moved
+FROM ring_diff(hashring(ARRAY['a', 'b', 'c']), hashring(ARRAY['a', 'b', 'c', 'd']));
+SELECT count(*) FROM ring_diff(hashring(ARRAY['a', 'b']), hashring(ARRAY['b', 'a']));
+SELECT abs(d.share - k.moved / 100000.0) < 0.01 AS diff_matches_keys
+FROM (SELECT sum(share) AS share
+      FROM ring_diff(hashring(ARRAY['a', 'b', 'c']), hashring(ARRAY['a', 'b', 'c'], ARRAY[1, 1, 3]::float8[]))) d,
+     (SELECT count(*) FILTER (WHERE ring_lookup(hashring(ARRAY['a', 'b', 'c']), i::bigint)
+                                  <> ring_lookup(hashring(ARRAY['a', 'b', 'c'], ARRAY[1, 1, 3]::float8[]), i::bigint)) AS moved
+      FROM generate_series(1, 100000) i) k;
+
+-- Test the aggregate
+SELECT hashring_agg(n)::bytea = hashring(ARRAY['a', 'b', 'c'])::bytea AS agg_matches
+FROM (VALUES ('b'), ('a'), (NULL), ('c')) v(n);
+SELECT hashring_agg(n, w)::bytea = hashring(ARRAY['a', 'b'], ARRAY[2, 1]::float8[])::bytea AS weighted_agg_matches
+FROM (VALUES ('a', 2.0), ('b', 1.0)) v(n, w);
+SELECT hashring_agg(n) IS NULL AS empty FROM (VALUES ('a')) v(n) WHERE false;
+
+-- Test text, binary and bytea round trips
+CREATE TABLE hashring_test (id int, ring hashring);
+INSERT INTO hashring_test VALUES (1, hashring(ARRAY['a', 'b', 'c']));
+SELECT ring::text::hashring::bytea = ring::bytea AS text_round_trip,
+       hashring(ring::bytea)::bytea = ring::bytea AS bytea_round_trip
+FROM hashring_test;
+SELECT ring_lookup(ring, i::bigint) = ring_lookup(hashring(ARRAY['a', 'b', 'c']), i::bigint) AS stored_lookup
+FROM hashring_test, generate_series(1, 3) i;
+
+-- Test parallel aggregation and lookups
+INSERT INTO hashring_test SELECT i, NULL FROM generate_series(2, 20000) i;
+ANALYZE hashring_test;
+SET parallel_setup_cost = 0;
+SET parallel_tuple_cost = 0;
+SET min_parallel_table_scan_size = 0;
+SET max_parallel_workers_per_gather = 2;
+EXPLAIN (COSTS OFF) SELECT hashring_agg(id::text) FROM hashring_test;
+SELECT hashring_agg(id::text)::bytea = hashring(ARRAY(SELECT id::text FROM hashring_test))::bytea AS parallel_matches
+FROM hashring_test;
+SELECT count(*) FILTER (WHERE ring_lookup(hashring(ARRAY['a', 'b', 'c']), t.id::bigint) = 'a') AS parallel_a
+FROM hashring_test t;
+RESET parallel_setup_cost;
+RESET parallel_tuple_cost;
+RESET min_parallel_table_scan_size;
+RESET max_parallel_workers_per_gather;
+SELECT count(*) FILTER (WHERE ring_lookup(hashring(ARRAY['a', 'b', 'c']), t.id::bigint) = 'a') AS serial_a
+FROM hashring_test t;
+DROP TABLE hashring_test;
+
+-- Test errors
+SELECT hashring('{}'::text[]);
+SELECT hashring(ARRAY['a', NULL]);
+SELECT hashring(ARRAY['a', 'a']);
+SELECT hashring(ARRAY[['a'], ['b']]);
+SELECT hashring(ARRAY['a', 'b'], ARRAY[1]::float8[]);
+SELECT hashring(ARRAY['a', 'b'], ARRAY[1, -1]::float8[]);
+SELECT hashring(ARRAY['a', 'b'], ARRAY[0, 0]::float8[]);
+SELECT hashring_agg(n) FROM (VALUES ('a'), ('a')) v(n);
+SELECT '\x01'::bytea::hashring;
+SELECT 'zz'::hashring;
+
+-- Test function properties
+SELECT 
+    proname,
+    provolatile,
+    proisstrict,
+    proparallel
+FROM pg_proc 
+WHERE proname IN ('hashring', 'ring_lookup', 'ring_nodes', 'ring_diff', 'hashring_agg')
+ORDER BY proname, proargtypes;
+
+-- Test extension metadata
+SELECT 
+    extname,
+    extversion
+FROM pg_extension 
+WHERE extname = 'hashlib';
@@ -0,0 +1,107 @@
+-- Exact hash sets
+CREATE TEMP TABLE hashset_test AS
+SELECT i AS id, md5(i::text)::uuid AS u FROM generate_series(1, 100000) i;
+
+CREATE TEMP TABLE hashsets AS
+SELECT hashset_agg(id) AS hi, hashset_agg(id::bigint * 3) AS hb, hashset_agg(u) AS hu
+FROM hashset_test;
+
+-- Test every value is found and no other value is
+SELECT bool_and(hashset_contains(hi, id)) AND bool_and(hashset_contains(hu, u)) AS all_found,
+       bool_and(hashset_contains(hb, id::bigint * 3)) AS all_found_bigint
+FROM hashset_test, hashsets;
+SELECT count(*) FILTER (WHERE hashset_contains(hi, i)) AS found_int,
+       count(*) FILTER (WHERE hashset_contains(hb, i::bigint * 3 + 1)) AS found_bigint,
+       count(*) FILTER (WHERE hashset_contains(hu, md5((-i)::text)::uuid)) AS found_uuid
+FROM generate_series(100001, 200000) i, hashsets;
+SELECT hashset_count(hi), length(hi::bytea), hashset_count(hu), length(hu::bytea)
+FROM hashsets;
+
+-- Test integer and bigint values are the same keys
+SELECT hashset_contains(hi, 42::bigint), hashset_contains(hb, 42::int),
+       hashset_contains(hb, 4294967296::bigint * 3),
+       hashset_contains(hashset_add(hb, 4294967296::bigint * 3), 4294967296::bigint * 3)
+FROM hashsets;
+
+-- Test hashset from arrays, with duplicates, NULLs, zero and negative values
+SELECT hashset_count(s), hashset_contains(s, 0), hashset_contains(s, -5),
+       hashset_contains(s, 5), hashset_contains(s, 1)
+FROM (SELECT hashset(ARRAY[-5, 0, 5, 5, NULL, -5]) AS s) t;
+SELECT hashset_count(s), hashset_contains(s, '00000000-0000-0000-0000-000000000000'::uuid),
+       hashset_contains(s, 'a0eebc99-9c0b-4ef8-bb6d-6bb9bd380a11'::uuid)
+FROM (SELECT hashset(ARRAY['00000000-0000-0000-0000-000000000000',
+                           'a0eebc99-9c0b-4ef8-bb6d-6bb9bd380a11']::uuid[]) AS s) t;
+SELECT hashset(ARRAY[1, 2]::bigint[]);
+SELECT hashset_count(hashset('{}'::int[])), hashset_contains(hashset('{}'::uuid[]),
+       'a0eebc99-9c0b-4ef8-bb6d-6bb9bd380a11'::uuid);
+
+-- Test hashset_add grows the set and keeps existing values
+SELECT min(hashset_count(s)), bool_and(hashset_contains(s, i))
+FROM (SELECT hashset_add(hashset_add(hashset(ARRAY(SELECT generate_series(1, 95))), 96), 0) AS s) t,
+     generate_series(0, 96) i;
+SELECT length(hashset(ARRAY(SELECT generate_series(1, 96)))::bytea),
+       length(hashset_add(hashset(ARRAY(SELECT generate_series(1, 96))), 97)::bytea);
+SELECT hashset_count(hashset_add(hashset_add(hashset('{}'::uuid[]),
+       'a0eebc99-9c0b-4ef8-bb6d-6bb9bd380a11'::uuid), 'a0eebc99-9c0b-4ef8-bb6d-6bb9bd380a11'::uuid));
+
+-- Test a stored set is probed for each row
+CREATE TEMP TABLE hashset_stored AS SELECT hi FROM hashsets;
+SELECT count(*) FROM generate_series(1, 200000, 3) i, hashset_stored WHERE hashset_contains(hi, i);
+
+-- Test NULLs are ignored and no rows give NULL
+SELECT hashset_count(hashset_agg(v)) FROM (VALUES (1), (NULL)) s(v);
+SELECT hashset_agg(id) FROM hashset_test WHERE false;
+
+-- Test text and bytea round trips
+SELECT hi::text::hashset::text = hi::text, hashset(hu::bytea)::bytea = hu::bytea
+FROM hashsets;
+
+-- Test parallel aggregation gives the serial set
+CREATE TABLE hashset_test_parallel AS SELECT id, u FROM hashset_test;
+ANALYZE hashset_test_parallel;
+SET parallel_setup_cost = 0;
+SET parallel_tuple_cost = 0;
+SET min_parallel_table_scan_size = 0;
+SET max_parallel_workers_per_gather = 2;
+EXPLAIN (COSTS OFF) SELECT hashset_agg(id) FROM hashset_test_parallel;
+CREATE TEMP TABLE hashsets_parallel AS
+SELECT hashset_agg(id) AS hi, hashset_agg(u) AS hu FROM hashset_test_parallel;
+RESET parallel_setup_cost;
+RESET parallel_tuple_cost;
+RESET min_parallel_table_scan_size;
+RESET max_parallel_workers_per_gather;
+SELECT hashset_count(p.hi) = hashset_count(s.hi) AND hashset_count(p.hu) = hashset_count(s.hu)
+FROM hashsets_parallel p, hashsets s;
+SELECT bool_and(hashset_contains(hi, id)) AND bool_and(hashset_contains(hu, u))
+FROM hashset_test, hashsets_parallel;
+DROP TABLE hashset_test_parallel;
+
+-- Test errors
+SELECT hashset_contains(hashset(ARRAY[1]), 'a0eebc99-9c0b-4ef8-bb6d-6bb9bd380a11'::uuid);
+SELECT hashset_add(hashset('{}'::uuid[]), 1);
+SELECT hashset(ARRAY['a']);
+CREATE FUNCTION pg_temp.hashset_text(text[]) RETURNS hashset
+AS 'hashlib', 'hashset_from_array' LANGUAGE C IMMUTABLE STRICT;
+SELECT pg_temp.hashset_text(ARRAY[NULL, NULL]::text[]);
+DROP FUNCTION pg_temp.hashset_text(text[]);
+SELECT 'xyz'::hashset;
+SELECT '\x01080000000000000000000000000000'::hashset;
+SELECT '\x01070000000000000000000000000000'::hashset;
+SELECT hashset_add(('\x01080000000000000500000000000000' || repeat('00', 64))::hashset, 1);
+
+-- Test function properties
+SELECT 
+    proname,
+    provolatile,
+    proisstrict,
+    proparallel
+FROM pg_proc 
+WHERE proname LIKE 'hashset%'
+ORDER BY proname, proargtypes;
+
+-- Test extension metadata
+SELECT 
+    extname,
+    extversion
+FROM pg_extension 
+WHERE extname = 'hashlib';
@@ -0,0 +1,112 @@
+-- HyperLogLog sketches
+CREATE TEMP TABLE hll_test AS
+SELECT i AS id, md5(i::text) AS name
+FROM generate_series(1, 100000) i;
+
+-- Test estimates are close to the true count, from sparse to dense
+SELECT n, abs(hll_cardinality(h) - n) / n < 0.02 AS close, hll_precision(h), length(h::bytea)
+FROM (SELECT n, (SELECT hll_add_agg(xxhash3_64(name)) FROM hll_test WHERE id <= n) AS h
+      FROM unnest(ARRAY[1, 10, 100, 1000, 5000, 100000]) n) s
+ORDER BY n;
+SELECT abs(hll_cardinality(hll_add_agg(wyhash(name), 10)) - 100000) / 100000 < 0.1 AS close
+FROM hll_test;
+
+-- Test that duplicates do not count
+SELECT round(hll_cardinality(hll_add_agg(xxhash3_64((id % 50)::text))))
+FROM hll_test;
+
+-- Test union, the union aggregate and that order does not matter
+SELECT hll_union(a, b)::text = hll_union(b, a)::text,
+       abs(hll_cardinality(hll_union(a, b)) - 100000) / 100000 < 0.02 AS close
+FROM (SELECT hll_add_agg(id) FILTER (WHERE id <= 60000) AS a,
+             hll_add_agg(id) FILTER (WHERE id > 40000) AS b
+      FROM hll_test) s;
+SELECT hll_union_agg(h)::text = (SELECT hll_add_agg(id)::text FROM hll_test)
+FROM (SELECT hll_add_agg(id) AS h FROM hll_test GROUP BY id % 7) s;
+SELECT hll_union_agg(h)::text = (SELECT hll_add_agg(id)::text FROM hll_test WHERE id <= 300)
+FROM (SELECT hll_add_agg(id) AS h FROM hll_test WHERE id <= 300 GROUP BY id % 7) s;
+
+-- Test sketches of different precisions combine at the lower one, as if built there
+SELECT n, hll_precision(hll_union(a, b)),
+       hll_union(a, b)::text = c::text AS union_folds,
+       hll_union(b, a)::text = c::text AS union_folds_either_way
+FROM (SELECT n, (SELECT hll_add_agg(id, 14) FROM hll_test WHERE id <= n) AS a,
+             hll_empty(10) AS b,
+             (SELECT hll_add_agg(id, 10) FROM hll_test WHERE id <= n) AS c
+      FROM unnest(ARRAY[1, 100, 1000, 100000]) n) s
+ORDER BY n;
+SELECT hll_precision(hll_union_agg(h)),
+       hll_union_agg(h)::text = (SELECT hll_add_agg(id, 6)::text FROM hll_test)
+FROM (SELECT hll_add_agg(id, 6 + id % 3 * 5) AS h FROM hll_test GROUP BY id % 3) s;
+SELECT hll_union(hll_empty(4), hll_empty(5));
+
+-- Test hll_add and hll_empty
+SELECT hll_empty(), hll_empty(4), hll_add(hll_empty(4), 1);
+SELECT hll_add(hll_add(hll_empty(), 1), 2)::text = (SELECT hll_add_agg(v)::text FROM (VALUES (2), (1)) s(v));
+SELECT hll_cardinality(hll_empty());
+
+-- Test approx_count_distinct over values of any type
+SELECT approx_count_distinct(name) = hll_cardinality(hll_add_agg(xxhash3_64(name))) AS same_as_text_sketch,
+       abs(approx_count_distinct(id) - 100000) / 100000 < 0.02 AS close_integer,
+       round(approx_count_distinct(id % 50)) AS duplicates,
+       abs(approx_count_distinct(ROW(id % 1000, name)) - 100000) / 100000 < 0.02 AS close_row
+FROM hll_test;
+SELECT round(approx_count_distinct(v)), approx_count_distinct(v) FILTER (WHERE false)
+FROM (VALUES (1), (NULL), (1), (2)) s(v);
+
+-- Test NULLs are ignored and no rows give NULL
+SELECT hll_add_agg(v) FROM (VALUES (NULL::bigint)) s(v);
+SELECT hll_add_agg(id) FROM hll_test WHERE false;
+SELECT hll_cardinality(hll_add_agg(v)) FROM (VALUES (1::bigint), (NULL)) s(v);
+
+-- Test text, binary and bytea round trips
+SELECT hll_add_agg(id, 4) FROM hll_test WHERE id <= 5;
+SELECT h::text::hll::text = h::text, hll(h::bytea)::bytea = h::bytea FROM (SELECT hll_add_agg(id) AS h FROM hll_test) s;
+CREATE TEMP TABLE hll_rollup (day integer, h hll);
+INSERT INTO hll_rollup SELECT id % 3, hll_add_agg(id) FROM hll_test GROUP BY 1;
+SELECT round(hll_cardinality(hll_union_agg(h)) / 1000) FROM hll_rollup;
+\copy hll_rollup TO '/dev/null' WITH (FORMAT binary)
+
+-- Test parallel aggregation gives the serial result
+SELECT hll_add_agg(xxhash3_64(name))::text AS serial, approx_count_distinct(id) AS serial_count FROM hll_test \gset
+CREATE TABLE hll_test_parallel AS SELECT id, xxhash3_64(name) AS h FROM hll_test;
+ANALYZE hll_test_parallel;
+SET parallel_setup_cost = 0;
+SET parallel_tuple_cost = 0;
+SET min_parallel_table_scan_size = 0;
+SET max_parallel_workers_per_gather = 2;
+EXPLAIN (COSTS OFF) SELECT hll_add_agg(h) FROM hll_test_parallel;
+SELECT hll_add_agg(h)::text = :'serial' FROM hll_test_parallel;
+EXPLAIN (COSTS OFF) SELECT approx_count_distinct(id) FROM hll_test_parallel;
+SELECT approx_count_distinct(id) = :serial_count FROM hll_test_parallel;
+RESET parallel_setup_cost;
+RESET parallel_tuple_cost;
+RESET min_parallel_table_scan_size;
+RESET max_parallel_workers_per_gather;
+DROP TABLE hll_test_parallel;
+
+-- Test errors
+SELECT hll_empty(3);
+SELECT hll_add_agg(id, 19) FROM hll_test;
+SELECT 'abc'::hll;
+SELECT '\x01'::hll;
+SELECT '\x0104020000'::hll;
+SELECT '\x01040100000f0000'::hll;
+SELECT '\x010401000002000002010000'::hll;
+
+-- Test function properties
+SELECT 
+    proname,
+    provolatile,
+    proisstrict,
+    proparallel
+FROM pg_proc 
+WHERE proname LIKE 'hll%'
+ORDER BY proname, proargtypes;
+
+-- Test extension metadata
+SELECT 
+    extname,
+    extversion
+FROM pg_extension 
+WHERE extname = 'hashlib';
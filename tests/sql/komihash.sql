@@ -0,0 +1,100 @@
+-- Test basic hash functionality with text
+SELECT komihash('hello world');
+
+-- Test hash with different text inputs
+SELECT komihash('test string');
+SELECT komihash('another test');
+
+-- Test text input with custom seed
+SELECT komihash('hello world', 42);
+SELECT komihash('hello world', 84);
+
+-- Test bytea input
+SELECT komihash('hello world'::bytea);
+
+-- Test bytea input with custom seed
+SELECT komihash('hello world'::bytea, 42);
+
+-- Test integer input
+SELECT komihash(12345);
+SELECT komihash(-12345);
+
+-- Test integer input with custom seed
+SELECT komihash(12345, 42);
+SELECT komihash(-12345, 84);
+
+-- Test bigint input
+SELECT komihash(123456789012345::bigint);
+SELECT komihash(-123456789012345::bigint);
+
+-- Test bigint input with custom seed
+SELECT komihash(123456789012345::bigint, 42);
+SELECT komihash(-123456789012345::bigint, 84);
+
+-- Test consistency (same input should give same hash)
+SELECT komihash('consistent test') = komihash('consistent test');
+
+-- Test seed effect (same input, different seeds should give different hashes)
+SELECT komihash('seed test', 1) != komihash('seed test', 2);
+
+-- Test empty string
+SELECT komihash('');
+
+-- Test single character
+SELECT komihash('a');
+
+-- Test long string
+SELECT komihash('Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod tempor incididunt ut labore et dolore magna aliqua. Ut enim ad minim veniam, quis nostrud exercitation ullamco laboris nisi ut aliquip ex ea commodo consequat.');
+
+-- Test various input lengths to test different code paths
+SELECT komihash('1234567');           -- 7 bytes
+SELECT komihash('12345678');          -- 8 bytes  
+SELECT komihash('123456789012345');   -- 15 bytes
+SELECT komihash('1234567890123456');  -- 16 bytes
+SELECT komihash('12345678901234567890123456789012'); -- 32 bytes
+SELECT komihash('123456789012345678901234567890123'); -- 33 bytes
+SELECT komihash('1234567890123456789012345678901234567890123456789012345'); -- 55 bytes
+
+-- Test reference vectors from the komihash distribution
+SELECT to_hex(komihash('This is a 32-byte testing string'));
+SELECT to_hex(komihash('The cat is out of the bag'));
+SELECT to_hex(komihash('A 16-byte string'));
+SELECT to_hex(komihash('The new string'));
+SELECT to_hex(komihash('7 chars'));
+
+-- Test lengths above 63 bytes (4-lane bulk loop)
+SELECT komihash(repeat('0123456789abcdef', 4));   -- 64 bytes
+SELECT komihash(repeat('0123456789abcdef', 9));   -- 144 bytes
+
+-- Test zero values
+SELECT komihash(0);
+SELECT komihash(0::bigint);
+
+-- Test maximum values
+SELECT komihash(2147483647);          -- max int4
+SELECT komihash(-2147483648);         -- min int4
+SELECT komihash(9223372036854775807::bigint);  -- max int8
+SELECT komihash(-9223372036854775808::bigint); -- min int8
+
+-- Test with various seeds
+SELECT komihash('test', 0);
+SELECT komihash('test', 1);
+SELECT komihash('test', -1);
+SELECT komihash('test', 9223372036854775807::bigint);   -- max positive seed
+SELECT komihash('test', -9223372036854775808::bigint);  -- max negative seed
+
+-- Test function properties
+SELECT 
+    proname,
+    provolatile,
+    proisstrict
+FROM pg_proc 
+WHERE proname = 'komihash'
+ORDER BY proname, proargtypes;
+
+-- Test extension metadata
+SELECT 
+    extname,
+    extversion
+FROM pg_extension 
+WHERE extname = 'hashlib';
\ No newline at end of file
@@ -0,0 +1,54 @@
+-- Large objects are hashed a few pages at a time; results must match hashing
+-- lo_get(oid) in memory
+CREATE TEMP TABLE lo_test (id int, lo oid);
+INSERT INTO lo_test
+SELECT n, lo_from_bytea(0, convert_to(string_agg(md5(i::text || n), ''), 'UTF8'))
+FROM generate_series(1, 2) n, generate_series(1, 30000 + n * 777) i
+GROUP BY n;
+INSERT INTO lo_test VALUES (3, lo_from_bytea(0, '')),
+                           (4, lo_from_bytea(0, 'hello world')),
+                           (5, lo_from_bytea(0, convert_to(repeat('x', 4096), 'UTF8')));
+
+-- Test sizes (empty, short, page multiple, several read buffers)
+SELECT id, length(lo_get(lo)) FROM lo_test ORDER BY id;
+
+-- Test against the bytea variants
+SELECT id,
+       lo_xxhash3_64(lo) = xxhash3_64(lo_get(lo)) AS xxhash3_64,
+       lo_xxhash3_64(lo, 42) = xxhash3_64(lo_get(lo), 42) AS xxhash3_64_seed,
+       lo_xxhash3_128(lo) = xxhash3_128(lo_get(lo)) AS xxhash3_128,
+       lo_xxhash3_128(lo, 42) = xxhash3_128(lo_get(lo), 42) AS xxhash3_128_seed,
+       lo_crc32(lo) = crc32(lo_get(lo)) AS crc32,
+       lo_crc32(lo, 7) = crc32(lo_get(lo), 7) AS crc32_seed
+FROM lo_test ORDER BY id;
+
+-- Test known values
+SELECT lo_xxhash3_64(lo), lo_xxhash3_128(lo), lo_crc32(lo) FROM lo_test WHERE id = 4;
+
+-- Test that a modified object hashes differently
+SELECT lo_put(lo, 0, 'j') FROM lo_test WHERE id = 4;
+SELECT lo_xxhash3_64(lo) = xxhash3_64('jello world'::bytea) AS updated FROM lo_test WHERE id = 4;
+
+-- Test missing large object
+SELECT lo_xxhash3_64(0);
+
+-- Test NULL input
+SELECT lo_crc32(NULL) IS NULL;
+
+SELECT count(lo_unlink(lo)) FROM lo_test;
+
+-- Test function properties
+SELECT 
+    proname,
+    provolatile,
+    proisstrict
+FROM pg_proc 
+WHERE proname IN ('lo_xxhash3_64', 'lo_xxhash3_128', 'lo_crc32')
+ORDER BY proname, proargtypes;
+
+-- Test extension metadata
+SELECT 
+    extname,
+    extversion
+FROM pg_extension 
+WHERE extname = 'hashlib';
@@ -0,0 +1,104 @@
+-- Minimal perfect hash functions
+CREATE TEMP TABLE mphf_test AS
+SELECT i AS id, 'sku-' || i AS name FROM generate_series(1, 100000) i;
+
+CREATE TEMP TABLE mphfs AS
+SELECT mphf_agg(name) AS m FROM mphf_test;
+
+-- Test every value gets its own index in [0, n)
+SELECT count(DISTINCT mphf_lookup(m, name)) AS distinct_indexes,
+       min(mphf_lookup(m, name)), max(mphf_lookup(m, name))
+FROM mphf_test, mphfs;
+SELECT mphf_count(m), length(m::bytea) * 8.0 / mphf_count(m) < 4 AS under_4_bits
+FROM mphfs;
+
+-- Test other values get an index in [0, n) or NULL
+SELECT bool_and(mphf_lookup(m, 'other-' || i) BETWEEN 0 AND 99999) AS in_range
+FROM generate_series(1, 10000) i, mphfs;
+
+-- Test dictionary encoding round trip
+CREATE TEMP TABLE mphf_dict AS
+SELECT mphf_lookup(m, name) AS code, name FROM mphf_test, mphfs;
+SELECT count(*) FROM mphf_test t, mphfs, mphf_dict d
+WHERE d.code = mphf_lookup(m, t.name) AND d.name <> t.name;
+
+-- Test duplicates are counted once and values of other types
+SELECT mphf_count(m), mphf_lookup(m, 1), mphf_lookup(m, 2), mphf_lookup(m, 3)
+FROM (SELECT mphf_agg(v) AS m FROM (VALUES (3), (1), (3), (2)) s(v)) t;
+SELECT mphf_lookup(m, 7::int4) IS NOT NULL, mphf_lookup(m, 7::int8) IS NOT NULL
+FROM (SELECT mphf_agg(i::int8) AS m FROM generate_series(1, 10) i) t;
+
+-- Test the function does not depend on the order or repetition of values
+SELECT (SELECT mphf_agg(v ORDER BY v DESC)::text FROM generate_series(1, 1000) v) =
+       (SELECT mphf_agg(v % 1000 + 1)::text FROM generate_series(1, 5000) v);
+
+-- Test a window aggregate gives the function of each frame
+SELECT bool_and(mphf_count(m) = i) AS counts_match,
+       bool_and((SELECT count(DISTINCT mphf_lookup(m, j)) = i AND
+                        min(mphf_lookup(m, j)) = 0 AND max(mphf_lookup(m, j)) = i - 1
+                 FROM generate_series(1, i) j)) AS indexes_match
+FROM (SELECT i, mphf_agg(i) OVER (ORDER BY i) AS m FROM generate_series(1, 300) i) w;
+
+-- Test small functions
+SELECT mphf_agg(v) FROM (VALUES ('a')) s(v);
+SELECT mphf_lookup(m, 'a'::text), mphf_lookup(m, 'b'::text), mphf_count(m) FROM (SELECT mphf_agg(v) AS m FROM (VALUES ('a')) s(v)) t;
+
+-- Test NULLs are ignored and no rows give NULL
+SELECT mphf_count(mphf_agg(v)) FROM (VALUES (1), (NULL)) s(v);
+SELECT mphf_agg(v), mphf_count(mphf_agg(v)) FROM (VALUES (NULL::int)) s(v);
+SELECT mphf_lookup(mphf_agg(v), 1) FROM (VALUES (NULL::int)) s(v);
+SELECT mphf_agg(id) FROM mphf_test WHERE false;
+
+-- Test text and bytea round trips
+SELECT m::text::mphf::text = m::text, mphf(m::bytea)::bytea = m::bytea
+FROM mphfs;
+
+-- Test lookups under another client_encoding give the same indexes
+CREATE TEMP TABLE mphf_text AS
+SELECT mphf_agg(U&'caf\00e9' || i) AS m FROM generate_series(1, 100) i;
+CREATE TEMP TABLE mphf_text_codes AS
+SELECT i, mphf_lookup(m, U&'caf\00e9' || i) AS code FROM mphf_text, generate_series(1, 100) i;
+SET client_encoding = 'LATIN1';
+SELECT bool_and(mphf_lookup(m, U&'caf\00e9' || i) = code) AS same_codes,
+       count(DISTINCT code) AS distinct_indexes
+FROM mphf_text, mphf_text_codes;
+RESET client_encoding;
+
+-- Test parallel aggregation gives the serial result
+CREATE TABLE mphf_test_parallel AS SELECT name FROM mphf_test;
+ANALYZE mphf_test_parallel;
+SET parallel_setup_cost = 0;
+SET parallel_tuple_cost = 0;
+SET min_parallel_table_scan_size = 0;
+SET max_parallel_workers_per_gather = 2;
+EXPLAIN (COSTS OFF) SELECT mphf_agg(name) FROM mphf_test_parallel;
+SELECT mphf_agg(name)::text = (SELECT m::text FROM mphfs)
+FROM mphf_test_parallel;
+RESET parallel_setup_cost;
+RESET parallel_tuple_cost;
+RESET min_parallel_table_scan_size;
+RESET max_parallel_workers_per_gather;
+DROP TABLE mphf_test_parallel;
+
+-- Test errors
+SELECT 'xyz'::mphf;
+SELECT '\x0101000001000000'::mphf;
+SELECT '\x010100000100000000000000'::mphf;
+SELECT '\x0200000000000000'::mphf;
+
+-- Test function properties
+SELECT 
+    proname,
+    provolatile,
+    proisstrict,
+    proparallel
+FROM pg_proc 
+WHERE proname LIKE 'mphf%'
+ORDER BY proname, proargtypes;
+
+-- Test extension metadata
+SELECT 
+    extname,
+    extversion
+FROM pg_extension 
+WHERE extname = 'hashlib';
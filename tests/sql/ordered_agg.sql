@@ -0,0 +1,61 @@
+-- Ordered streaming hash aggregates: each value is framed with its length
+-- and fed to the streaming kernel in order
+CREATE TEMP TABLE agg_test AS
+SELECT i AS id, md5(i::text) AS t, convert_to(repeat(md5(i::text), i % 5), 'UTF8') AS b
+FROM generate_series(1, 2000) i;
+
+-- Test basic functionality
+SELECT xxh3_64_agg(t ORDER BY id), xxh3_128_agg(t ORDER BY id), crc32_agg(t ORDER BY id) FROM agg_test;
+
+-- Test text and bytea give the same result for the same bytes
+SELECT xxh3_64_agg(t ORDER BY id) = xxh3_64_agg(convert_to(t, 'UTF8') ORDER BY id),
+       xxh3_128_agg(t ORDER BY id) = xxh3_128_agg(convert_to(t, 'UTF8') ORDER BY id),
+       crc32_agg(t ORDER BY id) = crc32_agg(convert_to(t, 'UTF8') ORDER BY id)
+FROM agg_test;
+
+-- Test that the result is the one-shot hash of the framed values
+-- (8-byte little-endian length, then the data)
+CREATE FUNCTION pg_temp.frame(v bytea) RETURNS bytea LANGUAGE sql AS
+$$ SELECT decode(string_agg(lpad(to_hex((length(v)::bigint >> (8 * i)) & 255), 2, '0'), '' ORDER BY i), 'hex') || v
+   FROM generate_series(0, 7) i $$;
+SELECT xxh3_64_agg(b ORDER BY id) = xxhash3_64(string_agg(pg_temp.frame(b), '' ORDER BY id)) AS xxh3_64,
+       xxh3_128_agg(b ORDER BY id) = xxhash3_128(string_agg(pg_temp.frame(b), '' ORDER BY id)) AS xxh3_128,
+       crc32_agg(b ORDER BY id) = crc32(string_agg(pg_temp.frame(b), '' ORDER BY id)) AS crc32
+FROM agg_test;
+
+-- Test that order matters
+SELECT xxh3_64_agg(t ORDER BY id) != xxh3_64_agg(t ORDER BY id DESC),
+       crc32_agg(t ORDER BY id) != crc32_agg(t ORDER BY id DESC)
+FROM agg_test;
+
+-- Test framing: the same concatenation split differently gives different hashes
+SELECT xxh3_64_agg(v ORDER BY n) FROM (VALUES (1, 'ab'), (2, 'c')) s(n, v)
+UNION ALL SELECT xxh3_64_agg(v ORDER BY n) FROM (VALUES (1, 'a'), (2, 'bc')) s(n, v);
+
+-- Test that NULL and empty values are distinct
+SELECT xxh3_128_agg(v) != xxh3_128_agg(COALESCE(v, '')) FROM (VALUES (NULL::text)) s(v);
+SELECT crc32_agg(v) != crc32_agg(COALESCE(v, '')) FROM (VALUES (NULL::text)) s(v);
+
+-- Test no rows (hash of empty input)
+SELECT xxh3_64_agg(t) = xxhash3_64(''), xxh3_128_agg(t) = xxhash3_128(''), crc32_agg(t) = crc32('')
+FROM agg_test WHERE false;
+
+-- Test per-group results
+SELECT id % 3 AS g, xxh3_64_agg(t ORDER BY id) = xxhash3_64(string_agg(pg_temp.frame(convert_to(t, 'UTF8')), '' ORDER BY id))
+FROM agg_test GROUP BY 1 ORDER BY 1;
+
+-- Test function properties
+SELECT 
+    proname,
+    provolatile,
+    proisstrict
+FROM pg_proc 
+WHERE proname IN ('xxh3_64_agg', 'xxh3_128_agg', 'crc32_agg')
+ORDER BY proname, proargtypes;
+
+-- Test extension metadata
+SELECT 
+    extname,
+    extversion
+FROM pg_extension 
+WHERE extname = 'hashlib';
@@ -0,0 +1,96 @@
+-- Test basic hash functionality with text
+SELECT rapidhash('hello world');
+
+-- Test hash with different text inputs
+SELECT rapidhash('test string');
+SELECT rapidhash('another test');
+
+-- Test text input with custom seed
+SELECT rapidhash('hello world', 42);
+SELECT rapidhash('hello world', 84);
+
+-- Test bytea input
+SELECT rapidhash('hello world'::bytea);
+
+-- Test bytea input with custom seed
+SELECT rapidhash('hello world'::bytea, 42);
+
+-- Test integer input
+SELECT rapidhash(12345);
+SELECT rapidhash(-12345);
+
+-- Test integer input with custom seed
+SELECT rapidhash(12345, 42);
+SELECT rapidhash(-12345, 84);
+
+-- Test bigint input
+SELECT rapidhash(123456789012345::bigint);
+SELECT rapidhash(-123456789012345::bigint);
+
+-- Test bigint input with custom seed
+SELECT rapidhash(123456789012345::bigint, 42);
+SELECT rapidhash(-123456789012345::bigint, 84);
+
+-- Test consistency (same input should give same hash)
+SELECT rapidhash('consistent test') = rapidhash('consistent test');
+
+-- Test seed effect (same input, different seeds should give different hashes)
+SELECT rapidhash('seed test', 1) != rapidhash('seed test', 2);
+
+-- Test empty string
+SELECT rapidhash('');
+
+-- Test single character
+SELECT rapidhash('a');
+
+-- Test long string
+SELECT rapidhash('Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod tempor incididunt ut labore et dolore magna aliqua. Ut enim ad minim veniam, quis nostrud exercitation ullamco laboris nisi ut aliquip ex ea commodo consequat.');
+
+-- Test various input lengths to test different code paths
+SELECT rapidhash('1234567');           -- 7 bytes
+SELECT rapidhash('12345678');          -- 8 bytes  
+SELECT rapidhash('123456789012345');   -- 15 bytes
+SELECT rapidhash('1234567890123456');  -- 16 bytes
+SELECT rapidhash('12345678901234567890123456789012'); -- 32 bytes
+SELECT rapidhash('123456789012345678901234567890123'); -- 33 bytes
+SELECT rapidhash('1234567890123456789012345678901234567890123456789012345'); -- 55 bytes (> 48)
+
+-- Test lengths that exercise the 48-byte loop tail handling
+SELECT rapidhash(repeat('0123456789abcdef', 6));  -- 96 bytes
+SELECT rapidhash(repeat('0123456789abcdef', 9));  -- 144 bytes
+
+-- Test that an explicit default seed matches the unseeded variant
+SELECT rapidhash('hello world') = rapidhash('hello world', -4766890152743124951);
+
+-- Test zero values
+SELECT rapidhash(0);
+SELECT rapidhash(0::bigint);
+
+-- Test maximum values
+SELECT rapidhash(2147483647);          -- max int4
+SELECT rapidhash(-2147483648);         -- min int4
+SELECT rapidhash(9223372036854775807::bigint);  -- max int8
+SELECT rapidhash(-9223372036854775808::bigint); -- min int8
+
+-- Test with various seeds
+SELECT rapidhash('test', 0);
+SELECT rapidhash('test', 1);
+SELECT rapidhash('test', -1);
+SELECT rapidhash('test', 9223372036854775807::bigint);   -- max positive seed
+SELECT rapidhash('test', -9223372036854775808::bigint);  -- max negative seed
+
+-- Test function properties
+SELECT 
+    proname,
+    provolatile,
+    proisstrict
+FROM pg_proc 
+WHERE proname = 'rapidhash'
+ORDER BY proname, proargtypes;
+
+-- Test extension metadata
+SELECT 
+    extname,
+    extversion
+FROM pg_extension 
+WHERE extname = 'hashlib';
\ No newline at end of file
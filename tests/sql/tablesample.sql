@@ -0,0 +1,73 @@
+-- Test hashlib_block and hashlib_row tablesample methods
+
+CREATE TABLE tablesample_test (id int, pad text) WITH (fillfactor = 10);
+INSERT INTO tablesample_test SELECT i, repeat('x', 100) FROM generate_series(1, 20000) i;
+ANALYZE tablesample_test;
+SELECT pg_relation_size('tablesample_test') / current_setting('block_size')::int AS blocks;
+
+-- Test sample sizes: about 10% of the blocks or rows
+SELECT count(*) BETWEEN 320 AND 480 AS block_count_ok,
+       bool_and(s.c = t.c) AS whole_blocks
+FROM (SELECT (ctid::text::point)[0] AS b, count(*) AS c
+      FROM tablesample_test TABLESAMPLE hashlib_block(10, 42) GROUP BY 1) s
+JOIN (SELECT (ctid::text::point)[0] AS b, count(*) AS c
+      FROM tablesample_test GROUP BY 1) t USING (b);
+SELECT count(*) BETWEEN 1800 AND 2200 AS row_count_ok
+FROM tablesample_test TABLESAMPLE hashlib_row(10, 42);
+SELECT (SELECT count(*) FROM tablesample_test TABLESAMPLE hashlib_block(0, 1)) AS block_none,
+       (SELECT count(*) FROM tablesample_test TABLESAMPLE hashlib_block(100, 1)) AS block_all,
+       (SELECT count(*) FROM tablesample_test TABLESAMPLE hashlib_row(0, 1)) AS row_none,
+       (SELECT count(*) FROM tablesample_test TABLESAMPLE hashlib_row(100, 1)) AS row_all;
+
+-- Test reproducibility: the same seed gives the same sample, another seed another one
+CREATE TABLE tablesample_runs AS
+SELECT 'block' AS method, array_agg(id ORDER BY id) AS ids FROM tablesample_test TABLESAMPLE hashlib_block(10, 42)
+UNION ALL
+SELECT 'row', array_agg(id ORDER BY id) FROM tablesample_test TABLESAMPLE hashlib_row(10, 42);
+SELECT (SELECT array_agg(id ORDER BY id) FROM tablesample_test TABLESAMPLE hashlib_block(10, 42)) =
+       (SELECT ids FROM tablesample_runs WHERE method = 'block') AS block_same,
+       (SELECT array_agg(id ORDER BY id) FROM tablesample_test TABLESAMPLE hashlib_row(10, 42)) =
+       (SELECT ids FROM tablesample_runs WHERE method = 'row') AS row_same,
+       (SELECT array_agg(id ORDER BY id) FROM tablesample_test TABLESAMPLE hashlib_block(10, 43)) =
+       (SELECT ids FROM tablesample_runs WHERE method = 'block') AS other_seed_same;
+
+-- Smaller samples are subsets of larger ones with the same seed
+SELECT bool_and(s.id IN (SELECT id FROM tablesample_test TABLESAMPLE hashlib_row(20, 42))) AS nested
+FROM tablesample_test s TABLESAMPLE hashlib_row(10, 42);
+
+-- A rewrite that keeps the blocks keeps the sample: the table OID is hashed, not the relfilenode
+VACUUM FULL tablesample_test;
+SELECT (SELECT array_agg(id ORDER BY id) FROM tablesample_test TABLESAMPLE hashlib_block(10, 42)) =
+       (SELECT ids FROM tablesample_runs WHERE method = 'block') AS same_after_rewrite;
+
+-- Test a sample in a join and a rescan
+SELECT count(*) = (SELECT count(*) FROM tablesample_test TABLESAMPLE hashlib_block(10, 42)) * 2 AS rescan_same
+FROM generate_series(1, 2) g,
+     LATERAL (SELECT id FROM tablesample_test TABLESAMPLE hashlib_block(10, 42) OFFSET 0) s;
+
+EXPLAIN (COSTS OFF) SELECT * FROM tablesample_test TABLESAMPLE hashlib_block(10, 42);
+DROP TABLE tablesample_runs;
+
+-- Test errors
+SELECT count(*) FROM tablesample_test TABLESAMPLE hashlib_block(-1, 1);
+SELECT count(*) FROM tablesample_test TABLESAMPLE hashlib_row(101, 1);
+SELECT count(*) FROM tablesample_test TABLESAMPLE hashlib_block(10);
+SELECT count(*) FROM tablesample_test TABLESAMPLE hashlib_block(NULL, 1);
+DROP TABLE tablesample_test;
+
+-- Test function properties
+SELECT 
+    proname,
+    provolatile,
+    proisstrict,
+    proparallel
+FROM pg_proc 
+WHERE proname IN ('hashlib_block', 'hashlib_row')
+ORDER BY proname, proargtypes;
+
+-- Test extension metadata
+SELECT 
+    extname,
+    extversion
+FROM pg_extension 
+WHERE extname = 'hashlib';
@@ -0,0 +1,103 @@
+-- Theta (KMV) sketches
+CREATE TEMP TABLE theta_test AS
+SELECT i AS id, md5(i::text) AS name
+FROM generate_series(1, 100000) i;
+
+CREATE TEMP TABLE theta_days AS
+SELECT 'a' AS day, theta_sketch_agg(xxhash3_64(name)) AS s FROM theta_test WHERE id <= 60000
+UNION ALL
+SELECT 'b', theta_sketch_agg(xxhash3_64(name)) FROM theta_test WHERE id > 40000;
+
+-- Test exact mode below k
+SELECT theta_estimate(s), theta_retained(s), theta_lower_bound(s, 2), theta_upper_bound(s, 2)
+FROM (SELECT theta_sketch_agg(id) AS s FROM theta_test WHERE id <= 1000) t;
+SELECT theta_estimate(theta_sketch_agg(id % 10)) FROM theta_test;
+
+-- Test estimates and bounds in estimation mode
+SELECT day, theta_retained(s), abs(theta_estimate(s) - 60000) / 60000 < 0.05 AS close,
+       theta_lower_bound(s, 3) < 60000 AND theta_upper_bound(s, 3) > 60000 AS bounded,
+       theta_lower_bound(s, 1) > theta_lower_bound(s, 2)
+FROM theta_days ORDER BY day;
+
+-- Test union, intersection and difference (true sizes 100000, 20000, 40000)
+SELECT abs(theta_estimate(theta_union(a.s, b.s)) - 100000) / 100000 < 0.05 AS union_close,
+       abs(theta_estimate(theta_intersect(a.s, b.s)) - 20000) / 20000 < 0.1 AS intersect_close,
+       abs(theta_estimate(theta_a_not_b(a.s, b.s)) - 40000) / 40000 < 0.1 AS a_not_b_close,
+       theta_lower_bound(theta_intersect(a.s, b.s), 3) < 20000
+           AND theta_upper_bound(theta_intersect(a.s, b.s), 3) > 20000 AS intersect_bounded
+FROM theta_days a, theta_days b
+WHERE a.day = 'a' AND b.day = 'b';
+SELECT theta_union(a.s, b.s)::text = theta_union(b.s, a.s)::text,
+       theta_intersect(a.s, b.s)::text = theta_intersect(b.s, a.s)::text,
+       theta_union(a.s, b.s)::text = (SELECT theta_union_agg(s)::text FROM theta_days),
+       theta_intersect(a.s, b.s)::text = (SELECT theta_intersect_agg(s)::text FROM theta_days)
+FROM theta_days a, theta_days b
+WHERE a.day = 'a' AND b.day = 'b';
+SELECT theta_estimate(theta_a_not_b(s, s)), theta_estimate(theta_intersect(s, s)) = theta_estimate(s)
+FROM theta_days WHERE day = 'a';
+
+-- Test that exact sketches give exact set operations
+SELECT theta_estimate(theta_intersect(a, b)), theta_estimate(theta_a_not_b(a, b)), theta_estimate(theta_union(a, b))
+FROM (SELECT theta_sketch_agg(id) FILTER (WHERE id <= 600) AS a,
+             theta_sketch_agg(id) FILTER (WHERE id > 400 AND id <= 1000) AS b
+      FROM theta_test) s;
+
+-- Test the union aggregate gives the single-pass sketch
+SELECT theta_union_agg(s)::text = (SELECT theta_sketch_agg(id)::text FROM theta_test)
+FROM (SELECT theta_sketch_agg(id) AS s FROM theta_test GROUP BY id % 7) t;
+
+-- Test sketch size and the smallest sketches
+SELECT theta_sketch_agg(id, 16) FROM theta_test WHERE id <= 3;
+SELECT theta_retained(theta_sketch_agg(id, 16)), theta_retained(theta_sketch_agg(id, 1024)) FROM theta_test;
+SELECT theta_retained(theta_union(theta_sketch_agg(id, 16), theta_sketch_agg(id, 1024))) FROM theta_test;
+
+-- Test NULLs are ignored and no rows give NULL
+SELECT theta_estimate(theta_sketch_agg(v)) FROM (VALUES (1::bigint), (NULL)) s(v);
+SELECT theta_sketch_agg(id) FROM theta_test WHERE false;
+SELECT theta_intersect_agg(s) FROM theta_days WHERE false;
+
+-- Test text and bytea round trips
+SELECT s::text::theta_sketch::text = s::text, theta_sketch(s::bytea)::bytea = s::bytea
+FROM theta_days;
+
+-- Test parallel aggregation gives the serial result
+SELECT theta_sketch_agg(xxhash3_64(name))::text AS serial FROM theta_test \gset
+CREATE TABLE theta_test_parallel AS SELECT id, xxhash3_64(name) AS h FROM theta_test;
+ANALYZE theta_test_parallel;
+SET parallel_setup_cost = 0;
+SET parallel_tuple_cost = 0;
+SET min_parallel_table_scan_size = 0;
+SET max_parallel_workers_per_gather = 2;
+EXPLAIN (COSTS OFF) SELECT theta_sketch_agg(h) FROM theta_test_parallel;
+SELECT theta_sketch_agg(h)::text = :'serial' FROM theta_test_parallel;
+RESET parallel_setup_cost;
+RESET parallel_tuple_cost;
+RESET min_parallel_table_scan_size;
+RESET max_parallel_workers_per_gather;
+DROP TABLE theta_test_parallel;
+
+-- Test errors
+SELECT theta_sketch_agg(id, 8) FROM theta_test;
+SELECT theta_lower_bound(s, 4) FROM theta_days WHERE day = 'a';
+SELECT 'xyz'::theta_sketch;
+SELECT '\x01000000'::theta_sketch;
+SELECT '\x0100000010000000ffffffffffffffff0200000000000000010000000000000000'::theta_sketch;
+SELECT '\x0100000010000000ffffffffffffffff02000000000000000100000000000000'::theta_sketch;
+SELECT '\x01000000100000000200000000000000ffffffffffffff00'::theta_sketch;
+
+-- Test function properties
+SELECT 
+    proname,
+    provolatile,
+    proisstrict,
+    proparallel
+FROM pg_proc 
+WHERE proname LIKE 'theta%'
+ORDER BY proname, proargtypes;
+
+-- Test extension metadata
+SELECT 
+    extname,
+    extversion
+FROM pg_extension 
+WHERE extname = 'hashlib';
@@ -0,0 +1,38 @@
+-- Large values stored out of line without compression are hashed one slice
+-- of TOAST chunks at a time; results must match hashing the value in memory
+CREATE TEMP TABLE toast_test (id int, b bytea, t text);
+ALTER TABLE toast_test ALTER COLUMN b SET STORAGE EXTERNAL, ALTER COLUMN t SET STORAGE EXTERNAL;
+INSERT INTO toast_test
+SELECT n, convert_to(string_agg(md5(i::text || n), ''), 'UTF8'), string_agg(md5(i::text || n), '')
+FROM generate_series(1, 2) n, generate_series(1, 70000 + n * 777) i
+GROUP BY n;
+
+-- Test that the values are large and stored uncompressed
+SELECT id, length(b), pg_column_size(b) = length(b) AS uncompressed FROM toast_test ORDER BY id;
+
+-- Test streamed results against in-memory copies (|| '' forces a plain value)
+SELECT id,
+       xxhash64(b) = xxhash64(b || ''::bytea) AS xxhash64,
+       xxhash64(t, 42) = xxhash64(t || '', 42) AS xxhash64_seed,
+       xxhash3_64(b) = xxhash3_64(b || ''::bytea) AS xxhash3_64,
+       xxhash3_128(t, 42) = xxhash3_128(t || '', 42) AS xxhash3_128,
+       spookyhash64(b, 7) = spookyhash64(b || ''::bytea, 7) AS spookyhash64,
+       spookyhash128(t, 1, 2) = spookyhash128(t || '', 1, 2) AS spookyhash128
+FROM toast_test ORDER BY id;
+
+SELECT id,
+       highwayhash64(b) = highwayhash64(b || ''::bytea) AS highwayhash64,
+       highwayhash128(t, 1, 2, 3, 4) = highwayhash128(t || '', 1, 2, 3, 4) AS highwayhash128,
+       highwayhash256(b) = highwayhash256(b || ''::bytea) AS highwayhash256,
+       crc32(t) = crc32(t || '') AS crc32,
+       crc64(b) = crc64(b || ''::bytea) AS crc64,
+       crc64_nvme(t, 5) = crc64_nvme(t || '', 5) AS crc64_nvme,
+       crc64_ecma(b) = crc64_ecma(b || ''::bytea) AS crc64_ecma
+FROM toast_test ORDER BY id;
+
+-- Test that compressed values still hash the same (full detoast path)
+ALTER TABLE toast_test ALTER COLUMN b SET STORAGE EXTENDED;
+INSERT INTO toast_test SELECT 3, convert_to(repeat('compressible ', 200000), 'UTF8'), NULL;
+SELECT pg_column_size(b) < length(b) AS compressed,
+       xxhash3_64(b) = xxhash3_64(convert_to(repeat('compressible ', 200000), 'UTF8')) AS xxhash3_64
+FROM toast_test WHERE id = 3;
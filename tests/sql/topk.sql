@@ -0,0 +1,86 @@
+-- Heavy hitters (Space-Saving)
+CREATE TEMP TABLE topk_test AS
+SELECT i AS id, CASE WHEN i % 2 = 0 THEN i % 10 ELSE i END AS v
+FROM generate_series(1, 100000) i;
+
+-- Test the Space-Saving replacement rule on a small input
+SELECT * FROM topk_items((SELECT topk_agg(x, 3) FROM (VALUES ('a'), ('b'), ('a'), ('c'), ('d'), ('a'), (NULL)) s(x)));
+
+-- Test exact counts while there are no more distinct values than counters
+SELECT * FROM topk_items((SELECT topk_agg(id % 5, 5) FROM topk_test));
+
+-- Test heavy hitters are found among many rare values, with valid bounds
+SELECT value, count >= 10000 AND count - error <= 10000 AS bounded
+FROM topk_items((SELECT topk_agg(v, 100) FROM topk_test), 5)
+ORDER BY value;
+SELECT topk_total(t), (SELECT count(*) FROM topk_items(t)) FROM (SELECT topk_agg(v, 100) AS t FROM topk_test) s;
+
+-- Test values of other types
+SELECT * FROM topk_items((SELECT topk_agg(md5((id % 3)::text), 10) FROM topk_test), 2);
+SELECT * FROM topk_items((SELECT topk_agg(ROW(id % 2, 'x'), 10) FROM topk_test));
+
+-- Test merging summaries
+SELECT value, count >= 10000 AND count - error <= 10000 AS bounded
+FROM topk_items((SELECT topk_union_agg(t) FROM (SELECT topk_agg(v, 100) AS t FROM topk_test GROUP BY id % 4) s), 5)
+ORDER BY value;
+SELECT * FROM topk_items(topk_union((SELECT topk_agg(x, 2) FROM (VALUES (1), (1), (2)) s(x)),
+                                    (SELECT topk_agg(x, 3) FROM (VALUES (3), (3), (3), (1)) s(x))));
+
+-- Test NULLs are ignored and no rows give NULL
+SELECT topk_agg(id, 10) FROM topk_test WHERE false;
+SELECT topk_total(topk_agg(x, 10)) FROM (VALUES (1), (NULL)) s(x);
+
+-- Test the text form round trip and the stored layout
+SELECT topk_agg(x, 2) FROM (VALUES (1), (2), (2)) s(x);
+SELECT t::text::topk::text = t::text FROM (SELECT topk_agg(v, 100) AS t FROM topk_test) s;
+
+-- Test summaries built under different client_encodings count the same items
+CREATE TEMP TABLE topk_text AS
+SELECT topk_agg(x, 10) AS t FROM (VALUES (U&'caf\00e9'), (U&'caf\00e9'), ('tea')) s(x);
+SET client_encoding = 'LATIN1';
+SELECT value = U&'caf\00e9' AS is_cafe, count, error
+FROM topk_items(topk_union((SELECT t FROM topk_text),
+                           (SELECT topk_agg(x, 10) FROM (VALUES (U&'caf\00e9'), ('tea')) s(x))));
+RESET client_encoding;
+
+-- Test parallel aggregation gives the serial result
+SELECT topk_agg(id % 50, 100)::text AS serial FROM topk_test \gset
+CREATE TABLE topk_test_parallel AS SELECT * FROM topk_test;
+ANALYZE topk_test_parallel;
+SET parallel_setup_cost = 0;
+SET parallel_tuple_cost = 0;
+SET min_parallel_table_scan_size = 0;
+SET max_parallel_workers_per_gather = 2;
+EXPLAIN (COSTS OFF) SELECT topk_agg(id % 50, 100) FROM topk_test_parallel;
+SELECT topk_agg(id % 50, 100)::text = :'serial' FROM topk_test_parallel;
+RESET parallel_setup_cost;
+RESET parallel_tuple_cost;
+RESET min_parallel_table_scan_size;
+RESET max_parallel_workers_per_gather;
+DROP TABLE topk_test_parallel;
+
+-- Test errors
+SELECT topk_agg(id, 0) FROM topk_test;
+SELECT topk_agg(id, NULL) FROM topk_test;
+SELECT * FROM topk_items((SELECT topk_agg(id, 10) FROM topk_test), -1);
+SELECT 'xyz'::topk;
+SELECT '\x010000000200000000000000000000000300000000'::topk;
+-- counts out of order
+SELECT '\x010000000200000003000000000000000200000001000000000000000000000000000000040000000000000101000000310200000000000000000000000000000004000000000000020100000032'::topk;
+
+-- Test function properties
+SELECT 
+    proname,
+    provolatile,
+    proisstrict,
+    proparallel
+FROM pg_proc 
+WHERE proname LIKE 'topk%'
+ORDER BY proname, proargtypes;
+
+-- Test extension metadata
+SELECT 
+    extname,
+    extversion
+FROM pg_extension 
+WHERE extname = 'hashlib';
@@ -0,0 +1,109 @@
+-- Order-independent set fingerprints
+CREATE TEMP TABLE set_test AS
+SELECT i AS id, md5(i::text) AS name, (i % 7 = 0) AS flag,
+       '2024-01-01 00:00:00+00'::timestamptz + i * interval '1 hour' AS ts
+FROM generate_series(1, 5000) i;
+
+-- Test basic functionality
+SELECT xxh3_set_agg(id) FROM set_test;
+SELECT xxh3_set_agg_record(t) FROM set_test t;
+
+-- Test that row order does not matter
+SELECT xxh3_set_agg(id) = (SELECT xxh3_set_agg(id) FROM (SELECT id FROM set_test ORDER BY id DESC) s)
+FROM set_test;
+SELECT xxh3_set_agg_record(t) = (SELECT xxh3_set_agg_record(s) FROM (SELECT * FROM set_test ORDER BY md5(name)) s)
+FROM set_test t;
+
+-- Test that the fingerprint changes when one value changes
+SELECT xxh3_set_agg(name) != (SELECT xxh3_set_agg(CASE WHEN id = 4321 THEN 'x' ELSE name END) FROM set_test)
+FROM set_test;
+
+-- Test multiset semantics (duplicates count, also in pairs)
+SELECT xxh3_set_agg(v) FROM (VALUES (1), (2)) s(v)
+UNION ALL SELECT xxh3_set_agg(v) FROM (VALUES (1), (1), (2)) s(v)
+UNION ALL SELECT xxh3_set_agg(v) FROM (VALUES (1), (1), (2), (2)) s(v);
+
+-- Test that NULLs are ignored and the empty set has a fixed fingerprint
+SELECT xxh3_set_agg(v) = xxh3_set_agg(v) FILTER (WHERE v IS NOT NULL) FROM (VALUES (1), (NULL), (2)) s(v);
+SELECT xxh3_set_agg(v) FROM (VALUES (NULL::int)) s(v);
+SELECT xxh3_set_agg(id) FROM set_test WHERE false;
+
+-- Test that values of a composite type are framed like records
+SELECT xxh3_set_agg(t) = xxh3_set_agg_record(t) FROM set_test t;
+SELECT xxh3_set_agg_record(ROW(id, name)) = xxh3_set_agg_record(ROW(id::int, name::text)),
+       xxh3_set_agg_record(ROW(id, name)) != xxh3_set_agg_record(ROW(name, id)),
+       xxh3_set_agg_record(ROW(id, NULL::text)) != xxh3_set_agg_record(ROW(id, ''::text))
+FROM set_test;
+
+-- Test that the binary form is used (same result for a domain over int4, and
+-- independent of TimeZone)
+CREATE DOMAIN pg_temp.set_test_int AS integer;
+SELECT xxh3_set_agg(id) = xxh3_set_agg(id::pg_temp.set_test_int) FROM set_test;
+SELECT xxh3_set_agg(ts) AS utc FROM set_test \gset
+SET TimeZone = 'America/New_York';
+SELECT xxh3_set_agg(ts) = :'utc' FROM set_test;
+RESET TimeZone;
+
+-- Test that text-like values are hashed in the server encoding, whatever
+-- the client encoding, and that varchar, name and text agree
+CREATE TYPE pg_temp.set_test_mood AS ENUM ('happy', U&'tr\00e8s');
+CREATE TEMP TABLE set_test_text AS
+SELECT U&'caf\00e9' || i AS t FROM generate_series(1, 100) i;
+SELECT xxh3_set_agg(t) AS utf8_text,
+       xxh3_set_agg(ROW(t::varchar, t::name, ARRAY[t], ('{"k": "' || t || '"}')::json,
+                        ('{"k": "' || t || '"}')::jsonb, U&'tr\00e8s'::pg_temp.set_test_mood)) AS utf8_row
+FROM set_test_text \gset
+SET client_encoding = 'LATIN1';
+SELECT xxh3_set_agg(t) = :'utf8_text' AS latin1_text,
+       xxh3_set_agg(ROW(t::varchar, t::name, ARRAY[t], ('{"k": "' || t || '"}')::json,
+                        ('{"k": "' || t || '"}')::jsonb, U&'tr\00e8s'::pg_temp.set_test_mood)) = :'utf8_row' AS latin1_row
+FROM set_test_text;
+SELECT xxh3_set_agg(U&'\4e2d'::text) IS NOT NULL AS not_in_latin1;
+RESET client_encoding;
+SELECT xxh3_set_agg(t) = xxh3_set_agg(t::varchar) AND xxh3_set_agg(t) = xxh3_set_agg(t::name) AS string_types_agree
+FROM set_test_text;
+SELECT xxh3_set_agg(makeaclitem(10, 10, 'SELECT', false));
+
+-- Test that type OIDs are not hashed: an array of an enum keeps its fingerprint
+-- when the type is recreated with a new OID, as in a restored dump
+CREATE TYPE pg_temp.set_test_color AS ENUM ('red', 'green');
+SELECT 'pg_temp.set_test_color'::regtype::oid AS color_oid,
+       xxh3_set_agg(ARRAY['red', NULL, 'green']::pg_temp.set_test_color[]) AS colors \gset
+DROP TYPE pg_temp.set_test_color;
+CREATE TYPE pg_temp.set_test_color AS ENUM ('red', 'green');
+SELECT 'pg_temp.set_test_color'::regtype::oid <> :color_oid AS new_oid,
+       xxh3_set_agg(ARRAY['red', NULL, 'green']::pg_temp.set_test_color[]) = :'colors' AS same_fingerprint;
+
+-- Test parallel aggregation gives the serial result
+SELECT xxh3_set_agg_record(t) AS serial FROM set_test t \gset
+ANALYZE set_test;
+CREATE TABLE set_test_parallel AS SELECT * FROM set_test;
+ANALYZE set_test_parallel;
+SET parallel_setup_cost = 0;
+SET parallel_tuple_cost = 0;
+SET min_parallel_table_scan_size = 0;
+SET max_parallel_workers_per_gather = 2;
+EXPLAIN (COSTS OFF) SELECT xxh3_set_agg_record(t) FROM set_test_parallel t;
+SELECT xxh3_set_agg_record(t) = :'serial' FROM set_test_parallel t;
+RESET parallel_setup_cost;
+RESET parallel_tuple_cost;
+RESET min_parallel_table_scan_size;
+RESET max_parallel_workers_per_gather;
+DROP TABLE set_test_parallel;
+
+-- Test function properties
+SELECT 
+    proname,
+    provolatile,
+    proisstrict,
+    proparallel
+FROM pg_proc 
+WHERE proname LIKE 'xxh3\_set\_agg%'
+ORDER BY proname, proargtypes;
+
+-- Test extension metadata
+SELECT 
+    extname,
+    extversion
+FROM pg_extension 
+WHERE extname = 'hashlib';
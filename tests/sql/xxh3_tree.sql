@@ -0,0 +1,79 @@
+-- Tree-mode XXH3: leaves of chunk_size bytes are hashed with XXH3_128bits,
+-- the root hashes the leaf digests plus the length and chunk size
+CREATE TEMP TABLE tree_test AS
+SELECT convert_to(string_agg(md5(i::text), ''), 'UTF8') AS data
+FROM generate_series(1, 160000) i;
+
+SELECT length(data) FROM tree_test;
+
+-- Test basic functionality with text input
+SELECT xxh3_tree_128('hello world', 1024);
+
+-- Test bytea input (same bytes as text)
+SELECT xxh3_tree_128('hello world'::bytea, 1024) = xxh3_tree_128('hello world', 1024);
+
+-- Test empty input
+SELECT xxh3_tree_128('', 1024);
+
+-- Test the tree layout: the root is xxhash3_128 of each leaf digest (low64,
+-- high64) followed by the length and the chunk size, all little-endian
+CREATE FUNCTION pg_temp.le64(hex text) RETURNS text LANGUAGE sql AS
+$$ SELECT string_agg(substr(lpad(hex, 16, '0'), 15 - 2 * i, 2), '' ORDER BY i) FROM generate_series(0, 7) i $$;
+WITH input AS (SELECT convert_to(repeat('abcdefgh', 300), 'UTF8') AS d),
+leaves AS (
+    SELECT i, xxhash3_128(substring(d FROM i * 1024 + 1 FOR 1024)) AS h
+    FROM input, generate_series(0, 2) i
+)
+SELECT xxh3_tree_128(d, 1024) =
+       xxhash3_128(decode(string_agg(pg_temp.le64(substr(h, 17)) || pg_temp.le64(substr(h, 1, 16)), '' ORDER BY i)
+                          || pg_temp.le64(to_hex(length(d))) || pg_temp.le64(to_hex(1024)), 'hex')) AS layout
+FROM input, leaves
+GROUP BY d;
+
+-- Test that the result does not depend on the number of threads
+SET hashlib.tree_max_threads = 64;
+SELECT count(DISTINCT xxh3_tree_128(data, 65536, t)) AS distinct_results
+FROM tree_test, (VALUES (1), (2), (3), (7), (64)) v(t);
+SELECT xxh3_tree_128(data, 65536) = xxh3_tree_128(data, 65536, 1) FROM tree_test;
+
+-- Test leaf boundaries (length an exact multiple of the chunk size, and one past)
+SELECT xxh3_tree_128(substring(data FROM 1 FOR 1048576), 4096, 4) = xxh3_tree_128(substring(data FROM 1 FOR 1048576), 4096, 1) AS exact,
+       xxh3_tree_128(substring(data FROM 1 FOR 1048577), 4096, 4) = xxh3_tree_128(substring(data FROM 1 FOR 1048577), 4096, 1) AS one_past
+FROM tree_test;
+RESET hashlib.tree_max_threads;
+
+-- Test the thread cap: it defaults to 2 and reduces larger thread counts
+SHOW hashlib.tree_max_threads;
+SELECT xxh3_tree_128(data, 65536, 64) = xxh3_tree_128(data, 65536, 1) FROM tree_test;
+SET hashlib.tree_max_threads = 0;
+SET hashlib.tree_max_threads = 65;
+
+-- Test that the chunk size changes the result
+SELECT xxh3_tree_128(data, 65536) != xxh3_tree_128(data, 131072) FROM tree_test;
+
+-- Test that it differs from the single-buffer hash
+SELECT xxh3_tree_128(data, 65536) != xxhash3_128(data) FROM tree_test;
+
+-- Test invalid arguments
+SELECT xxh3_tree_128('test', 100);
+SELECT xxh3_tree_128('test', 1024, 0);
+SELECT xxh3_tree_128('test', 1024, 65);
+
+-- Test NULL input
+SELECT xxh3_tree_128(NULL::bytea, 1024) IS NULL;
+
+-- Test function properties
+SELECT 
+    proname,
+    provolatile,
+    proisstrict
+FROM pg_proc 
+WHERE proname IN ('xxh3_tree_128')
+ORDER BY proname, proargtypes;
+
+-- Test extension metadata
+SELECT 
+    extname,
+    extversion
+FROM pg_extension 
+WHERE extname = 'hashlib';
@@ -45,6 +45,10 @@ SELECT xxhash3_128('hello world!'); -- 12 bytes (small)
 SELECT xxhash3_128('this is a test string with more than sixteen characters'); -- medium size
 SELECT xxhash3_128(repeat('x', 250)); -- large size (>240 bytes)
 
+-- Test lengths that are multiples of the 1024-byte block
+SELECT xxhash3_128(repeat('x', 1024));
+SELECT xxhash3_128(repeat('x', 2048));
+
 -- Test that results are 32-character hex strings
 SELECT length(xxhash3_128('test'));
 SELECT xxhash3_128('test') ~ '^[0-9a-f]{32}$';
@@ -45,6 +45,10 @@ SELECT xxhash3_64('hello world!'); -- 12 bytes (small)
 SELECT xxhash3_64('this is a test string with more than sixteen characters'); -- medium size
 SELECT xxhash3_64(repeat('x', 250)); -- large size (>240 bytes)
 
+-- Test lengths that are multiples of the 1024-byte block
+SELECT xxhash3_64(repeat('x', 1024));
+SELECT xxhash3_64(repeat('x', 2048));
+
 -- Test function properties
 SELECT 
     proname,